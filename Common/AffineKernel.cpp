@@ -0,0 +1,199 @@
+//*****************************************************************************
+// AffineKernel.cpp
+//
+// Author: Kyle Manning
+//
+// Brief Description: Contains the batched 2D transform kernel, with an SSE2
+//					  path that builds four transforms at a time and a scalar
+//					  fallback, the helpers for points and matrices in a
+//					  facing frame, and its microbenchmark against glm::mat4
+//*****************************************************************************
+#include "AffineKernel.h"
+#include "FastMath.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AFFINE_KERNEL_SSE2
+#include <emmintrin.h>
+#endif
+
+// Runs of each path timed by the benchmark; the fastest is kept
+const int BENCHMARK_RUNS = 5;
+
+// Written by the benchmark so neither of its loops can be optimized away
+static volatile float benchmarkSink;
+
+/// <summary>
+/// Builds one packed transform
+/// </summary>
+static void BuildAffineTransform(glm::vec2 pos, glm::vec2 facing, glm::vec2 scale, float pivot, float* out) {
+	out[0] = facing.y * scale.x;
+	out[1] = facing.x * scale.y;
+	out[2] = pos.x - facing.x * pivot;
+	out[3] = -facing.x * scale.x;
+	out[4] = facing.y * scale.y;
+	out[5] = pos.y + pivot - facing.y * pivot;
+}
+
+/// <summary>
+/// Builds packed transforms four at a time where SSE2 is available: positions, facings, and scales are
+/// split into x and y registers, the six rows are computed side by side, and a transpose puts
+/// each transform's floats together for the stores. The remainder is built one at a time
+/// </summary>
+/// <param name="pos">Position of each sprite</param>
+/// <param name="facing">Unit vector each sprite faces</param>
+/// <param name="scale">Half extents of each sprite</param>
+/// <param name="pivot">Height of the point each sprite turns about, or null to turn about the center</param>
+/// <param name="count">Number of sprites</param>
+/// <param name="out">Receives AFFINE_FLOATS floats per sprite</param>
+/// <param name="outStride">Floats from one sprite's transform to the next; at least AFFINE_FLOATS</param>
+void BuildAffineTransforms(const glm::vec2* pos, const glm::vec2* facing, const glm::vec2* scale, const float* pivot, size_t count,
+	float* out, size_t outStride) {
+	size_t i = 0;
+
+#ifdef AFFINE_KERNEL_SSE2
+	for (; i + 4 <= count; i += 4) {
+		__m128 pos01 = _mm_loadu_ps(&pos[i].x);
+		__m128 pos23 = _mm_loadu_ps(&pos[i + 2].x);
+		__m128 posX = _mm_shuffle_ps(pos01, pos23, _MM_SHUFFLE(2, 0, 2, 0));
+		__m128 posY = _mm_shuffle_ps(pos01, pos23, _MM_SHUFFLE(3, 1, 3, 1));
+
+		__m128 scale01 = _mm_loadu_ps(&scale[i].x);
+		__m128 scale23 = _mm_loadu_ps(&scale[i + 2].x);
+		__m128 scaleX = _mm_shuffle_ps(scale01, scale23, _MM_SHUFFLE(2, 0, 2, 0));
+		__m128 scaleY = _mm_shuffle_ps(scale01, scale23, _MM_SHUFFLE(3, 1, 3, 1));
+
+		__m128 pivots = pivot != nullptr ? _mm_loadu_ps(pivot + i) : _mm_setzero_ps();
+
+		__m128 facing01 = _mm_loadu_ps(&facing[i].x);
+		__m128 facing23 = _mm_loadu_ps(&facing[i + 2].x);
+		__m128 facingX = _mm_shuffle_ps(facing01, facing23, _MM_SHUFFLE(2, 0, 2, 0));
+		__m128 facingY = _mm_shuffle_ps(facing01, facing23, _MM_SHUFFLE(3, 1, 3, 1));
+
+		__m128 row0 = _mm_mul_ps(facingY, scaleX);
+		__m128 row1 = _mm_mul_ps(facingX, scaleY);
+		__m128 row2 = _mm_sub_ps(posX, _mm_mul_ps(facingX, pivots));
+		__m128 row3 = _mm_sub_ps(_mm_setzero_ps(), _mm_mul_ps(facingX, scaleX));
+		__m128 row4 = _mm_mul_ps(facingY, scaleY);
+		__m128 row5 = _mm_sub_ps(_mm_add_ps(posY, pivots), _mm_mul_ps(facingY, pivots));
+
+		// Rows 0 to 3 become the first four floats of each transform, rows 4 and 5 are paired for the last two
+		_MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+		__m128 tail01 = _mm_unpacklo_ps(row4, row5);
+		__m128 tail23 = _mm_unpackhi_ps(row4, row5);
+
+		float* target = out + i * outStride;
+		_mm_storeu_ps(target, row0);
+		_mm_storel_pi((__m64*)(target + 4), tail01);
+		target += outStride;
+		_mm_storeu_ps(target, row1);
+		_mm_storeh_pi((__m64*)(target + 4), tail01);
+		target += outStride;
+		_mm_storeu_ps(target, row2);
+		_mm_storel_pi((__m64*)(target + 4), tail23);
+		target += outStride;
+		_mm_storeu_ps(target, row3);
+		_mm_storeh_pi((__m64*)(target + 4), tail23);
+	}
+#endif
+
+	for (; i < count; i++) {
+		BuildAffineTransform(pos[i], facing[i], scale[i], pivot != nullptr ? pivot[i] : 0.0f, out + i * outStride);
+	}
+}
+
+/// <summary>
+/// Turns an offset into the frame of something facing a direction and adds it to a position. The
+/// frame's y axis is the facing and its x axis is the facing turned a quarter turn clockwise
+/// </summary>
+/// <param name="pos">Origin of the frame</param>
+/// <param name="facing">Unit vector the frame faces</param>
+/// <param name="offset">Point in the frame</param>
+/// <returns>World position of the point</returns>
+glm::vec2 FacingPoint(glm::vec2 pos, glm::vec2 facing, glm::vec2 offset) {
+	return glm::vec2(pos.x + facing.y * offset.x + facing.x * offset.y, pos.y - facing.x * offset.x + facing.y * offset.y);
+}
+
+/// <summary>
+/// Builds the full model matrix of a sprite facing a direction, for code that still draws with a mat4
+/// </summary>
+/// <param name="pos">Position of the sprite</param>
+/// <param name="facing">Unit vector the sprite faces</param>
+/// <param name="scale">Half extents of the sprite</param>
+/// <returns>Model matrix equal to translate, rotate, and scale by the same amounts</returns>
+glm::mat4 FacingMatrix(glm::vec2 pos, glm::vec2 facing, glm::vec2 scale) {
+	glm::mat4 model(1.0f);
+	model[0] = glm::vec4(facing.y * scale.x, -facing.x * scale.x, 0.0f, 0.0f);
+	model[1] = glm::vec4(facing.x * scale.y, facing.y * scale.y, 0.0f, 0.0f);
+	model[3] = glm::vec4(pos, 0.0f, 1.0f);
+	return model;
+}
+
+/// <summary>
+/// Builds the same spread of transforms, with and without a pivot, through glm::mat4 from angles the
+/// way sprites used to be built and through BuildAffineTransforms from facings, and keeps the fastest of several runs of each
+/// </summary>
+/// <param name="transforms">Number of transforms built per run</param>
+/// <returns>Time per transform of each path</returns>
+AffineBenchmark BenchmarkAffineKernel(size_t transforms) {
+	typedef std::chrono::steady_clock Clock;
+
+	std::vector<glm::vec2> pos(transforms), scale(transforms);
+	std::vector<float> rotation(transforms), pivot(transforms);
+	for (size_t i = 0; i < transforms; i++) {
+		pos[i] = glm::vec2((float)(i * 7 % 800), (float)(i * 13 % 600));
+		rotation[i] = (float)(i * 37 % 360) - 180.0f;
+		scale[i] = glm::vec2(25.0f, 25.0f + (i % 3) * 10.0f);
+		pivot[i] = i % 5 == 0 ? -0.1f : 0.0f;
+	}
+
+	// The kernel takes the facing the same rotations give, which sprites now store instead of an angle
+	std::vector<float> radians(transforms), sines(transforms), cosines(transforms);
+	std::vector<glm::vec2> facing(transforms);
+	for (size_t i = 0; i < transforms; i++) {
+		radians[i] = glm::radians(rotation[i]);
+	}
+	FastSinCosArray(radians.data(), sines.data(), cosines.data(), transforms);
+	for (size_t i = 0; i < transforms; i++) {
+		facing[i] = glm::vec2(-sines[i], cosines[i]);
+	}
+
+	std::vector<glm::mat4> matrices(transforms);
+	std::vector<float> affines(transforms * AFFINE_FLOATS);
+	double mat4Best = 0.0, kernelBest = 0.0;
+
+	for (int run = 0; run < BENCHMARK_RUNS; run++) {
+		Clock::time_point start = Clock::now();
+		for (size_t i = 0; i < transforms; i++) {
+			glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(pos[i], 0.0f));
+			model = glm::translate(model, glm::vec3(0.0f, pivot[i], 0.0f));
+			model = glm::rotate(model, glm::radians(rotation[i]), glm::vec3(0.0f, 0.0f, 1.0f));
+			model = glm::translate(model, glm::vec3(0.0f, -pivot[i], 0.0f));
+			matrices[i] = glm::scale(model, glm::vec3(scale[i], 1.0f));
+		}
+		Clock::time_point middle = Clock::now();
+		BuildAffineTransforms(pos.data(), facing.data(), scale.data(), pivot.data(), transforms, affines.data(), AFFINE_FLOATS);
+		Clock::time_point end = Clock::now();
+
+		double mat4Ns = std::chrono::duration<double, std::nano>(middle - start).count();
+		double kernelNs = std::chrono::duration<double, std::nano>(end - middle).count();
+		mat4Best = run == 0 ? mat4Ns : std::min(mat4Best, mat4Ns);
+		kernelBest = run == 0 ? kernelNs : std::min(kernelBest, kernelNs);
+	}
+
+	if (transforms > 0) {
+		benchmarkSink = matrices[transforms / 2][3][0] + affines[(transforms / 2) * AFFINE_FLOATS + 2];
+	}
+
+	AffineBenchmark result;
+	result.transforms = transforms;
+	result.mat4Ns = transforms > 0 ? mat4Best / transforms : 0.0;
+	result.kernelNs = transforms > 0 ? kernelBest / transforms : 0.0;
+	return result;
+}
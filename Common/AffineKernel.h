@@ -0,0 +1,51 @@
+//*****************************************************************************
+// AffineKernel.h
+//
+// Author: Kyle Manning
+//
+// Brief Description: Header for the batched 2D transform kernel, which builds
+//					  packed 2x3 affine transforms for instanced drawing, and
+//					  the helpers for points and matrices in the frame of
+//					  something facing a direction
+//*****************************************************************************
+#pragma once
+
+#include <cstddef>
+
+#include <glm/glm.hpp>
+
+// Floats in one packed transform: x' = m[0] * x + m[1] * y + m[2], y' = m[3] * x + m[4] * y + m[5]
+const int AFFINE_FLOATS = 6;
+
+// Nanoseconds per transform for each way of building one, from BenchmarkAffineKernel
+struct AffineBenchmark {
+	size_t transforms;
+	double mat4Ns;
+	double kernelNs;
+};
+
+/* A 2D sprite transform is a translation, a rotation, and a scale, which only needs six floats.
+*  Sprites store the way they face as a unit vector rather than an angle, and that vector already
+*  is the rotated y axis, so building a transform takes no trig at all. BuildAffineTransforms does
+*  a whole array in one pass: with SSE2 it takes four transforms at a time and writes the six
+*  floats of each straight to where the GPU will read them. Without SSE2 it falls back to the
+*  same math one transform at a time.
+*
+*  A facing of (0, 1) is no rotation. Any other facing turns the sprite so its local +y points
+*  along it, the same as glm::rotate about z by the angle between the two.
+*/
+
+// Builds the packed transform of count sprites: scaled by scale[i], turned to face facing[i] about
+// a point pivot[i] above the center, and moved to pos[i]. pivot may be null for no pivot.
+// Each transform is written at out + i * outStride, so it can be interleaved with other instance data
+void BuildAffineTransforms(const glm::vec2* pos, const glm::vec2* facing, const glm::vec2* scale, const float* pivot, size_t count,
+	float* out, size_t outStride);
+
+// Point at offset in the frame of something at pos facing facing, e.g. a muzzle in front of a shooter
+glm::vec2 FacingPoint(glm::vec2 pos, glm::vec2 facing, glm::vec2 offset);
+
+// Model matrix of a sprite at pos facing facing with half extents scale
+glm::mat4 FacingMatrix(glm::vec2 pos, glm::vec2 facing, glm::vec2 scale);
+
+// Times glm::mat4 translate, rotate, and scale against BuildAffineTransforms on the same transforms
+AffineBenchmark BenchmarkAffineKernel(size_t transforms);
@@ -0,0 +1,343 @@
+//*****************************************************************************
+// AllocTracker.cpp
+//
+// Author: Kyle Manning
+//
+// Brief Description: Contains the replacement global operator new and delete,
+//					  the per-tag and per-frame counters they update, and the
+//					  trace export for the allocation tracker
+//*****************************************************************************
+#include "AllocTracker.h"
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+// Counters updated by every thread; only ever zeroed by BeginFrame on the main thread
+struct AtomicCounts {
+	std::atomic<unsigned long long> calls;
+	std::atomic<unsigned long long> bytes;
+	std::atomic<unsigned long long> frees;
+	std::atomic<unsigned long long> resourceCalls;
+	std::atomic<unsigned long long> resourceBytes;
+};
+
+// One closed frame as written to the trace
+struct TraceFrame {
+	double timeUs;
+	AllocCounts tags[ALLOC_TAG_COUNT];
+	unsigned long long hotAllocations;
+};
+
+// All plain statics with constant initialization, so they are ready before any constructor that
+// allocates runs and are never destroyed before the last delete
+static AtomicCounts frameCounts[ALLOC_TAG_COUNT];
+static std::atomic<unsigned long long> frameHotAllocations;
+static std::atomic<bool> steadyState;
+
+static AllocFrameStats lastFrame;
+static AllocFrameStats totals;
+static TraceFrame traceFrames[ALLOC_TRACE_FRAMES];
+static int traceCount;
+static int traceNext;
+
+static thread_local AllocTag currentTag = ALLOC_UNTAGGED;
+static thread_local bool currentHot = false;
+// Set while reporting a hot allocation, since printing may allocate itself
+static thread_local bool reporting = false;
+
+/// <summary>
+/// Stops in the debugger, or ends the program when none is attached
+/// </summary>
+static void TrapAllocation() {
+#if defined(_MSC_VER)
+	__debugbreak();
+#elif defined(SIGTRAP)
+	std::raise(SIGTRAP);
+#else
+	std::abort();
+#endif
+}
+
+/// <summary>
+/// Charges an allocation to the thread's tag and traps if it happened in a hot scope in steady state
+/// </summary>
+/// <param name="bytes">Bytes requested</param>
+static void RecordAllocation(size_t bytes) {
+	AtomicCounts& counts = frameCounts[currentTag];
+	counts.calls.fetch_add(1, std::memory_order_relaxed);
+	counts.bytes.fetch_add(bytes, std::memory_order_relaxed);
+
+	if (currentHot && !reporting && steadyState.load(std::memory_order_relaxed)) {
+		frameHotAllocations.fetch_add(1, std::memory_order_relaxed);
+
+		reporting = true;
+		std::cout << "ERROR::ALLOC_TRACKER::HOT_ALLOCATION " << bytes << " bytes in " << AllocTracker::TagName(currentTag) << std::endl;
+		reporting = false;
+
+		TrapAllocation();
+	}
+}
+
+static void RecordFree() {
+	frameCounts[currentTag].frees.fetch_add(1, std::memory_order_relaxed);
+}
+
+#ifndef NO_ALLOC_TRACKING
+
+/// <summary>
+/// Allocates with malloc, or the platform's aligned allocator for over-aligned types, and counts
+/// the allocation
+/// </summary>
+/// <param name="bytes">Bytes requested</param>
+/// <param name="alignment">Alignment requested, or 0 for the default</param>
+/// <returns>Allocated memory, or nullptr on failure</returns>
+static void* TrackedAlloc(size_t bytes, size_t alignment) {
+	RecordAllocation(bytes);
+
+	if (bytes == 0) {
+		bytes = 1;
+	}
+
+	if (alignment == 0) {
+		return std::malloc(bytes);
+	}
+
+#if defined(_MSC_VER)
+	return _aligned_malloc(bytes, alignment);
+#else
+	// aligned_alloc needs a size that is a multiple of the alignment
+	return std::aligned_alloc(alignment, (bytes + alignment - 1) & ~(alignment - 1));
+#endif
+}
+
+static void TrackedFree(void* pointer, bool aligned) {
+	if (pointer == nullptr) {
+		return;
+	}
+
+	RecordFree();
+
+#if defined(_MSC_VER)
+	if (aligned) {
+		_aligned_free(pointer);
+		return;
+	}
+#else
+	// free releases aligned_alloc memory too
+	(void)aligned;
+#endif
+	std::free(pointer);
+}
+
+static void* TrackedNew(size_t bytes, size_t alignment) {
+	void* pointer = TrackedAlloc(bytes, alignment);
+	if (pointer == nullptr) {
+		throw std::bad_alloc();
+	}
+	return pointer;
+}
+
+void* operator new(size_t bytes) { return TrackedNew(bytes, 0); }
+void* operator new[](size_t bytes) { return TrackedNew(bytes, 0); }
+void* operator new(size_t bytes, const std::nothrow_t&) noexcept { return TrackedAlloc(bytes, 0); }
+void* operator new[](size_t bytes, const std::nothrow_t&) noexcept { return TrackedAlloc(bytes, 0); }
+void* operator new(size_t bytes, std::align_val_t alignment) { return TrackedNew(bytes, (size_t)alignment); }
+void* operator new[](size_t bytes, std::align_val_t alignment) { return TrackedNew(bytes, (size_t)alignment); }
+
+void operator delete(void* pointer) noexcept { TrackedFree(pointer, false); }
+void operator delete[](void* pointer) noexcept { TrackedFree(pointer, false); }
+void operator delete(void* pointer, size_t) noexcept { TrackedFree(pointer, false); }
+void operator delete[](void* pointer, size_t) noexcept { TrackedFree(pointer, false); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { TrackedFree(pointer, false); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { TrackedFree(pointer, false); }
+void operator delete(void* pointer, std::align_val_t) noexcept { TrackedFree(pointer, true); }
+void operator delete[](void* pointer, std::align_val_t) noexcept { TrackedFree(pointer, true); }
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept { TrackedFree(pointer, true); }
+void operator delete[](void* pointer, size_t, std::align_val_t) noexcept { TrackedFree(pointer, true); }
+
+#endif
+
+/// <summary>
+/// Moves the counters of the frame that just ended into lastFrame and the totals, and stores them
+/// in the trace ring with the time the frame ended
+/// </summary>
+void AllocTracker::BeginFrame() {
+	static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	AllocFrameStats frame = {};
+	frame.frame = totals.frame;
+
+	for (int tag = 0; tag < ALLOC_TAG_COUNT; tag++) {
+		AllocCounts& counts = frame.tags[tag];
+		counts.calls = frameCounts[tag].calls.exchange(0, std::memory_order_relaxed);
+		counts.bytes = frameCounts[tag].bytes.exchange(0, std::memory_order_relaxed);
+		counts.frees = frameCounts[tag].frees.exchange(0, std::memory_order_relaxed);
+		counts.resourceCalls = frameCounts[tag].resourceCalls.exchange(0, std::memory_order_relaxed);
+		counts.resourceBytes = frameCounts[tag].resourceBytes.exchange(0, std::memory_order_relaxed);
+
+		frame.total.calls += counts.calls;
+		frame.total.bytes += counts.bytes;
+		frame.total.frees += counts.frees;
+		frame.total.resourceCalls += counts.resourceCalls;
+		frame.total.resourceBytes += counts.resourceBytes;
+
+		totals.tags[tag].calls += counts.calls;
+		totals.tags[tag].bytes += counts.bytes;
+		totals.tags[tag].frees += counts.frees;
+		totals.tags[tag].resourceCalls += counts.resourceCalls;
+		totals.tags[tag].resourceBytes += counts.resourceBytes;
+	}
+	frame.hotAllocations = frameHotAllocations.exchange(0, std::memory_order_relaxed);
+
+	totals.total.calls += frame.total.calls;
+	totals.total.bytes += frame.total.bytes;
+	totals.total.frees += frame.total.frees;
+	totals.total.resourceCalls += frame.total.resourceCalls;
+	totals.total.resourceBytes += frame.total.resourceBytes;
+	totals.hotAllocations += frame.hotAllocations;
+	totals.frame += 1;
+
+	lastFrame = frame;
+
+	TraceFrame& trace = traceFrames[traceNext];
+	trace.timeUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+	for (int tag = 0; tag < ALLOC_TAG_COUNT; tag++) {
+		trace.tags[tag] = frame.tags[tag];
+	}
+	trace.hotAllocations = frame.hotAllocations;
+
+	traceNext = (traceNext + 1) % ALLOC_TRACE_FRAMES;
+	if (traceCount < ALLOC_TRACE_FRAMES) {
+		traceCount += 1;
+	}
+}
+
+AllocFrameStats AllocTracker::LastFrame() {
+	return lastFrame;
+}
+
+AllocFrameStats AllocTracker::Totals() {
+	return totals;
+}
+
+void AllocTracker::SetSteadyState(bool enabled) {
+	steadyState.store(enabled, std::memory_order_relaxed);
+}
+
+bool AllocTracker::SteadyState() {
+	return steadyState.load(std::memory_order_relaxed);
+}
+
+void AllocTracker::RecordResource(AllocTag tag, size_t bytes) {
+	frameCounts[tag].resourceCalls.fetch_add(1, std::memory_order_relaxed);
+	frameCounts[tag].resourceBytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+AllocTag AllocTracker::CurrentTag() {
+	return currentTag;
+}
+
+bool AllocTracker::CurrentHot() {
+	return currentHot;
+}
+
+/// <summary>
+/// Writes the recorded frames, oldest first, as three counter tracks in the Chrome trace event
+/// format: heap calls and heap bytes with one series per tag, and hot allocations. The file can be
+/// opened on its own or loaded next to a CPU trace of the same run
+/// </summary>
+/// <param name="path">File to write</param>
+/// <returns>Whether the file could be written</returns>
+bool AllocTracker::WriteTrace(const char* path) {
+	FILE* file = fopen(path, "w");
+	if (file == nullptr) {
+		std::cout << "ERROR::ALLOC_TRACKER::TRACE_NOT_WRITTEN " << path << std::endl;
+		return false;
+	}
+
+	fprintf(file, "{\"traceEvents\":[\n");
+
+	int first = (traceNext - traceCount + ALLOC_TRACE_FRAMES) % ALLOC_TRACE_FRAMES;
+	for (int i = 0; i < traceCount; i++) {
+		const TraceFrame& trace = traceFrames[(first + i) % ALLOC_TRACE_FRAMES];
+
+		fprintf(file, "%s{\"name\":\"Heap calls\",\"ph\":\"C\",\"pid\":1,\"tid\":1,\"ts\":%.1f,\"args\":{", i == 0 ? "" : ",\n", trace.timeUs);
+		for (int tag = 0; tag < ALLOC_TAG_COUNT; tag++) {
+			fprintf(file, "%s\"%s\":%llu", tag == 0 ? "" : ",", TagName((AllocTag)tag), trace.tags[tag].calls);
+		}
+
+		fprintf(file, "}},\n{\"name\":\"Heap bytes\",\"ph\":\"C\",\"pid\":1,\"tid\":1,\"ts\":%.1f,\"args\":{", trace.timeUs);
+		for (int tag = 0; tag < ALLOC_TAG_COUNT; tag++) {
+			fprintf(file, "%s\"%s\":%llu", tag == 0 ? "" : ",", TagName((AllocTag)tag), trace.tags[tag].bytes);
+		}
+
+		fprintf(file, "}},\n{\"name\":\"Hot allocations\",\"ph\":\"C\",\"pid\":1,\"tid\":1,\"ts\":%.1f,\"args\":{\"count\":%llu}}",
+			trace.timeUs, trace.hotAllocations);
+	}
+
+	fprintf(file, "\n]}\n");
+	fclose(file);
+	return true;
+}
+
+const char* AllocTracker::TagName(AllocTag tag) {
+	switch (tag) {
+		case ALLOC_UNTAGGED:
+			return "untagged";
+		case ALLOC_UPDATE:
+			return "update";
+		case ALLOC_COLLISION:
+			return "collision";
+		case ALLOC_RENDER:
+			return "render";
+		case ALLOC_UI:
+			return "ui";
+		case ALLOC_SPAWN:
+			return "spawn";
+		case ALLOC_ASSETS:
+			return "assets";
+		default:
+			return "unknown";
+	}
+}
+
+/// <summary>
+/// Constructor for AllocScopes; remembers the thread's tag so the destructor can put it back
+/// </summary>
+/// <param name="tag">Tag to charge allocations to</param>
+/// <param name="hot">Whether allocations here are trapped in steady state mode</param>
+AllocScope::AllocScope(AllocTag tag, bool hot) : previousTag(currentTag), previousHot(currentHot) {
+	currentTag = tag;
+	currentHot = hot;
+}
+
+AllocScope::~AllocScope() {
+	currentTag = previousTag;
+	currentHot = previousHot;
+}
+
+/// <summary>
+/// Constructor for TrackedResources
+/// </summary>
+/// <param name="upstream">Resource the memory actually comes from</param>
+/// <param name="tag">Tag the memory is charged to</param>
+TrackedResource::TrackedResource(std::pmr::memory_resource* upstream, AllocTag tag) : upstream(upstream), tag(tag) {
+}
+
+void* TrackedResource::do_allocate(size_t bytes, size_t alignment) {
+	AllocTracker::RecordResource(tag, bytes);
+	return upstream->allocate(bytes, alignment);
+}
+
+void TrackedResource::do_deallocate(void* pointer, size_t bytes, size_t alignment) {
+	upstream->deallocate(pointer, bytes, alignment);
+}
+
+bool TrackedResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+	return this == &other;
+}
@@ -0,0 +1,122 @@
+//*****************************************************************************
+// AllocTracker.h
+//
+// Author: Kyle Manning
+//
+// Brief Description: Header for the heap allocation tracker used by Geometry
+//					  Shooter, which counts allocations per frame and per
+//					  tagged scope through the global operator new
+//*****************************************************************************
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+
+// Subsystem an allocation is charged to, set by the innermost AllocScope on the thread
+enum AllocTag {
+	ALLOC_UNTAGGED,
+	ALLOC_UPDATE,
+	ALLOC_COLLISION,
+	ALLOC_RENDER,
+	ALLOC_UI,
+	ALLOC_SPAWN,
+	ALLOC_ASSETS,
+	ALLOC_TAG_COUNT
+};
+
+// Passed to AllocScope for loops that must not allocate once the game reaches steady state
+const bool ALLOC_HOT = true;
+
+// Frames kept for the trace written by WriteTrace; 30 seconds at 60 frames per second
+const int ALLOC_TRACE_FRAMES = 1800;
+
+// Heap calls and bytes for one tag, and memory taken from tracked pmr resources
+struct AllocCounts {
+	unsigned long long calls;
+	unsigned long long bytes;
+	unsigned long long frees;
+	unsigned long long resourceCalls;
+	unsigned long long resourceBytes;
+};
+
+// Counts per tag and in total over one frame, or over the whole run
+struct AllocFrameStats {
+	AllocCounts tags[ALLOC_TAG_COUNT];
+	AllocCounts total;
+	unsigned long long frame;
+	// Allocations made inside hot scopes while in steady state mode
+	unsigned long long hotAllocations;
+};
+
+/* Replaces the global operator new and delete so every heap allocation in the program is counted,
+*  charged to the tag of the innermost AllocScope on the allocating thread. Counts are kept per
+*  frame and in total; BeginFrame closes one frame and records it for the trace.
+*
+*  In steady state mode any heap allocation inside a scope marked ALLOC_HOT is reported and
+*  trapped, so a debugger stops on the call that allocated. The mode is meant to be turned on
+*  once loading is done and every pool has grown to its working size.
+*
+*  Building with NO_ALLOC_TRACKING leaves the global operators alone and every count at zero.
+*/
+class AllocTracker {
+public:
+	// Closes the current frame, recording it for the overlay and the trace; call at the top of each frame
+	static void BeginFrame();
+
+	// Counts for the last frame that was closed
+	static AllocFrameStats LastFrame();
+
+	// Counts since the program started
+	static AllocFrameStats Totals();
+
+	// Turns trapping on hot allocations on or off
+	static void SetSteadyState(bool enabled);
+	static bool SteadyState();
+
+	// Charges memory taken from a pmr resource to a tag; used by TrackedResource
+	static void RecordResource(AllocTag tag, size_t bytes);
+
+	// Tag and hot flag of the innermost AllocScope on the calling thread, so work handed to another
+	// thread can be charged the same way
+	static AllocTag CurrentTag();
+	static bool CurrentHot();
+
+	// Writes the recorded frames as Chrome trace counter events, viewable in chrome://tracing or Perfetto
+	static bool WriteTrace(const char* path);
+
+	// Short name of a tag for reports
+	static const char* TagName(AllocTag tag);
+};
+
+/* Charges heap allocations on this thread to a tag until it goes out of scope, then restores the
+*  tag it replaced. Scopes nest; a scope that is not hot inside a hot one allows allocations there,
+*  which is how asset streaming is let through inside the update loop.
+*/
+class AllocScope {
+public:
+	explicit AllocScope(AllocTag tag, bool hot = false);
+	~AllocScope();
+
+	AllocScope(const AllocScope&) = delete;
+	AllocScope& operator=(const AllocScope&) = delete;
+
+private:
+	AllocTag previousTag;
+	bool previousHot;
+};
+
+/* Passes allocations through to another pmr resource, charging them to a tag, so traffic into an
+*  arena shows up next to the heap traffic it replaced.
+*/
+class TrackedResource : public std::pmr::memory_resource {
+public:
+	TrackedResource(std::pmr::memory_resource* upstream, AllocTag tag);
+
+private:
+	std::pmr::memory_resource* upstream;
+	AllocTag tag;
+
+	void* do_allocate(size_t bytes, size_t alignment) override;
+	void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+};
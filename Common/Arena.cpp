@@ -0,0 +1,132 @@
+//*****************************************************************************
+// Arena.cpp
+//
+// Author: Kyle Manning
+//
+// Brief Description: Contains methods for MonotonicArena objects, which bump
+//					  allocate from a list of blocks and rewind to the first
+//					  block on Reset
+//*****************************************************************************
+#include "Arena.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+/// <summary>
+/// Rounds an address up to a multiple of alignment
+/// </summary>
+/// <param name="address">Address to round</param>
+/// <param name="alignment">Power of two to round to</param>
+/// <returns>Aligned address</returns>
+static size_t AlignUp(size_t address, size_t alignment) {
+	return (address + alignment - 1) & ~(alignment - 1);
+}
+
+/// <summary>
+/// Constructor for MonotonicArenas; the first block is allocated right away so the first wave
+/// does not have to
+/// </summary>
+/// <param name="blockSize">Size of the first block, and the smallest size of any later one</param>
+MonotonicArena::MonotonicArena(size_t blockSize) : blockSize(blockSize), current(0), offset(0), used(0), highWater(0), resets(0), liveAllocations(0) {
+	blocks.push_back({ new unsigned char[blockSize], blockSize });
+}
+
+MonotonicArena::~MonotonicArena() {
+	for (Block& block : blocks) {
+		delete[] block.data;
+	}
+}
+
+/// <summary>
+/// Rewinds to the start of the first block; the blocks themselves are kept for the next use. Only
+/// builds without NDEBUG touch the memory, to poison what was handed out
+/// </summary>
+void MonotonicArena::Reset() {
+#ifndef NDEBUG
+	for (size_t i = 0; i < current; i++) {
+		memset(blocks[i].data, ARENA_POISON, blocks[i].size);
+	}
+	memset(blocks[current].data, ARENA_POISON, offset);
+#endif
+
+	current = 0;
+	offset = 0;
+	used = 0;
+	resets += 1;
+	liveAllocations = 0;
+}
+
+ArenaStats MonotonicArena::GetStats() const {
+	ArenaStats stats = { 0, used, highWater, (int)blocks.size(), resets, liveAllocations };
+	for (const Block& block : blocks) {
+		stats.capacity += block.size;
+	}
+	return stats;
+}
+
+/// <summary>
+/// Bumps the offset in the current block past the allocation, moving on to the next block when
+/// the current one is full; padding for alignment counts toward the bytes used
+/// </summary>
+/// <param name="bytes">Bytes requested</param>
+/// <param name="alignment">Alignment requested, a power of two</param>
+/// <returns>Pointer into one of the blocks</returns>
+void* MonotonicArena::do_allocate(size_t bytes, size_t alignment) {
+	size_t base = (size_t)blocks[current].data;
+	size_t start = AlignUp(base + offset, alignment) - base;
+
+	if (start + bytes > blocks[current].size) {
+		used += blocks[current].size - offset;
+		current = NextBlock(bytes, alignment);
+		offset = 0;
+
+		base = (size_t)blocks[current].data;
+		start = AlignUp(base, alignment) - base;
+	}
+
+	used += start + bytes - offset;
+	highWater = std::max(highWater, used);
+	offset = start + bytes;
+	liveAllocations += 1;
+
+	return blocks[current].data + start;
+}
+
+/// <summary>
+/// Only counts the allocation as released, since the memory comes back on Reset; a container
+/// that grows leaves its old storage behind, which is poisoned in builds without NDEBUG
+/// </summary>
+void MonotonicArena::do_deallocate(void* pointer, size_t bytes, size_t) {
+	liveAllocations -= 1;
+
+#ifndef NDEBUG
+	memset(pointer, ARENA_POISON, bytes);
+#else
+	(void)pointer;
+	(void)bytes;
+#endif
+}
+
+bool MonotonicArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+	return this == &other;
+}
+
+/// <summary>
+/// Moves to the block after the current one if it can hold the allocation, and otherwise puts a
+/// new block there that can
+/// </summary>
+/// <param name="bytes">Bytes of the allocation that did not fit</param>
+/// <param name="alignment">Alignment of the allocation</param>
+/// <returns>Index of the block to allocate from</returns>
+size_t MonotonicArena::NextBlock(size_t bytes, size_t alignment) {
+	size_t next = current + 1;
+
+	if (next < blocks.size() && blocks[next].size >= bytes + alignment) {
+		return next;
+	}
+
+	size_t size = std::max(blockSize, bytes + alignment);
+	blocks.insert(blocks.begin() + next, { new unsigned char[size], size });
+	return next;
+}
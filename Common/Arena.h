@@ -0,0 +1,73 @@
+//*****************************************************************************
+// Arena.h
+//
+// Author: Kyle Manning
+//
+// Brief Description: Header for MonotonicArena, a bump allocator used by
+//					  Geometry Shooter that frees everything it handed out at
+//					  once
+//*****************************************************************************
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+// Byte written over memory the arena has taken back, in builds without NDEBUG
+const unsigned char ARENA_POISON = 0xDD;
+
+// How much of the arena is in use now and at most since it was created
+struct ArenaStats {
+	size_t capacity;
+	size_t used;
+	size_t highWater;
+	int blocks;
+	unsigned long long resets;
+	// Allocations not yet deallocated; containers still holding arena memory
+	int liveAllocations;
+};
+
+/* Hands out memory by moving an offset through large blocks, and takes all of it back in one
+*  step with Reset. Individual deallocations do nothing, so it suits objects that all die at the
+*  same time, such as everything spawned for one wave. Blocks are kept across resets, so once
+*  the arena has grown to the largest wave it never calls the heap again. It is a pmr memory
+*  resource, so standard containers can allocate from it directly.
+*
+*  Builds without NDEBUG fill released and deallocated memory with ARENA_POISON, so anything
+*  still pointing into the arena after a reset reads obvious garbage.
+*/
+class MonotonicArena : public std::pmr::memory_resource {
+public:
+	// Creates the arena with one block; more blocks of at least blockSize are added when it fills
+	explicit MonotonicArena(size_t blockSize);
+	~MonotonicArena();
+
+	MonotonicArena(const MonotonicArena&) = delete;
+	MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+	// Takes back everything allocated since the last reset; nothing allocated before may be used after
+	void Reset();
+
+	ArenaStats GetStats() const;
+
+private:
+	struct Block {
+		unsigned char* data;
+		size_t size;
+	};
+
+	size_t blockSize;
+	std::vector<Block> blocks;
+	// Block being filled and the bytes used in it
+	size_t current, offset;
+	size_t used, highWater;
+	unsigned long long resets;
+	int liveAllocations;
+
+	void* do_allocate(size_t bytes, size_t alignment) override;
+	void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+	// Returns the block to move to when the current one cannot fit bytes, adding one if needed
+	size_t NextBlock(size_t bytes, size_t alignment);
+};
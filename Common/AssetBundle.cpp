@@ -0,0 +1,233 @@
+//*****************************************************************************
+// AssetBundle.cpp
+//
+// Author: Kyle Manning
+//
+// Brief Description: Contains methods for AssetBundle objects, which map a
+//					  packed asset file read-only and look up its entries;
+//					  uses MapViewOfFile on Windows and mmap elsewhere
+//*****************************************************************************
+#include "AssetBundle.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/// <summary>
+/// Default constructor for AssetBundles; nothing is mapped until Open is called
+/// </summary>
+AssetBundle::AssetBundle() : mapping(nullptr), mappedSize(0), entries(nullptr), entryCount(0) {
+#ifdef _WIN32
+	file = INVALID_HANDLE_VALUE;
+	fileMapping = nullptr;
+#endif
+}
+
+AssetBundle::~AssetBundle() {
+	Close();
+}
+
+/// <summary>
+/// Maps the whole bundle file read-only and validates the header and entry table
+/// </summary>
+/// <param name="path">File name/path of the bundle</param>
+/// <returns>True if the bundle was mapped and is the current version</returns>
+bool AssetBundle::Open(const std::string& path) {
+	Close();
+
+#ifdef _WIN32
+	file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	GetFileSizeEx(file, &fileSize);
+	mappedSize = (size_t)fileSize.QuadPart;
+
+	fileMapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (fileMapping != nullptr) {
+		mapping = (const unsigned char*)MapViewOfFile(fileMapping, FILE_MAP_READ, 0, 0, 0);
+	}
+#else
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(fd, &info) == 0 && info.st_size > 0) {
+		mappedSize = (size_t)info.st_size;
+		void* view = mmap(NULL, mappedSize, PROT_READ, MAP_PRIVATE, fd, 0);
+		mapping = view == MAP_FAILED ? nullptr : (const unsigned char*)view;
+	}
+
+	// The mapping keeps the file alive, so the descriptor is not needed anymore
+	close(fd);
+#endif
+
+	if (mapping == nullptr || mappedSize < sizeof(BundleHeader)) {
+		std::cout << "ERROR::ASSET_BUNDLE::MAP_FAILED " << path << std::endl;
+		Close();
+		return false;
+	}
+
+	const BundleHeader* header = (const BundleHeader*)mapping;
+	if (memcmp(header->magic, BUNDLE_MAGIC, sizeof(BUNDLE_MAGIC)) != 0 || header->version != BUNDLE_VERSION ||
+		sizeof(BundleHeader) + (size_t)header->entryCount * sizeof(BundleEntry) > mappedSize) {
+		std::cout << "ERROR::ASSET_BUNDLE::INVALID_OR_OUTDATED " << path << std::endl;
+		Close();
+		return false;
+	}
+
+	entryCount = header->entryCount;
+	entries = (const BundleEntry*)(mapping + sizeof(BundleHeader));
+
+	for (uint32_t i = 0; i < entryCount; i++) {
+		if (entries[i].offset > mappedSize || entries[i].size > mappedSize - entries[i].offset) {
+			std::cout << "ERROR::ASSET_BUNDLE::TRUNCATED " << path << std::endl;
+			Close();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Unmaps the bundle and releases its handles
+/// </summary>
+void AssetBundle::Close() {
+#ifdef _WIN32
+	if (mapping != nullptr) {
+		UnmapViewOfFile(mapping);
+	}
+	if (fileMapping != nullptr) {
+		CloseHandle(fileMapping);
+		fileMapping = nullptr;
+	}
+	if (file != INVALID_HANDLE_VALUE) {
+		CloseHandle(file);
+		file = INVALID_HANDLE_VALUE;
+	}
+#else
+	if (mapping != nullptr) {
+		munmap((void*)mapping, mappedSize);
+	}
+#endif
+
+	mapping = nullptr;
+	mappedSize = 0;
+	entries = nullptr;
+	entryCount = 0;
+}
+
+bool AssetBundle::IsOpen() const {
+	return mapping != nullptr;
+}
+
+/// <summary>
+/// Finds an entry by the name it was packed with. An entry from a truncated or stale bundle whose
+/// data would not hold what its header describes is passed over, so the caller falls back to the
+/// loose file instead of reading past the entry
+/// </summary>
+/// <param name="name">File name of the asset, "file@size" for fonts</param>
+/// <param name="type">Kind of entry expected</param>
+/// <returns>Entry record inside the mapping, or nullptr if there is no usable match</returns>
+const BundleEntry* AssetBundle::Find(const std::string& name, BundleEntryType type) const {
+	for (uint32_t i = 0; i < entryCount; i++) {
+		if (entries[i].type == type && strncmp(entries[i].name, name.c_str(), BUNDLE_NAME_LENGTH) == 0) {
+			if (!SizeMatches(entries[i])) {
+				std::cout << "ERROR::ASSET_BUNDLE::ENTRY_SIZE_MISMATCH " << name << std::endl;
+				return nullptr;
+			}
+			return &entries[i];
+		}
+	}
+
+	return nullptr;
+}
+
+/// <summary>
+/// Returns where an entry's data starts in the mapping
+/// </summary>
+/// <param name="entry">Entry returned by Find</param>
+/// <returns>Pointer to the first byte of the entry's data</returns>
+const unsigned char* AssetBundle::Data(const BundleEntry& entry) const {
+	return mapping + entry.offset;
+}
+
+size_t AssetBundle::MappedBytes() const {
+	return mappedSize;
+}
+
+/// <summary>
+/// Adds up the sizes of the mip levels before the given one
+/// </summary>
+/// <param name="entry">RGBA8 texture entry</param>
+/// <param name="level">Mip level, 0 for the full size image</param>
+/// <returns>Byte offset of the level from the start of the entry's data</returns>
+size_t AssetBundle::LevelOffset(const BundleEntry& entry, int level) {
+	size_t offset = 0;
+	for (int i = 0; i < level; i++) {
+		offset += (size_t)LevelSize(entry.width, i) * LevelSize(entry.height, i) * 4;
+	}
+	return offset;
+}
+
+/// <summary>
+/// Halves a size once per mip level, never going below 1
+/// </summary>
+/// <param name="size">Width or height of level 0</param>
+/// <param name="level">Mip level</param>
+/// <returns>Width or height of the level</returns>
+int AssetBundle::LevelSize(int size, int level) {
+	return std::max(1, size >> level);
+}
+
+/// <summary>
+/// Works out the bytes an entry must hold from its type and header fields: a texture's full mip
+/// chain up to its level count, or an atlas's glyph records followed by its pixels. Fields out of
+/// range for the type, which could overflow the sum or overrun a glyph table indexed by char,
+/// never match
+/// </summary>
+/// <param name="entry">Entry record from the bundle</param>
+/// <returns>True if the entry's size is what its fields call for</returns>
+bool AssetBundle::SizeMatches(const BundleEntry& entry) {
+	switch (entry.type) {
+		case BUNDLE_TEXTURE_RGBA8: {
+			if (entry.width == 0 || entry.height == 0 || entry.width > BUNDLE_MAX_DIMENSION || entry.height > BUNDLE_MAX_DIMENSION) {
+				return false;
+			}
+
+			uint32_t fullLevels = 1;
+			while ((std::max(entry.width, entry.height) >> fullLevels) > 0) {
+				fullLevels += 1;
+			}
+			if (entry.levels == 0 || entry.levels > fullLevels) {
+				return false;
+			}
+
+			return entry.size == LevelOffset(entry, (int)entry.levels);
+		}
+		case BUNDLE_GLYPH_ATLAS:
+			if (entry.width > BUNDLE_MAX_DIMENSION || entry.height > BUNDLE_MAX_DIMENSION || entry.levels > BUNDLE_MAX_GLYPHS) {
+				return false;
+			}
+
+			return entry.size == (uint64_t)entry.levels * sizeof(BundleGlyph) + (uint64_t)entry.width * entry.height;
+		default:
+			return true;
+	}
+}
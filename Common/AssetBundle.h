@@ -0,0 +1,107 @@
+//*****************************************************************************
+// AssetBundle.h
+//
+// Author: Kyle Manning
+//
+// Brief Description: Header for the asset bundle file format and AssetBundle
+//					  objects, which memory map a bundle written by the asset
+//					  packer and hand out pointers straight into the mapping
+//*****************************************************************************
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/* Layout of a bundle file:
+*  BundleHeader, then entryCount BundleEntry records, then the entry data. Each entry's data
+*  starts on a BUNDLE_ALIGNMENT boundary so it can be passed to GL without copying.
+*/
+const char BUNDLE_MAGIC[4] = { 'G', 'S', 'A', 'B' };
+
+// Bumped whenever the layout of the header, entries, or entry data changes
+const uint32_t BUNDLE_VERSION = 1;
+
+const size_t BUNDLE_NAME_LENGTH = 64;
+const size_t BUNDLE_ALIGNMENT = 16;
+
+// Largest texture or atlas side an entry may claim, and the most glyphs an atlas may hold, one per char
+const uint32_t BUNDLE_MAX_DIMENSION = 16384;
+const uint32_t BUNDLE_MAX_GLYPHS = 256;
+
+enum BundleEntryType : uint32_t {
+	// RGBA8 mip chain, largest level first, each level tightly packed
+	BUNDLE_TEXTURE_RGBA8 = 1,
+	// levels BundleGlyph records followed by the R8 atlas pixels
+	BUNDLE_GLYPH_ATLAS = 2,
+	// GLSL source text, not null terminated
+	BUNDLE_SHADER_SOURCE = 3
+};
+
+struct BundleHeader {
+	char magic[4];
+	uint32_t version;
+	uint32_t entryCount;
+	uint32_t reserved;
+};
+
+struct BundleEntry {
+	// File name the entry was packed from; fonts are named "file@size"
+	char name[BUNDLE_NAME_LENGTH];
+	uint32_t type;
+	uint32_t width, height;
+	// Mip levels for textures, glyph count for atlases, 0 for shaders
+	uint32_t levels;
+	uint64_t offset, size;
+};
+
+struct BundleGlyph {
+	float uv[4];
+	int32_t size[2];
+	int32_t bearing[2];
+	uint32_t advance;
+};
+
+class AssetBundle {
+public:
+	AssetBundle();
+	~AssetBundle();
+
+	// Maps a bundle file and checks its header; returns false if it is missing or invalid
+	bool Open(const std::string& path);
+
+	// Unmaps the file; pointers returned by Data are invalid afterwards
+	void Close();
+
+	bool IsOpen() const;
+
+	// Returns the entry with the given name and type, or nullptr if the bundle does not have it or
+	// its size does not match what its type and header say it holds
+	const BundleEntry* Find(const std::string& name, BundleEntryType type) const;
+
+	// Returns a pointer to an entry's data inside the mapping
+	const unsigned char* Data(const BundleEntry& entry) const;
+
+	// Size of the mapping in bytes
+	size_t MappedBytes() const;
+
+	// Returns the byte offset of a mip level from the start of an RGBA8 texture entry
+	static size_t LevelOffset(const BundleEntry& entry, int level);
+
+	// Returns the width or height of a mip level
+	static int LevelSize(int size, int level);
+
+	// Returns whether an entry's size is exactly the bytes its type, size, and levels call for
+	static bool SizeMatches(const BundleEntry& entry);
+
+private:
+	const unsigned char* mapping;
+	size_t mappedSize;
+	const BundleEntry* entries;
+	uint32_t entryCount;
+#ifdef _WIN32
+	void* file;
+	void* fileMapping;
+#endif
+};
+
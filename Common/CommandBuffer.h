@@ -0,0 +1,132 @@
+//*****************************************************************************
+// CommandBuffer.h
+//
+// Author: Kyle Manning
+//
+// Brief Description: Header for CommandBuffer and CommandList, which record draw
+//					  commands as a sort key and a payload on any thread and merge
+//					  them into one sorted list for the GL thread, used by
+//					  Geometry Shooter
+//*****************************************************************************
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+/* A command is a 64 bit sort key and a payload. The key decides the order commands run in and
+*  carries whatever state the command needs, such as which program and mesh it uses; the payload
+*  holds the per-draw data. Neither knows anything about GL, so buffers can be filled on worker
+*  threads and only the code that runs the merged list makes API calls.
+*
+*  Each thread records into its own CommandBuffer and sorts it, so recording needs no locks.
+*  CommandList::Merge then does a k-way merge of the sorted buffers. Commands with the same state
+*  bits end up next to each other, and the executor only changes state when those bits change.
+*  Buffers and lists keep their capacity, so recording stops allocating once it has seen the
+*  busiest frame.
+*/
+template <class Payload>
+class CommandBuffer {
+public:
+	struct Command {
+		uint64_t key;
+		uint32_t payload;
+
+		bool operator<(const Command& other) const {
+			return key < other.key;
+		}
+	};
+
+	void Clear() {
+		commands.clear();
+		payloads.clear();
+	}
+
+	void Reserve(size_t count) {
+		commands.reserve(count);
+		payloads.reserve(count);
+	}
+
+	void Add(uint64_t key, const Payload& payload) {
+		commands.push_back({ key, (uint32_t)payloads.size() });
+		payloads.push_back(payload);
+	}
+
+	// Orders the commands by key; payloads stay where they were recorded
+	void Sort() {
+		std::sort(commands.begin(), commands.end());
+	}
+
+	size_t Size() const {
+		return commands.size();
+	}
+
+	const Command& CommandAt(size_t index) const {
+		return commands[index];
+	}
+
+	const Payload& PayloadOf(const Command& command) const {
+		return payloads[command.payload];
+	}
+
+private:
+	std::vector<Command> commands;
+	std::vector<Payload> payloads;
+};
+
+template <class Payload>
+class CommandList {
+public:
+	struct Entry {
+		uint64_t key;
+		const Payload* payload;
+	};
+
+	/// <summary>
+	/// Merges sorted buffers into this list, replacing what it held. The list points into the
+	/// buffers, so they must not change until it has been run
+	/// </summary>
+	/// <param name="buffers">Buffers, each already sorted</param>
+	/// <param name="count">Number of buffers</param>
+	void Merge(const CommandBuffer<Payload>* buffers, size_t count) {
+		entries.clear();
+
+		size_t total = 0;
+		for (size_t i = 0; i < count; i++) {
+			total += buffers[i].Size();
+		}
+		entries.reserve(total);
+
+		// Few buffers are merged at once, so the smallest head is found by scanning them all
+		heads.assign(count, 0);
+		while (entries.size() < total) {
+			size_t best = count;
+			for (size_t i = 0; i < count; i++) {
+				if (heads[i] < buffers[i].Size() &&
+					(best == count || buffers[i].CommandAt(heads[i]).key < buffers[best].CommandAt(heads[best]).key)) {
+					best = i;
+				}
+			}
+
+			const typename CommandBuffer<Payload>::Command& command = buffers[best].CommandAt(heads[best]);
+			entries.push_back({ command.key, &buffers[best].PayloadOf(command) });
+			heads[best] += 1;
+		}
+	}
+
+	void Clear() {
+		entries.clear();
+	}
+
+	size_t Size() const {
+		return entries.size();
+	}
+
+	const Entry& operator[](size_t index) const {
+		return entries[index];
+	}
+
+private:
+	std::vector<Entry> entries;
+	std::vector<size_t> heads;
+};
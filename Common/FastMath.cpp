@@ -0,0 +1,311 @@
+//*****************************************************************************
+// FastMath.cpp
+//
+// Author: Kyle Manning
+//
+// Brief Description: Contains the polynomial sine, cosine, and atan2, with
+//					  an SSE2 path for arrays and a scalar fallback, and the
+//					  checks and benchmarks that compare them with libm
+//*****************************************************************************
+#include "FastMath.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FAST_MATH_SSE2
+#include <emmintrin.h>
+#endif
+
+const float TWO_OVER_PI = 0.636619772367581f;
+const float HALF_PI = 1.57079632679490f;
+const float QUARTER_PI = 0.785398163397448f;
+const float TAN_PI_8 = 0.414213562373095f;
+
+// Pi / 2 in three parts with few enough bits that multiples of them up to FAST_SINCOS_RANGE are exact
+const float PIO2_1 = 1.5703125f;
+const float PIO2_2 = 4.837512969970703125e-4f;
+const float PIO2_3 = 7.54978995489188216e-8f;
+
+// Minimax polynomials for sine and cosine on [-pi/4, pi/4] and atan on [-tan(pi/8), tan(pi/8)], from Cephes
+const float SIN_C1 = -1.6666654611e-1f;
+const float SIN_C2 = 8.3321608736e-3f;
+const float SIN_C3 = -1.9515295891e-4f;
+const float COS_C1 = 4.166664568298827e-2f;
+const float COS_C2 = -1.388731625493765e-3f;
+const float COS_C3 = 2.443315711809948e-5f;
+const float ATAN_C1 = -3.33329491539e-1f;
+const float ATAN_C2 = 1.99777106478e-1f;
+const float ATAN_C3 = -1.38776856032e-1f;
+const float ATAN_C4 = 8.05374449538e-2f;
+
+// Runs of each timed loop in the benchmarks; the fastest is kept
+const int BENCHMARK_RUNS = 5;
+
+// Written by the benchmarks so none of their loops can be optimized away
+static volatile float benchmarkSink;
+
+/// <summary>
+/// Reduces the angle to within a quarter turn of zero, evaluates both polynomials, and lets the
+/// number of quarter turns pick which is the sine and which is the cosine, and their signs
+/// </summary>
+/// <param name="radians">Angle in radians</param>
+/// <param name="sine">Receives the sine</param>
+/// <param name="cosine">Receives the cosine</param>
+void FastSinCos(float radians, float& sine, float& cosine) {
+	int quadrant = (int)std::nearbyint(radians * TWO_OVER_PI);
+	float q = (float)quadrant;
+	float r = ((radians - q * PIO2_1) - q * PIO2_2) - q * PIO2_3;
+	float z = r * r;
+
+	float sinR = ((SIN_C3 * z + SIN_C2) * z + SIN_C1) * z * r + r;
+	float cosR = ((COS_C3 * z + COS_C2) * z + COS_C1) * z * z - 0.5f * z + 1.0f;
+
+	if (quadrant & 1) {
+		std::swap(sinR, cosR);
+	}
+	sine = (quadrant & 2) ? -sinR : sinR;
+	cosine = ((quadrant + 1) & 2) ? -cosR : cosR;
+}
+
+/// <summary>
+/// Folds the point into the first eighth of the circle, where atan of the smaller coordinate over
+/// the larger is at most pi / 4, evaluates atan there, and unfolds the result
+/// </summary>
+/// <param name="y">Y of the point</param>
+/// <param name="x">X of the point</param>
+/// <returns>Angle of the point in radians</returns>
+float FastAtan2(float y, float x) {
+	float ax = std::abs(x);
+	float ay = std::abs(y);
+	float larger = std::max(ax, ay);
+	float t = larger > 0.0f ? std::min(ax, ay) / larger : 0.0f;
+
+	float offset = 0.0f;
+	if (t > TAN_PI_8) {
+		t = (t - 1.0f) / (t + 1.0f);
+		offset = QUARTER_PI;
+	}
+
+	float z = t * t;
+	float angle = (((ATAN_C4 * z + ATAN_C3) * z + ATAN_C2) * z + ATAN_C1) * z * t + t + offset;
+
+	if (ay > ax) {
+		angle = HALF_PI - angle;
+	}
+	if (x < 0.0f) {
+		angle = FAST_PI - angle;
+	}
+	return std::copysign(angle, y);
+}
+
+#ifdef FAST_MATH_SSE2
+/// <summary>
+/// FastSinCos for four angles; the quarter turn is applied with masks and sign bits rather than branches
+/// </summary>
+static void FastSinCos4(__m128 radians, __m128& sine, __m128& cosine) {
+	const __m128i one = _mm_set1_epi32(1);
+	const __m128i two = _mm_set1_epi32(2);
+
+	__m128i quadrant = _mm_cvtps_epi32(_mm_mul_ps(radians, _mm_set1_ps(TWO_OVER_PI)));
+	__m128 q = _mm_cvtepi32_ps(quadrant);
+
+	__m128 r = _mm_sub_ps(radians, _mm_mul_ps(q, _mm_set1_ps(PIO2_1)));
+	r = _mm_sub_ps(r, _mm_mul_ps(q, _mm_set1_ps(PIO2_2)));
+	r = _mm_sub_ps(r, _mm_mul_ps(q, _mm_set1_ps(PIO2_3)));
+	__m128 z = _mm_mul_ps(r, r);
+
+	__m128 sinR = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(SIN_C3), z), _mm_set1_ps(SIN_C2));
+	sinR = _mm_add_ps(_mm_mul_ps(sinR, z), _mm_set1_ps(SIN_C1));
+	sinR = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(sinR, z), r), r);
+
+	__m128 cosR = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(COS_C3), z), _mm_set1_ps(COS_C2));
+	cosR = _mm_add_ps(_mm_mul_ps(cosR, z), _mm_set1_ps(COS_C1));
+	cosR = _mm_mul_ps(_mm_mul_ps(cosR, z), z);
+	cosR = _mm_add_ps(_mm_sub_ps(cosR, _mm_mul_ps(_mm_set1_ps(0.5f), z)), _mm_set1_ps(1.0f));
+
+	// Odd quarter turns swap sine and cosine; bit 1 of the quarter turn, shifted up to the sign bit, flips them
+	__m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, one), one));
+	__m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, two), 30));
+	__m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quadrant, one), two), 30));
+
+	sine = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, cosR), _mm_andnot_ps(swap, sinR)), sinSign);
+	cosine = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, sinR), _mm_andnot_ps(swap, cosR)), cosSign);
+}
+
+/// <summary>
+/// Picks a where mask is set and b elsewhere
+/// </summary>
+static __m128 Select(__m128 mask, __m128 a, __m128 b) {
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+/// <summary>
+/// FastAtan2 for four points; each fold and unfold is a compare and a select
+/// </summary>
+static __m128 FastAtan24(__m128 y, __m128 x) {
+	const __m128 signBit = _mm_set1_ps(-0.0f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 oneF = _mm_set1_ps(1.0f);
+
+	__m128 ax = _mm_andnot_ps(signBit, x);
+	__m128 ay = _mm_andnot_ps(signBit, y);
+	__m128 larger = _mm_max_ps(ax, ay);
+
+	// 0 / 0 at the origin is masked back to 0
+	__m128 t = _mm_and_ps(_mm_div_ps(_mm_min_ps(ax, ay), larger), _mm_cmpgt_ps(larger, zero));
+
+	__m128 folded = _mm_cmpgt_ps(t, _mm_set1_ps(TAN_PI_8));
+	t = Select(folded, _mm_div_ps(_mm_sub_ps(t, oneF), _mm_add_ps(t, oneF)), t);
+	__m128 offset = _mm_and_ps(folded, _mm_set1_ps(QUARTER_PI));
+
+	__m128 z = _mm_mul_ps(t, t);
+	__m128 angle = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(ATAN_C4), z), _mm_set1_ps(ATAN_C3));
+	angle = _mm_add_ps(_mm_mul_ps(angle, z), _mm_set1_ps(ATAN_C2));
+	angle = _mm_add_ps(_mm_mul_ps(angle, z), _mm_set1_ps(ATAN_C1));
+	angle = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(angle, z), t), t), offset);
+
+	angle = Select(_mm_cmpgt_ps(ay, ax), _mm_sub_ps(_mm_set1_ps(HALF_PI), angle), angle);
+	angle = Select(_mm_cmplt_ps(x, zero), _mm_sub_ps(_mm_set1_ps(FAST_PI), angle), angle);
+	return _mm_or_ps(angle, _mm_and_ps(y, signBit));
+}
+#endif
+
+void FastSinCosArray(const float* radians, float* sines, float* cosines, size_t count) {
+	size_t i = 0;
+
+#ifdef FAST_MATH_SSE2
+	for (; i + 4 <= count; i += 4) {
+		__m128 s, c;
+		FastSinCos4(_mm_loadu_ps(radians + i), s, c);
+		_mm_storeu_ps(sines + i, s);
+		_mm_storeu_ps(cosines + i, c);
+	}
+#endif
+
+	for (; i < count; i++) {
+		FastSinCos(radians[i], sines[i], cosines[i]);
+	}
+}
+
+void FastAtan2Array(const float* y, const float* x, float* angles, size_t count) {
+	size_t i = 0;
+
+#ifdef FAST_MATH_SSE2
+	for (; i + 4 <= count; i += 4) {
+		_mm_storeu_ps(angles + i, FastAtan24(_mm_loadu_ps(y + i), _mm_loadu_ps(x + i)));
+	}
+#endif
+
+	for (; i < count; i++) {
+		angles[i] = FastAtan2(y[i], x[i]);
+	}
+}
+
+glm::vec2 DirectionFromAngle(float radians) {
+	glm::vec2 direction;
+	FastSinCos(radians, direction.y, direction.x);
+	return direction;
+}
+
+/// <summary>
+/// Normalizes an offset, such as from one position to another, into the direction along it
+/// </summary>
+/// <param name="offset">Offset to follow</param>
+/// <param name="fallback">Direction used when the offset has no length</param>
+/// <returns>Unit vector along offset</returns>
+glm::vec2 DirectionTo(glm::vec2 offset, glm::vec2 fallback) {
+	float lengthSquared = offset.x * offset.x + offset.y * offset.y;
+	if (lengthSquared <= 0.0f) {
+		return fallback;
+	}
+
+	return offset / std::sqrt(lengthSquared);
+}
+
+/// <summary>
+/// Checks every function over evenly spread inputs and times the array functions against the
+/// same loops through libm; the fastest of several runs of each loop is kept. Inputs cover the
+/// whole checked range of angles, and points at every angle and many scales, including the axes
+/// </summary>
+/// <param name="count">Number of inputs checked and timed per function</param>
+/// <returns>Errors, whether they are within bounds, and time per value</returns>
+FastMathReport RunFastMathChecks(size_t count) {
+	typedef std::chrono::steady_clock Clock;
+
+	FastMathReport report = FastMathReport();
+	if (count == 0) {
+		report.passed = true;
+		return report;
+	}
+
+	std::vector<float> angles(count), sines(count), cosines(count);
+	std::vector<float> pointY(count), pointX(count), atans(count);
+	for (size_t i = 0; i < count; i++) {
+		angles[i] = -FAST_SINCOS_RANGE + 2.0f * FAST_SINCOS_RANGE * (float)i / (float)count;
+
+		// Walks the circle many times over while the radius sweeps several orders of magnitude
+		double turn = 2.0 * 3.14159265358979323846 * (double)(i % 1024) / 1024.0;
+		double radius = std::pow(10.0, -3.0 + 6.0 * (double)i / (double)count);
+		pointX[i] = (float)(radius * std::cos(turn));
+		pointY[i] = (float)(radius * std::sin(turn));
+	}
+
+	// Accuracy, for the single value functions and the array functions
+	FastSinCosArray(angles.data(), sines.data(), cosines.data(), count);
+	FastAtan2Array(pointY.data(), pointX.data(), atans.data(), count);
+	for (size_t i = 0; i < count; i++) {
+		float sine, cosine;
+		FastSinCos(angles[i], sine, cosine);
+		double exactSin = std::sin((double)angles[i]);
+		double exactCos = std::cos((double)angles[i]);
+
+		report.sinCosMaxError = std::max({ report.sinCosMaxError, std::abs(sine - exactSin), std::abs(cosine - exactCos),
+			std::abs(sines[i] - exactSin), std::abs(cosines[i] - exactCos) });
+
+		double exactAtan = std::atan2((double)pointY[i], (double)pointX[i]);
+		report.atan2MaxError = std::max({ report.atan2MaxError, std::abs(FastAtan2(pointY[i], pointX[i]) - exactAtan),
+			std::abs(atans[i] - exactAtan) });
+	}
+	report.passed = report.sinCosMaxError <= FAST_SINCOS_MAX_ERROR && report.atan2MaxError <= FAST_ATAN2_MAX_ERROR;
+
+	// Throughput
+	double libmSinCos = 0.0, fastSinCos = 0.0, libmAtan2 = 0.0, fastAtan2 = 0.0;
+	for (int run = 0; run < BENCHMARK_RUNS; run++) {
+		Clock::time_point start = Clock::now();
+		for (size_t i = 0; i < count; i++) {
+			sines[i] = std::sin(angles[i]);
+			cosines[i] = std::cos(angles[i]);
+		}
+		Clock::time_point libmSinCosEnd = Clock::now();
+		FastSinCosArray(angles.data(), sines.data(), cosines.data(), count);
+		Clock::time_point fastSinCosEnd = Clock::now();
+		for (size_t i = 0; i < count; i++) {
+			atans[i] = std::atan2(pointY[i], pointX[i]);
+		}
+		Clock::time_point libmAtan2End = Clock::now();
+		FastAtan2Array(pointY.data(), pointX.data(), atans.data(), count);
+		Clock::time_point fastAtan2End = Clock::now();
+
+		double times[4] = {
+			std::chrono::duration<double, std::nano>(libmSinCosEnd - start).count(),
+			std::chrono::duration<double, std::nano>(fastSinCosEnd - libmSinCosEnd).count(),
+			std::chrono::duration<double, std::nano>(libmAtan2End - fastSinCosEnd).count(),
+			std::chrono::duration<double, std::nano>(fastAtan2End - libmAtan2End).count()
+		};
+		libmSinCos = run == 0 ? times[0] : std::min(libmSinCos, times[0]);
+		fastSinCos = run == 0 ? times[1] : std::min(fastSinCos, times[1]);
+		libmAtan2 = run == 0 ? times[2] : std::min(libmAtan2, times[2]);
+		fastAtan2 = run == 0 ? times[3] : std::min(fastAtan2, times[3]);
+	}
+
+	benchmarkSink = sines[count / 2] + cosines[count / 2] + atans[count / 2];
+
+	report.libmSinCosNs = libmSinCos / count;
+	report.fastSinCosNs = fastSinCos / count;
+	report.libmAtan2Ns = libmAtan2 / count;
+	report.fastAtan2Ns = fastAtan2 / count;
+	return report;
+}
@@ -0,0 +1,73 @@
+//*****************************************************************************
+// FastMath.h
+//
+// Author: Kyle Manning
+//
+// Brief Description: Header for the fast trig functions shared by Geometry
+//					  Shooter and Graphics Demo: polynomial sine, cosine, and
+//					  atan2 for single values and arrays, helpers for
+//					  directions stored as unit vectors, and their accuracy
+//					  checks and benchmarks against libm
+//*****************************************************************************
+#pragma once
+
+#include <cstddef>
+
+#include <glm/glm.hpp>
+
+const float FAST_PI = 3.14159265358979f;
+
+// Largest absolute error FastSinCos may have against libm, for angles within FAST_SINCOS_RANGE radians of zero
+const float FAST_SINCOS_MAX_ERROR = 1e-6f;
+const float FAST_SINCOS_RANGE = 8192.0f;
+
+// Largest error FastAtan2 may have against libm, in radians
+const float FAST_ATAN2_MAX_ERROR = 1e-6f;
+
+// Results of RunFastMathChecks
+struct FastMathReport {
+	// Largest absolute errors against libm over every checked input, and whether both are within their bounds
+	double sinCosMaxError;
+	double atan2MaxError;
+	bool passed;
+	// Nanoseconds per value for libm and for the array functions
+	double libmSinCosNs, fastSinCosNs;
+	double libmAtan2Ns, fastAtan2Ns;
+};
+
+/* Sine, cosine, and atan2 in float as minimax polynomials, after reducing the input to a small
+*  range: sine and cosine subtract whole quarter turns in three parts so no bits are lost, and
+*  atan2 folds the point into the first eighth of the circle. Both come out within the bounds
+*  above, which RunFastMathChecks confirms against libm in double. The array versions do four
+*  values at a time with SSE2 and the same math one at a time elsewhere.
+*
+*  Most code should not need them. Things that turn, like sprites and the player's aim, store the
+*  way they face as a unit vector, which comes from a normalized difference of positions without
+*  any trig and is turned by a fixed angle with RotateDirection.
+*/
+
+// Sine and cosine of an angle in radians
+void FastSinCos(float radians, float& sine, float& cosine);
+
+// Angle of the point (x, y) from the positive x axis in radians, in [-pi, pi]; 0 at the origin
+float FastAtan2(float y, float x);
+
+// FastSinCos of count angles
+void FastSinCosArray(const float* radians, float* sines, float* cosines, size_t count);
+
+// FastAtan2 of count points
+void FastAtan2Array(const float* y, const float* x, float* angles, size_t count);
+
+// Unit vector at an angle in radians from the positive x axis
+glm::vec2 DirectionFromAngle(float radians);
+
+// Unit vector along offset, or fallback if offset is zero
+glm::vec2 DirectionTo(glm::vec2 offset, glm::vec2 fallback);
+
+// Turns a unit vector counterclockwise by the angle whose cosine and sine are given, e.g. a fixed spread between shots
+inline glm::vec2 RotateDirection(glm::vec2 direction, float cosine, float sine) {
+	return glm::vec2(cosine * direction.x - sine * direction.y, sine * direction.x + cosine * direction.y);
+}
+
+// Checks the error of every function against libm over count inputs each and times them against it
+FastMathReport RunFastMathChecks(size_t count);
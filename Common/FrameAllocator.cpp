@@ -0,0 +1,56 @@
+//*****************************************************************************
+// FrameAllocator.cpp
+//
+// Author: Kyle Manning
+//
+// Brief Description: Contains methods for FrameAllocator objects, which rotate
+//					  between arenas each frame and check that nothing allocated
+//					  in a frame outlives it
+//*****************************************************************************
+#include "FrameAllocator.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+
+/// <summary>
+/// Constructor for FrameAllocators
+/// </summary>
+/// <param name="bytesPerFrame">Size of each arena's first block; more are added if a frame needs them</param>
+FrameAllocator::FrameAllocator(size_t bytesPerFrame) : buffers{ MonotonicArena(bytesPerFrame), MonotonicArena(bytesPerFrame) }, current(0), frame(0) {
+}
+
+/// <summary>
+/// Moves to the arena used FRAME_ALLOCATOR_BUFFERS frames ago and rewinds it. Any allocation from
+/// that frame which was never released belongs to a container that escaped its frame and now points
+/// at memory about to be reused, so it is reported and asserted on
+/// </summary>
+void FrameAllocator::BeginFrame() {
+	current = (current + 1) % FRAME_ALLOCATOR_BUFFERS;
+	MonotonicArena& arena = buffers[current];
+
+	int escaped = arena.GetStats().liveAllocations;
+	if (escaped != 0) {
+		std::cout << "ERROR::FRAME_ALLOCATOR::ESCAPED " << escaped << " allocations from frame " << frame + 1 - FRAME_ALLOCATOR_BUFFERS << std::endl;
+		assert(escaped == 0 && "Frame memory was still in use when its frame was reset");
+	}
+
+	arena.Reset();
+	frame += 1;
+}
+
+std::pmr::memory_resource* FrameAllocator::Resource() {
+	return &buffers[current];
+}
+
+ArenaStats FrameAllocator::GetStats() const {
+	ArenaStats stats = buffers[current].GetStats();
+	for (const MonotonicArena& arena : buffers) {
+		stats.highWater = std::max(stats.highWater, arena.GetStats().highWater);
+	}
+	return stats;
+}
+
+unsigned long long FrameAllocator::Frame() const {
+	return frame;
+}
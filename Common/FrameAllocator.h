@@ -0,0 +1,50 @@
+//*****************************************************************************
+// FrameAllocator.h
+//
+// Author: Kyle Manning
+//
+// Brief Description: Header for FrameAllocator, the per-frame scratch memory
+//					  used by Geometry Shooter
+//*****************************************************************************
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+
+#include "Arena.h"
+
+// Frames of scratch memory kept alive at once; a frame's memory stays valid through the next frame
+const int FRAME_ALLOCATOR_BUFFERS = 2;
+
+/* Scratch memory for data that only lives for one frame: UI strings, candidate lists, sort
+*  keys, and the like. Each frame bump allocates from one of two arenas, and BeginFrame
+*  switches to the other one and rewinds it, so data built in one frame can still be read
+*  while the next is being built, for example by a render thread. Nothing is freed
+*  individually, and once the arenas have grown to the busiest frame no frame touches the heap.
+*
+*  Containers are put on it through std::pmr, e.g. std::pmr::vector<int> list(frame.Resource()).
+*  They must be destroyed before their frame's arena comes around again; BeginFrame checks that
+*  every allocation from it was released and asserts if one escaped.
+*/
+class FrameAllocator {
+public:
+	// Creates both arenas with blocks of bytesPerFrame
+	explicit FrameAllocator(size_t bytesPerFrame);
+
+	// Switches to the next arena and rewinds it; call once at the top of each frame
+	void BeginFrame();
+
+	// Memory resource of the current frame
+	std::pmr::memory_resource* Resource();
+
+	// Usage of the current frame's arena, with the high water of both
+	ArenaStats GetStats() const;
+
+	// Number of frames begun so far
+	unsigned long long Frame() const;
+
+private:
+	MonotonicArena buffers[FRAME_ALLOCATOR_BUFFERS];
+	int current;
+	unsigned long long frame;
+};
@@ -0,0 +1,223 @@
+//*****************************************************************************
+// FramePacer.cpp
+//
+// Author: Kyle Manning
+//
+// Brief Description: Contains methods for FramePacer objects, which wait at the
+//					  top of each frame for the frame limiter and the GPU, and
+//					  measure frame time variance and input latency
+//*****************************************************************************
+#include "FramePacer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#include <GLFW/glfw3.h>
+
+// Weight of the newest frame in the smoothed latency estimate
+const double LATENCY_SMOOTHING = 0.1;
+
+/// <summary>
+/// Default constructor for FramePacers; nothing is applied to the context until SetMode is called
+/// </summary>
+FramePacer::FramePacer() : mode(PACING_VSYNC), lowLatency(false), maxQueued(1), frameLimit(DEFAULT_FRAME_LIMIT), next(0), started(false),
+	historyCount(0), historyNext(0), stats() {
+	for (int i = 0; i < FRAME_PACER_MAX_QUEUED; i++) {
+		fences[i] = nullptr;
+	}
+}
+
+void FramePacer::SetMode(PacingMode mode) {
+	this->mode = mode;
+	glfwSwapInterval(mode == PACING_VSYNC ? 1 : 0);
+}
+
+PacingMode FramePacer::Mode() const {
+	return mode;
+}
+
+void FramePacer::SetFrameLimit(double framesPerSecond) {
+	frameLimit = std::max(1.0, framesPerSecond);
+}
+
+/// <summary>
+/// Turns the queued frame limit on or off
+/// </summary>
+/// <param name="enabled">Whether BeginFrame waits for the GPU</param>
+/// <param name="maxQueued">Frames that may still be on the GPU when a new one starts, 0 to wait for all of them</param>
+void FramePacer::SetLowLatency(bool enabled, int maxQueued) {
+	lowLatency = enabled;
+	this->maxQueued = std::min(std::max(maxQueued, 0), FRAME_PACER_MAX_QUEUED - 1);
+}
+
+bool FramePacer::LowLatency() const {
+	return lowLatency;
+}
+
+/// <summary>
+/// Waits until the frame may start and records the time since the last one started. The limiter
+/// wait comes before the GPU wait, so neither eats into the time between polling input and drawing
+/// </summary>
+void FramePacer::BeginFrame() {
+	if (mode == PACING_LIMITED && started) {
+		WaitForLimit();
+	}
+	else {
+		stats.limiterWaitMs = 0.0;
+	}
+
+	RetireFences();
+
+	Clock::time_point now = Clock::now();
+	if (started) {
+		history[historyNext] = std::chrono::duration<double, std::milli>(now - frameStart).count();
+		historyNext = (historyNext + 1) % FRAME_PACER_HISTORY;
+		historyCount = std::min(historyCount + 1, FRAME_PACER_HISTORY);
+	}
+
+	frameStart = now;
+	inputTime = now;
+	started = true;
+}
+
+void FramePacer::MarkInputSampled() {
+	inputTime = Clock::now();
+}
+
+/// <summary>
+/// Fences everything issued this frame, including the swap, in the oldest slot. The slot is only
+/// still taken when every frame in flight is unfinished and low latency is off, and then the oldest
+/// fence is dropped without a latency sample
+/// </summary>
+void FramePacer::EndFrame() {
+	if (fences[next] != nullptr) {
+		glDeleteSync(fences[next]);
+	}
+
+	fences[next] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	inputTimes[next] = inputTime;
+	next = (next + 1) % FRAME_PACER_MAX_QUEUED;
+}
+
+/// <summary>
+/// Works out the mean, standard deviation, and worst of the recent frame times
+/// </summary>
+/// <returns>Frame pacing and latency statistics</returns>
+FramePacingStats FramePacer::GetStats() const {
+	FramePacingStats result = stats;
+
+	double sum = 0.0, worst = 0.0;
+	for (int i = 0; i < historyCount; i++) {
+		sum += history[i];
+		worst = std::max(worst, history[i]);
+	}
+
+	double mean = historyCount > 0 ? sum / historyCount : 0.0;
+	double variance = 0.0;
+	for (int i = 0; i < historyCount; i++) {
+		variance += (history[i] - mean) * (history[i] - mean);
+	}
+
+	result.frameMs = mean;
+	result.frameStdDevMs = historyCount > 1 ? std::sqrt(variance / (historyCount - 1)) : 0.0;
+	result.worstFrameMs = worst;
+	return result;
+}
+
+void FramePacer::Release() {
+	for (int i = 0; i < FRAME_PACER_MAX_QUEUED; i++) {
+		if (fences[i] != nullptr) {
+			glDeleteSync(fences[i]);
+			fences[i] = nullptr;
+		}
+	}
+}
+
+const char* FramePacer::ModeName(PacingMode mode) {
+	switch (mode) {
+		case PACING_VSYNC:
+			return "vsync";
+		case PACING_UNCAPPED:
+			return "uncapped";
+		case PACING_LIMITED:
+			return "limited";
+		default:
+			return "unknown";
+	}
+}
+
+/// <summary>
+/// Sleeps in 1 ms steps while the next frame is more than FRAME_PACER_SPIN_MS away, then yields in
+/// a loop for the rest, which lands within microseconds of the deadline
+/// </summary>
+void FramePacer::WaitForLimit() {
+	Clock::time_point deadline = frameStart + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / frameLimit));
+	Clock::time_point start = Clock::now();
+
+	while (std::chrono::duration<double, std::milli>(deadline - Clock::now()).count() > FRAME_PACER_SPIN_MS) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	while (Clock::now() < deadline) {
+		std::this_thread::yield();
+	}
+
+	stats.limiterWaitMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+/// <summary>
+/// Checks every frame in flight from oldest to newest. Signaled ones are retired; in low latency
+/// mode unsignaled ones are waited on while more than maxQueued would be left, and otherwise the
+/// rest are counted as queued
+/// </summary>
+void FramePacer::RetireFences() {
+	Clock::time_point start = Clock::now();
+	int inFlight = 0;
+
+	for (int i = 0; i < FRAME_PACER_MAX_QUEUED; i++) {
+		if (fences[(next + i) % FRAME_PACER_MAX_QUEUED] != nullptr) {
+			inFlight += 1;
+		}
+	}
+
+	int queued = inFlight;
+	for (int i = 0; i < FRAME_PACER_MAX_QUEUED; i++) {
+		int slot = (next + i) % FRAME_PACER_MAX_QUEUED;
+		if (fences[slot] == nullptr) {
+			continue;
+		}
+
+		GLenum result = glClientWaitSync(fences[slot], 0, 0);
+		if (result == GL_TIMEOUT_EXPIRED && lowLatency && queued > maxQueued) {
+			// Flushes once so the fence is guaranteed to signal, then waits in 1 ms steps
+			GLbitfield waitFlags = GL_SYNC_FLUSH_COMMANDS_BIT;
+			do {
+				result = glClientWaitSync(fences[slot], waitFlags, 1000000);
+				waitFlags = 0;
+			} while (result == GL_TIMEOUT_EXPIRED);
+		}
+
+		if (result == GL_TIMEOUT_EXPIRED) {
+			break;
+		}
+
+		Retire(slot);
+		queued -= 1;
+	}
+
+	stats.queuedFrames = queued;
+	stats.gpuWaitMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+void FramePacer::Retire(int slot) {
+	double latency = std::chrono::duration<double, std::milli>(Clock::now() - inputTimes[slot]).count();
+	if (stats.inputLatencyMs == 0.0) {
+		stats.inputLatencyMs = latency;
+	}
+	else {
+		stats.inputLatencyMs += (latency - stats.inputLatencyMs) * LATENCY_SMOOTHING;
+	}
+
+	glDeleteSync(fences[slot]);
+	fences[slot] = nullptr;
+}
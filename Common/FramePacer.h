@@ -0,0 +1,121 @@
+//*****************************************************************************
+// FramePacer.h
+//
+// Author: Kyle Manning
+//
+// Brief Description: Header for FramePacer objects, which control swap interval,
+//					  frame rate limiting, and how far the CPU may run ahead of
+//					  the GPU for Geometry Shooter and Graphics Demo
+//*****************************************************************************
+#pragma once
+
+#include <chrono>
+
+#include <glad/glad.h>
+
+// How frames are paced
+enum PacingMode {
+	// Swap interval 1; frames are paced by the display
+	PACING_VSYNC,
+	// Swap interval 0 and no limit, for benchmarking
+	PACING_UNCAPPED,
+	// Swap interval 0 with frames started at a fixed rate
+	PACING_LIMITED,
+	PACING_MODE_COUNT
+};
+
+// Fences kept for frames in flight, and so the most frames low latency mode can be told to allow
+const int FRAME_PACER_MAX_QUEUED = 3;
+
+// Frame times kept for the mean and variance
+const int FRAME_PACER_HISTORY = 120;
+
+// Rate used by PACING_LIMITED unless another is set
+const double DEFAULT_FRAME_LIMIT = 120.0;
+
+// The limiter sleeps until this long before the deadline, then spins, since sleeps can overshoot by about a millisecond
+const double FRAME_PACER_SPIN_MS = 2.0;
+
+struct FramePacingStats {
+	// Mean and standard deviation of the recent frame times
+	double frameMs;
+	double frameStdDevMs;
+	double worstFrameMs;
+	// Time from the latest input read to the GPU finishing that frame, smoothed; scanout adds up to one refresh more
+	double inputLatencyMs;
+	// Frames the GPU had not finished at the start of the last frame
+	int queuedFrames;
+	// Time spent in the limiter and waiting on the GPU last frame
+	double limiterWaitMs;
+	double gpuWaitMs;
+};
+
+/* Paces the main loop. BeginFrame runs before input is polled and does all the waiting, so the
+*  input a frame uses is as fresh as possible: the limiter sleeps then spins until the next frame
+*  is due, and in low latency mode the CPU waits on a fence until at most maxQueued frames are
+*  still on the GPU. EndFrame, after the swap, fences the frame and records its time.
+*
+*  MarkInputSampled is called where the frame last reads input, just before the view is set up;
+*  the time from there to the frame's fence signaling is the latency estimate in the stats.
+*/
+class FramePacer {
+public:
+	FramePacer();
+
+	// Sets the pacing mode and applies its swap interval; the context must be current
+	void SetMode(PacingMode mode);
+	PacingMode Mode() const;
+
+	// Frame rate for PACING_LIMITED
+	void SetFrameLimit(double framesPerSecond);
+
+	// Limits how many frames may be queued on the GPU, or lifts the limit
+	void SetLowLatency(bool enabled, int maxQueued = 1);
+	bool LowLatency() const;
+
+	// Waits for the limiter and for queued frames; call at the top of the loop, before polling input
+	void BeginFrame();
+
+	// Records when the frame last read input
+	void MarkInputSampled();
+
+	// Fences the frame and records its time; call right after the swap
+	void EndFrame();
+
+	FramePacingStats GetStats() const;
+
+	// Deletes the fences; called before the context is destroyed
+	void Release();
+
+	// Short name of a pacing mode for reports
+	static const char* ModeName(PacingMode mode);
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	PacingMode mode;
+	bool lowLatency;
+	int maxQueued;
+	double frameLimit;
+
+	// Fence and input time of each frame in flight, oldest at next
+	GLsync fences[FRAME_PACER_MAX_QUEUED];
+	Clock::time_point inputTimes[FRAME_PACER_MAX_QUEUED];
+	int next;
+
+	Clock::time_point frameStart, inputTime;
+	bool started;
+
+	double history[FRAME_PACER_HISTORY];
+	int historyCount, historyNext;
+	FramePacingStats stats;
+
+	// Sleeps then spins until the next frame is due in PACING_LIMITED
+	void WaitForLimit();
+
+	// Retires signaled fences, waiting on older ones in low latency mode until few enough are left
+	void RetireFences();
+
+	// Deletes the fence in a slot once it has signaled, folding its latency into the stats
+	void Retire(int slot);
+};
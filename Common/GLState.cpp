@@ -0,0 +1,247 @@
+//*****************************************************************************
+// GLState.cpp
+//
+// Author: Kyle Manning
+//
+// Brief Description: Caches the currently bound program, vertex array, array
+//					  buffer, textures, framebuffer, and blend/depth enables
+//					  so that redundant GL calls are never sent to the driver
+//*****************************************************************************
+#include "GLState.h"
+
+// Value used for state that has not been set through the cache yet
+const unsigned int UNKNOWN_BINDING = 0xFFFFFFFF;
+
+// Texture targets that are tracked per unit; others are passed straight through
+const GLenum TRACKED_TARGETS[] = { GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY };
+const int TRACKED_TARGET_COUNT = 2;
+
+static unsigned int currentProgram = UNKNOWN_BINDING;
+static unsigned int currentVAO = UNKNOWN_BINDING;
+static unsigned int currentArrayBuffer = UNKNOWN_BINDING;
+static unsigned int currentFramebuffer = UNKNOWN_BINDING;
+static unsigned int activeUnit = UNKNOWN_BINDING;
+static unsigned int boundTextures[MAX_TRACKED_TEXTURE_UNITS][TRACKED_TARGET_COUNT];
+static int blendEnabled = -1;
+static int depthEnabled = -1;
+static GLStateStats stats = { 0, 0 };
+
+/// <summary>
+/// Binds a shader program if it is not already in use
+/// </summary>
+/// <param name="program">ID of the program to use</param>
+void GLState::UseProgram(unsigned int program) {
+	if (Changed(currentProgram, program)) {
+		glUseProgram(program);
+	}
+}
+
+/// <summary>
+/// Binds a vertex array object if it is not already bound
+/// </summary>
+/// <param name="vao">ID of the vertex array</param>
+void GLState::BindVertexArray(unsigned int vao) {
+	if (Changed(currentVAO, vao)) {
+		glBindVertexArray(vao);
+	}
+}
+
+/// <summary>
+/// Binds a buffer to GL_ARRAY_BUFFER if it is not already bound there
+/// </summary>
+/// <param name="buffer">ID of the buffer</param>
+void GLState::BindArrayBuffer(unsigned int buffer) {
+	if (Changed(currentArrayBuffer, buffer)) {
+		glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	}
+}
+
+/// <summary>
+/// Binds a texture to a texture unit; the active unit is only switched when the
+/// binding on that unit actually has to change
+/// </summary>
+/// <param name="unit">Index of the texture unit (0 for GL_TEXTURE0)</param>
+/// <param name="target">Texture target, e.g. GL_TEXTURE_2D</param>
+/// <param name="texture">ID of the texture</param>
+void GLState::BindTexture(unsigned int unit, GLenum target, unsigned int texture) {
+	int targetIndex = -1;
+	for (int i = 0; i < TRACKED_TARGET_COUNT; i++) {
+		if (TRACKED_TARGETS[i] == target) {
+			targetIndex = i;
+		}
+	}
+
+	// Untracked units and targets are always issued and forget the active unit
+	if (unit >= MAX_TRACKED_TEXTURE_UNITS || targetIndex == -1) {
+		glActiveTexture(GL_TEXTURE0 + unit);
+		glBindTexture(target, texture);
+		activeUnit = unit;
+		stats.issued += 1;
+		return;
+	}
+
+	if (!Changed(boundTextures[unit][targetIndex], texture)) {
+		return;
+	}
+
+	if (Changed(activeUnit, unit)) {
+		glActiveTexture(GL_TEXTURE0 + unit);
+	}
+	glBindTexture(target, texture);
+}
+
+/// <summary>
+/// Enables or disables GL_BLEND if it is not already in that state
+/// </summary>
+/// <param name="enabled">Whether blending should be on</param>
+void GLState::SetBlend(bool enabled) {
+	SetCapability(GL_BLEND, blendEnabled, enabled);
+}
+
+/// <summary>
+/// Enables or disables GL_DEPTH_TEST if it is not already in that state
+/// </summary>
+/// <param name="enabled">Whether depth testing should be on</param>
+void GLState::SetDepthTest(bool enabled) {
+	SetCapability(GL_DEPTH_TEST, depthEnabled, enabled);
+}
+
+/// <summary>
+/// Binds a framebuffer to GL_FRAMEBUFFER if it is not already bound
+/// </summary>
+/// <param name="fbo">ID of the framebuffer, 0 for the default framebuffer</param>
+void GLState::BindFramebuffer(unsigned int fbo) {
+	if (Changed(currentFramebuffer, fbo)) {
+		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	}
+}
+
+/// <summary>
+/// Marks every piece of cached state as unknown
+/// </summary>
+void GLState::Invalidate() {
+	currentProgram = UNKNOWN_BINDING;
+	currentVAO = UNKNOWN_BINDING;
+	currentArrayBuffer = UNKNOWN_BINDING;
+	currentFramebuffer = UNKNOWN_BINDING;
+	activeUnit = UNKNOWN_BINDING;
+
+	for (unsigned int unit = 0; unit < MAX_TRACKED_TEXTURE_UNITS; unit++) {
+		for (int i = 0; i < TRACKED_TARGET_COUNT; i++) {
+			boundTextures[unit][i] = UNKNOWN_BINDING;
+		}
+	}
+
+	blendEnabled = -1;
+	depthEnabled = -1;
+}
+
+/// <summary>
+/// Marks any unit holding a deleted texture as unknown; call after glDeleteTextures
+/// </summary>
+/// <param name="texture">ID of the deleted texture</param>
+void GLState::ForgetTexture(unsigned int texture) {
+	for (unsigned int unit = 0; unit < MAX_TRACKED_TEXTURE_UNITS; unit++) {
+		for (int i = 0; i < TRACKED_TARGET_COUNT; i++) {
+			if (boundTextures[unit][i] == texture) {
+				boundTextures[unit][i] = UNKNOWN_BINDING;
+			}
+		}
+	}
+}
+
+/// <summary>
+/// Marks the framebuffer binding as unknown if the deleted framebuffer was bound; call
+/// after glDeleteFramebuffers
+/// </summary>
+/// <param name="fbo">ID of the deleted framebuffer</param>
+void GLState::ForgetFramebuffer(unsigned int fbo) {
+	if (currentFramebuffer == fbo) {
+		currentFramebuffer = UNKNOWN_BINDING;
+	}
+}
+
+/// <summary>
+/// Marks the program binding as unknown if the deleted program was in use
+/// </summary>
+/// <param name="program">ID of the deleted program</param>
+void GLState::ForgetProgram(unsigned int program) {
+	if (currentProgram == program) {
+		currentProgram = UNKNOWN_BINDING;
+	}
+}
+
+/// <summary>
+/// Marks the vertex array binding as unknown if the deleted vertex array was bound
+/// </summary>
+/// <param name="vao">ID of the deleted vertex array</param>
+void GLState::ForgetVertexArray(unsigned int vao) {
+	if (currentVAO == vao) {
+		currentVAO = UNKNOWN_BINDING;
+	}
+}
+
+/// <summary>
+/// Marks the array buffer binding as unknown if the deleted buffer was bound
+/// </summary>
+/// <param name="buffer">ID of the deleted buffer</param>
+void GLState::ForgetBuffer(unsigned int buffer) {
+	if (currentArrayBuffer == buffer) {
+		currentArrayBuffer = UNKNOWN_BINDING;
+	}
+}
+
+/// <summary>
+/// Returns how many calls were sent to the driver and how many were skipped
+/// </summary>
+/// <returns>Issued and skipped call counts</returns>
+GLStateStats GLState::GetStats() {
+	return stats;
+}
+
+/// <summary>
+/// Resets the issued and skipped call counts, usually once per frame
+/// </summary>
+void GLState::ResetStats() {
+	stats.issued = 0;
+	stats.skipped = 0;
+}
+
+/// <summary>
+/// Enables or disables a capability when the cached value differs
+/// </summary>
+/// <param name="cap">GL capability enum</param>
+/// <param name="cached">Cached state; -1 when unknown</param>
+/// <param name="enabled">Requested state</param>
+void GLState::SetCapability(GLenum cap, int& cached, bool enabled) {
+	if (cached == (int)enabled) {
+		stats.skipped += 1;
+		return;
+	}
+
+	if (enabled) {
+		glEnable(cap);
+	}
+	else {
+		glDisable(cap);
+	}
+	cached = (int)enabled;
+	stats.issued += 1;
+}
+
+/// <summary>
+/// Updates a cached binding and records whether a GL call is needed
+/// </summary>
+/// <param name="cached">Cached binding</param>
+/// <param name="value">Requested binding</param>
+/// <returns>True if the binding changed and the call must be issued</returns>
+bool GLState::Changed(unsigned int& cached, unsigned int value) {
+	if (cached == value) {
+		stats.skipped += 1;
+		return false;
+	}
+
+	cached = value;
+	stats.issued += 1;
+	return true;
+}
@@ -0,0 +1,65 @@
+//*****************************************************************************
+// GLState.h
+//
+// Author: Kyle Manning
+//
+// Brief Description: Header for the GLState cache shared by Geometry Shooter
+//					  and Graphics Demo
+//*****************************************************************************
+#pragma once
+
+#include <glad/glad.h>
+
+const unsigned int MAX_TRACKED_TEXTURE_UNITS = 16;
+
+// Counts of state changes that were sent to the driver and ones that were skipped
+struct GLStateStats {
+	unsigned long long issued;
+	unsigned long long skipped;
+};
+
+/* Thin layer over the glad entry points that remembers the last value set for
+*  each piece of state and drops calls that would not change anything. Every bind
+*  in the program must go through here, otherwise the cached values go stale; call
+*  Invalidate() after any raw GL call that changes tracked state.
+*/
+class GLState {
+public:
+	// Binds a shader program
+	static void UseProgram(unsigned int program);
+
+	// Binds a vertex array object
+	static void BindVertexArray(unsigned int vao);
+
+	// Binds a buffer to GL_ARRAY_BUFFER
+	static void BindArrayBuffer(unsigned int buffer);
+
+	// Binds a texture to the given unit, switching the active unit only when needed
+	static void BindTexture(unsigned int unit, GLenum target, unsigned int texture);
+
+	// Enables or disables blending and depth testing
+	static void SetBlend(bool enabled);
+	static void SetDepthTest(bool enabled);
+
+	// Binds a framebuffer to GL_FRAMEBUFFER
+	static void BindFramebuffer(unsigned int fbo);
+
+	// Forgets all cached state so the next call of each kind is always issued
+	static void Invalidate();
+
+	// Drops cached bindings of deleted objects, since GL unbinds them and may reuse their names
+	static void ForgetTexture(unsigned int texture);
+	static void ForgetFramebuffer(unsigned int fbo);
+	static void ForgetProgram(unsigned int program);
+	static void ForgetVertexArray(unsigned int vao);
+	static void ForgetBuffer(unsigned int buffer);
+
+	// Returns the counts of issued and skipped calls since the last reset
+	static GLStateStats GetStats();
+	static void ResetStats();
+
+private:
+	static void SetCapability(GLenum cap, int& cached, bool enabled);
+	static bool Changed(unsigned int& cached, unsigned int value);
+};
+
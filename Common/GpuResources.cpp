@@ -0,0 +1,236 @@
+//*****************************************************************************
+// GpuResources.cpp
+//
+// Author: Kyle Manning
+//
+// Brief Description: Creates and deletes GL objects while keeping a registry of
+//					  every live object with its label and size, warns when the
+//					  total size goes over budget, and reports leaks at shutdown
+//*****************************************************************************
+#include "GpuResources.h"
+
+#include <algorithm>
+#include <iostream>
+#include <unordered_map>
+
+#include "GLState.h"
+
+// What the registry knows about one live object
+struct GpuRecord {
+	const char* label;
+	size_t bytes;
+};
+
+struct GpuRegistry {
+	std::unordered_map<unsigned int, GpuRecord> records[GPU_RESOURCE_TYPE_COUNT];
+	GpuResourceStats stats;
+	bool overBudget;
+	bool contextAlive;
+};
+
+/// <summary>
+/// Returns the registry; it is allocated once and never freed, because handles in globals are
+/// destroyed during static destruction, which may come after this file's statics are gone
+/// </summary>
+static GpuRegistry& Registry() {
+	static GpuRegistry* registry = new GpuRegistry{ {}, {}, false, true };
+	return *registry;
+}
+
+/// <summary>
+/// Creates a GL object and adds it to the registry with no storage recorded yet; everything but
+/// textures is created with the DSA entry points so it exists before it is first bound
+/// </summary>
+/// <param name="type">Kind of object to create</param>
+/// <param name="label">What the object is for, shown in leak reports</param>
+/// <returns>ID of the new object</returns>
+unsigned int GpuResources::Create(GpuResourceType type, const char* label) {
+	unsigned int id = 0;
+
+	switch (type) {
+		case GPU_BUFFER:
+			glCreateBuffers(1, &id);
+			break;
+		case GPU_VERTEX_ARRAY:
+			glCreateVertexArrays(1, &id);
+			break;
+		case GPU_TEXTURE:
+			// The target is fixed by the first bind, which the owner does
+			glGenTextures(1, &id);
+			break;
+		case GPU_RENDERBUFFER:
+			glCreateRenderbuffers(1, &id);
+			break;
+		case GPU_FRAMEBUFFER:
+			glCreateFramebuffers(1, &id);
+			break;
+		case GPU_PROGRAM:
+			id = glCreateProgram();
+			break;
+		default:
+			return 0;
+	}
+
+	GpuRegistry& registry = Registry();
+	registry.records[type][id] = { label, 0 };
+	registry.stats.live[type] += 1;
+	registry.stats.created += 1;
+	return id;
+}
+
+/// <summary>
+/// Deletes a GL object and removes it from the registry; objects that are not in the registry
+/// were either never created through it or already destroyed, so they are reported instead
+/// </summary>
+/// <param name="type">Kind of object</param>
+/// <param name="id">ID of the object</param>
+void GpuResources::Destroy(GpuResourceType type, unsigned int id) {
+	GpuRegistry& registry = Registry();
+
+	auto found = registry.records[type].find(id);
+	if (found == registry.records[type].end()) {
+		std::cout << "ERROR::GPU_RESOURCES::UNKNOWN_OBJECT " << TypeName(type) << " " << id << std::endl;
+		return;
+	}
+
+	registry.stats.bytes[type] -= found->second.bytes;
+	registry.stats.totalBytes -= found->second.bytes;
+	registry.stats.live[type] -= 1;
+	registry.stats.destroyed += 1;
+	registry.records[type].erase(found);
+
+	if (registry.overBudget && registry.stats.totalBytes <= registry.stats.budgetBytes) {
+		registry.overBudget = false;
+	}
+
+	if (!registry.contextAlive) {
+		return;
+	}
+
+	switch (type) {
+		case GPU_BUFFER:
+			GLState::ForgetBuffer(id);
+			glDeleteBuffers(1, &id);
+			break;
+		case GPU_VERTEX_ARRAY:
+			GLState::ForgetVertexArray(id);
+			glDeleteVertexArrays(1, &id);
+			break;
+		case GPU_TEXTURE:
+			GLState::ForgetTexture(id);
+			glDeleteTextures(1, &id);
+			break;
+		case GPU_RENDERBUFFER:
+			glDeleteRenderbuffers(1, &id);
+			break;
+		case GPU_FRAMEBUFFER:
+			GLState::ForgetFramebuffer(id);
+			glDeleteFramebuffers(1, &id);
+			break;
+		case GPU_PROGRAM:
+			GLState::ForgetProgram(id);
+			glDeleteProgram(id);
+			break;
+		default:
+			break;
+	}
+}
+
+/// <summary>
+/// Records how much storage an object holds and warns the first time the total goes over budget
+/// </summary>
+/// <param name="type">Kind of object</param>
+/// <param name="id">ID of the object</param>
+/// <param name="bytes">Bytes of storage, replacing any earlier value</param>
+void GpuResources::SetBytes(GpuResourceType type, unsigned int id, size_t bytes) {
+	GpuRegistry& registry = Registry();
+
+	auto found = registry.records[type].find(id);
+	if (found == registry.records[type].end()) {
+		return;
+	}
+
+	registry.stats.bytes[type] += bytes - found->second.bytes;
+	registry.stats.totalBytes += bytes - found->second.bytes;
+	registry.stats.peakBytes = std::max(registry.stats.peakBytes, registry.stats.totalBytes);
+	found->second.bytes = bytes;
+
+	if (registry.stats.budgetBytes == 0 || registry.stats.totalBytes <= registry.stats.budgetBytes) {
+		registry.overBudget = false;
+	}
+	else if (!registry.overBudget) {
+		registry.overBudget = true;
+		std::cout << "WARNING::GPU_RESOURCES::OVER_BUDGET " << registry.stats.totalBytes << " of " << registry.stats.budgetBytes
+			<< " bytes after " << TypeName(type) << " '" << found->second.label << "' grew to " << bytes << " bytes" << std::endl;
+	}
+}
+
+void GpuResources::SetBudget(size_t bytes) {
+	Registry().stats.budgetBytes = bytes;
+}
+
+GpuResourceStats GpuResources::GetStats() {
+	return Registry().stats;
+}
+
+const char* GpuResources::TypeName(GpuResourceType type) {
+	switch (type) {
+		case GPU_BUFFER:
+			return "buffer";
+		case GPU_VERTEX_ARRAY:
+			return "vertex array";
+		case GPU_TEXTURE:
+			return "texture";
+		case GPU_RENDERBUFFER:
+			return "renderbuffer";
+		case GPU_FRAMEBUFFER:
+			return "framebuffer";
+		case GPU_PROGRAM:
+			return "program";
+		default:
+			return "unknown";
+	}
+}
+
+/// <summary>
+/// Adds up the size of every mip level of every layer
+/// </summary>
+/// <param name="width">Width of level 0</param>
+/// <param name="height">Height of level 0</param>
+/// <param name="layers">Array layers, 1 for a plain 2D texture</param>
+/// <param name="bytesPerTexel">Bytes of one texel, e.g. 4 for RGBA8</param>
+/// <param name="levels">Mip levels</param>
+/// <returns>Bytes of storage</returns>
+size_t GpuResources::TextureBytes(int width, int height, int layers, int bytesPerTexel, int levels) {
+	size_t bytes = 0;
+	for (int level = 0; level < levels; level++) {
+		bytes += (size_t)std::max(1, width >> level) * std::max(1, height >> level);
+	}
+	return bytes * layers * bytesPerTexel;
+}
+
+/// <summary>
+/// Prints every object that is still alive with its label and size; everything should have been
+/// released by now, so each one is a leak
+/// </summary>
+void GpuResources::Shutdown() {
+	GpuRegistry& registry = Registry();
+
+	int leaked = 0;
+	for (int type = 0; type < GPU_RESOURCE_TYPE_COUNT; type++) {
+		for (auto& record : registry.records[type]) {
+			std::cout << "LEAK::GPU_RESOURCES " << TypeName((GpuResourceType)type) << " " << record.first
+				<< " '" << record.second.label << "' " << record.second.bytes << " bytes" << std::endl;
+			leaked += 1;
+		}
+	}
+
+	std::cout << "GPU resources: " << registry.stats.created << " created, " << registry.stats.destroyed << " destroyed, "
+		<< leaked << " leaked (" << registry.stats.totalBytes << " bytes), peak " << registry.stats.peakBytes << " bytes" << std::endl;
+
+	registry.contextAlive = false;
+}
+
+bool GpuResources::ContextAlive() {
+	return Registry().contextAlive;
+}
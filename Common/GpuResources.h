@@ -0,0 +1,133 @@
+//*****************************************************************************
+// GpuResources.h
+//
+// Author: Kyle Manning
+//
+// Brief Description: Header for the GPU resource registry shared by Geometry
+//					  Shooter and Graphics Demo, and the GpuHandle types that
+//					  own GL objects through it
+//*****************************************************************************
+#pragma once
+
+#include <cstddef>
+
+#include <glad/glad.h>
+
+enum GpuResourceType {
+	GPU_BUFFER,
+	GPU_VERTEX_ARRAY,
+	GPU_TEXTURE,
+	GPU_RENDERBUFFER,
+	GPU_FRAMEBUFFER,
+	GPU_PROGRAM,
+	GPU_RESOURCE_TYPE_COUNT
+};
+
+// Live object counts and estimated driver memory, per type and in total
+struct GpuResourceStats {
+	int live[GPU_RESOURCE_TYPE_COUNT];
+	size_t bytes[GPU_RESOURCE_TYPE_COUNT];
+	size_t totalBytes;
+	size_t peakBytes;
+	size_t budgetBytes;
+	unsigned long long created;
+	unsigned long long destroyed;
+};
+
+/* Every GL object the games create goes through Create and Destroy here, so the
+*  registry always knows what is alive, what it is for, and roughly how much memory
+*  it holds. Sizes are reported by the owner once storage is allocated, and a warning
+*  is printed whenever the total goes over the budget. Shutdown lists everything that
+*  was never destroyed; after it, destroying an object only removes it from the
+*  registry, since there is no context left to delete it from.
+*/
+class GpuResources {
+public:
+	// Creates a GL object of the given type; label must be a string that outlives the object
+	static unsigned int Create(GpuResourceType type, const char* label);
+
+	// Deletes a GL object and drops any cached bindings of it from GLState
+	static void Destroy(GpuResourceType type, unsigned int id);
+
+	// Records the bytes of storage an object holds, replacing what was recorded before
+	static void SetBytes(GpuResourceType type, unsigned int id, size_t bytes);
+
+	// Sets the total bytes allowed before warnings are printed, 0 for no budget
+	static void SetBudget(size_t bytes);
+
+	static GpuResourceStats GetStats();
+
+	// Short name of a resource type for reports
+	static const char* TypeName(GpuResourceType type);
+
+	// Bytes of a texture with the given mip levels, each level halving down to 1x1
+	static size_t TextureBytes(int width, int height, int layers, int bytesPerTexel, int levels);
+
+	// Reports objects that are still alive; call before the context is destroyed
+	static void Shutdown();
+
+	// Whether GL objects can still be deleted, false once Shutdown has been called
+	static bool ContextAlive();
+};
+
+/* Owns one GL object and destroys it through GpuResources when it goes out of scope.
+*  Handles can be moved but not copied, and convert to the object's ID so they can be
+*  passed straight to GL and GLState calls.
+*/
+template <GpuResourceType Type>
+class GpuHandle {
+public:
+	GpuHandle() : id(0) { }
+
+	explicit GpuHandle(const char* label) : id(GpuResources::Create(Type, label)) { }
+
+	~GpuHandle() {
+		Reset();
+	}
+
+	GpuHandle(const GpuHandle&) = delete;
+	GpuHandle& operator=(const GpuHandle&) = delete;
+
+	GpuHandle(GpuHandle&& other) noexcept : id(other.id) {
+		other.id = 0;
+	}
+
+	GpuHandle& operator=(GpuHandle&& other) noexcept {
+		if (this != &other) {
+			Reset();
+			id = other.id;
+			other.id = 0;
+		}
+		return *this;
+	}
+
+	// Destroys the object, leaving the handle empty
+	void Reset() {
+		if (id != 0) {
+			GpuResources::Destroy(Type, id);
+			id = 0;
+		}
+	}
+
+	// Records the bytes of storage the object holds
+	void SetBytes(size_t bytes) const {
+		GpuResources::SetBytes(Type, id, bytes);
+	}
+
+	unsigned int Get() const {
+		return id;
+	}
+
+	operator unsigned int() const {
+		return id;
+	}
+
+private:
+	unsigned int id;
+};
+
+typedef GpuHandle<GPU_BUFFER> GpuBuffer;
+typedef GpuHandle<GPU_VERTEX_ARRAY> GpuVertexArray;
+typedef GpuHandle<GPU_TEXTURE> GpuTexture;
+typedef GpuHandle<GPU_RENDERBUFFER> GpuRenderbuffer;
+typedef GpuHandle<GPU_FRAMEBUFFER> GpuFramebuffer;
@@ -0,0 +1,165 @@
+//*****************************************************************************
+// JobSystem.cpp
+//
+// Author: Kyle Manning
+//
+// Brief Description: Contains methods for JobSystem objects, which hand queued
+//					  jobs to a fixed pool of worker threads
+//*****************************************************************************
+#include "JobSystem.h"
+
+/// <summary>
+/// Default constructor for JobSystems; no threads are started until Init is called
+/// </summary>
+JobSystem::JobSystem() : running(0), quitting(false), batch(nullptr), batchCount(0), batchTag(ALLOC_UNTAGGED), batchHot(false), batchNext(0), batchWorkers(0) {
+}
+
+/// <summary>
+/// Lets the workers finish the jobs already queued and joins them
+/// </summary>
+JobSystem::~JobSystem() {
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		quitting = true;
+	}
+	wake.notify_all();
+
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+}
+
+/// <summary>
+/// Starts the worker threads
+/// </summary>
+/// <param name="workerCount">Number of workers, or 0 to size the pool from the hardware</param>
+void JobSystem::Init(unsigned int workerCount) {
+	if (workerCount == 0) {
+		unsigned int hardware = std::thread::hardware_concurrency();
+		workerCount = hardware > 1 ? hardware - 1 : 1;
+	}
+
+	for (unsigned int i = 0; i < workerCount; i++) {
+		workers.emplace_back(&JobSystem::WorkerLoop, this);
+	}
+}
+
+/// <summary>
+/// Queues a job and wakes one worker for it; the job is charged to the caller's allocation scope
+/// </summary>
+/// <param name="job">Work to run; must not touch the GL context</param>
+void JobSystem::Submit(std::function<void()> job) {
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		jobs.push({ std::move(job), AllocTracker::CurrentTag(), AllocTracker::CurrentHot() });
+	}
+	wake.notify_one();
+}
+
+/// <summary>
+/// Blocks the calling thread until the queue is empty and no worker is running a job
+/// </summary>
+void JobSystem::Wait() {
+	std::unique_lock<std::mutex> guard(lock);
+	idle.wait(guard, [this] { return jobs.empty() && running == 0; });
+}
+
+/// <summary>
+/// Waits for any other thread's ParallelFor, publishes the parts to the workers, claims parts on
+/// this thread until none are left, then waits for the workers still running one
+/// </summary>
+/// <param name="count">Number of parts</param>
+/// <param name="body">Work for one part, given its index; must not touch the GL context</param>
+void JobSystem::ParallelFor(unsigned int count, const std::function<void(unsigned int)>& body) {
+	if (count == 0) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> owner(batchOwner);
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		batch = &body;
+		batchCount = count;
+		batchTag = AllocTracker::CurrentTag();
+		batchHot = AllocTracker::CurrentHot();
+		batchNext.store(0, std::memory_order_relaxed);
+	}
+	wake.notify_all();
+
+	RunBatch();
+
+	// Every part is claimed, so no worker can join now; the ones that did are finishing theirs
+	std::unique_lock<std::mutex> guard(lock);
+	batchFinished.wait(guard, [this] { return batchWorkers == 0; });
+	batch = nullptr;
+}
+
+unsigned int JobSystem::WorkerCount() const {
+	return (unsigned int)workers.size();
+}
+
+/// <summary>
+/// Runs parts of a ParallelFor and jobs as they are queued, parts first; exits once the pool is
+/// shutting down and the queue is empty
+/// </summary>
+void JobSystem::WorkerLoop() {
+	while (true) {
+		QueuedJob job;
+
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			wake.wait(guard, [this] { return quitting || !jobs.empty() || BatchPending(); });
+
+			if (BatchPending()) {
+				batchWorkers += 1;
+				guard.unlock();
+
+				RunBatch();
+
+				guard.lock();
+				batchWorkers -= 1;
+				if (batchWorkers == 0) {
+					batchFinished.notify_all();
+				}
+				continue;
+			}
+
+			if (jobs.empty()) {
+				return;
+			}
+
+			job = std::move(jobs.front());
+			jobs.pop();
+			running += 1;
+		}
+
+		{
+			AllocScope jobScope(job.tag, job.hot);
+			job.work();
+		}
+
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			running -= 1;
+			if (jobs.empty() && running == 0) {
+				idle.notify_all();
+			}
+		}
+	}
+}
+
+/// <summary>
+/// Claims parts of the current ParallelFor until none are left, charging them to the scope the
+/// ParallelFor was called in
+/// </summary>
+void JobSystem::RunBatch() {
+	AllocScope batchScope(batchTag, batchHot);
+
+	for (unsigned int part = batchNext.fetch_add(1); part < batchCount; part = batchNext.fetch_add(1)) {
+		(*batch)(part);
+	}
+}
+
+bool JobSystem::BatchPending() const {
+	return batch != nullptr && batchNext.load(std::memory_order_relaxed) < batchCount;
+}
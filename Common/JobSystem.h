@@ -0,0 +1,90 @@
+//*****************************************************************************
+// JobSystem.h
+//
+// Author: Kyle Manning
+//
+// Brief Description: Header for JobSystem objects, a small pool of worker
+//					  threads shared by anything that runs work off the
+//					  main thread
+//*****************************************************************************
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "AllocTracker.h"
+
+/* Runs submitted jobs on a fixed set of worker threads in submission order. Jobs must not
+*  make GL calls, since the context only belongs to the main thread.
+*
+*  ParallelFor splits one piece of work into indexed parts that the workers and the calling
+*  thread claim one at a time. Workers take parts before queued jobs, and the caller keeps
+*  claiming parts itself, so it finishes even while every worker is busy with a long job. The
+*  parts are handed out through an atomic counter rather than the job queue, so a ParallelFor
+*  does not allocate. Only one ParallelFor runs at a time; one called from another thread, such
+*  as the sim while the render thread records commands, waits for the first to finish.
+*
+*  Jobs and parts run inside an AllocScope with the tag and hot flag of the thread that handed
+*  them over, so their allocations are charged, and trapped in steady state, as the caller's are.
+*/
+class JobSystem {
+public:
+	JobSystem();
+	~JobSystem();
+
+	// Starts the workers; 0 uses one fewer than the hardware thread count, and at least one
+	void Init(unsigned int workerCount = 0);
+
+	// Queues a job to run on the next free worker
+	void Submit(std::function<void()> job);
+
+	// Blocks until every submitted job has finished
+	void Wait();
+
+	// Runs body(0) to body(count - 1) on the workers and the calling thread and returns once all of
+	// them have finished; calls from different threads take turns
+	void ParallelFor(unsigned int count, const std::function<void(unsigned int)>& body);
+
+	unsigned int WorkerCount() const;
+
+private:
+	// A submitted job and the allocation scope it was submitted in
+	struct QueuedJob {
+		std::function<void()> work;
+		AllocTag tag;
+		bool hot;
+	};
+
+	std::vector<std::thread> workers;
+	std::queue<QueuedJob> jobs;
+	std::mutex lock;
+	std::condition_variable wake, idle;
+	unsigned int running;
+	bool quitting;
+
+	// Held for the whole of a ParallelFor, so calls from different threads take turns
+	std::mutex batchOwner;
+	// Parts of the current ParallelFor; batch is null when none is running
+	const std::function<void(unsigned int)>* batch;
+	unsigned int batchCount;
+	AllocTag batchTag;
+	bool batchHot;
+	std::atomic<unsigned int> batchNext;
+	unsigned int batchWorkers;
+	std::condition_variable batchFinished;
+
+	// Takes jobs off the queue until the pool is shut down
+	void WorkerLoop();
+
+	// Claims and runs parts of the current ParallelFor until none are left
+	void RunBatch();
+
+	// Whether a ParallelFor has parts left to claim; lock must be held
+	bool BatchPending() const;
+};
+
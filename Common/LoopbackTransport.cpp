@@ -0,0 +1,266 @@
+//*****************************************************************************
+// LoopbackTransport.cpp
+//
+// Author: Kyle Manning
+//
+// Brief Description: Contains methods for LoopbackTransport objects, which
+//					  hold outgoing packets for a simulated delay before
+//					  writing them to a non-blocking UDP socket; uses Winsock
+//					  on Windows and BSD sockets elsewhere
+//*****************************************************************************
+#include "LoopbackTransport.h"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "Ws2_32.lib")
+#endif
+typedef int SocketLength;
+const intptr_t NO_SOCKET = (intptr_t)INVALID_SOCKET;
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+typedef socklen_t SocketLength;
+const intptr_t NO_SOCKET = -1;
+#endif
+
+/// <summary>
+/// Fills an IPv4 address for a port on 127.0.0.1
+/// </summary>
+/// <param name="port">Port in host byte order</param>
+/// <returns>Loopback address</returns>
+static sockaddr_in LoopbackAddress(unsigned short port) {
+	sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_port = htons(port);
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	return address;
+}
+
+/// <summary>
+/// Default constructor for LoopbackTransports; no socket is opened until Open is called
+/// </summary>
+LoopbackTransport::LoopbackTransport() : handle(NO_SOCKET), remotePort(0), conditions(), randomState(1), stats() { }
+
+LoopbackTransport::~LoopbackTransport() {
+	Close();
+}
+
+/// <summary>
+/// Creates a non-blocking UDP socket bound to 127.0.0.1 on localPort, and takes the pool that
+/// held packets are kept in
+/// </summary>
+/// <param name="localPort">Port this end receives on</param>
+/// <param name="remotePort">Port the other end receives on</param>
+/// <returns>False if the socket could not be created or the port is in use</returns>
+bool LoopbackTransport::Open(unsigned short localPort, unsigned short remotePort) {
+	Close();
+
+#ifdef _WIN32
+	WSADATA data;
+	if (WSAStartup(MAKEWORD(2, 2), &data) != 0) {
+		std::cout << "ERROR::LOOPBACK_TRANSPORT::WINSOCK_NOT_STARTED" << std::endl;
+		return false;
+	}
+#endif
+
+	handle = (intptr_t)socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (handle == NO_SOCKET) {
+		std::cout << "ERROR::LOOPBACK_TRANSPORT::SOCKET_NOT_CREATED" << std::endl;
+		Close();
+		return false;
+	}
+
+	sockaddr_in address = LoopbackAddress(localPort);
+	if (bind(handle, (const sockaddr*)&address, sizeof(address)) != 0) {
+		std::cout << "ERROR::LOOPBACK_TRANSPORT::PORT_IN_USE " << localPort << std::endl;
+		Close();
+		return false;
+	}
+
+#ifdef _WIN32
+	u_long nonBlocking = 1;
+	ioctlsocket((SOCKET)handle, FIONBIO, &nonBlocking);
+#else
+	fcntl((int)handle, F_SETFL, fcntl((int)handle, F_GETFL, 0) | O_NONBLOCK);
+#endif
+
+	this->remotePort = remotePort;
+	pool.resize(NET_MAX_DELAYED_PACKETS);
+	delayed.clear();
+	delayed.reserve(NET_MAX_DELAYED_PACKETS);
+	freePackets.clear();
+	for (size_t i = NET_MAX_DELAYED_PACKETS; i > 0; i--) {
+		freePackets.push_back(i - 1);
+	}
+
+	// Each end gets its own loss and jitter sequence
+	randomState = 0x9E3779B9u ^ localPort;
+	stats = NetStats();
+	return true;
+}
+
+/// <summary>
+/// Closes the socket; packets still held by the simulator are lost
+/// </summary>
+void LoopbackTransport::Close() {
+	if (handle != NO_SOCKET) {
+#ifdef _WIN32
+		closesocket((SOCKET)handle);
+		WSACleanup();
+#else
+		close((int)handle);
+#endif
+		handle = NO_SOCKET;
+	}
+
+	delayed.clear();
+}
+
+bool LoopbackTransport::IsOpen() const {
+	return handle != NO_SOCKET;
+}
+
+void LoopbackTransport::SetConditions(const NetConditions& conditions) {
+	this->conditions = conditions;
+}
+
+const NetConditions& LoopbackTransport::Conditions() const {
+	return conditions;
+}
+
+/// <summary>
+/// Drops the packet at the loss rate, or holds a copy of it until its latency plus jitter have
+/// passed; with no latency or jitter it is written right away
+/// </summary>
+/// <param name="data">Packet bytes</param>
+/// <param name="size">Packet size, at most NET_MAX_PACKET_BYTES</param>
+void LoopbackTransport::Send(const uint8_t* data, size_t size) {
+	if (!IsOpen()) {
+		return;
+	}
+
+	if (size > NET_MAX_PACKET_BYTES) {
+		std::cout << "ERROR::LOOPBACK_TRANSPORT::PACKET_TOO_LARGE " << size << " bytes" << std::endl;
+		return;
+	}
+
+	stats.sent += 1;
+	stats.sentBytes += size;
+
+	if (conditions.lossPercent > 0.0f && NextRandom() * 100.0f < conditions.lossPercent) {
+		stats.dropped += 1;
+		return;
+	}
+
+	float delayMs = conditions.latencyMs + (NextRandom() * 2.0f - 1.0f) * conditions.jitterMs;
+	if (delayMs <= 0.0f) {
+		Transmit(data, size);
+		return;
+	}
+
+	if (freePackets.empty()) {
+		stats.dropped += 1;
+		return;
+	}
+
+	size_t index = freePackets.back();
+	freePackets.pop_back();
+
+	DelayedPacket& packet = pool[index];
+	packet.due = Now() + delayMs / 1000.0;
+	packet.size = size;
+	memcpy(packet.data, data, size);
+	delayed.push_back(index);
+}
+
+/// <summary>
+/// Lets held packets out, then reads the next packet that arrived, if any
+/// </summary>
+/// <param name="packet">Bytes of the packet read; replaced</param>
+/// <returns>False once no packet is waiting</returns>
+bool LoopbackTransport::Receive(std::vector<uint8_t>& packet) {
+	if (!IsOpen()) {
+		return false;
+	}
+
+	Flush();
+
+	packet.resize(NET_MAX_PACKET_BYTES);
+	sockaddr_in from;
+	SocketLength fromLength = sizeof(from);
+	int received = (int)recvfrom(handle, (char*)packet.data(), (int)packet.size(), 0, (sockaddr*)&from, &fromLength);
+	if (received <= 0) {
+		packet.clear();
+		return false;
+	}
+
+	packet.resize((size_t)received);
+	stats.received += 1;
+	stats.receivedBytes += (unsigned long long)received;
+	return true;
+}
+
+NetStats LoopbackTransport::GetStats() const {
+	NetStats result = stats;
+	result.delayed = (int)delayed.size();
+	return result;
+}
+
+double LoopbackTransport::Now() {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/// <summary>
+/// Steps a xorshift generator; the simulator only needs something cheap and repeatable
+/// </summary>
+/// <returns>Value from 0 to 1</returns>
+float LoopbackTransport::NextRandom() {
+	randomState ^= randomState << 13;
+	randomState ^= randomState >> 17;
+	randomState ^= randomState << 5;
+	return (float)(randomState >> 8) / (float)(1u << 24);
+}
+
+void LoopbackTransport::Transmit(const uint8_t* data, size_t size) {
+	sockaddr_in address = LoopbackAddress(remotePort);
+	sendto(handle, (const char*)data, (int)size, 0, (const sockaddr*)&address, sizeof(address));
+}
+
+/// <summary>
+/// Writes every held packet whose delay is up, in the order they come due rather than the order
+/// they were sent, and returns their places to the pool
+/// </summary>
+void LoopbackTransport::Flush() {
+	double now = Now();
+
+	while (!delayed.empty()) {
+		size_t earliest = 0;
+		for (size_t i = 1; i < delayed.size(); i++) {
+			if (pool[delayed[i]].due < pool[delayed[earliest]].due) {
+				earliest = i;
+			}
+		}
+
+		DelayedPacket& packet = pool[delayed[earliest]];
+		if (packet.due > now) {
+			break;
+		}
+
+		Transmit(packet.data, packet.size);
+		freePackets.push_back(delayed[earliest]);
+		delayed[earliest] = delayed.back();
+		delayed.pop_back();
+	}
+}
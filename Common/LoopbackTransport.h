@@ -0,0 +1,106 @@
+//*****************************************************************************
+// LoopbackTransport.h
+//
+// Author: Kyle Manning
+//
+// Brief Description: Header for LoopbackTransport, a non-blocking UDP socket
+//					  between two processes on the same machine, with a
+//					  simulator that adds latency, jitter, and packet loss to
+//					  what it sends
+//*****************************************************************************
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Largest packet sent or received
+const size_t NET_MAX_PACKET_BYTES = 1024;
+
+// Packets the simulator holds back at once; more are dropped as if the link were saturated
+const size_t NET_MAX_DELAYED_PACKETS = 256;
+
+// The link the simulator pretends packets cross
+struct NetConditions {
+	// One way delay, and how far each packet's delay may randomly stray from it either way
+	float latencyMs, jitterMs;
+	// Chance out of 100 that a packet is lost
+	float lossPercent;
+};
+
+struct NetStats {
+	unsigned long long sent, received, dropped;
+	unsigned long long sentBytes, receivedBytes;
+	// Packets the simulator is holding back
+	int delayed;
+};
+
+/* Both ends bind a port on 127.0.0.1 and send to the other's, so two copies of the game can talk
+*  on one machine without any setup. Sending and receiving never block; Receive returns false
+*  once nothing is waiting.
+*
+*  Packets do not go out when Send is called. The simulator first drops them at the loss rate,
+*  then holds the rest for the latency plus a random jitter, and only writes them to the socket
+*  once that time has passed, which happens whenever Send or Receive is called. Jitter can pass
+*  a packet out before one sent earlier, so packets arrive out of order as they can on a real
+*  network. With no latency, jitter, or loss set, packets go straight out.
+*
+*  Uses Winsock on Windows and BSD sockets elsewhere.
+*/
+class LoopbackTransport {
+public:
+	LoopbackTransport();
+	~LoopbackTransport();
+
+	LoopbackTransport(const LoopbackTransport&) = delete;
+	LoopbackTransport& operator=(const LoopbackTransport&) = delete;
+
+	// Binds 127.0.0.1 on localPort and sends everything to 127.0.0.1 on remotePort
+	bool Open(unsigned short localPort, unsigned short remotePort);
+
+	void Close();
+
+	bool IsOpen() const;
+
+	// Sets the link the simulator applies to packets sent from now on
+	void SetConditions(const NetConditions& conditions);
+
+	const NetConditions& Conditions() const;
+
+	// Passes a packet through the simulator; it is written to the socket once its delay is up
+	void Send(const uint8_t* data, size_t size);
+
+	// Sends any held packets that are due, then reads one waiting packet into packet
+	bool Receive(std::vector<uint8_t>& packet);
+
+	NetStats GetStats() const;
+
+private:
+	struct DelayedPacket {
+		double due;
+		size_t size;
+		uint8_t data[NET_MAX_PACKET_BYTES];
+	};
+
+	// SOCKET on Windows, a file descriptor elsewhere
+	intptr_t handle;
+	unsigned short remotePort;
+	NetConditions conditions;
+	// Held packets live in a fixed pool, so the simulator does not allocate per packet
+	std::vector<DelayedPacket> pool;
+	std::vector<size_t> delayed, freePackets;
+	uint32_t randomState;
+	NetStats stats;
+
+	// Seconds on a steady clock
+	static double Now();
+
+	// Uniform random value from 0 to 1 for loss and jitter
+	float NextRandom();
+
+	// Writes a packet to the socket
+	void Transmit(const uint8_t* data, size_t size);
+
+	// Writes every held packet whose delay is up
+	void Flush();
+};
@@ -0,0 +1,431 @@
+//*****************************************************************************
+// Narrowphase.cpp
+//
+// Author: Kyle Manning
+//
+// Brief Description: Contains the lane types the overlap kernels are built
+//					  over, the test for each pair of shapes, including the
+//					  swept tests of segments, the table that picks a batch's
+//					  kernel, and the batch itself
+//*****************************************************************************
+#include "Narrowphase.h"
+
+#include <cmath>
+#include <iostream>
+
+#if defined(__AVX2__)
+#define NARROWPHASE_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NARROWPHASE_SSE2
+#include <emmintrin.h>
+#endif
+
+// Values each kind of shape has, in the order center x, center y, extent x, extent y, facing x, facing y
+const int SHAPE_PARAMS[SHAPE_KIND_COUNT] = { 2, 4, 3, 4, 6 };
+
+/* Lane types, of which only the widest the compiler targets is built. Each holds one value of
+*  WIDTH pairs and supports the arithmetic and comparisons the tests use; comparisons give a
+*  Mask, which Bits turns into one bit per pair.
+*/
+#ifdef NARROWPHASE_SSE2
+struct SseMask {
+	__m128 v;
+};
+
+struct SseLanes {
+	typedef SseMask Mask;
+	static const int WIDTH = 4;
+	__m128 v;
+
+	static SseLanes Load(const float* values) {
+		return { _mm_loadu_ps(values) };
+	}
+
+	static SseLanes Set(float value) {
+		return { _mm_set1_ps(value) };
+	}
+
+	void Store(float* values) const {
+		_mm_storeu_ps(values, v);
+	}
+};
+
+static SseLanes operator+(SseLanes a, SseLanes b) { return { _mm_add_ps(a.v, b.v) }; }
+static SseLanes operator-(SseLanes a, SseLanes b) { return { _mm_sub_ps(a.v, b.v) }; }
+static SseLanes operator*(SseLanes a, SseLanes b) { return { _mm_mul_ps(a.v, b.v) }; }
+static SseLanes operator/(SseLanes a, SseLanes b) { return { _mm_div_ps(a.v, b.v) }; }
+static SseLanes Abs(SseLanes a) { return { _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v) }; }
+static SseLanes Sqrt(SseLanes a) { return { _mm_sqrt_ps(a.v) }; }
+static SseLanes Min(SseLanes a, SseLanes b) { return { _mm_min_ps(a.v, b.v) }; }
+static SseLanes Max(SseLanes a, SseLanes b) { return { _mm_max_ps(a.v, b.v) }; }
+static SseMask operator<=(SseLanes a, SseLanes b) { return { _mm_cmple_ps(a.v, b.v) }; }
+static SseMask operator<(SseLanes a, SseLanes b) { return { _mm_cmplt_ps(a.v, b.v) }; }
+static SseMask operator&(SseMask a, SseMask b) { return { _mm_and_ps(a.v, b.v) }; }
+static SseMask operator|(SseMask a, SseMask b) { return { _mm_or_ps(a.v, b.v) }; }
+static SseLanes Select(SseMask mask, SseLanes a, SseLanes b) { return { _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)) }; }
+static uint32_t Bits(SseMask mask) { return (uint32_t)_mm_movemask_ps(mask.v); }
+
+typedef SseLanes WideLanes;
+#elif defined(NARROWPHASE_AVX2)
+struct AvxMask {
+	__m256 v;
+};
+
+struct AvxLanes {
+	typedef AvxMask Mask;
+	static const int WIDTH = 8;
+	__m256 v;
+
+	static AvxLanes Load(const float* values) {
+		return { _mm256_loadu_ps(values) };
+	}
+
+	static AvxLanes Set(float value) {
+		return { _mm256_set1_ps(value) };
+	}
+
+	void Store(float* values) const {
+		_mm256_storeu_ps(values, v);
+	}
+};
+
+static AvxLanes operator+(AvxLanes a, AvxLanes b) { return { _mm256_add_ps(a.v, b.v) }; }
+static AvxLanes operator-(AvxLanes a, AvxLanes b) { return { _mm256_sub_ps(a.v, b.v) }; }
+static AvxLanes operator*(AvxLanes a, AvxLanes b) { return { _mm256_mul_ps(a.v, b.v) }; }
+static AvxLanes operator/(AvxLanes a, AvxLanes b) { return { _mm256_div_ps(a.v, b.v) }; }
+static AvxLanes Abs(AvxLanes a) { return { _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v) }; }
+static AvxLanes Sqrt(AvxLanes a) { return { _mm256_sqrt_ps(a.v) }; }
+static AvxLanes Min(AvxLanes a, AvxLanes b) { return { _mm256_min_ps(a.v, b.v) }; }
+static AvxLanes Max(AvxLanes a, AvxLanes b) { return { _mm256_max_ps(a.v, b.v) }; }
+static AvxMask operator<=(AvxLanes a, AvxLanes b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ) }; }
+static AvxMask operator<(AvxLanes a, AvxLanes b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ) }; }
+static AvxMask operator&(AvxMask a, AvxMask b) { return { _mm256_and_ps(a.v, b.v) }; }
+static AvxMask operator|(AvxMask a, AvxMask b) { return { _mm256_or_ps(a.v, b.v) }; }
+static AvxLanes Select(AvxMask mask, AvxLanes a, AvxLanes b) { return { _mm256_blendv_ps(b.v, a.v, mask.v) }; }
+static uint32_t Bits(AvxMask mask) { return (uint32_t)_mm256_movemask_ps(mask.v); }
+
+typedef AvxLanes WideLanes;
+#else
+struct ScalarMask {
+	bool v;
+};
+
+struct ScalarLanes {
+	typedef ScalarMask Mask;
+	static const int WIDTH = 1;
+	float v;
+
+	static ScalarLanes Load(const float* values) {
+		return { *values };
+	}
+
+	static ScalarLanes Set(float value) {
+		return { value };
+	}
+
+	void Store(float* values) const {
+		*values = v;
+	}
+};
+
+static ScalarLanes operator+(ScalarLanes a, ScalarLanes b) { return { a.v + b.v }; }
+static ScalarLanes operator-(ScalarLanes a, ScalarLanes b) { return { a.v - b.v }; }
+static ScalarLanes operator*(ScalarLanes a, ScalarLanes b) { return { a.v * b.v }; }
+static ScalarLanes operator/(ScalarLanes a, ScalarLanes b) { return { a.v / b.v }; }
+static ScalarLanes Abs(ScalarLanes a) { return { std::abs(a.v) }; }
+static ScalarLanes Sqrt(ScalarLanes a) { return { std::sqrt(a.v) }; }
+static ScalarLanes Min(ScalarLanes a, ScalarLanes b) { return { a.v < b.v ? a.v : b.v }; }
+static ScalarLanes Max(ScalarLanes a, ScalarLanes b) { return { a.v > b.v ? a.v : b.v }; }
+static ScalarMask operator<=(ScalarLanes a, ScalarLanes b) { return { a.v <= b.v }; }
+static ScalarMask operator<(ScalarLanes a, ScalarLanes b) { return { a.v < b.v }; }
+static ScalarMask operator&(ScalarMask a, ScalarMask b) { return { a.v && b.v }; }
+static ScalarMask operator|(ScalarMask a, ScalarMask b) { return { a.v || b.v }; }
+static ScalarLanes Select(ScalarMask mask, ScalarLanes a, ScalarLanes b) { return { mask.v ? a.v : b.v }; }
+static uint32_t Bits(ScalarMask mask) { return mask.v ? 1u : 0u; }
+
+typedef ScalarLanes WideLanes;
+#endif
+
+/* The test for each pair of shapes, given the values of the first shape in a and the second in
+*  b. Swept tests also write the time of impact; the others leave it at 0. Pairs without a
+*  specialization have no kernel.
+*/
+template <ShapeKind First, ShapeKind Second>
+struct PairTest;
+
+template <>
+struct PairTest<SHAPE_POINT, SHAPE_CIRCLE> {
+	template <class V>
+	static typename V::Mask Test(const V* a, const V* b, V&) {
+		V dx = a[0] - b[0];
+		V dy = a[1] - b[1];
+		return dx * dx + dy * dy < b[2] * b[2];
+	}
+};
+
+template <>
+struct PairTest<SHAPE_POINT, SHAPE_AABB> {
+	template <class V>
+	static typename V::Mask Test(const V* a, const V* b, V&) {
+		return (b[0] - b[2] <= a[0]) & (a[0] <= b[0] + b[2]) & (b[1] - b[3] <= a[1]) & (a[1] <= b[1] + b[3]);
+	}
+};
+
+template <>
+struct PairTest<SHAPE_POINT, SHAPE_OBB> {
+	// The offset is taken into the box's frame, whose x axis is the facing turned a quarter turn clockwise
+	template <class V>
+	static typename V::Mask Test(const V* a, const V* b, V&) {
+		V dx = a[0] - b[0];
+		V dy = a[1] - b[1];
+		V localX = dx * b[5] - dy * b[4];
+		V localY = dx * b[4] + dy * b[5];
+		return (Abs(localX) <= b[2]) & (Abs(localY) <= b[3]);
+	}
+};
+
+template <>
+struct PairTest<SHAPE_CIRCLE, SHAPE_CIRCLE> {
+	template <class V>
+	static typename V::Mask Test(const V* a, const V* b, V&) {
+		V dx = a[0] - b[0];
+		V dy = a[1] - b[1];
+		V reach = a[2] + b[2];
+		return dx * dx + dy * dy < reach * reach;
+	}
+};
+
+template <>
+struct PairTest<SHAPE_CIRCLE, SHAPE_AABB> {
+	// Distance from the circle's center to the closest point of the box
+	template <class V>
+	static typename V::Mask Test(const V* a, const V* b, V&) {
+		V dx = a[0] - Min(Max(a[0], b[0] - b[2]), b[0] + b[2]);
+		V dy = a[1] - Min(Max(a[1], b[1] - b[3]), b[1] + b[3]);
+		return dx * dx + dy * dy < a[2] * a[2];
+	}
+};
+
+template <>
+struct PairTest<SHAPE_AABB, SHAPE_AABB> {
+	template <class V>
+	static typename V::Mask Test(const V* a, const V* b, V&) {
+		return (Abs(a[0] - b[0]) <= a[2] + b[2]) & (Abs(a[1] - b[1]) <= a[3] + b[3]);
+	}
+};
+
+/// <summary>
+/// Narrows the fractions of a move during which a point is inside one slab of a box. A move too
+/// short to divide by is lengthened, which leaves a point that barely moves inside or outside the
+/// slab for the whole move, as it would be standing still
+/// </summary>
+template <class V>
+static void SweepSlab(V start, V move, V low, V high, V& enter, V& leave) {
+	V tiny = V::Set(SWEEP_MIN_MOVE);
+	move = Select(Abs(move) < tiny, tiny, move);
+	V toLow = (low - start) / move;
+	V toHigh = (high - start) / move;
+	enter = Max(enter, Min(toLow, toHigh));
+	leave = Min(leave, Max(toLow, toHigh));
+}
+
+/// <summary>
+/// Sweeps a point through a box given by its corners. The point hits when the fractions it is
+/// inside both slabs overlap within the move, and it enters at the latest of the slabs' entries
+/// </summary>
+template <class V>
+static typename V::Mask SweepBox(V startX, V startY, V moveX, V moveY, V lowX, V lowY, V highX, V highY, V& time) {
+	V enter = V::Set(0.0f);
+	V leave = V::Set(1.0f);
+	SweepSlab(startX, moveX, lowX, highX, enter, leave);
+	SweepSlab(startY, moveY, lowY, highY, enter, leave);
+	time = enter;
+	return enter <= leave;
+}
+
+template <>
+struct PairTest<SHAPE_SEGMENT, SHAPE_CIRCLE> {
+	// Solves for the first fraction at which the point is a radius from the center
+	template <class V>
+	static typename V::Mask Test(const V* a, const V* b, V& time) {
+		V zero = V::Set(0.0f);
+		V dx = a[0] - b[0];
+		V dy = a[1] - b[1];
+		V along = dx * a[2] + dy * a[3];
+		V moveSquared = a[2] * a[2] + a[3] * a[3];
+		V outside = dx * dx + dy * dy - b[2] * b[2];
+		V discriminant = along * along - moveSquared * outside;
+		V entry = (zero - along - Sqrt(Max(discriminant, zero))) / moveSquared;
+
+		typename V::Mask inside = outside < zero;
+		typename V::Mask crosses = (along < zero) & (zero < discriminant) & (entry <= V::Set(1.0f));
+		time = Select(inside, zero, entry);
+		return inside | crosses;
+	}
+};
+
+template <>
+struct PairTest<SHAPE_SEGMENT, SHAPE_AABB> {
+	template <class V>
+	static typename V::Mask Test(const V* a, const V* b, V& time) {
+		return SweepBox(a[0], a[1], a[2], a[3], b[0] - b[2], b[1] - b[3], b[0] + b[2], b[1] + b[3], time);
+	}
+};
+
+template <>
+struct PairTest<SHAPE_SEGMENT, SHAPE_OBB> {
+	// The start and the move are taken into the box's frame, as in the point test
+	template <class V>
+	static typename V::Mask Test(const V* a, const V* b, V& time) {
+		V zero = V::Set(0.0f);
+		V dx = a[0] - b[0];
+		V dy = a[1] - b[1];
+		V startX = dx * b[5] - dy * b[4];
+		V startY = dx * b[4] + dy * b[5];
+		V moveX = a[2] * b[5] - a[3] * b[4];
+		V moveY = a[2] * b[4] + a[3] * b[5];
+		return SweepBox(startX, startY, moveX, moveY, zero - b[2], zero - b[3], b[2], b[3], time);
+	}
+};
+
+typedef void (*PairKernel)(const float* const* first, const float* const* second, size_t count, uint32_t* hits, float* times);
+
+/// <summary>
+/// Loads WIDTH pairs at a time, runs the pair's test on them, ors the resulting bits into the
+/// hit words, and stores the times; the arrays are padded, so the last load and store never go
+/// past them
+/// </summary>
+template <ShapeKind First, ShapeKind Second>
+static void RunKernel(const float* const* first, const float* const* second, size_t count, uint32_t* hits, float* times) {
+	for (size_t i = 0; i < count; i += WideLanes::WIDTH) {
+		WideLanes a[SHAPE_MAX_PARAMS], b[SHAPE_MAX_PARAMS];
+		for (int p = 0; p < SHAPE_PARAMS[First]; p++) {
+			a[p] = WideLanes::Load(first[p] + i);
+		}
+		for (int p = 0; p < SHAPE_PARAMS[Second]; p++) {
+			b[p] = WideLanes::Load(second[p] + i);
+		}
+
+		WideLanes time = WideLanes::Set(0.0f);
+		hits[i / NARROWPHASE_HIT_BITS] |= Bits(PairTest<First, Second>::Test(a, b, time)) << (i % NARROWPHASE_HIT_BITS);
+		time.Store(times + i);
+	}
+}
+
+// Kernel for each pair of shape kinds, first kind by row; null where no test exists
+static const PairKernel KERNELS[SHAPE_KIND_COUNT][SHAPE_KIND_COUNT] = {
+	{ nullptr, nullptr, RunKernel<SHAPE_POINT, SHAPE_CIRCLE>, RunKernel<SHAPE_POINT, SHAPE_AABB>, RunKernel<SHAPE_POINT, SHAPE_OBB> },
+	{ nullptr, nullptr, RunKernel<SHAPE_SEGMENT, SHAPE_CIRCLE>, RunKernel<SHAPE_SEGMENT, SHAPE_AABB>, RunKernel<SHAPE_SEGMENT, SHAPE_OBB> },
+	{ nullptr, nullptr, RunKernel<SHAPE_CIRCLE, SHAPE_CIRCLE>, RunKernel<SHAPE_CIRCLE, SHAPE_AABB>, nullptr },
+	{ nullptr, nullptr, nullptr, RunKernel<SHAPE_AABB, SHAPE_AABB>, nullptr },
+	{ nullptr, nullptr, nullptr, nullptr, nullptr }
+};
+
+NarrowphaseBatch::NarrowphaseBatch() : kinds{ SHAPE_POINT, SHAPE_AABB }, count(0) {
+}
+
+/// <summary>
+/// Empties every array and sets the kinds the next pairs are; keeps the arrays' capacity so
+/// refilling the batch does not allocate
+/// </summary>
+/// <param name="first">Kind of the first shape of every pair</param>
+/// <param name="second">Kind of the second shape of every pair</param>
+void NarrowphaseBatch::Reset(ShapeKind first, ShapeKind second) {
+	if (KERNELS[first][second] == nullptr) {
+		std::cout << "ERROR::NARROWPHASE::NO_KERNEL_FOR_SHAPES " << first << " " << second << std::endl;
+	}
+
+	kinds[0] = first;
+	kinds[1] = second;
+	count = 0;
+	hits.clear();
+	times.clear();
+
+	for (int side = 0; side < 2; side++) {
+		for (int p = 0; p < SHAPE_MAX_PARAMS; p++) {
+			params[side][p].clear();
+		}
+	}
+}
+
+/// <summary>
+/// Appends the values each shape's kind uses to the batch's arrays
+/// </summary>
+/// <param name="first">First shape of the pair</param>
+/// <param name="second">Second shape of the pair</param>
+/// <returns>Index of the pair, for reading its result after Test</returns>
+size_t NarrowphaseBatch::Add(const Shape& first, const Shape& second) {
+	const Shape* shapes[2] = { &first, &second };
+
+	for (int side = 0; side < 2; side++) {
+		const float values[SHAPE_MAX_PARAMS] = { shapes[side]->center.x, shapes[side]->center.y, shapes[side]->extent.x,
+			shapes[side]->extent.y, shapes[side]->facing.x, shapes[side]->facing.y };
+		for (int p = 0; p < SHAPE_PARAMS[kinds[side]]; p++) {
+			params[side][p].push_back(values[p]);
+		}
+	}
+
+	return count++;
+}
+
+size_t NarrowphaseBatch::Size() const {
+	return count;
+}
+
+/// <summary>
+/// Pads the arrays with zeros to a whole number of lanes, runs the kernel for the batch's shapes,
+/// clears any bits the padding set, then trims the padding off again
+/// </summary>
+void NarrowphaseBatch::Test() {
+	size_t padded = (count + WideLanes::WIDTH - 1) / WideLanes::WIDTH * WideLanes::WIDTH;
+	hits.assign((count + NARROWPHASE_HIT_BITS - 1) / NARROWPHASE_HIT_BITS, 0);
+	times.assign(padded, 0.0f);
+
+	PairKernel kernel = KERNELS[kinds[0]][kinds[1]];
+	if (kernel == nullptr || count == 0) {
+		return;
+	}
+
+	const float* arrays[2][SHAPE_MAX_PARAMS] = {};
+	for (int side = 0; side < 2; side++) {
+		for (int p = 0; p < SHAPE_PARAMS[kinds[side]]; p++) {
+			params[side][p].resize(padded, 0.0f);
+			arrays[side][p] = params[side][p].data();
+		}
+	}
+
+	kernel(arrays[0], arrays[1], count, hits.data(), times.data());
+
+	if (count % NARROWPHASE_HIT_BITS != 0) {
+		hits.back() &= (1u << (count % NARROWPHASE_HIT_BITS)) - 1;
+	}
+
+	for (int side = 0; side < 2; side++) {
+		for (int p = 0; p < SHAPE_PARAMS[kinds[side]]; p++) {
+			params[side][p].resize(count);
+		}
+	}
+}
+
+bool NarrowphaseBatch::Hit(size_t index) const {
+	return (hits[index / NARROWPHASE_HIT_BITS] >> (index % NARROWPHASE_HIT_BITS) & 1u) != 0;
+}
+
+int NarrowphaseBatch::HitCount() const {
+	int total = 0;
+	for (uint32_t word : hits) {
+		for (; word != 0; word &= word - 1) {
+			total += 1;
+		}
+	}
+	return total;
+}
+
+float NarrowphaseBatch::Time(size_t index) const {
+	return times[index];
+}
+
+int NarrowphaseWidth() {
+	return WideLanes::WIDTH;
+}
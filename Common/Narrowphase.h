@@ -0,0 +1,110 @@
+//*****************************************************************************
+// Narrowphase.h
+//
+// Author: Kyle Manning
+//
+// Brief Description: Header for the narrowphase overlap kernels: shapes, the
+//					  batches that store candidate pairs of two shapes as
+//					  parallel arrays, and the SIMD tests that turn a batch
+//					  into a bitmask of hits and, for swept shapes, times of
+//					  impact
+//*****************************************************************************
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Kinds of shape the kernels test; which of a Shape's values are read depends on the kind
+enum ShapeKind {
+	// center
+	SHAPE_POINT,
+	// start in center, the move to its end in extent
+	SHAPE_SEGMENT,
+	// center, radius in extent.x
+	SHAPE_CIRCLE,
+	// center, half extents
+	SHAPE_AABB,
+	// center, half extents, and the facing its local +y points along
+	SHAPE_OBB,
+	SHAPE_KIND_COUNT
+};
+
+// Most values any kind of shape has
+const int SHAPE_MAX_PARAMS = 6;
+
+// Shortest move along an axis a swept test divides by; shorter moves are lengthened to it
+const float SWEEP_MIN_MOVE = 1e-20f;
+
+// Pairs tested per hit word
+const int NARROWPHASE_HIT_BITS = 32;
+
+struct Shape {
+	glm::vec2 center;
+	glm::vec2 extent;
+	glm::vec2 facing;
+};
+
+/* Overlap tests for many pairs at once. A batch holds candidate pairs of one kind of shape
+*  against one other kind, each value in its own array, so a kernel loads the same value of
+*  several pairs into one register. Kernels are written once over a lane type and built for
+*  AVX2 eight pairs at a time, SSE2 four at a time, or one at a time without either, whichever
+*  the compiler targets. Every comparison is done as a mask, and each pair's result comes out as
+*  one bit of a hit word, so there are no branches per pair.
+*
+*  Which kernel a batch runs is looked up in a table indexed by its two shape kinds, filled at
+*  compile time from the kernel templates, so adding a shape means adding its test and its table
+*  entries and nothing is dispatched through virtual calls. Kernels exist for a point or a
+*  segment against every other shape and for circle and box pairs; a pair is given with the
+*  simpler shape first.
+*
+*  A segment is a point swept through one move, the way a projectile travels over a tick, so a
+*  fast point cannot pass through a thin shape between two tests. Segment tests also give the
+*  time of impact: the fraction of the move at which the point first touches the other shape, 0
+*  when it starts inside. Tests of still shapes leave the time at 0. A segment that does not move
+*  hits exactly what a point at its start does.
+*
+*  Point tests against boxes are inclusive and against circles exclusive, matching the checks
+*  the game used before, so switching a check to a batch does not change what it hits. Batches
+*  pad their arrays to a whole number of registers, so every pair goes through the same
+*  instructions wherever it sits in the batch.
+*/
+class NarrowphaseBatch {
+public:
+	NarrowphaseBatch();
+
+	// Empties the batch and sets the kinds of shape its pairs are; prints an error if no kernel tests them
+	void Reset(ShapeKind first, ShapeKind second);
+
+	// Adds a candidate pair and returns its index
+	size_t Add(const Shape& first, const Shape& second);
+
+	size_t Size() const;
+
+	// Tests every pair added since Reset
+	void Test();
+
+	// Whether a pair overlapped in the last Test
+	bool Hit(size_t index) const;
+
+	// Pairs that overlapped in the last Test
+	int HitCount() const;
+
+	// Fraction of the first shape's move at which a pair that overlapped in the last Test first touched
+	float Time(size_t index) const;
+
+private:
+	ShapeKind kinds[2];
+	size_t count;
+	// One array per value of each shape
+	std::vector<float> params[2][SHAPE_MAX_PARAMS];
+	// Bit index % NARROWPHASE_HIT_BITS of word index / NARROWPHASE_HIT_BITS is set for each pair that overlapped
+	std::vector<uint32_t> hits;
+	// Time of impact of each pair, only meaningful where its hit bit is set
+	std::vector<float> times;
+};
+
+// Number of pairs the compiled kernels test at once
+int NarrowphaseWidth();
@@ -0,0 +1,355 @@
+//*****************************************************************************
+// SnapshotRing.cpp
+//
+// Author: Kyle Manning
+//
+// Brief Description: Contains methods for SnapshotRing objects, which encode
+//					  state images as zero-run deltas into a fixed ring of
+//					  memory and replay them from the nearest keyframe
+//*****************************************************************************
+#include "SnapshotRing.h"
+
+#include <algorithm>
+#include <iostream>
+
+/// <summary>
+/// Appends a value seven bits at a time, low bits first, with the top bit of each byte set while more follow
+/// </summary>
+/// <param name="value">Value to append</param>
+/// <param name="out">Bytes to append it to</param>
+static void WriteVarint(size_t value, std::vector<uint8_t>& out) {
+	while (value >= 0x80) {
+		out.push_back((uint8_t)(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back((uint8_t)value);
+}
+
+/// <summary>
+/// Reads a value written by WriteVarint
+/// </summary>
+/// <param name="data">Encoded bytes</param>
+/// <param name="size">Number of encoded bytes</param>
+/// <param name="offset">Where the value starts; moved past it</param>
+/// <param name="value">Value read</param>
+/// <returns>False if the bytes ran out or the value is too long to be one that was written</returns>
+static bool ReadVarint(const uint8_t* data, size_t size, size_t& offset, size_t& value) {
+	value = 0;
+	for (int shift = 0; shift < 64; shift += 7) {
+		if (offset >= size) {
+			return false;
+		}
+
+		uint8_t byte = data[offset++];
+		value |= (size_t)(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/// <summary>
+/// Encodes the XOR of an image with a base as runs of zeros, stored as their length, each
+/// followed by a run of changed bytes stored as they are. A changed run only ends at
+/// SNAPSHOT_MIN_ZERO_RUN zeros, since a shorter zero run costs more to end and restart than
+/// to copy. The base is treated as zeros past its end.
+/// </summary>
+/// <param name="image">Image to encode</param>
+/// <param name="base">Image it is stored against; empty for a keyframe</param>
+/// <param name="out">Encoded bytes; replaced</param>
+static void EncodeDelta(const std::vector<uint8_t>& image, const std::vector<uint8_t>& base, std::vector<uint8_t>& out) {
+	out.clear();
+	size_t size = image.size();
+	auto changed = [&](size_t i) {
+		return (image[i] ^ (i < base.size() ? base[i] : 0)) != 0;
+	};
+
+	size_t i = 0;
+	while (i < size) {
+		size_t zeroStart = i;
+		while (i < size && !changed(i)) {
+			i++;
+		}
+
+		// Extend the changed run over short gaps of unchanged bytes
+		size_t literalEnd = i, zerosSeen = 0;
+		while (literalEnd + zerosSeen < size && zerosSeen < SNAPSHOT_MIN_ZERO_RUN) {
+			if (changed(literalEnd + zerosSeen)) {
+				literalEnd += zerosSeen + 1;
+				zerosSeen = 0;
+			}
+			else {
+				zerosSeen++;
+			}
+		}
+
+		WriteVarint(i - zeroStart, out);
+		WriteVarint(literalEnd - i, out);
+		for (; i < literalEnd; i++) {
+			out.push_back(image[i] ^ (i < base.size() ? base[i] : 0));
+		}
+	}
+}
+
+/// <summary>
+/// Applies encoded bytes from EncodeDelta to the image they were stored against
+/// </summary>
+/// <param name="delta">Encoded bytes</param>
+/// <param name="size">Number of encoded bytes</param>
+/// <param name="imageSize">Size of the image they encode</param>
+/// <param name="image">Base image, turned into the encoded one; empty for a keyframe</param>
+/// <returns>False if the encoded bytes do not fit the image size</returns>
+static bool ApplyDelta(const uint8_t* delta, size_t size, size_t imageSize, std::vector<uint8_t>& image) {
+	// Bytes past the end of the base are zeros, as the encoder treated them
+	image.resize(imageSize, 0);
+
+	size_t offset = 0, position = 0;
+	while (offset < size) {
+		size_t zeroRun, literalLength;
+		if (!ReadVarint(delta, size, offset, zeroRun) || !ReadVarint(delta, size, offset, literalLength)) {
+			return false;
+		}
+
+		if (zeroRun > imageSize - position || literalLength > imageSize - position - zeroRun || literalLength > size - offset) {
+			return false;
+		}
+
+		position += zeroRun;
+		uint8_t* target = image.data() + position;
+		const uint8_t* source = delta + offset;
+		for (size_t i = 0; i < literalLength; i++) {
+			target[i] ^= source[i];
+		}
+
+		position += literalLength;
+		offset += literalLength;
+	}
+
+	return true;
+}
+
+SnapshotRing::SnapshotRing() : first(0), count(0), keyframeInterval(1), sinceKeyframe(0) { }
+
+/// <summary>
+/// Allocates everything the ring will use, so pushing snapshots only allocates while the
+/// images being encoded are still growing
+/// </summary>
+/// <param name="byteCapacity">Bytes of encoded snapshots the ring holds</param>
+/// <param name="maxSnapshots">Most snapshots the ring holds, however small they are</param>
+/// <param name="keyframeInterval">Snapshots from one keyframe to the next</param>
+void SnapshotRing::Init(size_t byteCapacity, size_t maxSnapshots, int keyframeInterval) {
+	data.assign(byteCapacity, 0);
+	records.assign(maxSnapshots, Record());
+	this->keyframeInterval = keyframeInterval > 0 ? keyframeInterval : 1;
+	Clear();
+}
+
+/// <summary>
+/// Encodes an image against the previous one, or as a keyframe when one is due or the ring is
+/// empty, and stores it after the newest snapshot
+/// </summary>
+/// <param name="tick">Sim tick the image was taken on</param>
+/// <param name="image">Bytes of the state</param>
+void SnapshotRing::Push(unsigned long long tick, const std::vector<uint8_t>& image) {
+	if (data.empty() || records.empty()) {
+		std::cout << "ERROR::SNAPSHOT_RING::NOT_INITIALIZED" << std::endl;
+		return;
+	}
+
+	static const std::vector<uint8_t> NO_BASE;
+	bool keyframe = count == 0 || sinceKeyframe + 1 >= keyframeInterval;
+	EncodeDelta(image, keyframe ? NO_BASE : previous, encoded);
+	if (encoded.size() > data.size()) {
+		std::cout << "ERROR::SNAPSHOT_RING::SNAPSHOT_LARGER_THAN_RING: " << encoded.size() << " bytes" << std::endl;
+		return;
+	}
+
+	size_t offset = MakeRoom(encoded.size());
+
+	// Making room dropped the snapshot this delta was against, so it has to stand on its own
+	if (!keyframe && count == 0) {
+		keyframe = true;
+		EncodeDelta(image, NO_BASE, encoded);
+		if (encoded.size() > data.size()) {
+			std::cout << "ERROR::SNAPSHOT_RING::SNAPSHOT_LARGER_THAN_RING: " << encoded.size() << " bytes" << std::endl;
+			return;
+		}
+
+		offset = MakeRoom(encoded.size());
+	}
+
+	std::copy(encoded.begin(), encoded.end(), data.begin() + offset);
+	Record& record = At(count);
+	record.tick = tick;
+	record.offset = offset;
+	record.size = encoded.size();
+	record.imageSize = image.size();
+	record.keyframe = keyframe;
+	count++;
+
+	sinceKeyframe = keyframe ? 0 : sinceKeyframe + 1;
+	previous = image;
+}
+
+size_t SnapshotRing::Count() const {
+	return count;
+}
+
+unsigned long long SnapshotRing::Tick(size_t index) const {
+	return At(index).tick;
+}
+
+/// <summary>
+/// Finds the snapshot to go back to for a tick
+/// </summary>
+/// <param name="tick">Latest tick the snapshot may have been taken on</param>
+/// <param name="index">Index of the snapshot found</param>
+/// <returns>False if there are no snapshots at or before tick</returns>
+bool SnapshotRing::Find(unsigned long long tick, size_t& index) const {
+	for (size_t i = count; i > 0; i--) {
+		if (At(i - 1).tick <= tick) {
+			index = i - 1;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/// <summary>
+/// Rebuilds the image of a snapshot by decoding the keyframe at or before it and applying
+/// each delta up to it in order
+/// </summary>
+/// <param name="index">Snapshot to rebuild, 0 being the oldest</param>
+/// <param name="image">Its image; replaced</param>
+/// <returns>False if there is no such snapshot or its bytes are damaged</returns>
+bool SnapshotRing::Decode(size_t index, std::vector<uint8_t>& image) const {
+	if (index >= count) {
+		return false;
+	}
+
+	// The oldest snapshot is always a keyframe, so this stops by index 0
+	size_t keyframe = index;
+	while (!At(keyframe).keyframe) {
+		keyframe--;
+	}
+
+	image.clear();
+	for (size_t i = keyframe; i <= index; i++) {
+		const Record& record = At(i);
+		if (!ApplyDelta(data.data() + record.offset, record.size, record.imageSize, image)) {
+			std::cout << "ERROR::SNAPSHOT_RING::DAMAGED_SNAPSHOT: tick " << record.tick << std::endl;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Goes back to a snapshot, for rewinding the sim to it; later snapshots are dropped, since
+/// once the sim runs on from the restored state they describe a future that will not happen
+/// </summary>
+/// <param name="index">Snapshot to go back to, 0 being the oldest</param>
+/// <param name="image">Its image; replaced</param>
+/// <returns>False if there is no such snapshot or its bytes are damaged</returns>
+bool SnapshotRing::Rewind(size_t index, std::vector<uint8_t>& image) {
+	if (!Decode(index, image)) {
+		return false;
+	}
+
+	count = index + 1;
+	sinceKeyframe = 0;
+	while (!At(index - sinceKeyframe).keyframe) {
+		sinceKeyframe++;
+	}
+
+	previous = image;
+	return true;
+}
+
+void SnapshotRing::Clear() {
+	first = 0;
+	count = 0;
+	sinceKeyframe = 0;
+	previous.clear();
+}
+
+SnapshotRingStats SnapshotRing::GetStats() const {
+	SnapshotRingStats stats = {};
+	stats.snapshots = (int)count;
+	stats.capacity = data.size();
+	for (size_t i = 0; i < count; i++) {
+		const Record& record = At(i);
+		stats.keyframes += record.keyframe ? 1 : 0;
+		stats.used += record.size;
+		stats.rawBytes += record.imageSize;
+	}
+
+	if (count > 0) {
+		stats.oldestTick = At(0).tick;
+		stats.newestTick = At(count - 1).tick;
+	}
+
+	return stats;
+}
+
+SnapshotRing::Record& SnapshotRing::At(size_t index) {
+	return records[(first + index) % records.size()];
+}
+
+const SnapshotRing::Record& SnapshotRing::At(size_t index) const {
+	return records[(first + index) % records.size()];
+}
+
+/// <summary>
+/// Drops the oldest snapshot, then every delta after it up to the next keyframe, since they
+/// cannot be decoded without it
+/// </summary>
+void SnapshotRing::DropOldest() {
+	do {
+		first = (first + 1) % records.size();
+		count--;
+	} while (count > 0 && !At(0).keyframe);
+
+	if (count == 0) {
+		Clear();
+	}
+}
+
+/// <summary>
+/// Finds room for size bytes after the newest snapshot, wrapping to the start of the ring
+/// when they do not fit before the end, and drops the oldest snapshots in the way
+/// </summary>
+/// <param name="size">Bytes to make room for; at most the ring's capacity</param>
+/// <returns>Offset of the room made</returns>
+size_t SnapshotRing::MakeRoom(size_t size) {
+	if (count == records.size()) {
+		DropOldest();
+	}
+
+	if (count == 0) {
+		return 0;
+	}
+
+	const Record& newest = At(count - 1);
+	size_t offset = newest.offset + newest.size;
+	if (offset + size > data.size()) {
+		// Snapshots laid out past the newest are older than everything before it, so all of
+		// them go before writing from the start again
+		while (count > 0 && At(0).offset >= offset) {
+			DropOldest();
+		}
+
+		offset = 0;
+	}
+
+	// Snapshots are laid out in the order they were taken, so the ones in the way are the oldest
+	while (count > 0 && At(0).offset < offset + size && offset < At(0).offset + At(0).size) {
+		DropOldest();
+	}
+
+	return count == 0 ? 0 : offset;
+}
@@ -0,0 +1,96 @@
+//*****************************************************************************
+// SnapshotRing.h
+//
+// Author: Kyle Manning
+//
+// Brief Description: Header for SnapshotRing, which keeps the most recent
+//					  snapshots of simulation state in a fixed block of memory,
+//					  each stored as the bytes that changed since the one
+//					  before it
+//*****************************************************************************
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Shortest run of unchanged bytes worth ending a run of changed ones for
+const size_t SNAPSHOT_MIN_ZERO_RUN = 4;
+
+// How full the ring is and how well its snapshots compress
+struct SnapshotRingStats {
+	int snapshots, keyframes;
+	size_t capacity, used;
+	// Bytes the stored snapshots would take as full images
+	size_t rawBytes;
+	unsigned long long oldestTick, newestTick;
+};
+
+/* A snapshot is handed in as an image: the bytes of the state written by a StateWriter, which
+*  come out in the same order tick after tick. Each image is stored as its XOR with the image
+*  before it, so bytes that did not change become zero, and the XOR is written as alternating
+*  runs of zeros, stored only as a length, and changed bytes, copied as they are. Every
+*  keyframeInterval snapshots, and whenever the one before it is gone, an image is stored
+*  against an empty one instead, which is the whole image with its zero runs squeezed out.
+*
+*  The memory for the encoded bytes and the record of each snapshot is taken once in Init, and
+*  snapshots are laid out one after another, wrapping to the start when one does not fit before
+*  the end. Making room drops the oldest snapshots, and then any deltas left without the
+*  keyframe they start from, so the oldest snapshot kept is always a keyframe. Decoding one
+*  replays the keyframe at or before it and the deltas up to it, so the cost of a restore is
+*  bounded by the keyframe interval rather than by how long the ring is.
+*/
+class SnapshotRing {
+public:
+	SnapshotRing();
+
+	// Takes the memory for the encoded snapshots and their records; call before Push
+	void Init(size_t byteCapacity, size_t maxSnapshots, int keyframeInterval);
+
+	// Stores an image as the newest snapshot, dropping the oldest ones to make room
+	void Push(unsigned long long tick, const std::vector<uint8_t>& image);
+
+	// Number of snapshots stored; index 0 is the oldest
+	size_t Count() const;
+
+	unsigned long long Tick(size_t index) const;
+
+	// Index of the newest snapshot taken at or before tick; returns false if every snapshot is later
+	bool Find(unsigned long long tick, size_t& index) const;
+
+	// Rebuilds the image of a snapshot
+	bool Decode(size_t index, std::vector<uint8_t>& image) const;
+
+	// Rebuilds the image of a snapshot and drops every snapshot after it, so the next Push
+	// continues from it as if the later ones had never been taken
+	bool Rewind(size_t index, std::vector<uint8_t>& image);
+
+	// Drops every snapshot; the next Push is a keyframe
+	void Clear();
+
+	SnapshotRingStats GetStats() const;
+
+private:
+	struct Record {
+		unsigned long long tick;
+		size_t offset, size, imageSize;
+		bool keyframe;
+	};
+
+	std::vector<uint8_t> data;
+	// Records in a ring of their own, count of them starting at first
+	std::vector<Record> records;
+	size_t first, count;
+	int keyframeInterval, sinceKeyframe;
+	// Image of the newest snapshot, which the next one is stored against, and the encoded bytes being built
+	std::vector<uint8_t> previous, encoded;
+
+	Record& At(size_t index);
+	const Record& At(size_t index) const;
+
+	// Drops the oldest snapshot, then any deltas whose keyframe went with it
+	void DropOldest();
+
+	// Drops snapshots until size bytes fit after the newest, and returns where they go
+	size_t MakeRoom(size_t size);
+};
@@ -0,0 +1,113 @@
+//*****************************************************************************
+// SpatialHash.cpp
+//
+// Author: Kyle Manning
+//
+// Brief Description: Contains the counting sort that builds a SpatialHash and
+//					  the accessors for its buckets
+//*****************************************************************************
+#include "SpatialHash.h"
+
+#include <cmath>
+
+// Fewest buckets a table is built with, and how many buckets it aims to have per entry
+const uint32_t MIN_BUCKETS = 256;
+const uint32_t BUCKETS_PER_ENTRY = 2;
+
+// Primes the cell coordinates are multiplied by before they are mixed into a bucket
+const uint32_t HASH_PRIME_X = 73856093u;
+const uint32_t HASH_PRIME_Y = 19349663u;
+
+SpatialHash::SpatialHash() : inverseCellSize(1.0f), bucketMask(0) {
+}
+
+/// <summary>
+/// Sizes the table to the next power of two above BUCKETS_PER_ENTRY buckets per box, counts what
+/// each bucket will hold, turns the counts into start offsets, then writes every box into the
+/// buckets of the cells it covers
+/// </summary>
+/// <param name="cellSize">Width and height of a cell in world units</param>
+/// <param name="boxMin">Lower corner of each box</param>
+/// <param name="boxMax">Upper corner of each box</param>
+/// <param name="boxCount">Number of boxes</param>
+void SpatialHash::Build(float cellSize, const glm::vec2* boxMin, const glm::vec2* boxMax, uint32_t boxCount) {
+	inverseCellSize = 1.0f / cellSize;
+
+	uint32_t buckets = MIN_BUCKETS;
+	while (buckets < boxCount * BUCKETS_PER_ENTRY) {
+		buckets *= 2;
+	}
+	bucketMask = buckets - 1;
+
+	// Counts land one bucket up, so the running sum below leaves each bucket's start in place
+	boxStart.assign(buckets + 1, 0);
+	for (uint32_t i = 0; i < boxCount; i++) {
+		int x0 = Cell(boxMin[i].x), x1 = Cell(boxMax[i].x);
+		int y0 = Cell(boxMin[i].y), y1 = Cell(boxMax[i].y);
+		for (int y = y0; y <= y1; y++) {
+			for (int x = x0; x <= x1; x++) {
+				boxStart[Bucket(x, y) + 1] += 1;
+			}
+		}
+	}
+
+	for (uint32_t b = 0; b < buckets; b++) {
+		boxStart[b + 1] += boxStart[b];
+	}
+
+	boxItems.resize(boxStart[buckets]);
+	cursor.assign(boxStart.begin(), boxStart.end() - 1);
+	for (uint32_t i = 0; i < boxCount; i++) {
+		int x0 = Cell(boxMin[i].x), x1 = Cell(boxMax[i].x);
+		int y0 = Cell(boxMin[i].y), y1 = Cell(boxMax[i].y);
+		for (int y = y0; y <= y1; y++) {
+			for (int x = x0; x <= x1; x++) {
+				boxItems[cursor[Bucket(x, y)]++] = i;
+			}
+		}
+	}
+}
+
+uint32_t SpatialHash::BucketCount() const {
+	return bucketMask + 1;
+}
+
+uint32_t SpatialHash::BucketOf(glm::vec2 point) const {
+	return Bucket(Cell(point.x), Cell(point.y));
+}
+
+/// <summary>
+/// Appends the bucket of each cell a box covers, row by row
+/// </summary>
+/// <param name="boxMin">Lower corner of the box</param>
+/// <param name="boxMax">Upper corner of the box</param>
+/// <param name="buckets">Receives the buckets</param>
+void SpatialHash::BucketsOf(glm::vec2 boxMin, glm::vec2 boxMax, std::vector<uint32_t>& buckets) const {
+	int x0 = Cell(boxMin.x), x1 = Cell(boxMax.x);
+	int y0 = Cell(boxMin.y), y1 = Cell(boxMax.y);
+	for (int y = y0; y <= y1; y++) {
+		for (int x = x0; x <= x1; x++) {
+			buckets.push_back(Bucket(x, y));
+		}
+	}
+}
+
+const uint32_t* SpatialHash::BoxesBegin(uint32_t bucket) const {
+	return boxItems.data() + boxStart[bucket];
+}
+
+const uint32_t* SpatialHash::BoxesEnd(uint32_t bucket) const {
+	return boxItems.data() + boxStart[bucket + 1];
+}
+
+uint32_t SpatialHash::BoxEntries() const {
+	return (uint32_t)boxItems.size();
+}
+
+uint32_t SpatialHash::Bucket(int x, int y) const {
+	return ((uint32_t)x * HASH_PRIME_X ^ (uint32_t)y * HASH_PRIME_Y) & bucketMask;
+}
+
+int SpatialHash::Cell(float coordinate) const {
+	return (int)std::floor(coordinate * inverseCellSize);
+}
@@ -0,0 +1,67 @@
+//*****************************************************************************
+// SpatialHash.h
+//
+// Author: Kyle Manning
+//
+// Brief Description: Header for SpatialHash objects, which bin boxes into the
+//					  buckets of a hashed grid so that a point only needs to
+//					  be tested against the boxes sharing its bucket
+//*****************************************************************************
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+/* The world is cut into square cells, and each cell is hashed to one of a power of two number
+*  of buckets, so the table stays small however far apart things are. A box goes into the
+*  bucket of every cell it overlaps, so a point can only overlap boxes in the bucket of the cell
+*  it is in, and a box, such as the path a point sweeps, only overlaps boxes in the buckets of
+*  the cells it covers. Different cells can share a bucket, and a box spanning two such cells
+*  is listed there twice, next to itself, so callers still test each pair exactly and skip
+*  repeats.
+*
+*  Build is a counting sort: one pass counts the entries of each bucket and a second writes
+*  them in box order, so a bucket's boxes are one contiguous, ascending range. Nothing is
+*  allocated once the arrays have grown to the busiest tick. The built table is only read
+*  afterward, so any number of threads may query it at once.
+*/
+class SpatialHash {
+public:
+	SpatialHash();
+
+	// Bins boxCount boxes into cells of the given size, replacing what was there
+	void Build(float cellSize, const glm::vec2* boxMin, const glm::vec2* boxMax, uint32_t boxCount);
+
+	uint32_t BucketCount() const;
+
+	// Bucket of the cell a point is in
+	uint32_t BucketOf(glm::vec2 point) const;
+
+	// Appends the bucket of every cell a box overlaps, which can repeat when cells share a bucket
+	void BucketsOf(glm::vec2 boxMin, glm::vec2 boxMax, std::vector<uint32_t>& buckets) const;
+
+	// Indices of the boxes in a bucket, from first to last
+	const uint32_t* BoxesBegin(uint32_t bucket) const;
+	const uint32_t* BoxesEnd(uint32_t bucket) const;
+
+	// Box entries across every bucket, counting a box once per bucket it is in
+	uint32_t BoxEntries() const;
+
+private:
+	float inverseCellSize;
+	uint32_t bucketMask;
+
+	// Where each bucket's entries start; one past the last bucket holds the total
+	std::vector<uint32_t> boxStart;
+	std::vector<uint32_t> boxItems;
+	// Next free entry of each bucket while filling
+	std::vector<uint32_t> cursor;
+
+	// Bucket the cell at grid coordinates (x, y) hashes to
+	uint32_t Bucket(int x, int y) const;
+
+	// Grid coordinate of a world coordinate
+	int Cell(float coordinate) const;
+};
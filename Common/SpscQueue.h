@@ -0,0 +1,77 @@
+//*****************************************************************************
+// SpscQueue.h
+//
+// Author: Kyle Manning
+//
+// Brief Description: Header for SpscQueue, a fixed size lock-free queue with
+//					  one producer thread and one consumer thread, used by
+//					  Geometry Shooter
+//*****************************************************************************
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+/* A ring of Capacity items written by one thread and read by another without locks. The producer
+*  only moves tail and the consumer only moves head, so each index has a single writer; release
+*  stores publish an item or a free slot, and acquire loads on the other side see it. Items are
+*  copied in and out, so T should be small and trivially copyable.
+*
+*  The queue never allocates. When it is full Push fails and the item is counted as dropped.
+*/
+template <class T, size_t Capacity>
+class SpscQueue {
+	static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+public:
+	SpscQueue() : head(0), tail(0), dropped(0) { }
+
+	SpscQueue(const SpscQueue&) = delete;
+	SpscQueue& operator=(const SpscQueue&) = delete;
+
+	// Producer: adds an item to the back, returning false and counting a drop if the queue is full
+	bool Push(const T& item) {
+		size_t back = tail.load(std::memory_order_relaxed);
+		if (back - head.load(std::memory_order_acquire) == Capacity) {
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+
+		items[back & (Capacity - 1)] = item;
+		tail.store(back + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer: copies the front item without removing it, returning false if the queue is empty
+	bool Peek(T& item) const {
+		size_t front = head.load(std::memory_order_relaxed);
+		if (front == tail.load(std::memory_order_acquire)) {
+			return false;
+		}
+
+		item = items[front & (Capacity - 1)];
+		return true;
+	}
+
+	// Consumer: removes the front item; only valid after Peek returned true
+	void Pop() {
+		head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	// Items waiting; exact only on the consumer thread
+	size_t Size() const {
+		return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+	}
+
+	// Items lost because the queue was full
+	unsigned long long Dropped() const {
+		return dropped.load(std::memory_order_relaxed);
+	}
+
+private:
+	T items[Capacity];
+	// Kept on separate cache lines so the two threads do not invalidate each other's index
+	alignas(64) std::atomic<size_t> head;
+	alignas(64) std::atomic<size_t> tail;
+	std::atomic<unsigned long long> dropped;
+};
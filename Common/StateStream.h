@@ -0,0 +1,127 @@
+//*****************************************************************************
+// StateStream.h
+//
+// Author: Kyle Manning
+//
+// Brief Description: Header for StateWriter and StateReader, which turn plain
+//					  values and arrays of them into a flat run of bytes and
+//					  back, for snapshots of simulation state
+//*****************************************************************************
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+/* Values are copied in as their bytes, with no field names, tags, or byte order fixups, so a
+*  stream is only readable by the same build on the same kind of machine, which is all a rewind
+*  or a save of the current session needs. Arrays are written as their length followed by their
+*  elements. Only trivially copyable types are accepted, so nothing holding a pointer is written
+*  by accident.
+*
+*  The writer keeps its buffer between uses, so building a snapshot every few ticks stops
+*  allocating once the buffer has grown to the size of the state.
+*/
+class StateWriter {
+public:
+	// Empties the stream without giving back its memory
+	void Clear() {
+		bytes.clear();
+	}
+
+	template <class T>
+	void Write(const T& value) {
+		static_assert(std::is_trivially_copyable<T>::value, "StateWriter only writes trivially copyable values");
+		WriteBytes(&value, sizeof(T));
+	}
+
+	// Writes the element count and then the elements of any vector, whatever its allocator
+	template <class T, class Alloc>
+	void WriteArray(const std::vector<T, Alloc>& values) {
+		static_assert(std::is_trivially_copyable<T>::value, "StateWriter only writes trivially copyable values");
+		Write((uint32_t)values.size());
+		if (!values.empty()) {
+			WriteBytes(values.data(), values.size() * sizeof(T));
+		}
+	}
+
+	const std::vector<uint8_t>& Bytes() const {
+		return bytes;
+	}
+
+private:
+	std::vector<uint8_t> bytes;
+
+	void WriteBytes(const void* data, size_t size) {
+		size_t offset = bytes.size();
+		bytes.resize(offset + size);
+		memcpy(bytes.data() + offset, data, size);
+	}
+};
+
+/* Reads values back in the order they were written. Reading past the end fails the reader
+*  rather than the program: the value is zeroed, and every read after it does nothing, so a
+*  caller can read a whole snapshot and check Failed once at the end.
+*/
+class StateReader {
+public:
+	StateReader(const uint8_t* data, size_t size) : data(data), size(size), offset(0), failed(false) { }
+
+	template <class T>
+	void Read(T& value) {
+		static_assert(std::is_trivially_copyable<T>::value, "StateReader only reads trivially copyable values");
+		ReadBytes(&value, sizeof(T));
+	}
+
+	// Resizes the vector to the written count and reads its elements
+	template <class T, class Alloc>
+	void ReadArray(std::vector<T, Alloc>& values) {
+		static_assert(std::is_trivially_copyable<T>::value, "StateReader only reads trivially copyable values");
+		uint32_t count = 0;
+		Read(count);
+		// A count larger than what is left can only come from a damaged stream
+		if (failed || count > (size - offset) / sizeof(T)) {
+			failed = true;
+			values.clear();
+			return;
+		}
+
+		values.resize(count);
+		if (count > 0) {
+			ReadBytes(values.data(), count * sizeof(T));
+		}
+	}
+
+	// Whether a read went past the end or the stream was otherwise unreadable
+	bool Failed() const {
+		return failed;
+	}
+
+	// Marks the stream unreadable, for checks the caller makes on what it read
+	void Fail() {
+		failed = true;
+	}
+
+	// Whether every byte was read
+	bool AtEnd() const {
+		return offset == size;
+	}
+
+private:
+	const uint8_t* data;
+	size_t size, offset;
+	bool failed;
+
+	void ReadBytes(void* out, size_t count) {
+		if (failed || count > size - offset) {
+			failed = true;
+			memset(out, 0, count);
+			return;
+		}
+
+		memcpy(out, data + offset, count);
+		offset += count;
+	}
+};
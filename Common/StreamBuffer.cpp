@@ -0,0 +1,136 @@
+//*****************************************************************************
+// StreamBuffer.cpp
+//
+// Author: Kyle Manning
+//
+// Brief Description: Contains methods for StreamBuffer objects, which split a
+//					  persistently mapped, coherent buffer into three frame
+//					  regions guarded by fences and bump allocate from the
+//					  current one, so dynamic data is written straight into
+//					  GPU-visible memory with no glBufferSubData copies
+//*****************************************************************************
+#include "StreamBuffer.h"
+
+#include <chrono>
+#include <iostream>
+
+/// <summary>
+/// Default constructor for StreamBuffers; no GL objects exist until Init is called
+/// </summary>
+StreamBuffer::StreamBuffer() : mapping(nullptr), regionSize(0), head(0), frame(0), fences(), stats() {
+}
+
+/// <summary>
+/// Creates immutable storage for all frame regions and maps it persistently
+/// </summary>
+/// <param name="bytesPerFrame">Size of each frame region in bytes</param>
+void StreamBuffer::Init(size_t bytesPerFrame) {
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	regionSize = bytesPerFrame;
+
+	ID = GpuBuffer("frame stream");
+	glNamedBufferStorage(ID, regionSize * STREAM_FRAME_COUNT, NULL, flags);
+	ID.SetBytes(regionSize * STREAM_FRAME_COUNT);
+	mapping = (unsigned char*)glMapNamedBufferRange(ID, 0, regionSize * STREAM_FRAME_COUNT, flags);
+
+	if (mapping == nullptr) {
+		std::cout << "ERROR::STREAM_BUFFER::MAP_FAILED" << std::endl;
+	}
+}
+
+/// <summary>
+/// Advances to the next frame region, blocking only if the GPU has not finished reading
+/// it yet; the time spent blocked is recorded as a stall
+/// </summary>
+void StreamBuffer::BeginFrame() {
+	frame = (frame + 1) % STREAM_FRAME_COUNT;
+	head = 0;
+
+	if (fences[frame] == nullptr) {
+		return;
+	}
+
+	GLenum result = glClientWaitSync(fences[frame], 0, 0);
+	if (result == GL_TIMEOUT_EXPIRED) {
+		auto start = std::chrono::high_resolution_clock::now();
+
+		// Flushes once so the fence is guaranteed to be signaled eventually, then waits in 1 ms steps
+		GLbitfield waitFlags = GL_SYNC_FLUSH_COMMANDS_BIT;
+		do {
+			result = glClientWaitSync(fences[frame], waitFlags, 1000000);
+			waitFlags = 0;
+		} while (result == GL_TIMEOUT_EXPIRED);
+
+		std::chrono::duration<double, std::milli> waited = std::chrono::high_resolution_clock::now() - start;
+		stats.stallMsLastFrame = waited.count();
+		stats.stallCount += 1;
+	}
+	else {
+		stats.stallMsLastFrame = 0.0;
+	}
+
+	glDeleteSync(fences[frame]);
+	fences[frame] = nullptr;
+}
+
+/// <summary>
+/// Bump allocates space from the current frame region
+/// </summary>
+/// <param name="size">Number of bytes needed</param>
+/// <param name="alignment">Alignment of the returned offset, e.g. the vertex stride; need not be a power of two</param>
+/// <returns>Write pointer and buffer offset; data is nullptr if the region is out of space</returns>
+StreamAllocation StreamBuffer::Allocate(size_t size, size_t alignment) {
+	// The offset from the start of the whole buffer is aligned, so it divides evenly into first vertices and base instances
+	size_t regionStart = frame * regionSize;
+	size_t aligned = ((regionStart + head + alignment - 1) / alignment) * alignment - regionStart;
+
+	if (mapping == nullptr || aligned + size > regionSize) {
+		stats.overflowCount += 1;
+		return { nullptr, 0 };
+	}
+
+	head = aligned + size;
+
+	size_t offset = frame * regionSize + aligned;
+	return { mapping + offset, offset };
+}
+
+/// <summary>
+/// Places a fence after this frame's draws and records how many bytes were streamed
+/// </summary>
+void StreamBuffer::EndFrame() {
+	if (mapping == nullptr) {
+		return;
+	}
+
+	fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	stats.bytesLastFrame = head;
+	if (head > stats.peakBytesPerFrame) {
+		stats.peakBytesPerFrame = head;
+	}
+}
+
+/// <summary>
+/// Returns streaming statistics
+/// </summary>
+/// <returns>Bytes streamed, fence stall time, and overflow counts</returns>
+StreamStats StreamBuffer::GetStats() const {
+	return stats;
+}
+
+/// <summary>
+/// Deletes any fences still pending and the buffer, which also unmaps it
+/// </summary>
+void StreamBuffer::Release() {
+	for (int i = 0; i < STREAM_FRAME_COUNT; i++) {
+		if (fences[i] != nullptr) {
+			glDeleteSync(fences[i]);
+			fences[i] = nullptr;
+		}
+	}
+
+	ID.Reset();
+	mapping = nullptr;
+}
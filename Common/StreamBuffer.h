@@ -0,0 +1,67 @@
+//*****************************************************************************
+// StreamBuffer.h
+//
+// Author: Kyle Manning
+//
+// Brief Description: Header for StreamBuffer objects, a persistently mapped
+//					  ring used for per-frame vertex and instance data
+//*****************************************************************************
+#pragma once
+
+#include <cstddef>
+
+#include <glad/glad.h>
+
+#include "GpuResources.h"
+
+// Number of frame regions in the ring; the CPU writes one while the GPU reads the others
+const int STREAM_FRAME_COUNT = 3;
+
+// Space handed out by StreamBuffer::Allocate
+struct StreamAllocation {
+	// Write pointer into the mapping, nullptr if the frame region is full
+	void* data;
+	// Byte offset of data from the start of the buffer, used as a draw or attribute offset
+	size_t offset;
+};
+
+struct StreamStats {
+	size_t bytesLastFrame;
+	size_t peakBytesPerFrame;
+	double stallMsLastFrame;
+	unsigned long long stallCount;
+	unsigned long long overflowCount;
+};
+
+class StreamBuffer {
+public:
+	GpuBuffer ID;
+
+	StreamBuffer();
+
+	// Creates the buffer storage and maps it for the lifetime of the program
+	void Init(size_t bytesPerFrame);
+
+	// Waits until the GPU is done with the next frame region and starts allocating from it
+	void BeginFrame();
+
+	// Returns space for this frame's data, aligned to the given number of bytes
+	StreamAllocation Allocate(size_t size, size_t alignment);
+
+	// Fences the current frame region so it is not overwritten while still in use
+	void EndFrame();
+
+	// Returns bytes streamed and time spent waiting on fences
+	StreamStats GetStats() const;
+
+	// Deletes the fences and the buffer; called before the context is destroyed
+	void Release();
+
+private:
+	unsigned char* mapping;
+	size_t regionSize, head;
+	int frame;
+	GLsync fences[STREAM_FRAME_COUNT];
+	StreamStats stats;
+};
+
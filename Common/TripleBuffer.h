@@ -0,0 +1,64 @@
+//*****************************************************************************
+// TripleBuffer.h
+//
+// Author: Kyle Manning
+//
+// Brief Description: Header for TripleBuffer, which hands the latest of a
+//					  stream of values from one thread to another without either
+//					  side ever waiting, used by Geometry Shooter
+//*****************************************************************************
+#pragma once
+
+#include <atomic>
+
+/* Three copies of a value: the writer fills the back one, the reader uses the front one, and the
+*  third sits in the middle holding the newest finished value. Publish swaps the back copy into the
+*  middle and Acquire swaps the middle into the front, each a single atomic exchange, so neither
+*  thread blocks and the reader always gets the most recent value. Values the reader never picked
+*  up are simply overwritten.
+*
+*  Copies are reused rather than rebuilt, so containers in T keep their capacity from one use to
+*  the next.
+*/
+template <class T>
+class TripleBuffer {
+public:
+	TripleBuffer() : back(0), front(1), middle(2) { }
+
+	TripleBuffer(const TripleBuffer&) = delete;
+	TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+	// Writer: the copy to fill next; its old contents are from three publishes ago
+	T& Back() {
+		return slots[back];
+	}
+
+	// Writer: makes the back copy the newest and takes the old middle copy as the next back one
+	void Publish() {
+		back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX;
+	}
+
+	// Reader: moves to the newest published copy, returning false if nothing new was published
+	bool Acquire() {
+		if ((middle.load(std::memory_order_relaxed) & FRESH) == 0) {
+			return false;
+		}
+
+		front = middle.exchange(front, std::memory_order_acq_rel) & INDEX;
+		return true;
+	}
+
+	// Reader: the copy taken by the last Acquire
+	const T& Front() const {
+		return slots[front];
+	}
+
+private:
+	// The middle index carries a flag for whether it was published since the reader last took it
+	static const int INDEX = 3;
+	static const int FRESH = 4;
+
+	T slots[3];
+	int back, front;
+	std::atomic<int> middle;
+};
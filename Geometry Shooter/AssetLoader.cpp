@@ -0,0 +1,240 @@
+//*****************************************************************************
+// AssetLoader.cpp
+//
+// Author: Kyle Manning
+//
+// Brief Description: Contains methods for AssetLoader objects, which decode
+//					  images and fonts on worker threads and upload them
+//					  through a pixel buffer object a few at a time each
+//					  frame, keeping track of how much is left to load
+//*****************************************************************************
+#include "AssetLoader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include "stb_image.h"
+
+/// <summary>
+/// Default constructor for AssetLoaders; nothing can be queued until Init is called
+/// </summary>
+AssetLoader::AssetLoader() : jobs(nullptr), queuedCount(0), uploadedCount(0) {
+}
+
+/// <summary>
+/// Creates the pixel unpack buffer that uploads are staged in
+/// </summary>
+/// <param name="jobs">Job system that decodes run on</param>
+void AssetLoader::Init(JobSystem* jobs) {
+	this->jobs = jobs;
+
+	unpackBuffer = GpuBuffer("asset unpack buffer");
+
+	// stb's flip flag is global, so it is set once here rather than from the workers
+	stbi_set_flip_vertically_on_load(true);
+
+	// Glyph bitmaps are tightly packed single channel rows
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+}
+
+/// <summary>
+/// Submits a decode to the job system; its result waits in the ready queue for Pump
+/// </summary>
+/// <param name="decode">Reads and decodes the asset on a worker thread</param>
+/// <param name="upload">Creates or fills the GL object on the main thread</param>
+void AssetLoader::Queue(DecodeFunc decode, UploadFunc upload) {
+	queuedCount += 1;
+
+	jobs->Submit([this, decode, upload]() {
+		ReadyAsset finished = { decode(), upload, nullptr, 0 };
+
+		std::lock_guard<std::mutex> guard(readyLock);
+		ready.push_back(std::move(finished));
+	});
+}
+
+/// <summary>
+/// Queues data that needs no decoding; a worker touches each page of it first so that page faults
+/// on a memory mapped file are taken off the main thread, then Pump passes the pointer directly
+/// to the upload callback with no copy
+/// </summary>
+/// <param name="data">Pixels in the layout the upload callback expects</param>
+/// <param name="size">Bytes of data, counted against the per-frame budget</param>
+/// <param name="width">Width passed through to the callback</param>
+/// <param name="height">Height passed through to the callback</param>
+/// <param name="upload">Creates or fills the GL object on the main thread</param>
+void AssetLoader::QueueMapped(const unsigned char* data, size_t size, int width, int height, UploadFunc upload) {
+	const size_t pageSize = 4096;
+
+	queuedCount += 1;
+
+	jobs->Submit([this, data, size, width, height, upload]() {
+		volatile unsigned char touched = 0;
+		for (size_t offset = 0; offset < size; offset += pageSize) {
+			touched ^= data[offset];
+		}
+
+		ReadyAsset finished = { { width, height, {} }, upload, data, size };
+
+		std::lock_guard<std::mutex> guard(readyLock);
+		ready.push_back(std::move(finished));
+	});
+}
+
+/// <summary>
+/// Uploads decoded assets in the order they finished; always uploads at least one that is ready
+/// so an asset larger than the budget still gets through
+/// </summary>
+/// <param name="byteBudget">Bytes of pixel data to copy this frame</param>
+void AssetLoader::Pump(size_t byteBudget) {
+	size_t uploaded = 0;
+
+	while (uploaded < byteBudget) {
+		ReadyAsset next;
+
+		{
+			std::lock_guard<std::mutex> guard(readyLock);
+			if (ready.empty()) {
+				break;
+			}
+			next = std::move(ready.front());
+			ready.pop_front();
+		}
+
+		Upload(next);
+		uploaded += next.mapped != nullptr ? next.mappedSize : next.asset.pixels.size();
+	}
+}
+
+/// <summary>
+/// Waits for every queued decode and uploads all of them; used when an asset is needed right away
+/// </summary>
+void AssetLoader::Flush() {
+	jobs->Wait();
+	Pump(SIZE_MAX);
+}
+
+/// <summary>
+/// Returns how much of what has been queued is on the GPU
+/// </summary>
+/// <returns>Uploaded assets over queued assets</returns>
+float AssetLoader::Progress() const {
+	return queuedCount == 0 ? 1.0f : (float)uploadedCount / queuedCount;
+}
+
+bool AssetLoader::Done() const {
+	return uploadedCount == queuedCount;
+}
+
+/// <summary>
+/// Stops loading so the objects that upload callbacks write into can be destroyed; anything not
+/// uploaded yet is dropped
+/// </summary>
+void AssetLoader::Release() {
+	if (jobs != nullptr) {
+		jobs->Wait();
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(readyLock);
+		ready.clear();
+	}
+
+	uploadedCount = queuedCount;
+	unpackBuffer.Reset();
+}
+
+/// <summary>
+/// Orphans the unpack buffer, copies the pixels into it, and lets the upload callback source its
+/// texture call from the buffer; the buffer is unbound afterwards so that later glTexImage calls
+/// with NULL data do not read from it
+/// </summary>
+/// <param name="ready">Decoded asset and its upload callback</param>
+void AssetLoader::Upload(ReadyAsset& ready) {
+	uploadedCount += 1;
+
+	if (ready.mapped != nullptr) {
+		ready.upload(ready.asset, ready.mapped);
+		return;
+	}
+
+	if (ready.asset.pixels.empty()) {
+		return;
+	}
+
+	size_t size = ready.asset.pixels.size();
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, unpackBuffer);
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+	unpackBuffer.SetBytes(size);
+
+	void* staging = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	if (staging != nullptr) {
+		memcpy(staging, ready.asset.pixels.data(), size);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+		ready.upload(ready.asset, (const void*)0);
+	}
+	else {
+		// Falls back to a client memory upload if the buffer could not be mapped
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		ready.upload(ready.asset, ready.asset.pixels.data());
+	}
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+/// <summary>
+/// Decodes an image as RGBA and resamples it bilinearly when a different size is requested;
+/// runs on worker threads, so it must not touch GL
+/// </summary>
+/// <param name="file">File name/path of the image</param>
+/// <param name="width">Width to resample to, or 0 to keep the image's own size</param>
+/// <param name="height">Height to resample to, or 0 to keep the image's own size</param>
+/// <returns>Decoded pixels; empty if the file could not be loaded</returns>
+DecodedAsset AssetLoader::DecodeImage(const std::string& file, int width, int height) {
+	DecodedAsset decoded = { 0, 0, {} };
+
+	int imageWidth, imageHeight, channels;
+	unsigned char* data = stbi_load(file.c_str(), &imageWidth, &imageHeight, &channels, 4);
+
+	if (!data) {
+		std::cout << "Failed to load texture" << std::endl;
+		return decoded;
+	}
+
+	if (width == 0 || height == 0 || (width == imageWidth && height == imageHeight)) {
+		decoded.width = imageWidth;
+		decoded.height = imageHeight;
+		decoded.pixels.assign(data, data + (size_t)imageWidth * imageHeight * 4);
+	}
+	else {
+		decoded.width = width;
+		decoded.height = height;
+		decoded.pixels.resize((size_t)width * height * 4);
+
+		for (int y = 0; y < height; y++) {
+			float srcY = std::max(0.0f, (y + 0.5f) * imageHeight / height - 0.5f);
+			int y0 = std::min((int)srcY, imageHeight - 1);
+			int y1 = std::min(y0 + 1, imageHeight - 1);
+			float fy = srcY - y0;
+
+			for (int x = 0; x < width; x++) {
+				float srcX = std::max(0.0f, (x + 0.5f) * imageWidth / width - 0.5f);
+				int x0 = std::min((int)srcX, imageWidth - 1);
+				int x1 = std::min(x0 + 1, imageWidth - 1);
+				float fx = srcX - x0;
+
+				for (int c = 0; c < 4; c++) {
+					float top = data[(y0 * imageWidth + x0) * 4 + c] * (1.0f - fx) + data[(y0 * imageWidth + x1) * 4 + c] * fx;
+					float bottom = data[(y1 * imageWidth + x0) * 4 + c] * (1.0f - fx) + data[(y1 * imageWidth + x1) * 4 + c] * fx;
+					decoded.pixels[((size_t)y * width + x) * 4 + c] = (unsigned char)(top * (1.0f - fy) + bottom * fy + 0.5f);
+				}
+			}
+		}
+	}
+
+	stbi_image_free(data);
+	return decoded;
+}
@@ -0,0 +1,85 @@
+//*****************************************************************************
+// AssetLoader.h
+//
+// Author: Kyle Manning
+//
+// Brief Description: Header for AssetLoader objects
+//*****************************************************************************
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "../Common/JobSystem.h"
+#include "../Common/GpuResources.h"
+
+// Pixels produced by a worker thread, waiting to be copied to the GPU
+struct DecodedAsset {
+	int width, height;
+	std::vector<unsigned char> pixels;
+};
+
+// Runs on a worker thread; reads and decodes a file without touching GL
+typedef std::function<DecodedAsset()> DecodeFunc;
+
+// Runs on the main thread with the pixel unpack buffer bound; pixels is the offset to pass to glTex*Image
+typedef std::function<void(const DecodedAsset& asset, const void* pixels)> UploadFunc;
+
+/* Loads assets in two halves: file I/O and decoding run as jobs on the JobSystem, and the
+*  finished pixels are copied into a pixel buffer object and handed to an upload callback on the
+*  main thread. Pump spreads the uploads over frames, so nothing is decoded or uploaded in bulk
+*  before the first frame is drawn.
+*/
+class AssetLoader {
+public:
+	AssetLoader();
+
+	// Creates the pixel unpack buffer and sets the decode state shared by all workers
+	void Init(JobSystem* jobs);
+
+	// Decodes an asset on a worker and uploads it on a later Pump
+	void Queue(DecodeFunc decode, UploadFunc upload);
+
+	// Uploads data that is already in its final form, such as a bundle entry, straight from memory
+	void QueueMapped(const unsigned char* data, size_t size, int width, int height, UploadFunc upload);
+
+	// Uploads finished assets until about byteBudget bytes have been copied this frame
+	void Pump(size_t byteBudget);
+
+	// Blocks until everything queued so far has been decoded and uploaded
+	void Flush();
+
+	// Fraction of queued assets that have been uploaded, 1 when nothing is outstanding
+	float Progress() const;
+	bool Done() const;
+
+	// Waits for running decodes, drops every upload that has not happened, and deletes the unpack buffer
+	void Release();
+
+	// Decodes an image file as RGBA, resampling it bilinearly to width x height when both are non-zero
+	static DecodedAsset DecodeImage(const std::string& file, int width = 0, int height = 0);
+
+private:
+	struct ReadyAsset {
+		DecodedAsset asset;
+		UploadFunc upload;
+		// Set for mapped uploads, which skip the unpack buffer
+		const unsigned char* mapped;
+		size_t mappedSize;
+	};
+
+	JobSystem* jobs;
+	GpuBuffer unpackBuffer;
+	int queuedCount, uploadedCount;
+	std::mutex readyLock;
+	std::deque<ReadyAsset> ready;
+
+	// Copies one asset into the unpack buffer and runs its upload callback
+	void Upload(ReadyAsset& ready);
+};
+
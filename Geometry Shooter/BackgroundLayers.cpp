@@ -0,0 +1,230 @@
+//*****************************************************************************
+// BackgroundLayers.cpp
+//
+// Author: Kyle Manning
+//
+// Brief Description: Contains methods for BackgroundLayers objects, which hold
+//					  the wave backgrounds in a two-layer array texture and
+//					  stream upcoming images into it through the AssetLoader
+//					  while the current one is on screen
+//*****************************************************************************
+#include "BackgroundLayers.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "stb_image.h"
+#include "../Common/GLState.h"
+
+/// <summary>
+/// Default constructor for BackgroundLayers; no GL objects exist until Init is called
+/// </summary>
+BackgroundLayers::BackgroundLayers() : width(0), height(0), levels(1), unit(0), residentImages(), requestedImages(), fromImage(0), toImage(0), loader(nullptr), bundle(nullptr) {
+}
+
+/// <summary>
+/// Allocates the array at the first image's size, read from its bundle entry or file header so
+/// nothing is decoded on the main thread, and queues the first image and the one faded to after
+/// the first wave
+/// </summary>
+/// <param name="imageFiles">Background image files in the order the waves show them</param>
+/// <param name="unit">Texture unit the array is bound to</param>
+/// <param name="loader">Loader that decodes and uploads the images</param>
+/// <param name="bundle">Asset bundle that may hold the images with their mip chains</param>
+void BackgroundLayers::Init(const std::vector<std::string>& imageFiles, unsigned int unit, AssetLoader* loader, const AssetBundle* bundle) {
+	files = imageFiles;
+	this->unit = unit;
+	this->loader = loader;
+	this->bundle = bundle;
+
+	for (int i = 0; i < BACKGROUND_LAYER_COUNT; i++) {
+		residentImages[i] = -1;
+		requestedImages[i] = -1;
+	}
+
+	const BundleEntry* first = files.empty() ? nullptr : bundle->Find(files[0], BUNDLE_TEXTURE_RGBA8);
+	int channels;
+	if (first != nullptr) {
+		width = first->width;
+		height = first->height;
+	}
+	else if (files.empty() || !stbi_info(files[0].c_str(), &width, &height, &channels)) {
+		std::cout << "Failed to load texture" << std::endl;
+		return;
+	}
+
+	levels = 1 + (int)std::log2(std::max(width, height));
+
+	ID = GpuTexture("background layers");
+	GLState::BindTexture(unit, GL_TEXTURE_2D_ARRAY, ID);
+	glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels, GL_RGBA8, width, height, BACKGROUND_LAYER_COUNT);
+	ID.SetBytes(ResidentBytes());
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	RequestImage(0);
+	RequestImage(1);
+}
+
+/// <summary>
+/// Checks whether the image being shown has reached its layer yet
+/// </summary>
+/// <returns>True if the background can be drawn</returns>
+bool BackgroundLayers::Ready() const {
+	return ID != 0 && residentImages[ToLayer()] == toImage;
+}
+
+/// <summary>
+/// Starts a crossfade from the image currently shown to the given one; if it has not been
+/// uploaded yet the loader is flushed rather than fading to the wrong image
+/// </summary>
+/// <param name="image">Index of the image to fade to</param>
+void BackgroundLayers::BeginFade(int image) {
+	if (image < 0 || image >= (int)files.size()) {
+		return;
+	}
+
+	fromImage = toImage;
+	toImage = image;
+
+	if (residentImages[image % BACKGROUND_LAYER_COUNT] != image) {
+		RequestImage(image);
+		loader->Flush();
+	}
+}
+
+/// <summary>
+/// Finishes the crossfade so only the target image is considered on screen, and queues the image
+/// after it into the layer that was just freed
+/// </summary>
+void BackgroundLayers::EndFade() {
+	fromImage = toImage;
+
+	RequestImage(toImage + 1);
+}
+
+/// <summary>
+/// Jumps straight to an image, as when a saved state is restored. Nothing else is on screen
+/// afterwards, so the image can be loaded into its layer even if that layer held the image shown
+/// before, which a fade could not replace; the image after it is queued as EndFade would
+/// </summary>
+/// <param name="image">Index of the image to show</param>
+void BackgroundLayers::Show(int image) {
+	if (image < 0 || image >= (int)files.size()) {
+		return;
+	}
+
+	fromImage = image;
+	toImage = image;
+
+	if (residentImages[image % BACKGROUND_LAYER_COUNT] != image) {
+		RequestImage(image);
+		loader->Flush();
+	}
+
+	RequestImage(image + 1);
+}
+
+/// <summary>
+/// Returns the layer of the image being faded from
+/// </summary>
+/// <returns>Layer index in the array</returns>
+int BackgroundLayers::FromLayer() const {
+	return fromImage % BACKGROUND_LAYER_COUNT;
+}
+
+/// <summary>
+/// Returns the layer of the image being faded to
+/// </summary>
+/// <returns>Layer index in the array</returns>
+int BackgroundLayers::ToLayer() const {
+	return toImage % BACKGROUND_LAYER_COUNT;
+}
+
+/// <summary>
+/// Estimates the memory used by the array from its size and mip chain
+/// </summary>
+/// <returns>Bytes of RGBA8 texel data in all layers</returns>
+size_t BackgroundLayers::ResidentBytes() const {
+	return ID == 0 ? 0 : GpuResources::TextureBytes(width, height, BACKGROUND_LAYER_COUNT, 4, levels);
+}
+
+/// <summary>
+/// Queues an image on the loader unless it is out of range, already requested, or its layer still
+/// holds an image that is on screen. A bundle entry of the layer size is uploaded from the mapping
+/// with its packed mips; anything else is decoded and resampled to the layer size
+/// </summary>
+/// <param name="image">Index of the image to load</param>
+void BackgroundLayers::RequestImage(int image) {
+	int layer = image % BACKGROUND_LAYER_COUNT;
+
+	if (ID == 0 || image >= (int)files.size() || requestedImages[layer] == image || !LayerFree(image)) {
+		return;
+	}
+
+	requestedImages[layer] = image;
+
+	const BundleEntry* entry = bundle->Find(files[image], BUNDLE_TEXTURE_RGBA8);
+	if (entry != nullptr && (int)entry->width == width && (int)entry->height == height && (int)entry->levels == levels) {
+		loader->QueueMapped(bundle->Data(*entry), entry->size, width, height,
+			[this, image](const DecodedAsset&, const void* pixels) { Upload(image, pixels, true); });
+		return;
+	}
+
+	std::string file = files[image];
+	int layerWidth = width;
+	int layerHeight = height;
+	loader->Queue(
+		[file, layerWidth, layerHeight]() { return AssetLoader::DecodeImage(file, layerWidth, layerHeight); },
+		[this, image](const DecodedAsset&, const void* pixels) { Upload(image, pixels, false); });
+}
+
+/// <summary>
+/// Writes an image into its layer; packed mip levels are copied as they are, otherwise the
+/// mipmaps of the array are regenerated
+/// </summary>
+/// <param name="image">Index of the image being uploaded</param>
+/// <param name="pixels">Offset of the pixels in the bound unpack buffer, or a pointer into the bundle</param>
+/// <param name="includesMips">Whether every mip level follows the full size image</param>
+void BackgroundLayers::Upload(int image, const void* pixels, bool includesMips) {
+	int layer = image % BACKGROUND_LAYER_COUNT;
+
+	GLState::BindTexture(unit, GL_TEXTURE_2D_ARRAY, ID);
+
+	if (includesMips) {
+		const unsigned char* level = (const unsigned char*)pixels;
+		for (int i = 0; i < levels; i++) {
+			int levelWidth = AssetBundle::LevelSize(width, i);
+			int levelHeight = AssetBundle::LevelSize(height, i);
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, i, 0, 0, layer, levelWidth, levelHeight, 1, GL_RGBA, GL_UNSIGNED_BYTE, level);
+			level += (size_t)levelWidth * levelHeight * 4;
+		}
+	}
+	else {
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+		glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+	}
+
+	residentImages[layer] = image;
+}
+
+/// <summary>
+/// Checks whether the layer an image maps to holds an image that is being shown
+/// </summary>
+/// <param name="image">Index of the image that would be uploaded</param>
+/// <returns>True if the layer can be overwritten</returns>
+bool BackgroundLayers::LayerFree(int image) const {
+	int resident = residentImages[image % BACKGROUND_LAYER_COUNT];
+
+	return resident != fromImage && resident != toImage;
+}
+
+/// <summary>
+/// Deletes the array texture; images still queued on the loader must be dropped first
+/// </summary>
+void BackgroundLayers::Release() {
+	ID.Reset();
+}
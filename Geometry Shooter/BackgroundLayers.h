@@ -0,0 +1,76 @@
+//*****************************************************************************
+// BackgroundLayers.h
+//
+// Author: Kyle Manning
+//
+// Brief Description: Header for BackgroundLayers objects
+//*****************************************************************************
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "AssetLoader.h"
+#include "../Common/AssetBundle.h"
+#include "../Common/GpuResources.h"
+
+// Layers in the background array; one holds the image on screen, the other the one faded to next
+const int BACKGROUND_LAYER_COUNT = 2;
+
+/* Keeps the wave backgrounds in one GL_TEXTURE_2D_ARRAY with only BACKGROUND_LAYER_COUNT layers,
+*  instead of one full texture per image. Image n always lives in layer n % BACKGROUND_LAYER_COUNT;
+*  the image after the one being shown is queued on the AssetLoader once the layer it replaces is
+*  no longer on screen, so startup only pays for reading the first image's header.
+*/
+class BackgroundLayers {
+public:
+	GpuTexture ID;
+
+	BackgroundLayers();
+
+	// Sizes the array from the first image's header and queues the first two images
+	void Init(const std::vector<std::string>& imageFiles, unsigned int unit, AssetLoader* loader, const AssetBundle* bundle);
+
+	// Returns whether the image on screen has been uploaded
+	bool Ready() const;
+
+	// Makes an image the target of a crossfade, loading it immediately if it is not resident yet
+	void BeginFade(int image);
+
+	// Marks the crossfade as finished so the layer of the old image can be reused
+	void EndFade();
+
+	// Shows an image on its own with no crossfade, loading it over whatever its layer holds
+	void Show(int image);
+
+	// Layers the background shader mixes between
+	int FromLayer() const;
+	int ToLayer() const;
+
+	// Returns the bytes of image data held by the array, including mipmaps
+	size_t ResidentBytes() const;
+
+	// Deletes the array texture
+	void Release();
+
+private:
+	std::vector<std::string> files;
+	int width, height, levels;
+	unsigned int unit;
+	int residentImages[BACKGROUND_LAYER_COUNT], requestedImages[BACKGROUND_LAYER_COUNT];
+	int fromImage, toImage;
+	AssetLoader* loader;
+	const AssetBundle* bundle;
+
+	// Queues an image for its layer if the layer is free and the image is not already there
+	void RequestImage(int image);
+
+	// Copies pixels into the image's layer; the mip chain is either included or rebuilt
+	void Upload(int image, const void* pixels, bool includesMips);
+
+	// Returns whether the layer an image would go into is free of anything on screen
+	bool LayerFree(int image) const;
+};
+
@@ -0,0 +1,433 @@
+//*****************************************************************************
+// CollisionDetector.cpp
+//
+// Author: Kyle Manning
+//
+// Brief Description: Contains the parallel detect phase of collision checking,
+//					  which gathers bullets and targets, bins the targets into
+//					  a spatial hash, and tests each range of bullets on its
+//					  own job through the narrowphase batches, and the
+//					  benchmark that times it split into parts
+//*****************************************************************************
+#include "CollisionDetector.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "Systems.h"
+#include "../Common/FastMath.h"
+
+// Runs of each split timed by the benchmark; the fastest is kept
+const int BENCHMARK_RUNS = 5;
+
+// World units per bullet along each side of the benchmark's square, so density stays the same at any size
+const float BENCHMARK_SPACING = 40.0f;
+
+// Tick the benchmark's bullets sweep through, as at the game's sim rate
+const float BENCHMARK_TICK = 1.0f / 120.0f;
+
+// Speeds of the sweep check's player and enemy bullets, as fired in the game
+const float SWEEP_CHECK_BULLET_SPEED = 300.0f;
+const float SWEEP_CHECK_TARGET_SPEED = 150.0f;
+
+// Marks a sweep check bullet that hit nothing
+const uint32_t SWEEP_CHECK_MISS = 0xFFFFFFFFu;
+
+CollisionDetector::CollisionDetector() : jobs(nullptr), enemyCount(0), partCount(0), stats() {
+}
+
+void CollisionDetector::Init(JobSystem* jobs) {
+	this->jobs = jobs;
+}
+
+/// <summary>
+/// Gathers player bullets and targets in the order the world's queries visit them, builds the
+/// spatial hash from the boxes the targets sweep, runs one part per range of bullets, then joins
+/// the hits. Nothing in the world is changed, so the caller decides what every hit does. Enemies
+/// have already moved when collisions are checked, so only enemy bullets are given a move
+/// </summary>
+/// <param name="world">World to check</param>
+/// <param name="dt">Time player bullets move for after the check; 0 tests them as still points</param>
+/// <param name="targetDt">Time enemy bullets move for after the check</param>
+/// <param name="parts">Parts to split the bullets into; 0 uses one per worker plus the calling thread</param>
+void CollisionDetector::Detect(EntityWorld& world, float dt, float targetDt, unsigned int parts) {
+	typedef std::chrono::high_resolution_clock Clock;
+	Clock::time_point start = Clock::now();
+
+	bullets.clear();
+	targets.clear();
+	bulletPos.clear();
+	bulletMove.clear();
+	targetMove.clear();
+	targetMin.clear();
+	targetMax.clear();
+	targetShape.clear();
+	targetKind.clear();
+
+	Gather(world, C_TRANSFORM | C_DAMAGE | C_PLAYER_TEAM, 0, bullets, false, dt);
+	Gather(world, C_TRANSFORM | C_HEALTH | C_SEEK, 0, targets, true, 0.0f);
+	enemyCount = (uint32_t)targets.size();
+	Gather(world, C_TRANSFORM | C_DAMAGE, C_PLAYER_TEAM, targets, true, targetDt);
+
+	hash.Build(COLLISION_CELL_SIZE, targetMin.data(), targetMax.data(), (uint32_t)targets.size());
+	Clock::time_point built = Clock::now();
+
+	if (parts == 0) {
+		parts = jobs != nullptr ? jobs->WorkerCount() + 1 : 1;
+	}
+	partCount = std::max(1u, std::min(parts, (unsigned int)bullets.size()));
+
+	if (partData.size() < partCount) {
+		partData.resize(partCount);
+	}
+
+	if (jobs != nullptr && partCount > 1) {
+		jobs->ParallelFor(partCount, [this](unsigned int part) {
+			DetectPart(part);
+		});
+	}
+	else {
+		for (unsigned int part = 0; part < partCount; part++) {
+			DetectPart(part);
+		}
+	}
+
+	// Parts hold consecutive bullets, each sorted, so joining them in order leaves the hits sorted
+	hits.clear();
+	int tests = 0;
+	for (unsigned int part = 0; part < partCount; part++) {
+		hits.insert(hits.end(), partData[part].hits.begin(), partData[part].hits.end());
+		tests += partData[part].tests;
+	}
+
+	Clock::time_point end = Clock::now();
+	stats.bullets = (int)bullets.size();
+	stats.targets = (int)targets.size();
+	stats.boxEntries = (int)hash.BoxEntries();
+	stats.tests = tests;
+	stats.hits = (int)hits.size();
+	stats.parts = (int)partCount;
+	stats.lanes = NarrowphaseWidth();
+	stats.setupMs = std::chrono::duration<double, std::milli>(built - start).count();
+	stats.testMs = std::chrono::duration<double, std::milli>(end - built).count();
+	stats.detectMs = std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+size_t CollisionDetector::HitCount() const {
+	return hits.size();
+}
+
+const CollisionHit& CollisionDetector::Hit(size_t index) const {
+	return hits[index];
+}
+
+const CollisionRef& CollisionDetector::Bullet(uint32_t bullet) const {
+	return bullets[bullet];
+}
+
+const CollisionRef& CollisionDetector::Target(uint32_t target) const {
+	return targets[target];
+}
+
+bool CollisionDetector::IsEnemy(uint32_t target) const {
+	return target < enemyCount;
+}
+
+CollisionStats CollisionDetector::GetStats() const {
+	return stats;
+}
+
+/// <summary>
+/// Appends every entity matching a query, with its position for bullets or its shape and bounds
+/// for targets, and the move its velocity makes over dt. Growing bullets are turned boxes,
+/// bounded by the box around their corners, and a target's bounds cover it at both ends of its move
+/// </summary>
+/// <param name="world">World to read</param>
+/// <param name="required">Components an entity must have</param>
+/// <param name="excluded">Components an entity must not have</param>
+/// <param name="refs">Receives where each entity lives</param>
+/// <param name="shapes">Whether to record shapes into the target arrays rather than positions into the bullet array</param>
+/// <param name="dt">Time the entities move for</param>
+void CollisionDetector::Gather(EntityWorld& world, uint32_t required, uint32_t excluded, std::vector<CollisionRef>& refs, bool shapes, float dt) {
+	world.ForEach(required, excluded, [&](Archetype& archetype) {
+		std::vector<glm::vec2>& moves = shapes ? targetMove : bulletMove;
+		for (uint32_t row = 0; row < archetype.Size(); row++) {
+			refs.push_back({ &archetype, row });
+			moves.push_back(archetype.Has(C_VELOCITY) ? archetype.velocity[row] * dt : glm::vec2(0.0f));
+		}
+
+		if (!shapes) {
+			bulletPos.insert(bulletPos.end(), archetype.pos.begin(), archetype.pos.end());
+			return;
+		}
+
+		bool oriented = archetype.Has(C_GROWTH);
+		for (uint32_t row = 0; row < archetype.Size(); row++) {
+			Shape shape = { archetype.pos[row], archetype.size[row], archetype.facing[row] };
+			glm::vec2 reach = shape.extent;
+
+			if (oriented) {
+				float fx = std::abs(shape.facing.x), fy = std::abs(shape.facing.y);
+				reach = glm::vec2(fy * shape.extent.x + fx * shape.extent.y, fx * shape.extent.x + fy * shape.extent.y);
+			}
+
+			glm::vec2 move = targetMove[targetShape.size()];
+			targetShape.push_back(shape);
+			targetKind.push_back(oriented ? SHAPE_OBB : SHAPE_AABB);
+			targetMin.push_back(glm::min(shape.center - reach, shape.center + move - reach));
+			targetMax.push_back(glm::max(shape.center + reach, shape.center + move + reach));
+		}
+	});
+}
+
+/// <summary>
+/// Runs on a worker or the calling thread: gathers the targets listed in every bucket a bullet's
+/// path covers, once each and in ascending order, and queues the bullet's path relative to each
+/// one against its shape. The queue is tested whenever it fills, between bullets
+/// </summary>
+/// <param name="part">Index of the range, which is also the buffers it writes</param>
+void CollisionDetector::DetectPart(unsigned int part) {
+	CollisionPart& data = partData[part];
+	uint32_t total = (uint32_t)bullets.size();
+	uint32_t begin = (uint32_t)((uint64_t)total * part / partCount);
+	uint32_t end = (uint32_t)((uint64_t)total * (part + 1) / partCount);
+
+	data.hits.clear();
+	data.candidates.clear();
+	data.boxes.Reset(SHAPE_SEGMENT, SHAPE_AABB);
+	data.orientedBoxes.Reset(SHAPE_SEGMENT, SHAPE_OBB);
+	data.tests = 0;
+
+	for (uint32_t bullet = begin; bullet < end; bullet++) {
+		glm::vec2 start = bulletPos[bullet];
+		glm::vec2 move = bulletMove[bullet];
+
+		data.buckets.clear();
+		data.nearby.clear();
+		hash.BucketsOf(glm::min(start, start + move), glm::max(start, start + move), data.buckets);
+		for (uint32_t bucket : data.buckets) {
+			data.nearby.insert(data.nearby.end(), hash.BoxesBegin(bucket), hash.BoxesEnd(bucket));
+		}
+
+		// One bucket is already in order, with any target in two of its cells listed twice in a row
+		if (data.buckets.size() > 1) {
+			std::sort(data.nearby.begin(), data.nearby.end());
+		}
+		data.nearby.erase(std::unique(data.nearby.begin(), data.nearby.end()), data.nearby.end());
+
+		for (uint32_t target : data.nearby) {
+			Shape path = { start, move - targetMove[target], glm::vec2(0.0f, 1.0f) };
+			NarrowphaseBatch& batch = targetKind[target] == SHAPE_OBB ? data.orientedBoxes : data.boxes;
+			data.candidates.push_back({ bullet, target, (uint32_t)batch.Add(path, targetShape[target]) });
+		}
+
+		if (data.candidates.size() >= COLLISION_FLUSH_PAIRS) {
+			FlushPart(data);
+		}
+	}
+
+	FlushPart(data);
+}
+
+/// <summary>
+/// Runs both batches' kernels, then walks the candidates in the order they were queued, keeping
+/// each whose bit came back set, and empties the queue for the next bullets. The new hits are
+/// in bullet and target order; a stable sort puts each bullet's in the order it reached them
+/// </summary>
+/// <param name="data">Part whose candidates are tested</param>
+void CollisionDetector::FlushPart(CollisionPart& data) {
+	data.boxes.Test();
+	data.orientedBoxes.Test();
+
+	size_t first = data.hits.size();
+	for (const CollisionCandidate& candidate : data.candidates) {
+		const NarrowphaseBatch& batch = targetKind[candidate.target] == SHAPE_OBB ? data.orientedBoxes : data.boxes;
+		if (batch.Hit(candidate.pair)) {
+			data.hits.push_back({ candidate.bullet, candidate.target, batch.Time(candidate.pair) });
+		}
+	}
+
+	std::stable_sort(data.hits.begin() + first, data.hits.end(), [](const CollisionHit& a, const CollisionHit& b) {
+		return a.bullet != b.bullet ? a.bullet < b.bullet : a.time < b.time;
+	});
+
+	data.tests += (int)data.candidates.size();
+	data.candidates.clear();
+	data.boxes.Reset(SHAPE_SEGMENT, SHAPE_AABB);
+	data.orientedBoxes.Reset(SHAPE_SEGMENT, SHAPE_OBB);
+}
+
+/// <summary>
+/// Fills a scratch world with player bullets spread over a square, and an eighth as many enemies
+/// and a quarter as many enemy bullets over the same square, then times Detect split into 1, 2,
+/// 4, and 8 parts, keeping the fastest of several runs of each and checking every split against
+/// the hits of one part. Gathering and building the hash stay on the calling thread, so the
+/// parallel tests are timed on their own as well. Parts beyond the worker count plus one share
+/// threads, so scaling stops there
+/// </summary>
+/// <param name="jobs">Jobs to split detection across</param>
+/// <param name="bullets">Number of player bullets</param>
+/// <returns>Time per Detect for each split</returns>
+CollisionBenchmark BenchmarkCollisions(JobSystem& jobs, size_t bullets) {
+	EntityWorld world;
+	float side = BENCHMARK_SPACING * std::sqrt((float)bullets);
+
+	// A fixed generator, so every run sees the same scene and the sim's random sequence is left alone
+	uint32_t seed = 12345u;
+	auto next = [&seed, side]() {
+		seed = seed * 1664525u + 1013904223u;
+		return (float)(seed >> 8) / (float)(1u << 24) * side;
+	};
+
+	for (size_t i = 0; i < bullets; i++) {
+		glm::vec2 pos(next(), next());
+		CreateProjectile(world, pos, glm::vec2(5.0f, 5.0f), glm::vec2(0.0f, 1.0f), glm::vec2(0.0f, 300.0f), glm::vec3(1.0f), 10, false, true);
+	}
+	for (size_t i = 0; i < bullets / 8; i++) {
+		glm::vec2 pos(next(), next());
+		CreateEnemy(world, (EnemyKind)(i % ENEMY_KIND_COUNT), pos);
+	}
+	for (size_t i = 0; i < bullets / 4; i++) {
+		glm::vec2 pos(next(), next());
+		CreateProjectile(world, pos, glm::vec2(5.0f, 5.0f), glm::vec2(0.0f, 1.0f), glm::vec2(0.0f, 150.0f), glm::vec3(1.0f), 10, i % 10 == 0, false);
+	}
+
+	CollisionDetector detector;
+	detector.Init(&jobs);
+
+	CollisionBenchmark result = CollisionBenchmark();
+	result.bullets = bullets;
+	result.threads = jobs.WorkerCount() + 1;
+	result.runs = BENCHMARK_RUNS;
+	result.identical = true;
+
+	std::vector<CollisionHit> reference;
+	unsigned int parts = 1;
+	for (int split = 0; split < COLLISION_BENCHMARK_SPLITS; split++, parts *= 2) {
+		for (int run = 0; run < BENCHMARK_RUNS; run++) {
+			detector.Detect(world, BENCHMARK_TICK, BENCHMARK_TICK, parts);
+			CollisionStats stats = detector.GetStats();
+			result.ms[split] = run == 0 ? stats.detectMs : std::min(result.ms[split], stats.detectMs);
+			result.testMs[split] = run == 0 ? stats.testMs : std::min(result.testMs[split], stats.testMs);
+		}
+
+		if (split == 0) {
+			for (size_t i = 0; i < detector.HitCount(); i++) {
+				reference.push_back(detector.Hit(i));
+			}
+			result.targets = detector.GetStats().targets;
+			result.hits = reference.size();
+			continue;
+		}
+
+		bool same = detector.HitCount() == reference.size();
+		for (size_t i = 0; same && i < reference.size(); i++) {
+			same = detector.Hit(i) == reference[i];
+		}
+		result.identical = result.identical && same;
+	}
+
+	return result;
+}
+
+/// <summary>
+/// Fills a fresh world with the sweep check's scene: player bullets fired across a square in
+/// every direction, then still enemies and enemy bullets drifting through them, a tenth of them
+/// wave bullets turned to their heading. The same generator makes the same scene every call, so
+/// every entity gets the same handle each time
+/// </summary>
+/// <param name="world">Empty world to fill</param>
+/// <param name="bullets">Number of player bullets</param>
+static void BuildSweepScene(EntityWorld& world, size_t bullets) {
+	float side = BENCHMARK_SPACING * std::sqrt((float)bullets);
+
+	uint32_t seed = 67890u;
+	auto next = [&seed]() {
+		seed = seed * 1664525u + 1013904223u;
+		return (float)(seed >> 8) / (float)(1u << 24);
+	};
+
+	for (size_t i = 0; i < bullets; i++) {
+		glm::vec2 pos(next() * side, next() * side);
+		glm::vec2 facing = DirectionFromAngle(next() * 2.0f * FAST_PI);
+		CreateProjectile(world, pos, glm::vec2(5.0f, 5.0f), facing, facing * SWEEP_CHECK_BULLET_SPEED, glm::vec3(1.0f), 10, false, true);
+	}
+	for (size_t i = 0; i < bullets / 8; i++) {
+		glm::vec2 pos(next() * side, next() * side);
+		CreateEnemy(world, (EnemyKind)(i % ENEMY_KIND_COUNT), pos);
+	}
+	for (size_t i = 0; i < bullets / 4; i++) {
+		glm::vec2 pos(next() * side, next() * side);
+		glm::vec2 facing = DirectionFromAngle(next() * 2.0f * FAST_PI);
+		bool wave = i % 10 == 0;
+		glm::vec2 size = wave ? glm::vec2(40.0f, 5.0f) : glm::vec2(5.0f, 5.0f);
+		CreateProjectile(world, pos, size, facing, facing * SWEEP_CHECK_TARGET_SPEED, glm::vec3(1.0f), 10, wave, false);
+	}
+}
+
+/// <summary>
+/// Runs the sweep check's scene for SWEEP_CHECK_SECONDS at the slow and the fast tick rate,
+/// stopping each player bullet at the first target it reaches and leaving targets standing, so
+/// every bullet meets the same scene at both rates, then compares the first target of each
+/// bullet. The slow rate is run again with bullets tested as still points, as they were before
+/// collisions were swept, to count the hits sweeping keeps
+/// </summary>
+/// <param name="jobs">Jobs to split detection across</param>
+/// <param name="bullets">Number of player bullets</param>
+/// <returns>Hits at each rate and how many bullets hit something different</returns>
+CollisionSweepCheck CheckSweptTickRates(JobSystem& jobs, size_t bullets) {
+	CollisionDetector detector;
+	detector.Init(&jobs);
+
+	CollisionSweepCheck result = CollisionSweepCheck();
+	result.bullets = bullets;
+	result.rates[0] = SWEEP_CHECK_SLOW_RATE;
+	result.rates[1] = SWEEP_CHECK_FAST_RATE;
+
+	// Player bullets are created first in an empty world, so a bullet's entity index is its place in the scene
+	auto run = [&](int rate, bool swept, std::vector<uint32_t>& firstTarget) {
+		EntityWorld world;
+		BuildSweepScene(world, bullets);
+		result.targets = (size_t)world.EntityCount() - bullets;
+
+		float dt = 1.0f / (float)rate;
+		int hits = 0;
+		firstTarget.assign(bullets, SWEEP_CHECK_MISS);
+
+		for (int tick = 0; tick < rate * SWEEP_CHECK_SECONDS; tick++) {
+			detector.Detect(world, swept ? dt : 0.0f, swept ? dt : 0.0f);
+
+			// A bullet's first hit is the earliest
+			for (size_t i = 0; i < detector.HitCount(); i++) {
+				const CollisionHit& found = detector.Hit(i);
+				if (i > 0 && detector.Hit(i - 1).bullet == found.bullet) {
+					continue;
+				}
+
+				const CollisionRef& bullet = detector.Bullet(found.bullet);
+				const CollisionRef& target = detector.Target(found.target);
+				Entity entity = bullet.archetype->entities[bullet.row];
+				firstTarget[entity.index] = target.archetype->entities[target.row].index;
+				world.Destroy(entity);
+				hits += 1;
+			}
+
+			world.FlushDestroyed();
+			MovementSystem(world, dt, C_DAMAGE, 0);
+		}
+
+		return hits;
+	};
+
+	std::vector<uint32_t> slow, fast, still;
+	result.hits[0] = run(SWEEP_CHECK_SLOW_RATE, true, slow);
+	result.hits[1] = run(SWEEP_CHECK_FAST_RATE, true, fast);
+	result.pointHits = run(SWEEP_CHECK_SLOW_RATE, false, still);
+
+	for (size_t i = 0; i < bullets; i++) {
+		result.mismatched += slow[i] != fast[i] ? 1 : 0;
+	}
+
+	return result;
+}
@@ -0,0 +1,183 @@
+//*****************************************************************************
+// CollisionDetector.h
+//
+// Author: Kyle Manning
+//
+// Brief Description: Header for CollisionDetector objects, which find where
+//					  player bullets first reach what they can hit over a
+//					  tick on the job system without changing the world
+//*****************************************************************************
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Entities.h"
+#include "../Common/JobSystem.h"
+#include "../Common/Narrowphase.h"
+#include "../Common/SpatialHash.h"
+
+// Side of a spatial hash cell in world units; a little larger than the largest enemy
+const float COLLISION_CELL_SIZE = 64.0f;
+
+// Candidate pairs a part gathers before running them through the narrowphase
+const size_t COLLISION_FLUSH_PAIRS = 1024;
+
+// Splits the collision benchmark times: 1, 2, 4, and 8 parts
+const int COLLISION_BENCHMARK_SPLITS = 4;
+
+// Tick rates the swept collision check compares, and how long it runs each for in seconds
+const int SWEEP_CHECK_SLOW_RATE = 30;
+const int SWEEP_CHECK_FAST_RATE = 240;
+const int SWEEP_CHECK_SECONDS = 1;
+
+// An entity the detector saw, by where its data lives
+struct CollisionRef {
+	Archetype* archetype;
+	uint32_t row;
+};
+
+// A player bullet reaching a target; both are places in the order the serial check walked them
+struct CollisionHit {
+	uint32_t bullet, target;
+	// Fraction of the tick at which the bullet reached the target, 0 if they already overlapped
+	float time;
+
+	bool operator==(const CollisionHit& other) const {
+		return bullet == other.bullet && target == other.target && time == other.time;
+	}
+};
+
+// A bullet and a target sharing a bucket, and the pair's index in the batch for the target's shape
+struct CollisionCandidate {
+	uint32_t bullet, target;
+	uint32_t pair;
+};
+
+// What one part fills while testing its range of bullets
+struct CollisionPart {
+	// Buckets a bullet's path covers, and the targets listed in them
+	std::vector<uint32_t> buckets, nearby;
+	std::vector<CollisionCandidate> candidates;
+	// Bullets against axis aligned targets, and against targets turned to their facing
+	NarrowphaseBatch boxes, orientedBoxes;
+	std::vector<CollisionHit> hits;
+	int tests;
+};
+
+// Counts from the last Detect for the debug overlay
+struct CollisionStats {
+	// Tests counts candidate pairs; lanes is how many of them the narrowphase tests at once
+	int bullets, targets, boxEntries, tests, hits, parts, lanes;
+	// Serial gathering and hash building, the parallel tests and join, and the whole Detect
+	double setupMs, testMs, detectMs;
+};
+
+// Which target each bullet reached first at two tick rates, from CheckSweptTickRates
+struct CollisionSweepCheck {
+	size_t bullets, targets;
+	int rates[2];
+	// Bullets that hit something at each rate, and at the slow rate tested as still points
+	int hits[2];
+	int pointHits;
+	// Bullets whose first target differs between the rates, which should only be ones that graze a target or reach two at about the same time
+	int mismatched;
+};
+
+// Time to detect the same scene split into 1, 2, 4, and 8 parts, from BenchmarkCollisions
+struct CollisionBenchmark {
+	size_t bullets, targets, hits;
+	unsigned int threads;
+	int runs;
+	// Whole Detect, and only its parallel tests, for each split
+	double ms[COLLISION_BENCHMARK_SPLITS];
+	double testMs[COLLISION_BENCHMARK_SPLITS];
+	// Whether every split found exactly the hits of the single part
+	bool identical;
+};
+
+/* Collisions are found in two phases. Detect is the parallel, read-only one: it flattens player
+*  bullets and their targets, enemies first and then enemy bullets, into arrays in the order the
+*  world's queries walk them, so a bullet's or target's place in its array is a key that does
+*  not depend on threads. Target boxes are binned into a spatial hash, and the bullets are split
+*  into parts of consecutive keys. Each part tests its bullets against the boxes in their cell's
+*  bucket and writes hits to its own buffer, so parts share nothing but what they read.
+*
+*  Bullets are tested as the path they travel over the tick to come, not where they stand, so a
+*  fast bullet cannot pass through a target between two ticks at any tick rate. The path is taken
+*  relative to the target, whose own move over the tick is subtracted, and targets are binned by
+*  the box they sweep, so a bullet finds them in the buckets of every cell its path covers. Each
+*  hit carries the fraction of the tick at which the bullet first reached the target.
+*
+*  A part does not test pairs as it finds them. It queues each bullet and target sharing a bucket
+*  into a narrowphase batch for the target's shape, then tests a batch at a time with the SIMD
+*  kernels and reads the hits back in the order the pairs were queued. Enemies and most enemy
+*  bullets are tested as axis aligned boxes; wave bullets, which widen while drawn turned to their
+*  facing, are tested as the turned box that is drawn, and are binned by the box around it.
+*
+*  Hits are ordered by bullet key, then time, then target key. Each part sorts the hits of its
+*  own consecutive bullets, so joining the buffers in part order sorts the whole list without a
+*  sort pass over it. The resolve phase belongs to the caller and runs on one thread. Walking the
+*  sorted hits visits every bullet's targets in the order it reached them, the same way however
+*  many parts found the hits, so damage, kills, score, and powerup rolls come out exactly as a
+*  single-threaded check would have them.
+*/
+class CollisionDetector {
+public:
+	CollisionDetector();
+
+	// Detection is split across the given jobs
+	void Init(JobSystem* jobs);
+
+	// Finds every enemy or enemy bullet each player bullet reaches as it moves for dt, while enemy
+	// bullets move for targetDt; parts of 0 uses one per worker plus the caller
+	void Detect(EntityWorld& world, float dt, float targetDt, unsigned int parts = 0);
+
+	// Hits from the last Detect, sorted by bullet, then time, then target, each pair once
+	size_t HitCount() const;
+	const CollisionHit& Hit(size_t index) const;
+
+	// Entities the hits refer to
+	const CollisionRef& Bullet(uint32_t bullet) const;
+	const CollisionRef& Target(uint32_t target) const;
+
+	// Whether a target is an enemy rather than an enemy bullet
+	bool IsEnemy(uint32_t target) const;
+
+	CollisionStats GetStats() const;
+
+private:
+	JobSystem* jobs;
+	SpatialHash hash;
+
+	// Bullets and targets in query order, with the positions, moves over the tick, and shapes the
+	// parts test and the axis aligned bounds of the boxes the targets sweep
+	std::vector<CollisionRef> bullets, targets;
+	std::vector<glm::vec2> bulletPos, bulletMove, targetMove, targetMin, targetMax;
+	std::vector<Shape> targetShape;
+	std::vector<ShapeKind> targetKind;
+	uint32_t enemyCount;
+
+	// One set of buffers per part, whose hits are joined once every part has finished
+	std::vector<CollisionPart> partData;
+	unsigned int partCount;
+	std::vector<CollisionHit> hits;
+	CollisionStats stats;
+
+	// Adds the entities of every archetype matching a query to refs, with their positions or shapes and their moves over dt
+	void Gather(EntityWorld& world, uint32_t required, uint32_t excluded, std::vector<CollisionRef>& refs, bool shapes, float dt);
+
+	// Tests one range of bullets against the targets in the buckets their paths cover
+	void DetectPart(unsigned int part);
+
+	// Tests a part's queued candidates and appends the ones that overlap to its hits
+	void FlushPart(CollisionPart& data);
+};
+
+// Times Detect on a generated scene of bullets, enemies, and enemy bullets split into 1 to 8 parts
+CollisionBenchmark BenchmarkCollisions(JobSystem& jobs, size_t bullets);
+
+// Runs the same bullets through the same targets at a slow and a fast tick rate and compares what each bullet hits first
+CollisionSweepCheck CheckSweptTickRates(JobSystem& jobs, size_t bullets);
@@ -0,0 +1,678 @@
+//*****************************************************************************
+// Entities.cpp
+//
+// Author: Kyle Manning
+//
+// Brief Description: Contains methods for archetypes, which add and remove
+//					  rows across their component arrays, and for the entity
+//					  world, which hands out generational handles and keeps
+//					  the slot table in step as rows move
+//*****************************************************************************
+#include "Entities.h"
+
+#include <iostream>
+
+/// <summary>
+/// Moves the last element of a component array into row and drops the last element
+/// </summary>
+/// <param name="column">Component array</param>
+/// <param name="row">Row being removed</param>
+template <class T>
+static void SwapRemove(std::pmr::vector<T>& column, uint32_t row) {
+	column[row] = column.back();
+	column.pop_back();
+}
+
+/// <summary>
+/// Reads a component array written by StateWriter::WriteArray, failing the reader if it does not
+/// have one element per row
+/// </summary>
+/// <param name="reader">Stream to read from</param>
+/// <param name="column">Component array; replaced</param>
+/// <param name="rows">Number of rows the archetype has</param>
+template <class T>
+static void ReadColumn(StateReader& reader, std::pmr::vector<T>& column, size_t rows) {
+	reader.ReadArray(column);
+	if (column.size() != rows) {
+		reader.Fail();
+	}
+}
+
+// A slot as written by EntityWorld::Save, with its archetype as an index into the saved ones
+struct SavedSlot {
+	uint32_t archetype;
+	uint32_t row;
+	uint32_t generation;
+};
+
+// Archetype index of a slot with no entity
+const uint32_t NO_ARCHETYPE = 0xFFFFFFFF;
+
+/// <summary>
+/// Constructor for Archetypes; every array is created empty on the given resource
+/// </summary>
+/// <param name="mask">ComponentFlags of the entities stored here</param>
+/// <param name="resource">Memory resource the arrays allocate from</param>
+Archetype::Archetype(uint32_t mask, std::pmr::memory_resource* resource) : mask(mask), resource(resource), entities(resource),
+	pos(resource), size(resource), facing(resource), velocity(resource), health(resource), seekSpeed(resource), followDistance(resource),
+	contactDamage(resource), reloadTime(resource), weapon(resource), flashTime(resource), lifeTime(resource), damage(resource),
+	growth(resource), mesh(resource), color(resource), pointValue(resource), pickup(resource) {
+}
+
+/// <summary>
+/// Appends a row for an entity, zeroing every component the archetype has
+/// </summary>
+/// <param name="entity">Handle of the entity that owns the row</param>
+/// <returns>Index of the new row</returns>
+uint32_t Archetype::AddRow(Entity entity) {
+	entities.push_back(entity);
+
+	if (Has(C_TRANSFORM)) {
+		pos.push_back(glm::vec2(0.0f));
+		size.push_back(glm::vec2(0.0f));
+		facing.push_back(glm::vec2(0.0f, 1.0f));
+	}
+	if (Has(C_VELOCITY)) {
+		velocity.push_back(glm::vec2(0.0f));
+	}
+	if (Has(C_HEALTH)) {
+		health.push_back(0);
+	}
+	if (Has(C_SEEK)) {
+		seekSpeed.push_back(0.0f);
+		followDistance.push_back(0.0f);
+	}
+	if (Has(C_CONTACT)) {
+		contactDamage.push_back(0);
+	}
+	if (Has(C_SHOOTER)) {
+		reloadTime.push_back(0.0f);
+		weapon.push_back(0);
+	}
+	if (Has(C_DAMAGE_FLASH)) {
+		flashTime.push_back(0.0f);
+	}
+	if (Has(C_LIFETIME)) {
+		lifeTime.push_back(0.0f);
+	}
+	if (Has(C_DAMAGE)) {
+		damage.push_back(0);
+	}
+	if (Has(C_GROWTH)) {
+		growth.push_back(0.0f);
+	}
+	if (Has(C_RENDER)) {
+		mesh.push_back(0);
+		color.push_back(glm::vec3(0.0f));
+	}
+	if (Has(C_SCORE)) {
+		pointValue.push_back(0);
+	}
+	if (Has(C_PICKUP)) {
+		pickup.push_back(0);
+	}
+
+	return (uint32_t)entities.size() - 1;
+}
+
+/// <summary>
+/// Removes a row by moving the last row into it, so every array stays dense
+/// </summary>
+/// <param name="row">Row to remove</param>
+void Archetype::RemoveRow(uint32_t row) {
+	SwapRemove(entities, row);
+
+	if (Has(C_TRANSFORM)) {
+		SwapRemove(pos, row);
+		SwapRemove(size, row);
+		SwapRemove(facing, row);
+	}
+	if (Has(C_VELOCITY)) {
+		SwapRemove(velocity, row);
+	}
+	if (Has(C_HEALTH)) {
+		SwapRemove(health, row);
+	}
+	if (Has(C_SEEK)) {
+		SwapRemove(seekSpeed, row);
+		SwapRemove(followDistance, row);
+	}
+	if (Has(C_CONTACT)) {
+		SwapRemove(contactDamage, row);
+	}
+	if (Has(C_SHOOTER)) {
+		SwapRemove(reloadTime, row);
+		SwapRemove(weapon, row);
+	}
+	if (Has(C_DAMAGE_FLASH)) {
+		SwapRemove(flashTime, row);
+	}
+	if (Has(C_LIFETIME)) {
+		SwapRemove(lifeTime, row);
+	}
+	if (Has(C_DAMAGE)) {
+		SwapRemove(damage, row);
+	}
+	if (Has(C_GROWTH)) {
+		SwapRemove(growth, row);
+	}
+	if (Has(C_RENDER)) {
+		SwapRemove(mesh, row);
+		SwapRemove(color, row);
+	}
+	if (Has(C_SCORE)) {
+		SwapRemove(pointValue, row);
+	}
+	if (Has(C_PICKUP)) {
+		SwapRemove(pickup, row);
+	}
+}
+
+/// <summary>
+/// Reserves room for count rows in each array the archetype uses, so an arena backed archetype
+/// takes its memory in one piece instead of leaving every outgrown array behind
+/// </summary>
+/// <param name="count">Rows to make room for</param>
+void Archetype::Reserve(size_t count) {
+	entities.reserve(count);
+
+	if (Has(C_TRANSFORM)) {
+		pos.reserve(count);
+		size.reserve(count);
+		facing.reserve(count);
+	}
+	if (Has(C_VELOCITY)) {
+		velocity.reserve(count);
+	}
+	if (Has(C_HEALTH)) {
+		health.reserve(count);
+	}
+	if (Has(C_SEEK)) {
+		seekSpeed.reserve(count);
+		followDistance.reserve(count);
+	}
+	if (Has(C_CONTACT)) {
+		contactDamage.reserve(count);
+	}
+	if (Has(C_SHOOTER)) {
+		reloadTime.reserve(count);
+		weapon.reserve(count);
+	}
+	if (Has(C_DAMAGE_FLASH)) {
+		flashTime.reserve(count);
+	}
+	if (Has(C_LIFETIME)) {
+		lifeTime.reserve(count);
+	}
+	if (Has(C_DAMAGE)) {
+		damage.reserve(count);
+	}
+	if (Has(C_GROWTH)) {
+		growth.reserve(count);
+	}
+	if (Has(C_RENDER)) {
+		mesh.reserve(count);
+		color.reserve(count);
+	}
+	if (Has(C_SCORE)) {
+		pointValue.reserve(count);
+	}
+	if (Has(C_PICKUP)) {
+		pickup.reserve(count);
+	}
+}
+
+void Archetype::Clear() {
+	entities.clear();
+	pos.clear();
+	size.clear();
+	facing.clear();
+	velocity.clear();
+	health.clear();
+	seekSpeed.clear();
+	followDistance.clear();
+	contactDamage.clear();
+	reloadTime.clear();
+	weapon.clear();
+	flashTime.clear();
+	lifeTime.clear();
+	damage.clear();
+	growth.clear();
+	mesh.clear();
+	color.clear();
+	pointValue.clear();
+	pickup.clear();
+}
+
+/// <summary>
+/// Writes the entity handles and then every array the archetype uses, in the order AddRow fills them
+/// </summary>
+/// <param name="writer">Stream to write to</param>
+void Archetype::Save(StateWriter& writer) const {
+	writer.WriteArray(entities);
+
+	if (Has(C_TRANSFORM)) {
+		writer.WriteArray(pos);
+		writer.WriteArray(size);
+		writer.WriteArray(facing);
+	}
+	if (Has(C_VELOCITY)) {
+		writer.WriteArray(velocity);
+	}
+	if (Has(C_HEALTH)) {
+		writer.WriteArray(health);
+	}
+	if (Has(C_SEEK)) {
+		writer.WriteArray(seekSpeed);
+		writer.WriteArray(followDistance);
+	}
+	if (Has(C_CONTACT)) {
+		writer.WriteArray(contactDamage);
+	}
+	if (Has(C_SHOOTER)) {
+		writer.WriteArray(reloadTime);
+		writer.WriteArray(weapon);
+	}
+	if (Has(C_DAMAGE_FLASH)) {
+		writer.WriteArray(flashTime);
+	}
+	if (Has(C_LIFETIME)) {
+		writer.WriteArray(lifeTime);
+	}
+	if (Has(C_DAMAGE)) {
+		writer.WriteArray(damage);
+	}
+	if (Has(C_GROWTH)) {
+		writer.WriteArray(growth);
+	}
+	if (Has(C_RENDER)) {
+		writer.WriteArray(mesh);
+		writer.WriteArray(color);
+	}
+	if (Has(C_SCORE)) {
+		writer.WriteArray(pointValue);
+	}
+	if (Has(C_PICKUP)) {
+		writer.WriteArray(pickup);
+	}
+}
+
+/// <summary>
+/// Reads arrays written by Save into this archetype's storage, so they allocate from its resource
+/// </summary>
+/// <param name="reader">Stream to read from</param>
+void Archetype::Load(StateReader& reader) {
+	Clear();
+	reader.ReadArray(entities);
+	size_t rows = entities.size();
+
+	if (Has(C_TRANSFORM)) {
+		ReadColumn(reader, pos, rows);
+		ReadColumn(reader, size, rows);
+		ReadColumn(reader, facing, rows);
+	}
+	if (Has(C_VELOCITY)) {
+		ReadColumn(reader, velocity, rows);
+	}
+	if (Has(C_HEALTH)) {
+		ReadColumn(reader, health, rows);
+	}
+	if (Has(C_SEEK)) {
+		ReadColumn(reader, seekSpeed, rows);
+		ReadColumn(reader, followDistance, rows);
+	}
+	if (Has(C_CONTACT)) {
+		ReadColumn(reader, contactDamage, rows);
+	}
+	if (Has(C_SHOOTER)) {
+		ReadColumn(reader, reloadTime, rows);
+		ReadColumn(reader, weapon, rows);
+	}
+	if (Has(C_DAMAGE_FLASH)) {
+		ReadColumn(reader, flashTime, rows);
+	}
+	if (Has(C_LIFETIME)) {
+		ReadColumn(reader, lifeTime, rows);
+	}
+	if (Has(C_DAMAGE)) {
+		ReadColumn(reader, damage, rows);
+	}
+	if (Has(C_GROWTH)) {
+		ReadColumn(reader, growth, rows);
+	}
+	if (Has(C_RENDER)) {
+		ReadColumn(reader, mesh, rows);
+		ReadColumn(reader, color, rows);
+	}
+	if (Has(C_SCORE)) {
+		ReadColumn(reader, pointValue, rows);
+	}
+	if (Has(C_PICKUP)) {
+		ReadColumn(reader, pickup, rows);
+	}
+
+	if (reader.Failed()) {
+		Clear();
+	}
+}
+
+/// <summary>
+/// Default constructor for EntityWorlds
+/// </summary>
+EntityWorld::EntityWorld() : liveCount(0) {
+}
+
+/// <summary>
+/// Takes a free slot, or a new one, and adds a row for it in the archetype matching the components;
+/// generations start at 1 so a zeroed handle never refers to anything
+/// </summary>
+/// <param name="components">ComponentFlags the entity has</param>
+/// <returns>Handle of the new entity</returns>
+Entity EntityWorld::Create(uint32_t components) {
+	uint32_t index;
+	if (!freeSlots.empty()) {
+		index = freeSlots.back();
+		freeSlots.pop_back();
+	}
+	else {
+		index = (uint32_t)slots.size();
+		slots.push_back({ nullptr, 0, 1, false });
+	}
+
+	EntitySlot& slot = slots[index];
+	Entity entity = { index, slot.generation };
+
+	slot.archetype = &ArchetypeFor(components);
+	slot.row = slot.archetype->AddRow(entity);
+	slot.dying = false;
+
+	liveCount += 1;
+	return entity;
+}
+
+/// <summary>
+/// Marks an entity to be removed once the current systems are done with it; marking it twice, or
+/// passing a handle whose entity is already gone, does nothing
+/// </summary>
+/// <param name="entity">Entity to destroy</param>
+void EntityWorld::Destroy(Entity entity) {
+	if (!IsAlive(entity) || slots[entity.index].dying) {
+		return;
+	}
+
+	slots[entity.index].dying = true;
+	pendingDestroy.push_back(entity);
+}
+
+/// <summary>
+/// Removes the rows of every marked entity, points the slot of each row that moved at its new
+/// position, and bumps the generation of each freed slot so old handles stop resolving
+/// </summary>
+void EntityWorld::FlushDestroyed() {
+	for (Entity entity : pendingDestroy) {
+		EntitySlot& slot = slots[entity.index];
+		Archetype* archetype = slot.archetype;
+		uint32_t row = slot.row;
+
+		archetype->RemoveRow(row);
+		if (row < archetype->Size()) {
+			slots[archetype->entities[row].index].row = row;
+		}
+
+		slot.archetype = nullptr;
+		slot.generation += 1;
+		slot.dying = false;
+		freeSlots.push_back(entity.index);
+		liveCount -= 1;
+	}
+
+	pendingDestroy.clear();
+}
+
+/// <summary>
+/// Empties every archetype and frees every slot; the archetypes themselves are kept, along with
+/// the capacity of their arrays, for the next game
+/// </summary>
+void EntityWorld::Clear() {
+	for (auto& archetype : archetypes) {
+		archetype->Clear();
+	}
+
+	freeSlots.clear();
+	for (uint32_t index = 0; index < slots.size(); index++) {
+		if (slots[index].archetype != nullptr) {
+			slots[index].generation += 1;
+		}
+		slots[index].archetype = nullptr;
+		slots[index].dying = false;
+		freeSlots.push_back(index);
+	}
+
+	pendingDestroy.clear();
+	liveCount = 0;
+}
+
+/// <summary>
+/// Routes the storage of matching archetypes to another memory resource, such as an arena that is
+/// reset when the entities in them all die together; later calls take precedence
+/// </summary>
+/// <param name="required">Components an archetype must have to use the resource</param>
+/// <param name="resource">Memory resource to allocate from</param>
+void EntityWorld::SetResource(uint32_t required, std::pmr::memory_resource* resource) {
+	resources.insert(resources.begin(), { required, resource });
+
+	// Archetypes that already exist are rebuilt on the new resource
+	ReleaseStorage(required);
+}
+
+/// <summary>
+/// Replaces each empty matching archetype with a fresh one, giving its arrays' memory back to its
+/// resource; must not be called while a system is walking the archetypes
+/// </summary>
+/// <param name="required">Components an archetype must have</param>
+void EntityWorld::ReleaseStorage(uint32_t required) {
+	for (auto& archetype : archetypes) {
+		if (!archetype->Has(required)) {
+			continue;
+		}
+
+		if (archetype->Size() > 0) {
+			std::cout << "ERROR::ENTITIES::RELEASE_NOT_EMPTY " << archetype->Size() << " entities with components " << archetype->mask << std::endl;
+			continue;
+		}
+
+		uint32_t mask = archetype->mask;
+		archetype.reset(new Archetype(mask, ResourceFor(mask)));
+	}
+}
+
+void EntityWorld::Reserve(uint32_t components, size_t count) {
+	ArchetypeFor(components).Reserve(count);
+}
+
+bool EntityWorld::IsAlive(Entity entity) const {
+	return entity.index < slots.size() && slots[entity.index].generation == entity.generation && slots[entity.index].archetype != nullptr;
+}
+
+bool EntityWorld::IsDying(const Archetype& archetype, uint32_t row) const {
+	return slots[archetype.entities[row].index].dying;
+}
+
+/// <summary>
+/// Finds where a live entity's components are stored
+/// </summary>
+/// <param name="entity">Handle to look up</param>
+/// <param name="archetype">Set to the entity's archetype</param>
+/// <param name="row">Set to the entity's row in the archetype</param>
+/// <returns>False if the handle is stale</returns>
+bool EntityWorld::Locate(Entity entity, Archetype*& archetype, uint32_t& row) const {
+	if (!IsAlive(entity)) {
+		return false;
+	}
+
+	archetype = slots[entity.index].archetype;
+	row = slots[entity.index].row;
+	return true;
+}
+
+/// <summary>
+/// Counts the entities matching a query that have not been marked by Destroy
+/// </summary>
+/// <param name="required">Components an entity must have</param>
+/// <param name="excluded">Components an entity must not have</param>
+/// <returns>Number of matching entities</returns>
+int EntityWorld::Count(uint32_t required, uint32_t excluded) const {
+	int count = 0;
+
+	for (const auto& archetype : archetypes) {
+		if (archetype->Has(required) && (archetype->mask & excluded) == 0) {
+			count += (int)archetype->Size();
+		}
+	}
+
+	for (Entity entity : pendingDestroy) {
+		const Archetype* archetype = slots[entity.index].archetype;
+		if (archetype->Has(required) && (archetype->mask & excluded) == 0) {
+			count -= 1;
+		}
+	}
+
+	return count;
+}
+
+/// <summary>
+/// Writes the archetypes in their current order, then the slot table with each archetype
+/// pointer turned into an index, then the free list, so a Load hands out slots in the same order
+/// </summary>
+/// <param name="writer">Stream to write to</param>
+void EntityWorld::Save(StateWriter& writer) const {
+	if (!pendingDestroy.empty()) {
+		std::cout << "ERROR::ENTITIES::SAVE_WITH_PENDING_DESTROY " << pendingDestroy.size() << " entities" << std::endl;
+	}
+
+	writer.Write((uint32_t)archetypes.size());
+	for (const auto& archetype : archetypes) {
+		writer.Write(archetype->mask);
+		archetype->Save(writer);
+	}
+
+	writer.Write((uint32_t)slots.size());
+	for (const EntitySlot& slot : slots) {
+		SavedSlot saved = { NO_ARCHETYPE, slot.row, slot.generation };
+		for (uint32_t i = 0; i < archetypes.size() && slot.archetype != nullptr; i++) {
+			if (archetypes[i].get() == slot.archetype) {
+				saved.archetype = i;
+				break;
+			}
+		}
+		writer.Write(saved);
+	}
+
+	writer.WriteArray(freeSlots);
+	writer.Write(liveCount);
+}
+
+/// <summary>
+/// Puts back a world written by Save. Archetypes are put in the saved order, since systems and
+/// collision keys walk them in order; ones that already exist are reused, and ones the save
+/// does not have are kept empty after them
+/// </summary>
+/// <param name="reader">Stream to read from</param>
+void EntityWorld::Load(StateReader& reader) {
+	pendingDestroy.clear();
+
+	uint32_t archetypeCount = 0;
+	reader.Read(archetypeCount);
+
+	std::vector<std::unique_ptr<Archetype>> ordered;
+	for (uint32_t i = 0; i < archetypeCount && !reader.Failed(); i++) {
+		uint32_t mask = 0;
+		reader.Read(mask);
+
+		std::unique_ptr<Archetype> archetype;
+		for (auto& existing : archetypes) {
+			if (existing && existing->mask == mask) {
+				archetype = std::move(existing);
+				break;
+			}
+		}
+		if (!archetype) {
+			archetype.reset(new Archetype(mask, ResourceFor(mask)));
+		}
+
+		archetype->Load(reader);
+		ordered.push_back(std::move(archetype));
+	}
+
+	for (auto& existing : archetypes) {
+		if (existing) {
+			existing->Clear();
+			ordered.push_back(std::move(existing));
+		}
+	}
+	archetypes.swap(ordered);
+
+	uint32_t slotCount = 0;
+	reader.Read(slotCount);
+	slots.clear();
+	for (uint32_t i = 0; i < slotCount && !reader.Failed(); i++) {
+		SavedSlot saved;
+		reader.Read(saved);
+
+		EntitySlot slot = { nullptr, saved.row, saved.generation, false };
+		if (saved.archetype != NO_ARCHETYPE) {
+			if (saved.archetype >= archetypeCount || saved.row >= archetypes[saved.archetype]->Size()) {
+				reader.Fail();
+				break;
+			}
+			slot.archetype = archetypes[saved.archetype].get();
+		}
+		slots.push_back(slot);
+	}
+
+	reader.ReadArray(freeSlots);
+	reader.Read(liveCount);
+
+	if (reader.Failed()) {
+		std::cout << "ERROR::ENTITIES::LOAD_FAILED" << std::endl;
+		for (auto& archetype : archetypes) {
+			archetype->Clear();
+		}
+		slots.clear();
+		freeSlots.clear();
+		liveCount = 0;
+	}
+}
+
+int EntityWorld::EntityCount() const {
+	return liveCount;
+}
+
+int EntityWorld::ArchetypeCount() const {
+	return (int)archetypes.size();
+}
+
+/// <summary>
+/// Returns the archetype holding entities with exactly these components
+/// </summary>
+/// <param name="mask">ComponentFlags of the archetype</param>
+/// <returns>Existing or newly created archetype</returns>
+Archetype& EntityWorld::ArchetypeFor(uint32_t mask) {
+	for (auto& archetype : archetypes) {
+		if (archetype->mask == mask) {
+			return *archetype;
+		}
+	}
+
+	archetypes.push_back(std::unique_ptr<Archetype>(new Archetype(mask, ResourceFor(mask))));
+	return *archetypes.back();
+}
+
+std::pmr::memory_resource* EntityWorld::ResourceFor(uint32_t mask) const {
+	for (const auto& resource : resources) {
+		if ((mask & resource.first) == resource.first) {
+			return resource.second;
+		}
+	}
+	return std::pmr::new_delete_resource();
+}
@@ -0,0 +1,214 @@
+//*****************************************************************************
+// Entities.h
+//
+// Author: Kyle Manning
+//
+// Brief Description: Header for the entity world, which stores enemies,
+//					  projectiles, and powerups as generational handles into
+//					  archetypes that keep each component in its own packed
+//					  array
+//*****************************************************************************
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "../Common/StateStream.h"
+
+// Components an entity can have; an archetype is the set of entities sharing one combination
+enum ComponentFlag : uint32_t {
+	// pos, size, facing; facing is the unit vector the entity's front points along
+	C_TRANSFORM = 1 << 0,
+	// velocity
+	C_VELOCITY = 1 << 1,
+	// health
+	C_HEALTH = 1 << 2,
+	// seekSpeed, followDistance; turns toward the player and closes to followDistance
+	C_SEEK = 1 << 3,
+	// contactDamage; hurts the player when touching them
+	C_CONTACT = 1 << 4,
+	// reloadTime, weapon; fires at the player whenever reloadTime runs out
+	C_SHOOTER = 1 << 5,
+	// flashTime; drawn in the damage color while it is above zero
+	C_DAMAGE_FLASH = 1 << 6,
+	// lifeTime; destroyed when it runs out
+	C_LIFETIME = 1 << 7,
+	// damage dealt on hit
+	C_DAMAGE = 1 << 8,
+	// growth; widens by this much per second
+	C_GROWTH = 1 << 9,
+	// mesh, color
+	C_RENDER = 1 << 10,
+	// pointValue awarded when destroyed by the player
+	C_SCORE = 1 << 11,
+	// Tag with no data for projectiles fired by the player
+	C_PLAYER_TEAM = 1 << 12,
+	// pickup; applies a powerup when the player touches it
+	C_PICKUP = 1 << 13
+};
+
+// Generational handle; stays invalid once its entity is destroyed even if the slot is reused
+struct Entity {
+	uint32_t index;
+	uint32_t generation;
+};
+
+/* One packed array per component; only the arrays named in mask are used, the rest stay
+*  empty. Row i of every used array belongs to entities[i], and rows are kept dense by moving
+*  the last row into any row that is removed. Every array allocates from the archetype's
+*  memory resource, which is the heap unless the world was told otherwise.
+*/
+struct Archetype {
+	uint32_t mask;
+	std::pmr::memory_resource* resource;
+	std::pmr::vector<Entity> entities;
+
+	std::pmr::vector<glm::vec2> pos, size, facing;
+	std::pmr::vector<glm::vec2> velocity;
+	std::pmr::vector<int> health;
+	std::pmr::vector<float> seekSpeed, followDistance;
+	std::pmr::vector<int> contactDamage;
+	std::pmr::vector<float> reloadTime;
+	std::pmr::vector<int> weapon;
+	std::pmr::vector<float> flashTime;
+	std::pmr::vector<float> lifeTime;
+	std::pmr::vector<int> damage;
+	std::pmr::vector<float> growth;
+	std::pmr::vector<int> mesh;
+	std::pmr::vector<glm::vec3> color;
+	std::pmr::vector<int> pointValue;
+	std::pmr::vector<int> pickup;
+
+	Archetype(uint32_t mask, std::pmr::memory_resource* resource);
+
+	size_t Size() const {
+		return entities.size();
+	}
+
+	bool Has(uint32_t components) const {
+		return (mask & components) == components;
+	}
+
+	// Appends a row with zeroed components and returns its index
+	uint32_t AddRow(Entity entity);
+
+	// Moves the last row into row and shrinks every used array by one
+	void RemoveRow(uint32_t row);
+
+	// Makes room for count rows in every used array
+	void Reserve(size_t count);
+
+	void Clear();
+
+	// Writes every used array, entities first
+	void Save(StateWriter& writer) const;
+
+	// Replaces every used array with ones written by Save; fails the reader if their lengths disagree
+	void Load(StateReader& reader);
+};
+
+// Where an entity's data lives, and the generation a handle needs to reach it
+struct EntitySlot {
+	Archetype* archetype;
+	uint32_t row;
+	uint32_t generation;
+	bool dying;
+};
+
+/* Owns every archetype and the slot table that maps handles to rows. Entities are destroyed in
+*  two steps: Destroy marks them so systems can skip them for the rest of the tick, and
+*  FlushDestroyed removes them once nothing is iterating, so rows never move under a loop.
+*/
+class EntityWorld {
+public:
+	EntityWorld();
+
+	// Adds an entity with the given components, all zeroed, and returns its handle
+	Entity Create(uint32_t components);
+
+	// Marks an entity to be removed on the next FlushDestroyed; stale handles are ignored
+	void Destroy(Entity entity);
+
+	// Removes every entity marked by Destroy
+	void FlushDestroyed();
+
+	// Removes every entity and invalidates every handle
+	void Clear();
+
+	// Makes archetypes with all of required allocate from resource; they must be empty when this is called
+	void SetResource(uint32_t required, std::pmr::memory_resource* resource);
+
+	// Drops the storage of empty archetypes with all of required, so their resource can be reset
+	void ReleaseStorage(uint32_t required);
+
+	// Makes room for count entities with exactly these components
+	void Reserve(uint32_t components, size_t count);
+
+	// Whether the handle still refers to an entity that has not been destroyed
+	bool IsAlive(Entity entity) const;
+
+	// Whether the entity in a row has been marked by Destroy this tick
+	bool IsDying(const Archetype& archetype, uint32_t row) const;
+
+	// Archetype and row of a live entity; returns false for stale handles
+	bool Locate(Entity entity, Archetype*& archetype, uint32_t& row) const;
+
+	// Calls visit for every non-empty archetype that has all of required and none of excluded; a
+	// template rather than std::function so a system's captures never go to the heap
+	template <class Visit>
+	void ForEach(uint32_t required, uint32_t excluded, Visit&& visit);
+
+	// Number of entities that have all of required and none of excluded, not counting dying ones
+	int Count(uint32_t required, uint32_t excluded = 0) const;
+
+	// Writes every entity and the slot table, so a Load puts back the same handles and the same
+	// archetype order; only called between ticks, when no entity is waiting to be removed
+	void Save(StateWriter& writer) const;
+
+	// Replaces every entity with ones written by Save, keeping the archetypes that already exist;
+	// on a failed read the world is left empty
+	void Load(StateReader& reader);
+
+	// Number of live entities, and of archetypes created so far
+	int EntityCount() const;
+	int ArchetypeCount() const;
+
+private:
+	// Held by pointer so slots and systems can keep references while new archetypes are added
+	std::vector<std::unique_ptr<Archetype>> archetypes;
+	std::vector<EntitySlot> slots;
+	std::vector<uint32_t> freeSlots;
+	std::vector<Entity> pendingDestroy;
+	// Components and the resource used by archetypes that have them, checked in order
+	std::vector<std::pair<uint32_t, std::pmr::memory_resource*>> resources;
+	int liveCount;
+
+	// Resource for a new archetype with the given components
+	std::pmr::memory_resource* ResourceFor(uint32_t mask) const;
+
+	// Finds the archetype for a component mask, creating it the first time it is needed
+	Archetype& ArchetypeFor(uint32_t mask);
+};
+
+/// <summary>
+/// Runs a system over every archetype matching a query; systems then walk each archetype's arrays
+/// from first row to last
+/// </summary>
+/// <param name="required">Components an archetype must have</param>
+/// <param name="excluded">Components an archetype must not have</param>
+/// <param name="visit">System to run on each matching archetype</param>
+template <class Visit>
+void EntityWorld::ForEach(uint32_t required, uint32_t excluded, Visit&& visit) {
+	// Indexed, since visit may create entities in an archetype that did not exist yet
+	for (size_t i = 0; i < archetypes.size(); i++) {
+		Archetype& archetype = *archetypes[i];
+		if (archetype.Has(required) && (archetype.mask & excluded) == 0 && archetype.Size() > 0) {
+			visit(archetype);
+		}
+	}
+}
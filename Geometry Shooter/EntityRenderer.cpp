@@ -0,0 +1,312 @@
+//*****************************************************************************
+// EntityRenderer.cpp
+//
+// Author: Kyle Manning
+//
+// Brief Description: Contains methods for EntityRenderer objects, which hold
+//					  the meshes and programs shared by every enemy, projectile,
+//					  and powerup and draw the entities extracted for a snapshot
+//*****************************************************************************
+#include "EntityRenderer.h"
+#include "../Common/GLState.h"
+
+#include <cstddef>
+#include <cstring>
+
+// Sort key layout, high bits first: layer, program, mesh, then the entity's index among all recorded entities
+const int KEY_LAYER_SHIFT = 56;
+const int KEY_SHADER_SHIFT = 48;
+const int KEY_MESH_SHIFT = 40;
+const int KEY_STATE_SHIFT = KEY_MESH_SHIFT;
+
+// Parts smaller than this cost more to hand out than they save
+const size_t MIN_COMMANDS_PER_PART = 256;
+
+/// <summary>
+/// Default constructor for EntityRenderers; nothing can be drawn until Init is called
+/// </summary>
+EntityRenderer::EntityRenderer() : jobs(nullptr), stream(nullptr), stats(), recordLayers(), layerStart(), cullMin(0.0f), cullMax(0.0f), partCount(0) {
+	for (Mesh& mesh : meshes) {
+		mesh.vertexCount = 0;
+		mesh.shader = SHADER_ENEMY;
+	}
+}
+
+/// <summary>
+/// Creates the instanced enemy and projectile programs, uploads the mesh of each shape, and makes
+/// a command buffer for each thread that can record
+/// </summary>
+/// <param name="jobs">Job system the commands are recorded on</param>
+/// <param name="stream">Frame stream the instance data is written into</param>
+void EntityRenderer::Init(JobSystem* jobs, StreamBuffer* stream) {
+	this->jobs = jobs;
+	this->stream = stream;
+	buffers.resize(jobs->WorkerCount() + 1);
+	partTransforms.resize(buffers.size());
+	partCulled.resize(buffers.size());
+
+	// The same sources the player is drawn with, taking the model and color per instance instead of as uniforms
+	shaders[SHADER_ENEMY] = Shader("player.vs", "player.fs", "#define INSTANCED\n");
+	shaders[SHADER_PROJECTILE] = Shader("projectile.vs", "projectile.fs", "#define INSTANCED\n");
+
+	glm::mat4 projection = glm::ortho(0.0f, 800.0f, 600.0f, 0.0f, -1.0f, 1.0f);
+
+	for (int i = 0; i < ENTITY_SHADER_COUNT; i++) {
+		viewUniforms[i] = shaders[i].Uniform<glm::mat4>("view");
+		shaders[i].SetMat4("projection", projection);
+	}
+
+	CreateMesh(MESH_ENEMY, {
+		-1.0f, -1.0f,
+		1.0f, 1.0f,
+		-1.0f, 1.0f,
+
+		-1.0f, -1.0f,
+		1.0f, -1.0f,
+		1.0f, 1.0f
+	}, SHADER_ENEMY);
+
+	CreateMesh(MESH_RANGED_ENEMY, {
+		-1.0f, 0.25f,
+		-0.65f, -1.0f,
+		0.65f, -1.0f,
+
+		-1.0f, 0.25f,
+		0.65f, -1.0f,
+		1.0f, 0.25f,
+
+		-1.0f, 0.25f,
+		1.0f, 0.25f,
+		0.0f, 1.0f
+	}, SHADER_ENEMY);
+
+	CreateMesh(MESH_WAVE_ENEMY, {
+		-1.0f, -1.0f,
+		1.0f, -1.0f,
+		-0.6f, 1.0f,
+
+		-0.6f, 1.0f,
+		1.0f, -1.0f,
+		0.6f, 1.0f
+	}, SHADER_ENEMY);
+
+	CreateMesh(MESH_PROJECTILE, {
+		-1.0f, 1.0f,
+		-1.0f, -1.0f,
+		1.0f, 1.0f,
+
+		1.0f, 1.0f,
+		-1.0f, -1.0f,
+		1.0f, -1.0f
+	}, SHADER_PROJECTILE);
+
+	CreateMesh(MESH_POWERUP, {
+		-1.0f, 1.0f,
+		-1.0f, -1.0f,
+		1.0f, 1.0f,
+
+		1.0f, 1.0f,
+		-1.0f, -1.0f,
+		1.0f, -1.0f
+	}, SHADER_ENEMY);
+}
+
+/// <summary>
+/// Splits the entities of every layer into equal ranges, records each range on the job system, and
+/// merges the sorted buffers. Small frames use fewer parts, down to one on this thread alone
+/// </summary>
+/// <param name="layers">Entities of each layer, as extracted by ExtractRenderList, or null to skip a layer</param>
+/// <param name="cullMin">World position of the top-left corner of the region being drawn</param>
+/// <param name="cullMax">World position of the bottom-right corner of the region being drawn</param>
+void EntityRenderer::Record(const RenderList* const (&layers)[RENDER_LAYER_COUNT], glm::vec2 cullMin, glm::vec2 cullMax) {
+	layerStart[0] = 0;
+	for (int layer = 0; layer < RENDER_LAYER_COUNT; layer++) {
+		recordLayers[layer] = layers[layer];
+		layerStart[layer + 1] = layerStart[layer] + (layers[layer] != nullptr ? layers[layer]->Size() : 0);
+	}
+
+	size_t total = layerStart[RENDER_LAYER_COUNT];
+	this->cullMin = cullMin;
+	this->cullMax = cullMax;
+	partCount = (unsigned int)std::min(buffers.size(), std::max((size_t)1, (total + MIN_COMMANDS_PER_PART - 1) / MIN_COMMANDS_PER_PART));
+
+	// Only this is captured, so the function fits in its small buffer and recording does not allocate
+	jobs->ParallelFor(partCount, [this](unsigned int part) { RecordPart(part); });
+
+	commands.Merge(buffers.data(), partCount);
+
+	stats = RenderCommandStats();
+	stats.recorded = (int)commands.Size();
+	stats.parts = (int)partCount;
+	for (unsigned int part = 0; part < partCount; part++) {
+		stats.culled += partCulled[part];
+	}
+}
+
+/// <summary>
+/// Runs the recorded commands of the chosen layers. The view is set once per program. Each run of
+/// commands with the same state bits, so the same layer, program, and mesh, has its instances
+/// copied into the frame stream and is drawn with one instanced call whose base instance points at them
+/// </summary>
+/// <param name="view">View matrix used in drawing</param>
+/// <param name="layerMask">LayerBit of every layer to draw</param>
+void EntityRenderer::Execute(const glm::mat4& view, uint32_t layerMask) {
+	for (int i = 0; i < ENTITY_SHADER_COUNT; i++) {
+		viewUniforms[i].Set(view);
+	}
+
+	size_t runStart = 0;
+	while (runStart < commands.Size()) {
+		uint64_t state = commands[runStart].key >> KEY_STATE_SHIFT;
+		size_t runEnd = runStart + 1;
+		while (runEnd < commands.Size() && commands[runEnd].key >> KEY_STATE_SHIFT == state) {
+			runEnd += 1;
+		}
+
+		size_t first = runStart;
+		size_t count = runEnd - runStart;
+		runStart = runEnd;
+
+		if ((layerMask & (1u << (commands[first].key >> KEY_LAYER_SHIFT))) == 0) {
+			continue;
+		}
+
+		// Offsets are kept a whole number of instances from the start of the buffer, so they can be a base instance
+		StreamAllocation alloc = stream->Allocate(count * sizeof(EntityInstance), sizeof(EntityInstance));
+		if (alloc.data == nullptr) {
+			continue;
+		}
+
+		EntityInstance* instances = (EntityInstance*)alloc.data;
+		for (size_t i = 0; i < count; i++) {
+			instances[i] = *commands[first + i].payload;
+		}
+
+		const Mesh& mesh = meshes[(commands[first].key >> KEY_MESH_SHIFT) & 0xff];
+		shaders[(commands[first].key >> KEY_SHADER_SHIFT) & 0xff].Use();
+		GLState::BindVertexArray(mesh.VAO);
+
+		glDrawArraysInstancedBaseInstance(GL_TRIANGLES, 0, mesh.vertexCount, (GLsizei)count, (GLuint)(alloc.offset / sizeof(EntityInstance)));
+
+		stats.draws += 1;
+		stats.instances += (int)count;
+	}
+}
+
+/// <summary>
+/// Switches every entity shader between writing its color and writing the average of its color;
+/// the time stop layer is baked in the latter
+/// </summary>
+/// <param name="luminance">Whether to write the average</param>
+void EntityRenderer::SetLuminance(bool luminance) {
+	for (int i = 0; i < ENTITY_SHADER_COUNT; i++) {
+		shaders[i].SetBool("luminance", luminance);
+	}
+}
+
+RenderCommandStats EntityRenderer::GetStats() const {
+	return stats;
+}
+
+void EntityRenderer::Release() {
+	commands.Clear();
+
+	for (Mesh& mesh : meshes) {
+		mesh.VBO.Reset();
+		mesh.VAO.Reset();
+	}
+
+	for (int i = 0; i < ENTITY_SHADER_COUNT; i++) {
+		viewUniforms[i] = UniformHandle<glm::mat4>();
+		shaders[i] = Shader();
+	}
+}
+
+/// <summary>
+/// Runs on a worker or the GL thread: takes one range of the recorded entities a layer at a time,
+/// builds the packed transforms of the layer's slice of the range with the transform kernel, then
+/// skips the entities entirely outside the cull rectangle and adds the rest to this part's buffer,
+/// sorting it at the end so the GL thread only has to merge
+/// </summary>
+/// <param name="part">Index of the range, which is also the buffer it records into</param>
+void EntityRenderer::RecordPart(unsigned int part) {
+	CommandBuffer<EntityInstance>& buffer = buffers[part];
+	std::vector<float>& transforms = partTransforms[part];
+	size_t total = layerStart[RENDER_LAYER_COUNT];
+	size_t begin = total * part / partCount;
+	size_t end = total * (part + 1) / partCount;
+	int culled = 0;
+
+	buffer.Clear();
+	buffer.Reserve(end - begin);
+	transforms.resize((end - begin) * AFFINE_FLOATS);
+
+	for (int layer = 0; layer < RENDER_LAYER_COUNT; layer++) {
+		size_t sliceBegin = std::max(begin, layerStart[layer]);
+		size_t sliceEnd = std::min(end, layerStart[layer + 1]);
+		if (sliceBegin >= sliceEnd) {
+			continue;
+		}
+
+		const RenderList& list = *recordLayers[layer];
+		size_t first = sliceBegin - layerStart[layer];
+		size_t count = sliceEnd - sliceBegin;
+
+		BuildAffineTransforms(&list.pos[first], &list.facing[first], &list.size[first], &list.pivot[first], count, transforms.data(), AFFINE_FLOATS);
+
+		for (size_t i = 0; i < count; i++) {
+			size_t row = first + i;
+			glm::vec2 pos = list.pos[row];
+
+			float radius = RenderRadius(list.size[row], list.pivot[row]);
+			if (pos.x + radius < cullMin.x || pos.x - radius > cullMax.x || pos.y + radius < cullMin.y || pos.y - radius > cullMax.y) {
+				culled += 1;
+				continue;
+			}
+
+			int mesh = list.mesh[row];
+			uint64_t key = ((uint64_t)layer << KEY_LAYER_SHIFT) | ((uint64_t)meshes[mesh].shader << KEY_SHADER_SHIFT) |
+				((uint64_t)mesh << KEY_MESH_SHIFT) | (uint64_t)(sliceBegin + i);
+
+			EntityInstance instance;
+			memcpy(instance.model, &transforms[i * AFFINE_FLOATS], sizeof(instance.model));
+			instance.color = list.color[row];
+			buffer.Add(key, instance);
+		}
+	}
+
+	buffer.Sort();
+	partCulled[part] = culled;
+}
+
+/// <summary>
+/// Uploads the vertices of one shape into its own buffer and array
+/// </summary>
+/// <param name="mesh">Shape being created</param>
+/// <param name="vertices">2D positions, three per triangle</param>
+/// <param name="shader">Program the shape is drawn with</param>
+void EntityRenderer::CreateMesh(EntityMesh mesh, const vector<float>& vertices, EntityShader shader) {
+	Mesh& target = meshes[mesh];
+	target.VAO = GpuVertexArray("entity mesh VAO");
+	target.VBO = GpuBuffer("entity mesh vertices");
+	target.vertexCount = (int)vertices.size() / 2;
+	target.shader = shader;
+
+	GLState::BindArrayBuffer(target.VBO);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+	target.VBO.SetBytes(vertices.size() * sizeof(float));
+
+	GLState::BindVertexArray(target.VAO);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+	glEnableVertexAttribArray(0);
+
+	// Instances are sourced from the frame stream, one per instance; draws select them with their base instance
+	GLState::BindArrayBuffer(stream->ID);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(EntityInstance), (void*)offsetof(EntityInstance, model));
+	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(EntityInstance), (void*)(offsetof(EntityInstance, model) + 3 * sizeof(float)));
+	glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(EntityInstance), (void*)offsetof(EntityInstance, color));
+	for (GLuint attribute = 1; attribute <= 3; attribute++) {
+		glEnableVertexAttribArray(attribute);
+		glVertexAttribDivisor(attribute, 1);
+	}
+}
@@ -0,0 +1,123 @@
+//*****************************************************************************
+// EntityRenderer.h
+//
+// Author: Kyle Manning
+//
+// Brief Description: Header for EntityRenderer objects
+//*****************************************************************************
+#pragma once
+
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+#include "Systems.h"
+#include "../Common/AffineKernel.h"
+#include "../Common/CommandBuffer.h"
+#include "../Common/GpuResources.h"
+#include "../Common/JobSystem.h"
+#include "../Common/StreamBuffer.h"
+
+// Groups of entities in the order they are drawn; commands sort by layer first, so the order between layers is kept
+enum RenderLayer {
+	LAYER_PICKUPS,
+	LAYER_ENEMIES,
+	LAYER_PLAYER_BULLETS,
+	LAYER_ENEMY_BULLETS,
+	RENDER_LAYER_COUNT
+};
+
+// Bit for a layer in the masks passed to EntityRenderer::Execute
+inline uint32_t LayerBit(RenderLayer layer) {
+	return 1u << layer;
+}
+
+// Commands recorded, culled, and run for the debug overlay
+struct RenderCommandStats {
+	int recorded, culled, parts;
+	// Instanced draw calls, one per run of commands sharing a program and mesh, and instances in the Execute calls since Record
+	int draws, instances;
+};
+
+/* Draws entities with one shared mesh per shape and one shared program per shader, rather than
+*  a buffer, array, and program for every object. The sim thread extracts the transforms and
+*  colors into a render snapshot, so drawing never reads the world itself.
+*
+*  Record splits the snapshot's entities into ranges and has the job system cull them in parallel,
+*  each range into its own CommandBuffer; the transform kernel builds each range's packed 2x3
+*  transforms in one pass. The sort key holds the layer, program, mesh, and the entity's place in
+*  the snapshot, so the merged list keeps layers in order, groups entities sharing a program and
+*  mesh, and comes out the same however the work was split. Execute, on the GL thread, copies each
+*  run of commands sharing a program and mesh into the frame stream and draws the run with one
+*  instanced call.
+*/
+class EntityRenderer {
+public:
+	EntityRenderer();
+
+	// Builds the meshes and programs and sets their projection; commands are recorded on the given jobs and instances streamed through stream
+	void Init(JobSystem* jobs, StreamBuffer* stream);
+
+	// Records commands for the entities of each layer that overlap the cull rectangle, replacing the last ones; null layers are skipped
+	void Record(const RenderList* const (&layers)[RENDER_LAYER_COUNT], glm::vec2 cullMin, glm::vec2 cullMax);
+
+	// Draws the recorded commands of the layers in layerMask
+	void Execute(const glm::mat4& view, uint32_t layerMask);
+
+	// Makes every entity shader write the average of its color, for baking into a one-channel target
+	void SetLuminance(bool luminance);
+
+	RenderCommandStats GetStats() const;
+
+	// Deletes the meshes and programs; called before the context is destroyed
+	void Release();
+
+private:
+	// Enemies and powerups are drawn with one shader, projectiles with another
+	enum EntityShader {
+		SHADER_ENEMY,
+		SHADER_PROJECTILE,
+		ENTITY_SHADER_COUNT
+	};
+
+	struct Mesh {
+		GpuBuffer VBO;
+		GpuVertexArray VAO;
+		int vertexCount;
+		EntityShader shader;
+	};
+
+	// Per-instance data of a command, laid out as the instanced attributes read it
+	struct EntityInstance {
+		float model[AFFINE_FLOATS];
+		glm::vec3 color;
+	};
+
+	Mesh meshes[ENTITY_MESH_COUNT];
+	Shader shaders[ENTITY_SHADER_COUNT];
+	UniformHandle<glm::mat4> viewUniforms[ENTITY_SHADER_COUNT];
+
+	JobSystem* jobs;
+	StreamBuffer* stream;
+
+	// One buffer and one set of transforms per recording part; the buffers are merged into commands
+	std::vector<CommandBuffer<EntityInstance>> buffers;
+	std::vector<std::vector<float>> partTransforms;
+	std::vector<int> partCulled;
+	CommandList<EntityInstance> commands;
+	RenderCommandStats stats;
+
+	// The layers and cull rectangle of the Record in progress, read by every part
+	const RenderList* recordLayers[RENDER_LAYER_COUNT];
+	size_t layerStart[RENDER_LAYER_COUNT + 1];
+	glm::vec2 cullMin, cullMax;
+	unsigned int partCount;
+
+	// Culls one range of the recorded entities and builds commands for the rest into its own buffer
+	void RecordPart(unsigned int part);
+
+	// Uploads a mesh's vertices and describes their layout
+	void CreateMesh(EntityMesh mesh, const vector<float>& vertices, EntityShader shader);
+};
@@ -9,15 +9,21 @@
 //					  and handling game flow
 //*****************************************************************************
 #include "Game.h"
+#include "../Common/GLState.h"
+#include "../Common/FastMath.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iterator>
 
 Player* player;
+// Second player in a co-op game, null otherwise; player is always player 0 and partner player 1
+Player* partner;
 TextRenderer* titleRenderer;
 TextRenderer* uiRenderer;
 
-vector<Projectile*> playerBullets;
-vector<Enemy*> enemies;
-vector<Projectile> enemyBullets;
-vector<Powerup*> powerups;
 
 float backGroundVerts[] = {
 	-1.0f, 1.0f, 0.0f, 30.0f,
@@ -39,7 +45,20 @@ float grayScaleVerts[]{
 	1.0f,  1.0f,  1.0f, 1.0f
 };
 
-float loadTime = 1.0f;
+/// <summary>
+/// Lists the players in the sim: the first player, then the partner in a co-op game
+/// </summary>
+/// <param name="players">Filled with the players in order</param>
+/// <returns>Number of players</returns>
+static int GatherPlayers(Player* players[NET_PLAYER_COUNT]) {
+	int count = 0;
+	players[count++] = player;
+	if (partner != nullptr) {
+		players[count++] = partner;
+	}
+	return count;
+}
+
 float winTime = 2.0f;
 float comboResetTime = 5.0f;
 
@@ -131,28 +150,105 @@ vector<int> wave4 = {
 	1, 2, 3, 2, 1, 2, 3, 2, 1
 };
 
+vector<int>* waves[] = { &wave1, &wave2, &wave3, &wave4 };
+
 /// <summary>
 /// Default constructor for Game objects
 /// </summary>
 /// <param name="width">Width of the window</param>
 /// <param name="height">Height of the window</param>
-Game::Game(unsigned int width, unsigned int height) : State(GAME_TITLE), pState(P_NONE), Keys(), Width(width), Height(height), score(0), comboNumber(0), scoreMultiplier(1.0f), powerUpTimer(POWER_UP_TIME), powerupSpawnChance(20), waveCount(0), waveCountDown(5.0f), spawnPauseTimer(SPAWN_PAUSE), backgroundShift(0.0f) {
+Game::Game(unsigned int width, unsigned int height) : Keys(), score(0), comboNumber(0), powerupSpawnChance(20), waveCount(0), Width(width), Height(height), frozenLayerValid(false), debugOverlay(false), fireRate(FIRE_RATE), simTime(0.0), scoreMultiplier(1.0f), powerUpTimer(POWER_UP_TIME), waveCountDown(5.0f), spawnPauseTimer(SPAWN_PAUSE), backgroundShift(0.0f), backgroundImage(0), frozenVersion(0), frozenLayerOrigin(0.0f, 0.0f), State(GAME_TITLE), pState(P_NONE), waveArena(WAVE_ARENA_BYTES), waveResource(&waveArena, ALLOC_SPAWN), frameMemory(FRAME_SCRATCH_BYTES), fireHeld(false), nextFireTime(0.0), simRunning(false), assetsReady(false), simTick(0), captureMs(0.0), restoreMs(0.0), restoreCount(0), stateRequest(STATE_NONE), coopStarted(false), coopFailed(false), tickInputs(), shownBackground(0), shownShift(0.0f), shownRestoreCount(0), fadeEnded(true), bakedFrozenVersion(0), aimLatched(false), latchedAim(0.0f, 1.0f) {
 
 }
 
 Game::~Game() {
+	StopSim();
+	delete player;
+	delete partner;
+}
+
+/// <summary>
+/// Stops the loader, deletes every game object, and releases the game's GL resources while the
+/// context still exists, so that anything GpuResources reports afterwards is a real leak
+/// </summary>
+void Game::Shutdown() {
+	// The sim thread is the only other user of the world and the player
+	StopSim();
+
+	// Pending uploads hold pointers into the text renderers and textures released below
+	loader.Release();
+
 	delete player;
+	delete partner;
+	player = nullptr;
+	partner = nullptr;
+	rollback.Close();
+
+	entities.Clear();
+	entityRenderer.Release();
+
+	delete uiRenderer;
+	delete titleRenderer;
+	uiRenderer = nullptr;
+	titleRenderer = nullptr;
+
+	backgroundShader = Shader();
+	grayScaleShader = Shader();
+	backgroundVBO.Reset();
+	backgroundVAO.Reset();
+	timestopVBO.Reset();
+	timestopVAO.Reset();
+	frozenLayerFBO.Reset();
+	frozenLayerTex.Reset();
+	healingTex.Reset();
+
+	backgrounds.Release();
+	postProcess.Release();
+	frameStream.Release();
+	pacer.Release();
 }
 
 /// <summary>
 /// Initializes data for the game by creating the player and TextRenderers, as well as
-/// calling to initialize the background
+/// calling to initialize the background; images and fonts are only queued here, so the title
+/// screen is drawn right away and fills in as the loader uploads them
 /// </summary>
 void Game::Init() {
-	player = new Player(glm::vec2(400.0f, 350.0f), PLAYER_SIZE, 0.0f, glm::vec3(0.0f, 0.8f, 0.0f));
+	// Shader sources, textures, and glyph atlases are taken from the bundle when it has them
+	if (bundle.Open(ASSET_BUNDLE_FILE)) {
+		Shader::SetSourceLookup([this](const char* path, string& source) {
+			const BundleEntry* entry = bundle.Find(path, BUNDLE_SHADER_SOURCE);
+			if (entry == nullptr) {
+				return false;
+			}
+			source.assign((const char*)bundle.Data(*entry), (size_t)entry->size);
+			return true;
+		});
+	}
+
+	Shader::LoadProgramCache(SHADER_CACHE_FILE);
+	GpuResources::SetBudget(GPU_MEMORY_BUDGET);
+
+	jobs.Init();
+	loader.Init(&jobs);
+
+	player = new Player(glm::vec2(400.0f, 350.0f), PLAYER_SIZE, glm::vec2(0.0f, 1.0f), glm::vec3(0.0f, 0.8f, 0.0f));
+	if (rollback.IsOpen()) {
+		partner = new Player(glm::vec2(460.0f, 350.0f), PLAYER_SIZE, glm::vec2(0.0f, 1.0f), glm::vec3(0.2f, 0.6f, 1.0f));
+	}
+
+	frameStream.Init(STREAM_BYTES_PER_FRAME);
+	entityRenderer.Init(&jobs, &frameStream);
+	collisions.Init(&jobs);
 
-	uiRenderer = new TextRenderer("bahnschrift.ttf", 48);
-	titleRenderer = new TextRenderer("arial.ttf", 72);
+	// Every enemy is dead by the time a wave ends, so enemy archetypes can be freed with the arena
+	entities.SetResource(C_SEEK, &waveResource);
+	ReserveWave(wave1);
+
+	stateRing.Init(SNAPSHOT_RING_BYTES, SNAPSHOT_RING_MAX, SNAPSHOT_KEYFRAME_INTERVAL);
+
+	uiRenderer = new TextRenderer("bahnschrift.ttf", 48, &frameStream, &loader, &bundle);
+	titleRenderer = new TextRenderer("arial.ttf", 72, &frameStream, &loader, &bundle);
 
 	InitializeBackground();
 	InitializeHealingVignette();
@@ -161,38 +257,56 @@ void Game::Init() {
 	view = glm::mat4(1.0f);
 }
 
+/// <summary>
+/// Makes this a co-op game: this window plays one of the two players, and the other player's
+/// window is found on the loopback port of the other index. Play starts once both have pressed
+/// Enter and loaded, from a seed the first player picks; from then on only inputs are exchanged
+/// and both windows run the same ticks
+/// </summary>
+/// <param name="localIndex">0 for the first player, 1 for the second</param>
+/// <param name="conditions">Latency, jitter, and loss to simulate on what this window sends</param>
+/// <returns>False if the port could not be opened; the game is then single player</returns>
+bool Game::EnableCoop(int localIndex, const NetConditions& conditions) {
+	if (!rollback.Open(localIndex, conditions)) {
+		std::cout << "ERROR::GAME::COOP_NOT_STARTED" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
 /// <summary>
 /// Creates a background Shader object, sets the vertex buffer and array for the background,
-/// loads the background textures, and sets the initial uniform values for the background
+/// loads the first background image, and sets the initial uniform values for the background
 /// </summary>
 void Game::InitializeBackground() {
 	backgroundShader = Shader("background.vs", "background.fs");
 
-	glGenVertexArrays(1, &backgroundVAO);
-	glGenBuffers(1, &backgroundVBO);
+	backgroundVAO = GpuVertexArray("background VAO");
+	backgroundVBO = GpuBuffer("background vertices");
 
-	glBindBuffer(GL_ARRAY_BUFFER, backgroundVBO);
+	GLState::BindArrayBuffer(backgroundVBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(backGroundVerts), backGroundVerts, GL_STATIC_DRAW);
+	backgroundVBO.SetBytes(sizeof(backGroundVerts));
 
-	glBindVertexArray(backgroundVAO);
+	GLState::BindVertexArray(backgroundVAO);
 	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
 	glEnableVertexAttribArray(1);
 
-	// Loads the background textures that will be switched between as rounds progress
-	LoadTexture("background.jpg", backgroundTex);
-	LoadTexture("purple_background.png", background2);
-	LoadTexture("green_background.jpg", background3);
-	LoadTexture("red_background.jpg", background4);
+	// Only the first background is loaded now; the ones shown after later waves are streamed
+	// into the array while the game runs
+	backgrounds.Init({ "background.jpg", "purple_background.png", "green_background.jpg", "red_background.jpg" }, BACKGROUND_TEXTURE_UNIT, &loader, &bundle);
 	backgroundShader.Use();
 
 	glm::mat4 backModel = glm::mat4(1.0f);
 	backModel = glm::translate(backModel, glm::vec3(0.0f, 0.0f, 0.0f));
 	backModel = glm::scale(backModel, glm::vec3(15000.0f, 15000.0f, 0.0f));
 
-	backgroundShader.SetInt("texture", 0);
-	backgroundShader.SetInt("texture2", 1);
+	backgroundShader.SetInt("backgrounds", BACKGROUND_TEXTURE_UNIT);
+	backgroundShader.SetInt("fromLayer", backgrounds.FromLayer());
+	backgroundShader.SetInt("toLayer", backgrounds.ToLayer());
 	backgroundShader.SetFloat("shift", backgroundShift);
 	backgroundShader.SetMat4("model", backModel);
 	glm::mat4 projection = glm::ortho(0.0f, 800.0f, 600.0f, 0.0f, -1.0f, 1.0f);
@@ -200,100 +314,207 @@ void Game::InitializeBackground() {
 }
 
 /// <summary>
-/// Creates a Shader object for the healing vignette, initializes the vertex buffer and array, and generates the texture
-/// used for it
+/// Queues the texture for the healing vignette and initializes the post-processing chain that
+/// blends it over the scene, building the vignette's pass during loading; the targets start at
+/// the window size until Resize is called
 /// </summary>
 void Game::InitializeHealingVignette() {
-	healingShader = Shader("healing.vs", "healing.fs");
-
-	glGenVertexArrays(1, &healingVAO);
-	glGenBuffers(1, &healingVBO);
-
-	glBindBuffer(GL_ARRAY_BUFFER, healingVBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(grayScaleVerts), grayScaleVerts, GL_STATIC_DRAW);
-
-	glBindVertexArray(healingVAO);
-	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
-	glEnableVertexAttribArray(1);
-
-	LoadTexture("healing.png", healingTex);
+	postProcess.Init(Width, Height, { POST_HEALING_VIGNETTE });
 
-	healingShader.Use();
-	healingShader.SetInt("texture", 4);
+	LoadTexture("healing.png", healingTex, POST_VIGNETTE_TEXTURE_UNIT, [this]() {
+		postProcess.SetVignetteTexture(healingTex);
+	});
 }
 
 /// <summary>
 /// Creates a Shader object for the time stop filter, intializes the vertex buffer and array for
-/// the Shader, and generates a texture that will be drawn to with a bound framebuffer
+/// the Shader, and creates the framebuffer that the frozen layer is baked into
 /// </summary>
 void Game::InitializeTimeStopFilter() {
 	grayScaleShader = Shader("timeStop.vs", "timeStop.fs");
 
-	glGenVertexArrays(1, &timestopVAO);
-	glGenBuffers(1, &timestopVBO);
-	glBindVertexArray(timestopVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, timestopVBO);
+	timestopVAO = GpuVertexArray("time stop VAO");
+	timestopVBO = GpuBuffer("time stop vertices");
+	GLState::BindVertexArray(timestopVAO);
+	GLState::BindArrayBuffer(timestopVBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(grayScaleVerts), &grayScaleVerts, GL_STATIC_DRAW);
+	timestopVBO.SetBytes(sizeof(grayScaleVerts));
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
 	glEnableVertexAttribArray(1);
 	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
 
-	glGenFramebuffers(1, &fbo);
-	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	grayScaleShader.Use();
+	grayScaleShader.SetInt("texture", GRAYSCALE_TEXTURE_UNIT);
 
-	glGenTextures(1, &grayscaleTex);
-	glBindTexture(GL_TEXTURE_2D, grayscaleTex);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 800, 600, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+	// The view only ever shows one screen's worth of the layer
+	grayScaleShader.SetVec2("uvScale", 1.0f / FROZEN_LAYER_SCALE, 1.0f / FROZEN_LAYER_SCALE);
+
+	frozenLayerFBO = GpuFramebuffer("frozen layer");
+	CreateFrozenLayer();
+}
+
+/// <summary>
+/// Creates the oversized texture that the frozen layer is baked into, sized from the framebuffer
+/// rather than the window so it stays sharp after a resize; assigning the handle deletes any
+/// previous texture. The layer is only ever shown in grayscale, so it holds one channel
+/// </summary>
+void Game::CreateFrozenLayer() {
+	glm::ivec2 layerSize = FrozenLayerSize();
+
+	// The texture stays bound to its own unit so the filter never has to rebind it
+	frozenLayerTex = GpuTexture("frozen layer");
+	GLState::BindTexture(GRAYSCALE_TEXTURE_UNIT, GL_TEXTURE_2D, frozenLayerTex);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, layerSize.x, layerSize.y, 0, GL_RED, GL_UNSIGNED_BYTE, NULL);
+	frozenLayerTex.SetBytes(GpuResources::TextureBytes(layerSize.x, layerSize.y, 1, 1, 1));
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glBindTexture(GL_TEXTURE_2D, 0);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, grayscaleTex, 0);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	GLState::BindFramebuffer(frozenLayerFBO);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, frozenLayerTex, 0);
+	GLState::BindFramebuffer(0);
+
+	frozenLayerValid = false;
 }
 
 /// <summary>
-/// Generates a texture from the provided imageFile and sets it to the referenced unsigned int
+/// Scales the framebuffer up to the screens the frozen layer covers, then shrinks it, keeping its
+/// shape, until neither side is over FROZEN_LAYER_MAX_SIZE, so a large framebuffer does not make
+/// the layer outgrow the GPU budget
 /// </summary>
-/// <param name="imageFile">File name/path of the image used</param>
-/// <param name="texture">Unsigned int to assign texture to</param>
-void Game::LoadTexture(string imageFile, unsigned int& texture) {
-	glGenTextures(1, &texture);
-	glBindTexture(GL_TEXTURE_2D, texture);
+/// <returns>Width and height of the layer in texels</returns>
+glm::ivec2 Game::FrozenLayerSize() const {
+	glm::vec2 size = glm::vec2(postProcess.Width(), postProcess.Height()) * (float)FROZEN_LAYER_SCALE;
+	float shrink = std::min(1.0f, FROZEN_LAYER_MAX_SIZE / std::max(size.x, size.y));
 
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	return glm::ivec2(size * shrink);
+}
 
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+/// <summary>
+/// Resizes the post-processing targets and the frozen layer to match the framebuffer; the game
+/// world keeps its fixed Width x Height projection and is stretched over the new size
+/// </summary>
+/// <param name="fbWidth">Width of the framebuffer in pixels</param>
+/// <param name="fbHeight">Height of the framebuffer in pixels</param>
+void Game::Resize(unsigned int fbWidth, unsigned int fbHeight) {
+	// Minimizing the window reports a zero size, which cannot back a texture
+	if (fbWidth == 0 || fbHeight == 0 || (fbWidth == postProcess.Width() && fbHeight == postProcess.Height())) {
+		return;
+	}
 
-	stbi_set_flip_vertically_on_load(true);
-	int width, height, nrChannels;
-	const char* c = imageFile.c_str();
-	unsigned char* data = stbi_load(c, &width, &height, &nrChannels, 0);
+	postProcess.Resize(fbWidth, fbHeight);
+	CreateFrozenLayer();
+}
 
-	if (nrChannels == 3) {
-		if (data) {
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-			glGenerateMipmap(GL_TEXTURE_2D);
-		}
-		else {
-			cout << "Failed to load texture" << endl;
+/// <summary>
+/// Renders the background, enemies, and enemy bullets into the frozen layer texture, as the average
+/// of their colors; the layer is centered on the current view and covers FROZEN_LAYER_SCALE screens
+/// in each direction, so while time is stopped it only has to be drawn again if something in it
+/// changes or the player leaves it
+/// </summary>
+/// <param name="cameraCorner">World position of the top-left corner of the view</param>
+/// <param name="snapshot">Snapshot whose enemies and enemy bullets are baked</param>
+void Game::BakeFrozenLayer(glm::vec2 cameraCorner, const RenderSnapshot& snapshot) {
+	frozenLayerOrigin = cameraCorner - glm::vec2(Width, Height) * ((FROZEN_LAYER_SCALE - 1) / 2.0f);
+
+	// Shrinks the layer's region into the objects' screen-sized projection so all of it fits in one pass
+	glm::vec3 origin = glm::vec3(frozenLayerOrigin, 0.0f);
+	glm::mat4 layerView = glm::scale(glm::mat4(1.0f), glm::vec3(1.0f / FROZEN_LAYER_SCALE, 1.0f / FROZEN_LAYER_SCALE, 1.0f));
+	layerView = layerView * glm::lookAt(origin, origin + glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+	glm::mat4 screenView = view;
+	view = layerView;
+
+	glm::ivec2 layerSize = FrozenLayerSize();
+	GLState::BindFramebuffer(frozenLayerFBO);
+	glViewport(0, 0, layerSize.x, layerSize.y);
+	glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	backgroundShader.SetBool("luminance", true);
+	entityRenderer.SetLuminance(true);
+
+	DrawBackground();
+
+	const RenderList* layers[RENDER_LAYER_COUNT] = { nullptr, &snapshot.enemies, nullptr, &snapshot.enemyBullets };
+	entityRenderer.Record(layers, frozenLayerOrigin, frozenLayerOrigin + glm::vec2(Width, Height) * (float)FROZEN_LAYER_SCALE);
+	entityRenderer.Execute(view, LayerBit(LAYER_ENEMIES) | LayerBit(LAYER_ENEMY_BULLETS));
+
+	backgroundShader.SetBool("luminance", false);
+	entityRenderer.SetLuminance(false);
+
+	GLState::BindFramebuffer(postProcess.SceneTarget());
+	glViewport(0, 0, postProcess.Width(), postProcess.Height());
+
+	view = screenView;
+	frozenLayerValid = true;
+	bakedFrozenVersion = snapshot.frozenVersion;
+}
+
+/// <summary>
+/// Checks whether the whole view fits inside the region the frozen layer was baked for
+/// </summary>
+/// <param name="cameraCorner">World position of the top-left corner of the view</param>
+/// <returns>True if the cached layer can be used for this view</returns>
+bool Game::FrozenLayerCovers(glm::vec2 cameraCorner) {
+	glm::vec2 layerEnd = frozenLayerOrigin + glm::vec2(Width, Height) * (float)FROZEN_LAYER_SCALE;
+
+	return cameraCorner.x >= frozenLayerOrigin.x && cameraCorner.y >= frozenLayerOrigin.y &&
+		cameraCorner.x + Width <= layerEnd.x && cameraCorner.y + Height <= layerEnd.y;
+}
+
+/// <summary>
+/// Queues the provided imageFile on the asset loader and creates the texture in the referenced
+/// handle on a later frame; a bundle entry is uploaded from the mapping with its packed mips,
+/// otherwise the file is decoded on a worker thread and the mips are generated
+/// </summary>
+/// <param name="imageFile">File name/path of the image used</param>
+/// <param name="texture">Handle to create the texture in; must outlive the load</param>
+/// <param name="unit">Texture unit the texture is bound to</param>
+/// <param name="onLoaded">Called on the main thread once the texture has been uploaded</param>
+void Game::LoadTexture(string imageFile, GpuTexture& texture, unsigned int unit, std::function<void()> onLoaded) {
+	GpuTexture* target = &texture;
+	const BundleEntry* entry = bundle.Find(imageFile, BUNDLE_TEXTURE_RGBA8);
+	int levels = entry != nullptr ? (int)entry->levels : 1;
+
+	UploadFunc upload = [target, unit, levels, onLoaded](const DecodedAsset& image, const void* pixels) {
+		*target = GpuTexture("loaded image");
+		GLState::BindTexture(unit, GL_TEXTURE_2D, *target);
+
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		const unsigned char* level = (const unsigned char*)pixels;
+		for (int i = 0; i < levels; i++) {
+			int levelWidth = AssetBundle::LevelSize(image.width, i);
+			int levelHeight = AssetBundle::LevelSize(image.height, i);
+			glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA8, levelWidth, levelHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, level);
+			level += (size_t)levelWidth * levelHeight * 4;
 		}
-	}
-	else if (nrChannels == 4) {
-		if (data) {
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+
+		if (levels == 1) {
 			glGenerateMipmap(GL_TEXTURE_2D);
 		}
-		else {
-			cout << "Failed to load texture" << endl;
+
+		int fullLevels = 1 + (int)floor(log2(std::max(image.width, image.height)));
+		target->SetBytes(GpuResources::TextureBytes(image.width, image.height, 1, 4, fullLevels));
+
+		if (onLoaded) {
+			onLoaded();
 		}
-	}
+	};
 
-	stbi_image_free(data);
+	if (entry != nullptr) {
+		loader.QueueMapped(bundle.Data(*entry), entry->size, entry->width, entry->height, upload);
+	}
+	else {
+		loader.Queue([imageFile]() { return AssetLoader::DecodeImage(imageFile); }, upload);
+	}
 }
 
 /// <summary>
@@ -328,27 +549,52 @@ void Game::ProcessInput() {
 /// <summary>
 /// Handles the general gameloop by having separate behaviors for different game states and calling
 /// updates to object postions, spawning waves, checking collsions, reseting the player's combo, and
-/// checking for win and loss state conditions
+/// checking for win and loss state conditions. Each call is one fixed tick starting at simTime; the
+/// inputs that arrived during it are applied first, at the times they happened
 /// </summary>
-/// <param name="dt">Time elapsed between frames</param>
+/// <param name="dt">Length of the tick</param>
 void Game::Update(float dt) {
+	AllocScope updateScope(ALLOC_UPDATE);
 
-	if (State == GAME_LOAD) {
-		loadTime -= dt;
+	double tickStart = simTime;
+	double tickEnd = simTime + dt;
+	simTime = tickEnd;
 
-		if (loadTime <= 0.0f) {
+	// Play starts once the render thread has every queued asset on the GPU and every shader compiled
+	if (State == GAME_LOAD) {
+		if (assetsReady.load(std::memory_order_acquire)) {
 			State = GAME_ACTIVE;
 		}
 	}
 
+	// Co-op players move on the inputs exchanged for the tick rather than the local queue
+	if (rollback.IsOpen()) {
+		ApplyNetInputs(dt);
+	}
+	else {
+		RunInput(tickStart, tickEnd);
+	}
+
 	if (State == GAME_ACTIVE) {
-		player->UpdatePosition(dt);
-		player->UpdateRotation(mouseX, mouseY);
+		AllocScope activeScope(ALLOC_UPDATE, ALLOC_HOT);
+
+		Player* players[NET_PLAYER_COUNT];
+		int playerCount = GatherPlayers(players);
 
+		// Enemies stand still and hold their fire while time is frozen
 		if (pState != P_TIME_STOP) {
-			for (Enemy* enemy : enemies) {
-				enemy->UpdatePosition(dt);
+			glm::vec2 targets[NET_PLAYER_COUNT];
+			for (int i = 0; i < playerCount; i++) {
+				targets[i] = players[i]->pos;
+			}
+
+			SeekSystem(entities, targets, playerCount);
+			MovementSystem(entities, dt, C_SEEK, 0);
+			for (int i = 0; i < playerCount; i++) {
+				ContactDamageSystem(entities, *players[i], playerBatch);
 			}
+			ShooterSystem(entities, targets, playerCount, dt);
+			DamageFlashSystem(entities, dt);
 		}
 
 		// Changes the games background between waves
@@ -393,30 +639,21 @@ void Game::Update(float dt) {
 			}
 		}
 
-		CheckCollisions();
+		CheckCollisions(dt);
 
-		// Deletes bullets after a time to free up space
-		for (int i = 0; i < playerBullets.size(); i++) {
-			if (playerBullets[i]->hasExpired) {
-				playerBullets.erase(playerBullets.begin() + i);
-			}
-			else {
-				playerBullets[i]->UpdatePosition(dt);
-			}
-		}
+		MovementSystem(entities, dt, C_PLAYER_TEAM, 0);
+		LifetimeSystem(entities, dt, C_PLAYER_TEAM, 0);
 
-		// Enemy bullets do not lose lifetime while time is frozen
+		// Enemy bullets do not move or lose lifetime while time is frozen
 		if (pState != P_TIME_STOP) {
-			for (int i = 0; i < enemyBullets.size(); i++) {
-				if (enemyBullets[i].hasExpired) {
-					enemyBullets.erase(enemyBullets.begin() + i);
-				}
-				else {
-					enemyBullets[i].UpdatePosition(dt);
-				}
-			}
+			MovementSystem(entities, dt, C_DAMAGE, C_PLAYER_TEAM);
+			LifetimeSystem(entities, dt, 0, C_PLAYER_TEAM);
+			GrowthSystem(entities, dt, 0, C_PLAYER_TEAM);
 		}
 
+		// Removes bullets that ran out of time
+		entities.FlushDestroyed();
+
 		if (comboNumber > 0) {
 			comboResetTime -= dt;
 
@@ -426,8 +663,11 @@ void Game::Update(float dt) {
 			}
 		}
 
-		if (player->health <= 0) {
-			State = GAME_LOSS;
+		// Co-op players win or lose together
+		for (int i = 0; i < playerCount; i++) {
+			if (players[i]->health <= 0) {
+				State = GAME_LOSS;
+			}
 		}
 
 		if (waveCount == 4) {
@@ -441,184 +681,1078 @@ void Game::Update(float dt) {
 }
 
 /// <summary>
-/// Gradually shifts from one background to another by incrementing and setting a
-/// uniform shader in the background's Shader
+/// Gradually shifts from one background to another; the render thread passes the progress on to
+/// the background's Shader. The frozen layer is only baked again when the fade ends, not on every
+/// tick of it, so a time stop during a fade keeps the background it was baked with until then
 /// </summary>
 /// <param name="dt">Time elapsed between frames</param>
 void Game::ChangeBackground(float dt) {
 	if (backgroundShift < 1.0f) {
-		backgroundShift += (0.2f * dt);
-		backgroundShader.Use();
-		backgroundShader.SetFloat("shift", backgroundShift);
+		backgroundShift = std::min(backgroundShift + 0.2f * dt, 1.0f);
+
+		if (backgroundShift >= 1.0f) {
+			frozenVersion += 1;
+		}
 	}
 }
 
 /// <summary>
-/// Handles rendering behavior for the game; only the background and title UI are drawn in the Title game
-/// state, objects in the scene and gameplay UI are draw in the Active state
+/// Starts fading to another background image from the sim; the render thread sees the new image
+/// in the next snapshot and loads and binds it
 /// </summary>
-void Game::Render() {
+/// <param name="image">Index of the background image to fade to</param>
+void Game::StartBackgroundFade(int image) {
+	backgroundImage = image;
+	backgroundShift = 0.0f;
+	frozenVersion += 1;
+}
 
-	glm::vec3 cameraPos = glm::vec3(player->pos.x - 400.0f, player->pos.y - 300.0f, 0.0f);
+/// <summary>
+/// Points the background Shader at the layers of the image being shown and the given image, and
+/// restarts the crossfade; the image is loaded right away if it has not streamed in yet
+/// </summary>
+/// <param name="image">Index of the background image to fade to</param>
+void Game::FadeToBackground(int image) {
+	AllocScope assetScope(ALLOC_ASSETS);
+
+	backgrounds.BeginFade(image);
+
+	backgroundShader.SetInt("fromLayer", backgrounds.FromLayer());
+	backgroundShader.SetInt("toLayer", backgrounds.ToLayer());
+	shownShift = 0.0f;
+	backgroundShader.SetFloat("shift", shownShift);
+	fadeEnded = false;
+	frozenLayerValid = false;
+}
 
-	view = glm::lookAt(cameraPos, cameraPos + glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+/// <summary>
+/// Shows one background image with no fade, for a restored state whose image may not be one a
+/// fade could reach from the image on screen
+/// </summary>
+/// <param name="image">Index of the background image to show</param>
+void Game::ShowBackground(int image) {
+	AllocScope assetScope(ALLOC_ASSETS);
 
-	if (State == GAME_TITLE) {
-		DrawBackground();
+	backgrounds.Show(image);
+
+	backgroundShader.SetInt("fromLayer", backgrounds.FromLayer());
+	backgroundShader.SetInt("toLayer", backgrounds.ToLayer());
+	fadeEnded = true;
+	frozenLayerValid = false;
+}
+
+/// <summary>
+/// Catches the background up with the sim: jumps to the image of a restored state, starts a fade
+/// when the snapshot names a new image, sets the fade's progress, and once it is done frees the
+/// old layer for the next background to stream into
+/// </summary>
+/// <param name="snapshot">Snapshot being drawn</param>
+void Game::SyncBackground(const RenderSnapshot& snapshot) {
+	if (snapshot.restoreCount != shownRestoreCount) {
+		ShowBackground(snapshot.backgroundImage);
+		shownBackground = snapshot.backgroundImage;
+		shownRestoreCount = snapshot.restoreCount;
+	}
+	else if (snapshot.backgroundImage != shownBackground) {
+		FadeToBackground(snapshot.backgroundImage);
+		shownBackground = snapshot.backgroundImage;
 	}
 
-	if (State == GAME_ACTIVE || State == GAME_WIN || State == GAME_LOSS) {
-		/* When the player has the time stop powerup the background, enemies, and enemy projectiles
-		* are all drawn to a framebuffer and saved as a texture, which is then drawn to the screen
-		* with the player and player bullets drawn on top
-		*/
-		if (pState == P_TIME_STOP) {
-			glBindFramebuffer(GL_FRAMEBUFFER, fbo);
-			glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-			glEnable(GL_DEPTH_TEST);
+	if (snapshot.backgroundShift != shownShift) {
+		shownShift = snapshot.backgroundShift;
+		backgroundShader.SetFloat("shift", shownShift);
+	}
 
-			DrawBackground();
+	if (!fadeEnded && shownShift >= 1.0f) {
+		// Ending a fade can start streaming in the next background
+		AllocScope assetScope(ALLOC_ASSETS);
+
+		backgrounds.EndFade();
+		backgroundShader.SetInt("fromLayer", backgrounds.FromLayer());
+		fadeEnded = true;
+	}
+}
+
+/// <summary>
+/// Starts the sim thread from the current state. A first snapshot is published and taken here, so
+/// the render thread always has one to draw
+/// </summary>
+void Game::StartSim() {
+	PublishSnapshot(0.0);
+	snapshots.Acquire();
 
-			for (Enemy* enemy : enemies) {
-				enemy->DrawEnemy(view);
+	simRunning.store(true, std::memory_order_release);
+	simThread = std::thread(&Game::SimLoop, this);
+}
+
+void Game::StopSim() {
+	simRunning.store(false, std::memory_order_release);
+
+	if (simThread.joinable()) {
+		simThread.join();
+	}
+}
+
+/// <summary>
+/// Runs on the sim thread: every tick that has come due is run, at most MAX_SIM_STEPS at a time
+/// with the rest skipped after a stall, then a snapshot is published and the thread sleeps until
+/// the next tick. The render thread never waits on any of this. State snapshots for rewinding are
+/// taken and restored between ticks, where no entity is waiting to be removed. A co-op game runs
+/// each tick slot through RunCoopTick instead, and has no rewinding, since only one player's
+/// window would go back
+/// </summary>
+void Game::SimLoop() {
+	while (simRunning.load(std::memory_order_acquire)) {
+		auto start = std::chrono::high_resolution_clock::now();
+		double currentTime = glfwGetTime();
+		int steps = 0;
+
+		while (simTime + SIM_TICK <= currentTime && steps < MAX_SIM_STEPS) {
+			steps += 1;
+
+			if (rollback.IsOpen() || coopFailed) {
+				RunCoopTick();
+				continue;
 			}
 
-			for (Projectile bullet : enemyBullets) {
-				bullet.DrawProjectile(view);
+			Update((float)SIM_TICK);
+			simTick += 1;
+
+			if (State == GAME_ACTIVE && simTick % SNAPSHOT_INTERVAL_TICKS == 0) {
+				CaptureState();
 			}
+			RunStateRequest();
+		}
 
-			glBindFramebuffer(GL_FRAMEBUFFER, 0);
-			glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
-			glClear(GL_COLOR_BUFFER_BIT);
+		// After a long stall the sim skips to the present rather than running a backlog of ticks
+		if (simTime + SIM_TICK <= currentTime) {
+			simTime = currentTime;
+		}
 
-			// Draws texture from the framebuffer back on the default framebuffer
-			grayScaleShader.Use();
-			glDisable(GL_DEPTH_TEST);
-			glActiveTexture(GL_TEXTURE0);
-			glBindTexture(GL_TEXTURE_2D, grayscaleTex);
-			glBindVertexArray(timestopVAO);
-			glDrawArrays(GL_TRIANGLES, 0, 6);
+		if (steps > 0) {
+			std::chrono::duration<double, std::milli> simMs = std::chrono::high_resolution_clock::now() - start;
+			PublishSnapshot(simMs.count());
+		}
+
+		double wait = simTime + SIM_TICK - glfwGetTime();
+		if (wait > 0.0) {
+			std::this_thread::sleep_for(std::chrono::duration<double>(wait));
+		}
+	}
+}
+
+/// <summary>
+/// Fills the back snapshot with the player, HUD, background, and entity draw lists of the current
+/// tick and publishes it
+/// </summary>
+/// <param name="simMs">Time spent on the ticks since the last snapshot</param>
+void Game::PublishSnapshot(double simMs) {
+	AllocScope publishScope(ALLOC_UPDATE, ALLOC_HOT);
+	RenderSnapshot& snapshot = snapshots.Back();
+
+	snapshot.tick = simTick;
+	snapshot.state = State;
+	snapshot.pState = pState;
+	// The camera and HUD follow the player this window controls
+	Player* players[NET_PLAYER_COUNT];
+	int playerCount = GatherPlayers(players);
+	int local = rollback.IsOpen() || coopFailed ? rollback.LocalIndex() : 0;
+	const Player& shown = *players[local];
+
+	snapshot.playerPos = shown.pos;
+	snapshot.playerFacing = shown.facing;
+	snapshot.playerColor = shown.DrawColor();
+	snapshot.playerHealth = shown.health;
+	snapshot.score = score;
+	snapshot.comboNumber = comboNumber;
+	snapshot.waveCount = waveCount;
+	snapshot.backgroundImage = backgroundImage;
+	snapshot.backgroundShift = backgroundShift;
+	snapshot.restoreCount = restoreCount;
+	snapshot.frozenVersion = frozenVersion;
+
+	snapshot.pickups.Clear();
+	snapshot.enemies.Clear();
+	snapshot.playerBullets.Clear();
+	snapshot.enemyBullets.Clear();
+	ExtractRenderList(entities, C_PICKUP, 0, snapshot.pickups);
+	ExtractRenderList(entities, C_SEEK, 0, snapshot.enemies);
+	ExtractRenderList(entities, C_PLAYER_TEAM, 0, snapshot.playerBullets);
+	ExtractRenderList(entities, C_DAMAGE, C_PLAYER_TEAM, snapshot.enemyBullets);
+
+	snapshot.entityCount = entities.EntityCount();
+	snapshot.archetypeCount = entities.ArchetypeCount();
+	snapshot.waveArena = waveArena.GetStats();
+	snapshot.simMs = simMs;
+	snapshot.collisions = collisions.GetStats();
+	snapshot.stateRing = stateRing.GetStats();
+	snapshot.captureMs = captureMs;
+	snapshot.restoreMs = restoreMs;
+
+	snapshot.coop = rollback.IsOpen() || coopFailed;
+	snapshot.netFailed = coopFailed;
+	snapshot.partnerActive = playerCount > 1;
+	if (snapshot.partnerActive) {
+		const Player& other = *players[1 - local];
+		snapshot.partnerPos = other.pos;
+		snapshot.partnerFacing = other.facing;
+		snapshot.partnerColor = other.DrawColor();
+	}
+	snapshot.netWaiting = snapshot.coop && !coopStarted && State == GAME_LOAD && assetsReady.load(std::memory_order_acquire);
+	if (snapshot.coop) {
+		snapshot.rollback = rollback.GetStats();
+	}
+
+	snapshots.Publish();
+}
+
+/// <summary>
+/// Writes the sim's state: the header, the game's timers and counters, the waves still to spawn,
+/// the random sequence, the players, and every entity. Anything only the render thread reads,
+/// anything rebuilt from these, and the input held, which belongs to whoever is playing now, is
+/// left out
+/// </summary>
+/// <param name="writer">Stream to write to</param>
+void Game::SaveState(StateWriter& writer) {
+	writer.Write(STATE_MAGIC);
+	writer.Write(STATE_VERSION);
+	writer.Write(simTick);
+
+	writer.Write(State);
+	writer.Write(pState);
+	writer.Write(score);
+	writer.Write(comboNumber);
+	writer.Write(powerupSpawnChance);
+	writer.Write(waveCount);
+	writer.Write(scoreMultiplier);
+	writer.Write(powerUpTimer);
+	writer.Write(waveCountDown);
+	writer.Write(spawnPauseTimer);
+	writer.Write(backgroundShift);
+	writer.Write(backgroundImage);
+	writer.Write(fireRate);
+	writer.Write(winTime);
+	writer.Write(comboResetTime);
+
+	for (vector<int>* wave : waves) {
+		writer.WriteArray(*wave);
+	}
+
+	// The sim clock keeps running across a restore, so the next shot is saved as a time from now
+	writer.Write(nextFireTime - simTime);
+
+	writer.Write(random.GetState());
+	player->Save(writer);
+	if (partner != nullptr) {
+		partner->Save(writer);
+	}
+	entities.Save(writer);
+}
+
+/// <summary>
+/// Reads back what SaveState wrote. The enemies being replaced are dropped with the wave arena
+/// before the saved ones are read in, so restoring over and over within a wave does not grow it
+/// </summary>
+/// <param name="reader">Stream to read from</param>
+/// <returns>False if the image is from another layout or ran out</returns>
+bool Game::LoadState(StateReader& reader) {
+	uint32_t magic = 0, version = 0;
+	reader.Read(magic);
+	reader.Read(version);
+	if (magic != STATE_MAGIC || version != STATE_VERSION) {
+		std::cout << "ERROR::GAME::STATE_LAYOUT_MISMATCH: version " << version << ", expected " << STATE_VERSION << std::endl;
+		reader.Fail();
+		return false;
+	}
+
+	reader.Read(simTick);
+
+	reader.Read(State);
+	reader.Read(pState);
+	reader.Read(score);
+	reader.Read(comboNumber);
+	reader.Read(powerupSpawnChance);
+	reader.Read(waveCount);
+	reader.Read(scoreMultiplier);
+	reader.Read(powerUpTimer);
+	reader.Read(waveCountDown);
+	reader.Read(spawnPauseTimer);
+	reader.Read(backgroundShift);
+	reader.Read(backgroundImage);
+	reader.Read(fireRate);
+	reader.Read(winTime);
+	reader.Read(comboResetTime);
+
+	for (vector<int>* wave : waves) {
+		reader.ReadArray(*wave);
+	}
+
+	double fireDelay = 0.0;
+	reader.Read(fireDelay);
+	nextFireTime = simTime + fireDelay;
+
+	uint64_t randomState = 0;
+	reader.Read(randomState);
+	random.SetState(randomState);
+	player->Load(reader);
+	if (partner != nullptr) {
+		partner->Load(reader);
+	}
+
+	{
+		AllocScope spawnScope(ALLOC_SPAWN);
+		entities.Clear();
+		entities.ReleaseStorage(C_SEEK);
+		waveArena.Reset();
+		entities.Load(reader);
+	}
+
+	// Everything baked into the frozen layer may have changed
+	frozenVersion += 1;
+	return !reader.Failed();
+}
+
+/// <summary>
+/// Writes the state of the tick just finished and adds it to the rewind ring
+/// </summary>
+void Game::CaptureState() {
+	AllocScope captureScope(ALLOC_UPDATE);
+	auto start = std::chrono::high_resolution_clock::now();
+
+	stateWriter.Clear();
+	SaveState(stateWriter);
+	stateRing.Push(simTick, stateWriter.Bytes());
+
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+	captureMs = elapsed.count();
+}
+
+/// <summary>
+/// Loads a state image over the sim. The current state is written aside first and put back if
+/// the image turns out to be unreadable. Images hold no input, so the player carries on with the
+/// keys, buttons, and cursor they hold now
+/// </summary>
+/// <param name="image">Bytes written by SaveState</param>
+/// <returns>False if the image could not be read; the state is then unchanged</returns>
+bool Game::RestoreState(const std::vector<uint8_t>& image) {
+	AllocScope restoreScope(ALLOC_UPDATE);
+	auto start = std::chrono::high_resolution_clock::now();
+
+	restoreBackup.Clear();
+	SaveState(restoreBackup);
+
+	StateReader reader(image.data(), image.size());
+	if (!LoadState(reader) || !reader.AtEnd()) {
+		std::cout << "ERROR::GAME::STATE_IMAGE_NOT_READ" << std::endl;
+		StateReader backup(restoreBackup.Bytes().data(), restoreBackup.Bytes().size());
+		LoadState(backup);
+		return false;
+	}
+
+	ProcessInput();
+	player->UpdateFacing(mouseX, mouseY);
+	restoreCount += 1;
+
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+	restoreMs = elapsed.count();
+	return true;
+}
 
-			for (Powerup* powerup : powerups) {
-				powerup->DrawPowerup(view);
+/// <summary>
+/// F10 rewinds to the newest snapshot at least REWIND_TICKS old, or the oldest one kept, and
+/// drops the snapshots after it. F11 writes the current state to SESSION_FILE, and F12 resumes
+/// from it, starting the rewind ring over since its snapshots belong to another run
+/// </summary>
+void Game::RunStateRequest() {
+	StateRequest request = stateRequest;
+	stateRequest = STATE_NONE;
+
+	switch (request) {
+		case STATE_REWIND: {
+			if (stateRing.Count() == 0) {
+				std::cout << "ERROR::GAME::NO_SNAPSHOT_TO_REWIND_TO" << std::endl;
+				break;
 			}
 
-			player->DrawPlayer(view);
+			unsigned long long target = simTick > REWIND_TICKS ? simTick - REWIND_TICKS : 0;
+			size_t index = 0;
+			stateRing.Find(target, index);
 
-			for (Projectile* bullet : playerBullets) {
-				bullet->DrawProjectile(view);
+			if (stateRing.Rewind(index, restoreImage) && RestoreState(restoreImage)) {
+				std::cout << "Rewound to tick " << simTick << " in " << restoreMs << " ms" << std::endl;
 			}
+			break;
 		}
-		else {
-			DrawBackground();
+		case STATE_SAVE_SESSION: {
+			stateWriter.Clear();
+			SaveState(stateWriter);
+
+			std::ofstream file(SESSION_FILE, std::ios::binary);
+			file.write((const char*)stateWriter.Bytes().data(), stateWriter.Bytes().size());
+			if (!file) {
+				std::cout << "ERROR::GAME::SESSION_NOT_WRITTEN: " << SESSION_FILE << std::endl;
+				break;
+			}
 
-			if (pState == P_HEALING) {
-				healingShader.Use();
+			std::cout << "Saved tick " << simTick << " to " << SESSION_FILE << " (" << stateWriter.Bytes().size() << " bytes)" << std::endl;
+			break;
+		}
+		case STATE_RESUME_SESSION: {
+			// The saved state may be mid-wave, which needs every asset on the GPU
+			if (!assetsReady.load(std::memory_order_acquire)) {
+				std::cout << "ERROR::GAME::RESUME_BEFORE_ASSETS_LOADED" << std::endl;
+				break;
+			}
 
-				glBindVertexArray(healingVAO);
-				glDrawArrays(GL_TRIANGLES, 0, 6);
-				glBindVertexArray(0);
+			std::ifstream file(SESSION_FILE, std::ios::binary);
+			if (!file) {
+				std::cout << "ERROR::GAME::SESSION_NOT_FOUND: " << SESSION_FILE << std::endl;
+				break;
 			}
+			restoreImage.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
 
-			for (Powerup* powerup : powerups) {
-				powerup->DrawPowerup(view);
+			if (RestoreState(restoreImage)) {
+				stateRing.Clear();
+				std::cout << "Resumed tick " << simTick << " from " << SESSION_FILE << " in " << restoreMs << " ms" << std::endl;
 			}
+			break;
+		}
+		case STATE_NONE:
+			break;
+	}
+}
+
+/// <summary>
+/// Runs one co-op tick slot. Before play starts this only takes input and says hello; once both
+/// players are connected, both start tick 0 from the host's seed. From then on each slot takes
+/// the inputs that arrived, and if one contradicts a prediction a tick already ran on, loads the
+/// state saved before that tick and runs every tick since again with the inputs now known. The
+/// next tick then runs with this player's input sampled now, unless it would go too far past the
+/// other player's input or this player is running ahead, in which case the slot is skipped.
+/// If a saved state cannot be read back, or has bytes left over once it is, the world may be part
+/// loaded or wrong and can no longer match the other player's, so the session is closed and the
+/// sim stays stopped from then on
+/// </summary>
+void Game::RunCoopTick() {
+	double tickEnd = simTime + SIM_TICK;
+	DrainCoopInput(tickEnd);
+
+	if (coopFailed) {
+		simTime = tickEnd;
+		return;
+	}
 
-			player->DrawPlayer(view);
+	bool localReady = State == GAME_LOAD && assetsReady.load(std::memory_order_acquire);
+	rollback.Poll(localReady, simTick);
+
+	if (!coopStarted) {
+		if (!rollback.Connected()) {
+			simTime = tickEnd;
+			return;
+		}
+
+		random.Seed(rollback.Seed());
+		State = GAME_ACTIVE;
+		simTick = 0;
+		coopStarted = true;
+	}
+
+	unsigned long long from = 0;
+	if (rollback.TakeRollback(from) && from < simTick) {
+		auto start = std::chrono::high_resolution_clock::now();
+		unsigned long long resumeTick = simTick;
+		double resumeTime = simTime;
+
+		const std::vector<uint8_t>& image = rollback.StateAt(from).Bytes();
+		StateReader reader(image.data(), image.size());
+		if (!LoadState(reader) || !reader.AtEnd()) {
+			std::cout << "ERROR::GAME::ROLLBACK_STATE_NOT_READ: tick " << from << std::endl;
+			rollback.Close();
+			coopFailed = true;
+			simTime = tickEnd;
+			return;
+		}
 
-			for (Enemy* enemy : enemies) {
-				enemy->DrawEnemy(view);
+		while (simTick < resumeTick) {
+			AdvanceCoopTick();
+		}
+		simTime = resumeTime;
+
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+		rollback.RecordRollback((int)(resumeTick - from), elapsed.count());
+	}
+
+	if (!rollback.CanRun(simTick) || rollback.ShouldWait(simTick)) {
+		simTime = tickEnd;
+		return;
+	}
+
+	rollback.AddLocalInput(simTick, SampleLocalInput());
+	AdvanceCoopTick();
+}
+
+/// <summary>
+/// Saves the state at the start of the tick, so it can be rolled back to, then runs the tick with
+/// both players' inputs, predicted where the other player's has not arrived
+/// </summary>
+void Game::AdvanceCoopTick() {
+	auto start = std::chrono::high_resolution_clock::now();
+	StateWriter& state = rollback.StateAt(simTick);
+	state.Clear();
+	SaveState(state);
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+	rollback.RecordSave(elapsed.count());
+
+	rollback.Inputs(simTick, tickInputs);
+	Update((float)SIM_TICK);
+	simTick += 1;
+}
+
+/// <summary>
+/// Handles rendering behavior for the game; only the background and title UI are drawn in the Title game
+/// state, objects in the scene and gameplay UI are draw in the Active state. All dynamic vertex data for
+/// the frame is written into one region of frameStream, and full-screen effects are applied in one
+/// post-processing pass before the UI is drawn
+/// </summary>
+void Game::Render() {
+	AllocScope renderScope(ALLOC_RENDER, ALLOC_HOT);
+
+	// Uploads, shader builds, and the move out of loading are driven from here, since they need the context
+	{
+		AllocScope assetScope(ALLOC_ASSETS);
+		loader.Pump(ASSET_UPLOAD_BYTES_PER_FRAME);
+		bool shadersReady = Shader::PollPending();
+
+		if (loader.Done() && shadersReady) {
+			assetsReady.store(true, std::memory_order_release);
+		}
+	}
+
+	// Draws the newest tick the sim has finished, or the same one again if it has not finished another
+	snapshots.Acquire();
+	const RenderSnapshot& snapshot = snapshots.Front();
+	SyncBackground(snapshot);
+
+	glm::vec2 playerFacing = snapshot.playerFacing;
+	if (aimLatched && snapshot.state == GAME_ACTIVE) {
+		playerFacing = latchedAim;
+	}
+	aimLatched = false;
+
+	frameStream.BeginFrame();
+
+	postProcess.SetEffects(snapshot.pState == P_HEALING && snapshot.state != GAME_TITLE ? POST_HEALING_VIGNETTE : POST_NONE);
+	postProcess.BeginScene();
+
+	glm::vec3 cameraPos = glm::vec3(snapshot.playerPos.x - 400.0f, snapshot.playerPos.y - 300.0f, 0.0f);
+
+	view = glm::lookAt(cameraPos, cameraPos + glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+	if (snapshot.state == GAME_TITLE) {
+		DrawBackground();
+	}
+
+	if (snapshot.state == GAME_ACTIVE || snapshot.state == GAME_WIN || snapshot.state == GAME_LOSS) {
+		/* When the player has the time stop powerup the background, enemies, and enemy projectiles are
+		* frozen, so they are baked once into a cached layer and drawn as a single grayscale quad offset
+		* by the camera, with the player and player bullets drawn on top. The layer is only baked again
+		* when something in it changes or the player moves outside of it
+		*/
+		glm::vec2 cameraCorner = glm::vec2(cameraPos.x, cameraPos.y);
+		glm::vec2 cameraEnd = cameraCorner + glm::vec2(Width, Height);
+
+		if (snapshot.pState == P_TIME_STOP) {
+			if (!frozenLayerValid || bakedFrozenVersion != snapshot.frozenVersion || !FrozenLayerCovers(cameraCorner)) {
+				BakeFrozenLayer(cameraCorner, snapshot);
 			}
 
-			for (Projectile* bullet : playerBullets) {
-				bullet->DrawProjectile(view);
+			// Maps the screen quad onto the part of the layer under the view; layer texture rows run bottom to top
+			glm::vec2 layerSize = glm::vec2(Width, Height) * (float)FROZEN_LAYER_SCALE;
+			glm::vec2 offset = cameraCorner - frozenLayerOrigin;
+
+			grayScaleShader.Use();
+			grayScaleShader.SetVec2("uvOffset", offset.x / layerSize.x, 1.0f - (offset.y + Height) / layerSize.y);
+			GLState::BindTexture(GRAYSCALE_TEXTURE_UNIT, GL_TEXTURE_2D, frozenLayerTex);
+			GLState::BindVertexArray(timestopVAO);
+			glDrawArrays(GL_TRIANGLES, 0, 6);
+
+			const RenderList* layers[RENDER_LAYER_COUNT] = { &snapshot.pickups, nullptr, &snapshot.playerBullets, nullptr };
+			entityRenderer.Record(layers, cameraCorner, cameraEnd);
+
+			entityRenderer.Execute(view, LayerBit(LAYER_PICKUPS));
+
+			player->DrawPlayer(view, snapshot.playerPos, playerFacing, snapshot.playerColor);
+			if (snapshot.partnerActive) {
+				partner->DrawPlayer(view, snapshot.partnerPos, snapshot.partnerFacing, snapshot.partnerColor);
 			}
 
-			for (Projectile bullet : enemyBullets) {
-				bullet.DrawProjectile(view);
+			entityRenderer.Execute(view, LayerBit(LAYER_PLAYER_BULLETS));
+		}
+		else {
+			frozenLayerValid = false;
+
+			const RenderList* layers[RENDER_LAYER_COUNT] = { &snapshot.pickups, &snapshot.enemies, &snapshot.playerBullets, &snapshot.enemyBullets };
+			entityRenderer.Record(layers, cameraCorner, cameraEnd);
+
+			DrawBackground();
+
+			entityRenderer.Execute(view, LayerBit(LAYER_PICKUPS));
+
+			player->DrawPlayer(view, snapshot.playerPos, playerFacing, snapshot.playerColor);
+			if (snapshot.partnerActive) {
+				partner->DrawPlayer(view, snapshot.partnerPos, snapshot.partnerFacing, snapshot.partnerColor);
 			}
+
+			entityRenderer.Execute(view, LayerBit(LAYER_ENEMIES) | LayerBit(LAYER_PLAYER_BULLETS) | LayerBit(LAYER_ENEMY_BULLETS));
 		}
 	}
 
-	DrawUI();
+	postProcess.EndScene();
+
+	DrawUI(snapshot);
+
+	if (debugOverlay) {
+		DrawDebugOverlay(snapshot);
+	}
+
+	frameStream.EndFrame();
 }
 
 /// <summary>
-/// Draws the background by setting the Shader's view matrix, binding active textures, and then
-/// drawing it to the screen
+/// Draws the background by setting the Shader's view matrix, binding the background array, and then
+/// drawing it to the screen; the crossfade picks layers through uniforms, so the bind is skipped by
+/// GLState after the first frame
 /// </summary>
 void Game::DrawBackground() {
+	if (!backgrounds.Ready()) {
+		return;
+	}
+
 	backgroundShader.Use();
 	backgroundShader.SetMat4("view", view);
 
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, backgroundTex);
-	glActiveTexture(GL_TEXTURE1);
-	glBindTexture(GL_TEXTURE_2D, background2);
-	glActiveTexture(GL_TEXTURE2);
-	glBindTexture(GL_TEXTURE_2D, background3);
-	glActiveTexture(GL_TEXTURE3);
-	glBindTexture(GL_TEXTURE_2D, background4);
-	glActiveTexture(GL_TEXTURE4);
-	glBindTexture(GL_TEXTURE_2D, healingTex);
-
-	glBindVertexArray(backgroundVAO);
+	GLState::BindTexture(BACKGROUND_TEXTURE_UNIT, GL_TEXTURE_2D_ARRAY, backgrounds.ID);
+
+	GLState::BindVertexArray(backgroundVAO);
 	glDrawArrays(GL_TRIANGLES, 0, 6);
-	glBindVertexArray(0);
 }
 
+// Byte count formatted for the debug overlay, held by value so formatting never touches the heap
+struct ByteText {
+	char text[16];
+};
+
 /// <summary>
-/// Draws text UI on the screen; depending on the game state, different strings
-/// of text are drawn, with some using string vectors with updating elements
+/// Formats a byte count for the debug overlay
+/// </summary>
+/// <param name="bytes">Number of bytes</param>
+/// <returns>Size in KB or MB with one decimal place</returns>
+static ByteText FormatBytes(size_t bytes) {
+	ByteText result;
+	if (bytes >= 1024 * 1024) {
+		snprintf(result.text, sizeof(result.text), "%.1f MB", bytes / (1024.0 * 1024.0));
+	}
+	else {
+		snprintf(result.text, sizeof(result.text), "%.1f KB", bytes / 1024.0);
+	}
+	return result;
+}
+
+/// <summary>
+/// Name of a powerup for the HUD
+/// </summary>
+/// <param name="state">Active powerup state</param>
+/// <returns>Name shown after "Powerup Active: "</returns>
+static const char* PowerupName(PowerupState state) {
+	switch (state) {
+		case P_BETTER_BULLETS:
+			return "Better Bullets";
+		case P_MULTI_SHOT:
+			return "Multi Shot";
+		case P_TIME_STOP:
+			return "Time Stop";
+		default:
+			return "";
+	}
+}
+
+/// <summary>
+/// Draws the GL state cache, stream buffer, GPU resource, memory, and entity counters in the bottom
+/// left corner, one line per GL object type. Lines are formatted into a fixed buffer and copied into
+/// frame memory, so drawing the overlay does not allocate from the heap. Sim-side counters come from
+/// the snapshot
 /// </summary>
-void Game::DrawUI() {
-	string waveDisplay;
-	healthStrings[1] = std::to_string(player->health);
-	scoreStrings[1] = std::to_string(score);
-	comboStrings[1] = std::to_string(comboNumber) + "x";
+/// <param name="snapshot">Snapshot being drawn</param>
+void Game::DrawDebugOverlay(const RenderSnapshot& snapshot) {
+	const float lineHeight = 16.0f;
+	const float scale = 0.3f;
+	const glm::vec3 overlayColor = glm::vec3(1.0f, 1.0f, 0.6f);
+
+	GLStateStats glStats = GLState::GetStats();
+	StreamStats streamStats = frameStream.GetStats();
+	GpuResourceStats gpuStats = GpuResources::GetStats();
+	const ArenaStats& arenaStats = snapshot.waveArena;
+	ArenaStats frameStats = frameMemory.GetStats();
+	AllocFrameStats allocStats = AllocTracker::LastFrame();
+	FramePacingStats pacingStats = pacer.GetStats();
+	RenderCommandStats commandStats = entityRenderer.GetStats();
+
+	std::pmr::vector<std::pmr::string> lines(frameMemory.Resource());
+	lines.reserve(18 + GPU_RESOURCE_TYPE_COUNT);
+	char text[128];
+
+	snprintf(text, sizeof(text), "Frame: %.2f ms, std dev %.2f ms, worst %.2f ms, %s%s", pacingStats.frameMs, pacingStats.frameStdDevMs,
+		pacingStats.worstFrameMs, FramePacer::ModeName(pacer.Mode()), pacer.LowLatency() ? ", low latency" : "");
+	lines.emplace_back(text);
+	snprintf(text, sizeof(text), "Input latency: ~%.1f ms, %d frames queued, waited %.2f ms limiter %.2f ms GPU", pacingStats.inputLatencyMs,
+		pacingStats.queuedFrames, pacingStats.limiterWaitMs, pacingStats.gpuWaitMs);
+	lines.emplace_back(text);
+
+	snprintf(text, sizeof(text), "GL state: %llu issued, %llu skipped", glStats.issued, glStats.skipped);
+	lines.emplace_back(text);
+	snprintf(text, sizeof(text), "Stream: %s this frame, peak %s, %llu stalls", FormatBytes(streamStats.bytesLastFrame).text,
+		FormatBytes(streamStats.peakBytesPerFrame).text, streamStats.stallCount);
+	lines.emplace_back(text);
+	snprintf(text, sizeof(text), "GPU memory: %s of %s, peak %s", FormatBytes(gpuStats.totalBytes).text, FormatBytes(gpuStats.budgetBytes).text,
+		FormatBytes(gpuStats.peakBytes).text);
+	lines.emplace_back(text);
+	snprintf(text, sizeof(text), "Wave arena: %s, high water %s of %s, %llu resets", FormatBytes(arenaStats.used).text,
+		FormatBytes(arenaStats.highWater).text, FormatBytes(arenaStats.capacity).text, arenaStats.resets);
+	lines.emplace_back(text);
+	snprintf(text, sizeof(text), "Frame memory: %s, high water %s of %s", FormatBytes(frameStats.used).text,
+		FormatBytes(frameStats.highWater).text, FormatBytes(frameStats.capacity).text);
+	lines.emplace_back(text);
+	snprintf(text, sizeof(text), "Entities: %d in %d archetypes", snapshot.entityCount, snapshot.archetypeCount);
+	lines.emplace_back(text);
+	snprintf(text, sizeof(text), "Commands: %d recorded in %d parts, %d culled, %d instances in %d draws", commandStats.recorded,
+		commandStats.parts, commandStats.culled, commandStats.instances, commandStats.draws);
+	lines.emplace_back(text);
+	snprintf(text, sizeof(text), "Sim: tick %llu, %.2f ms for the ticks behind this frame", snapshot.tick, snapshot.simMs);
+	lines.emplace_back(text);
+	snprintf(text, sizeof(text), "Collisions: %d bullets x %d targets, %d tests %d wide in %d parts, %d hits, %.2f ms setup %.2f ms tests",
+		snapshot.collisions.bullets, snapshot.collisions.targets, snapshot.collisions.tests, snapshot.collisions.lanes, snapshot.collisions.parts, snapshot.collisions.hits,
+		snapshot.collisions.setupMs, snapshot.collisions.testMs);
+	lines.emplace_back(text);
+	snprintf(text, sizeof(text), "Snapshots: %d, %d keyframes, ticks %llu-%llu, %s for %s of state, %.3f ms capture %.3f ms restore",
+		snapshot.stateRing.snapshots, snapshot.stateRing.keyframes, snapshot.stateRing.oldestTick, snapshot.stateRing.newestTick,
+		FormatBytes(snapshot.stateRing.used).text, FormatBytes(snapshot.stateRing.rawBytes).text, snapshot.captureMs, snapshot.restoreMs);
+	lines.emplace_back(text);
+	if (snapshot.coop) {
+		const RollbackStats& net = snapshot.rollback;
+		snprintf(text, sizeof(text), "Rollback: %llu, last %d ticks in %.2f ms, worst %d ticks in %.2f ms, %llu ticks run again, save %.3f ms",
+			net.rollbacks, net.lastResimTicks, net.lastRollbackMs, net.maxResimTicks, net.maxRollbackMs, net.resimulatedTicks, net.saveMs);
+		lines.emplace_back(text);
+		snprintf(text, sizeof(text), "Net: player %d%s, %d predicted, %llu stalls %llu waits, ahead %d/%d, %.0f+-%.0f ms %.0f%% loss, %llu lost",
+			net.localIndex + 1, snapshot.netFailed ? " stopped, rollback state not read" : net.connected ? "" : " waiting", net.predictedTicks, net.stalls, net.syncWaits, net.localAdvantage, net.remoteAdvantage,
+			net.conditions.latencyMs, net.conditions.jitterMs, net.conditions.lossPercent, net.net.dropped);
+		lines.emplace_back(text);
+	}
+	snprintf(text, sizeof(text), "Input: %d queued, %llu dropped, fire rate %.1f/s", (int)inputQueue.Size(), inputQueue.Dropped(), fireRate);
+	lines.emplace_back(text);
+	snprintf(text, sizeof(text), "Heap: %llu allocations (%s) last frame, %llu hot, steady state %s", allocStats.total.calls,
+		FormatBytes(allocStats.total.bytes).text, allocStats.hotAllocations, AllocTracker::SteadyState() ? "on" : "off");
+	lines.emplace_back(text);
+
+	// Calls per tag on one line, e.g. "update 0, collision 0, ..."
+	int length = snprintf(text, sizeof(text), "Heap by tag:");
+	for (int tag = 0; tag < ALLOC_TAG_COUNT && length < (int)sizeof(text); tag++) {
+		length += snprintf(text + length, sizeof(text) - length, "%s %s %llu", tag == 0 ? "" : ",", AllocTracker::TagName((AllocTag)tag),
+			allocStats.tags[tag].calls);
+	}
+	lines.emplace_back(text);
+
+	for (int type = 0; type < GPU_RESOURCE_TYPE_COUNT; type++) {
+		snprintf(text, sizeof(text), "%ss: %d (%s)", GpuResources::TypeName((GpuResourceType)type), gpuStats.live[type],
+			FormatBytes(gpuStats.bytes[type]).text);
+		lines.emplace_back(text);
+	}
+
+	// Drawn bottom up so the summary lines stay on top
+	glm::vec2 pos = glm::vec2(10.0f, 10.0f);
+	for (int i = (int)lines.size() - 1; i >= 0; i--) {
+		uiRenderer->DrawText(lines[i], pos, scale, overlayColor);
+		pos.y += lineHeight;
+	}
+}
 
-	if (waveCount != 4) {
-		waveDisplay = "Wave " + std::to_string(waveCount + 1);
+/// <summary>
+/// Draws text UI on the screen; depending on the game state, different strings
+/// of text are drawn, with some using string vectors with updating elements.
+/// Strings built each frame live in frame memory
+/// </summary>
+/// <param name="snapshot">Snapshot holding the HUD values to show</param>
+void Game::DrawUI(const RenderSnapshot& snapshot) {
+	AllocScope uiScope(ALLOC_UI, ALLOC_HOT);
+	std::pmr::string waveDisplay(frameMemory.Resource());
+	healthStrings[1] = std::to_string(snapshot.playerHealth);
+	scoreStrings[1] = std::to_string(snapshot.score);
+	comboStrings[1] = std::to_string(snapshot.comboNumber) + "x";
+
+	if (snapshot.waveCount != 4) {
+		waveDisplay = "Wave ";
+		waveDisplay += std::to_string(snapshot.waveCount + 1);
 	}
 
-	if (State == GAME_TITLE) {
+	if (snapshot.state == GAME_TITLE) {
 		titleRenderer->DrawText("Geometry Shooter", glm::vec2(104.0f, 350.0f), 1.0f, glm::vec3(0.2f, 1.0f, 0.2f));
 		uiRenderer->DrawText("Press ENTER to start", glm::vec2(240.0f, 290.0f), 0.7f, glm::vec3(1.0f, 1.0f, 1.0f));
 	}
 
-	if (State == GAME_LOAD) {
-		uiRenderer->DrawText("Loading...", glm::vec2(285.0f, 300.0f), 1.0f, glm::vec3(1.0f, 1.0f, 1.0f));
+	if (snapshot.netFailed) {
+		uiRenderer->DrawText("Co-op stopped: rollback failed", glm::vec2(150.0f, 300.0f), 1.0f, glm::vec3(1.0f, 0.2f, 0.2f));
 	}
 
-	if (State == GAME_ACTIVE) {
+	if (snapshot.state == GAME_LOAD && snapshot.netWaiting) {
+		std::pmr::string waitDisplay("Waiting for player ", frameMemory.Resource());
+		waitDisplay += std::to_string(2 - snapshot.rollback.localIndex);
+		uiRenderer->DrawText(waitDisplay, glm::vec2(200.0f, 300.0f), 1.0f, glm::vec3(1.0f, 1.0f, 1.0f));
+	}
+	else if (snapshot.state == GAME_LOAD) {
+		std::pmr::string loadDisplay("Loading... ", frameMemory.Resource());
+		loadDisplay += std::to_string((int)(loader.Progress() * 100.0f));
+		loadDisplay += "%";
+		uiRenderer->DrawText(loadDisplay, glm::vec2(250.0f, 300.0f), 1.0f, glm::vec3(1.0f, 1.0f, 1.0f));
+	}
+
+	if (snapshot.state == GAME_ACTIVE) {
 		uiRenderer->DrawTextMultColor(scoreStrings, scoreColors, glm::vec2(15.0f, 550.0f), 0.7f);
 		uiRenderer->DrawTextMultColor(healthStrings, healthColors, glm::vec2(625.0f, 550.0f), 0.7f);
 		uiRenderer->DrawText(waveDisplay, glm::vec2(350.0f, 550.0f), 0.7f, glm::vec3(1.0f, 1.0f, 1.0f));
 
-		if (comboNumber > 0) {
+		if (snapshot.comboNumber > 0) {
 			uiRenderer->DrawTextMultColor(comboStrings, comboColors, glm::vec2(15.0f, 515.0f), 0.5f);
 		}
 
-		if (pState != P_NONE && pState != P_HEALING) {
-			string pDisplay = "Powerup Active: " + powerUpDisplay;
+		if (snapshot.pState != P_NONE && snapshot.pState != P_HEALING) {
+			std::pmr::string pDisplay("Powerup Active: ", frameMemory.Resource());
+			pDisplay += PowerupName(snapshot.pState);
 			uiRenderer->DrawText(pDisplay, glm::vec2(15.0f, 485.0f), 0.5f, glm::vec3(0.0f, 0.96f, 0.98f));
 		}
 	}
 
-	if (State == GAME_LOSS) {
+	if (snapshot.state == GAME_LOSS) {
 		titleRenderer->DrawText("YOU LOSE!", glm::vec2(220.0f, 325.0f), 1.0f, glm::vec3(1.0f, 1.0f, 1.0f));
 		uiRenderer->DrawTextMultColor(scoreStrings, scoreColors, glm::vec2(290.0f, 260.0f), 1.0f);
 	}
 
-	if (State == GAME_WIN) {
+	if (snapshot.state == GAME_WIN) {
 		titleRenderer->DrawText("YOU WIN!", glm::vec2(220.0f, 325.0f), 1.0f, glm::vec3(1.0f, 1.0f, 1.0f));
 		uiRenderer->DrawTextMultColor(scoreStrings, scoreColors, glm::vec2(290.0f, 260.0f), 1.0f);
 	}
 }
 
 /// <summary>
-/// Sets the values of the variables used in updating the player's rotation to the mouse's coordinates
+/// Adds an input to the queue; called from the GLFW callbacks, which may run on another thread than
+/// the sim, so nothing else is touched here. Inputs are dropped if the sim falls a full queue behind
+/// </summary>
+/// <param name="event">Input stamped with the time it arrived</param>
+void Game::QueueInput(const InputEvent& event) {
+	inputQueue.Push(event);
+}
+
+/// <summary>
+/// Applies every queued input that happened before the end of the tick, oldest first. The player
+/// is moved up to each input's time before it is applied, so a key tapped and released between two
+/// frames still moves the player for as long as it was down, and held shots are fired at their own
+/// times in between. Inputs from before the tick, e.g. after the sim skipped ahead, count as
+/// happening at its start
+/// </summary>
+/// <param name="tickStart">Time the tick starts</param>
+/// <param name="tickEnd">Time the tick ends; later inputs wait for the next tick</param>
+void Game::RunInput(double tickStart, double tickEnd) {
+	double cursor = tickStart;
+	InputEvent event;
+
+	while (inputQueue.Peek(event) && event.time < tickEnd) {
+		inputQueue.Pop();
+
+		double time = std::max(event.time, tickStart);
+		AdvancePlayer(cursor, time, tickStart);
+		cursor = time;
+
+		ApplyInput(event, time, tickStart);
+	}
+
+	AdvancePlayer(cursor, tickEnd, tickStart);
+}
+
+/// <summary>
+/// Applies one input: keys update Keys and the player's movement directions, the cursor updates the
+/// aim, and the left mouse button fires on press and starts or stops automatic fire. F10 to F12
+/// ask for a rewind, save, or resume, which waits until the tick is over
+/// </summary>
+/// <param name="event">Input to apply</param>
+/// <param name="time">Time within the tick the input happened</param>
+/// <param name="tickStart">Time the tick starts</param>
+void Game::ApplyInput(const InputEvent& event, double time, double tickStart) {
+	switch (event.type) {
+		case INPUT_KEY:
+			if (event.code >= 0 && event.code < 1024) {
+				if (event.action == GLFW_PRESS)
+					Keys[event.code] = true;
+				else if (event.action == GLFW_RELEASE)
+					Keys[event.code] = false;
+			}
+			ProcessInput();
+
+			if (event.action == GLFW_PRESS) {
+				if (event.code == GLFW_KEY_F10)
+					stateRequest = STATE_REWIND;
+				else if (event.code == GLFW_KEY_F11)
+					stateRequest = STATE_SAVE_SESSION;
+				else if (event.code == GLFW_KEY_F12)
+					stateRequest = STATE_RESUME_SESSION;
+			}
+			break;
+		case INPUT_CURSOR:
+			SetMousePos(event.x, event.y);
+			break;
+		case INPUT_MOUSE_BUTTON:
+			if (event.code == GLFW_MOUSE_BUTTON_LEFT) {
+				if (event.action == GLFW_PRESS) {
+					fireHeld = true;
+					nextFireTime = time + 1.0 / fireRate;
+					player->UpdateFacing(mouseX, mouseY);
+					CreateBullet(*player, (float)(time - tickStart));
+				}
+				else if (event.action == GLFW_RELEASE) {
+					fireHeld = false;
+				}
+			}
+			break;
+	}
+}
+
+/// <summary>
+/// Moves and turns the player across part of a tick, stopping at each held shot that falls in it so
+/// the shot leaves from where the player was at that moment; nothing moves outside of play. Shots
+/// that came due in time the sim skipped, after a stall or outside of play, are not made up for
+/// </summary>
+/// <param name="from">Time the player is at</param>
+/// <param name="to">Time to move the player to</param>
+/// <param name="tickStart">Time the tick starts</param>
+void Game::AdvancePlayer(double from, double to, double tickStart) {
+	if (State != GAME_ACTIVE) {
+		return;
+	}
+
+	// Only one shot is owed for any stretch of skipped time, fired now
+	nextFireTime = std::max(nextFireTime, from);
+
+	while (fireHeld && nextFireTime < to) {
+		double shotTime = nextFireTime;
+		player->UpdatePosition((float)(shotTime - from));
+		player->UpdateFacing(mouseX, mouseY);
+		from = shotTime;
+
+		CreateBullet(*player, (float)(shotTime - tickStart));
+		nextFireTime += 1.0 / fireRate;
+	}
+
+	player->UpdatePosition((float)(to - from));
+	player->UpdateFacing(mouseX, mouseY);
+}
+
+/// <summary>
+/// Takes every queued input before the end of the tick into Keys, the cursor, and the fire
+/// button, which SampleLocalInput reads. Nothing in the sim is touched, since the sim only moves
+/// on the inputs both players agree on; Enter on the title screen starts loading as usual
+/// </summary>
+/// <param name="tickEnd">Time the tick ends; later inputs wait for the next tick</param>
+void Game::DrainCoopInput(double tickEnd) {
+	InputEvent event;
+
+	while (inputQueue.Peek(event) && event.time < tickEnd) {
+		inputQueue.Pop();
+
+		switch (event.type) {
+			case INPUT_KEY:
+				if (event.code >= 0 && event.code < 1024) {
+					if (event.action == GLFW_PRESS)
+						Keys[event.code] = true;
+					else if (event.action == GLFW_RELEASE)
+						Keys[event.code] = false;
+				}
+
+				if (event.code == GLFW_KEY_ENTER && event.action == GLFW_PRESS && State == GAME_TITLE) {
+					State = GAME_LOAD;
+				}
+				break;
+			case INPUT_CURSOR:
+				SetMousePos(event.x, event.y);
+				break;
+			case INPUT_MOUSE_BUTTON:
+				if (event.code == GLFW_MOUSE_BUTTON_LEFT) {
+					if (event.action == GLFW_PRESS)
+						fireHeld = true;
+					else if (event.action == GLFW_RELEASE)
+						fireHeld = false;
+				}
+				break;
+		}
+	}
+}
+
+/// <summary>
+/// Packs the movement keys, the fire button, and the aim at the cursor into one tick's input
+/// </summary>
+/// <returns>Input for the tick being sampled</returns>
+NetInput Game::SampleLocalInput() const {
+	NetInput input = {};
+	if (Keys[GLFW_KEY_W])
+		input.buttons |= NET_UP;
+	if (Keys[GLFW_KEY_S])
+		input.buttons |= NET_DOWN;
+	if (Keys[GLFW_KEY_A])
+		input.buttons |= NET_LEFT;
+	if (Keys[GLFW_KEY_D])
+		input.buttons |= NET_RIGHT;
+	if (fireHeld)
+		input.buttons |= NET_FIRE;
+
+	SetNetAim(input, Player::AimFacing(mouseX, mouseY));
+	return input;
+}
+
+/// <summary>
+/// Moves, turns, and fires each player by their input for the tick, the same way on both
+/// players' windows. Direction keys resolve as ProcessInput does, and a held fire button shoots
+/// on press and then every 1 / fireRate seconds, counted in whole ticks by the player's cooldown
+/// </summary>
+/// <param name="dt">Length of the tick</param>
+void Game::ApplyNetInputs(float dt) {
+	if (State != GAME_ACTIVE) {
+		return;
+	}
+
+	Player* players[NET_PLAYER_COUNT];
+	int playerCount = GatherPlayers(players);
+
+	for (int i = 0; i < playerCount; i++) {
+		Player& shooter = *players[i];
+		uint16_t buttons = tickInputs[i].buttons;
+
+		shooter.horDrct = (buttons & NET_RIGHT) ? RIGHT : (buttons & NET_LEFT) ? LEFT : H_NONE;
+		shooter.vertDrct = (buttons & NET_DOWN) ? DOWN : (buttons & NET_UP) ? UP : V_NONE;
+		shooter.facing = NetAimFacing(tickInputs[i]);
+
+		shooter.fireCooldown -= dt;
+		if (buttons & NET_FIRE) {
+			if (shooter.fireCooldown <= 0.0f) {
+				CreateBullet(shooter);
+				shooter.fireCooldown += 1.0f / fireRate;
+			}
+		}
+		else if (shooter.fireCooldown < 0.0f) {
+			shooter.fireCooldown = 0.0f;
+		}
+
+		shooter.UpdatePosition(dt);
+	}
+}
+
+/// <summary>
+/// Sets the values of the variables used in updating the player's facing to the mouse's coordinates
 /// </summary>
 /// <param name="xPos">Mouse's x position in screen space</param>
 /// <param name="yPos">Mouse's y position in screen space</param>
@@ -628,29 +1762,67 @@ void Game::SetMousePos(float xPos, float yPos) {
 }
 
 /// <summary>
-/// Spawns bullets at the player's bullet spawn position; spawns different or more projectiles based
+/// Aims the next drawn player at a cursor position read just before drawing, so the aim on screen
+/// is fresher than the snapshot's. Only the drawn facing changes: the sim still aims from the
+/// queued cursor moves, so shots follow the inputs in order
+/// </summary>
+/// <param name="xPos">Mouse's x position in screen space</param>
+/// <param name="yPos">Mouse's y position in screen space</param>
+void Game::LateLatchAim(float xPos, float yPos) {
+	latchedAim = Player::AimFacing(xPos, yPos);
+	aimLatched = true;
+}
+
+/// <summary>
+/// Spawns bullets at a player's bullet spawn position; spawns different or more projectiles based
 /// on powerup states
 /// </summary>
-void Game::CreateBullet() {
+/// <param name="shooter">Player firing</param>
+/// <param name="delay">Seconds from the start of the tick to the shot</param>
+void Game::CreateBullet(Player& shooter, float delay) {
+	AllocScope spawnScope(ALLOC_SPAWN, ALLOC_HOT);
 
 	if (State == GAME_ACTIVE) {
-		player->UpdateBulletSpawnPosition();
+		shooter.UpdateBulletSpawnPosition();
 
 		// Add new bullets to end of vector
 		if (pState == P_BETTER_BULLETS) {
-			playerBullets.push_back(new Projectile(player->bulletSpawn, BETTER_PROJ_SIZE, (player->rotation + 45), glm::vec2(300, 300) * CalculateDirectionVector(player->pos, player->bulletSpawn), glm::vec3(0.99f, 0.76f, 0.0f), 20, false));
+			FirePlayerProjectile(shooter, shooter.bulletSpawn, BETTER_PROJ_SIZE, RotateDirection(shooter.facing, COS_45, SIN_45), glm::vec3(0.99f, 0.76f, 0.0f), 20, delay);
 		}
 		else {
-			playerBullets.push_back(new Projectile(player->bulletSpawn, PROJECTILE_SIZE, player->rotation, glm::vec2(300, 300) * CalculateDirectionVector(player->pos, player->bulletSpawn), glm::vec3(1.0f, 0.0f, 0.0f), 10, false));
+			FirePlayerProjectile(shooter, shooter.bulletSpawn, PROJECTILE_SIZE, shooter.facing, glm::vec3(1.0f, 0.0f, 0.0f), 10, delay);
 		}
 
 		if (pState == P_MULTI_SHOT) {
-			playerBullets.push_back(new Projectile(player->shiftedLeftSpawn, PROJECTILE_SIZE, (player->rotation + 30), glm::vec2(300, 300) * CalculateDirectionVector(player->pos, player->shiftedLeftSpawn), glm::vec3(1.0f, 0.0f, 0.0f), 10, false));
-			playerBullets.push_back(new Projectile(player->shiftedRightSpawn, PROJECTILE_SIZE, (player->rotation - 30), glm::vec2(300, 300) * CalculateDirectionVector(player->pos, player->shiftedRightSpawn), glm::vec3(1.0f, 0.0f, 0.0f), 10, false));
+			FirePlayerProjectile(shooter, shooter.shiftedLeftSpawn, PROJECTILE_SIZE, RotateDirection(shooter.facing, COS_30, SIN_30), glm::vec3(1.0f, 0.0f, 0.0f), 10, delay);
+			FirePlayerProjectile(shooter, shooter.shiftedRightSpawn, PROJECTILE_SIZE, RotateDirection(shooter.facing, COS_30, -SIN_30), glm::vec3(1.0f, 0.0f, 0.0f), 10, delay);
 		}
 	}
 }
 
+/// <summary>
+/// Creates a player projectile heading away from the player through its spawn point. Player bullets
+/// are moved by a whole tick later in Update, so one fired partway through the tick starts that far
+/// back along its path with that much more lifetime, and ends the tick where it would have been
+/// </summary>
+/// <param name="shooter">Player firing</param>
+/// <param name="spawn">Point the projectile leaves from</param>
+/// <param name="size">Size of the projectile</param>
+/// <param name="facing">Unit vector to draw the projectile facing</param>
+/// <param name="color">Color of the projectile</param>
+/// <param name="damage">Damage dealt on hit</param>
+/// <param name="delay">Seconds from the start of the tick to the shot</param>
+void Game::FirePlayerProjectile(const Player& shooter, glm::vec2 spawn, glm::vec2 size, glm::vec2 facing, glm::vec3 color, int damage, float delay) {
+	glm::vec2 velocity = glm::vec2(300, 300) * CalculateDirectionVector(shooter.pos, spawn);
+	Entity entity = CreateProjectile(entities, spawn - velocity * delay, size, facing, velocity, color, damage, false, true);
+
+	Archetype* archetype;
+	uint32_t row;
+	if (entities.Locate(entity, archetype, row)) {
+		archetype->lifeTime[row] += delay;
+	}
+}
+
 /// <summary>
 /// Calculates and returns the direction vector for player projectiles
 /// </summary>
@@ -664,121 +1836,168 @@ glm::vec2 Game::CalculateDirectionVector(glm::vec2 pos1, glm::vec2 pos2) {
 }
 
 /// <summary>
-/// Checks for and resolves collsions between the objects in the game; index is used as an
-/// iterator for identifying which element in object vectors should be erased
+/// Checks for and resolves collsions between the objects in the game. Bullets are checked along
+/// the paths they move over the coming tick, so a fast bullet cannot skip through a target at a low
+/// tick rate. Player bullets are tested on the job system by the collision detector, which changes
+/// nothing; its hits are then resolved here in order, bullet by bullet, each bullet's targets in
+/// the order it reached them, so the outcome is the same however the detection was split.
+/// Enemies, bullets, and powerups that are hit are marked with Destroy and skipped for the rest of
+/// the check, then removed together so no component array changes size while it is being walked
 /// </summary>
-void Game::CheckCollisions() {
-	int index = 0;
-	bool xCol;
-	bool yCol;
-
-	// Used for solving edge case where multiple bullets delete the same frame
-	int eraseCount = 0;
-
-	for (Projectile* bullet : playerBullets) {
-		float enemyIndex = 0;
-		for (Enemy* enemy : enemies) {
-			// Check if enemy and bullet overlap on both x- and y-axis
-			xCol = bullet->pos.x >= enemy->pos.x - enemy->size.x && bullet->pos.x <= enemy->pos.x + enemy->size.x;
-			yCol = bullet->pos.y >= enemy->pos.y - enemy->size.y && bullet->pos.y <= enemy->pos.y + enemy->size.y;
-
-			if (xCol && yCol) {
-				enemy->TakeDamage(bullet->damage);
-				playerBullets.erase(playerBullets.begin() + (index - eraseCount));
-				eraseCount += 1;
-
-				if (enemy->health <= 0) {
-					IncreaseScore(enemy->GetPointValue());
-					int randInt = rand() % 100 + 1;
-					if (randInt <= powerupSpawnChance) {
-						SpawnPowerup(enemy->pos);
-					}
-					enemies.erase(enemies.begin() + enemyIndex);
-					CheckWaveEnd();
-				}
+/// <param name="dt">Length of the tick the bullets move through after the check</param>
+void Game::CheckCollisions(float dt) {
+	AllocScope collisionScope(ALLOC_COLLISION, ALLOC_HOT);
+	bool enemyKilled = false;
+
+	// Enemy bullets do not move while time is frozen, so they are still targets
+	float targetDt = pState == P_TIME_STOP ? 0.0f : dt;
+	collisions.Detect(entities, dt, targetDt);
+
+	size_t next = 0;
+	while (next < collisions.HitCount()) {
+		uint32_t bullet = collisions.Hit(next).bullet;
+		const CollisionRef& bullets = collisions.Bullet(bullet);
+		int damage = bullets.archetype->damage[bullets.row];
+		bool enemyHit = false;
+		bool hit = false;
+		float impact = 0.0f;
+
+		for (; next < collisions.HitCount() && collisions.Hit(next).bullet == bullet; next++) {
+			uint32_t target = collisions.Hit(next).target;
+			Archetype& archetype = *collisions.Target(target).archetype;
+			uint32_t row = collisions.Target(target).row;
+
+			if (entities.IsDying(archetype, row)) {
+				continue;
+			}
 
-				// break used to prevent cases of 1 bullet hitting multiple enemies
-				break;
+			// Hits come in the order the bullet reached them; it stops at the first live one, still hitting anything it reached at the same moment
+			if (hit && collisions.Hit(next).time > impact) {
+				continue;
 			}
+			impact = collisions.Hit(next).time;
 
-			enemyIndex += 1;
-		}
+			if (collisions.IsEnemy(target)) {
+				// Only the first live enemy takes the hit, so 1 bullet cannot hit multiple enemies
+				if (enemyHit) {
+					continue;
+				}
 
-		// Player and Enemy bullets destroy each other
-		float bulletIndex = 0;
-		for (Projectile& eBullet : enemyBullets) {
-			//Check for overlaps
-			xCol = bullet->pos.x >= eBullet.pos.x - eBullet.size.x && bullet->pos.x <= eBullet.pos.x + eBullet.size.x;
-			yCol = bullet->pos.y >= eBullet.pos.y - eBullet.size.y && bullet->pos.y <= eBullet.pos.y + eBullet.size.y;
+				ApplyDamage(archetype, row, damage);
+				frozenVersion += 1;
+				enemyHit = true;
+				hit = true;
+
+				if (archetype.health[row] <= 0) {
+					IncreaseScore(archetype.pointValue[row]);
+					int randInt = random.Next() % 100 + 1;
+					if (randInt <= powerupSpawnChance) {
+						SpawnPowerup(archetype.pos[row]);
+					}
+					entities.Destroy(archetype.entities[row]);
+					enemyKilled = true;
+				}
+			}
+			// Player and Enemy bullets destroy each other
+			else {
+				frozenVersion += 1;
+				hit = true;
 
-			if (xCol && yCol) {
 				// Wave bullets take three hits to destroy
-				if (eBullet.isWave) {
-					eBullet.SetWaveHealth(eBullet.waveHealth - 10);
+				if (archetype.Has(C_HEALTH)) {
+					ApplyDamage(archetype, row, 10);
 
-					if (eBullet.waveHealth <= 0) {
-						enemyBullets.erase(enemyBullets.begin() + bulletIndex);
+					if (archetype.health[row] <= 0) {
+						entities.Destroy(archetype.entities[row]);
 					}
-					playerBullets.erase(playerBullets.begin() + (index - eraseCount));
-					eraseCount += 1;
 				}
 				else {
-					enemyBullets.erase(enemyBullets.begin() + bulletIndex);
-					playerBullets.erase(playerBullets.begin() + (index - eraseCount));
-					eraseCount += 1;
+					entities.Destroy(archetype.entities[row]);
 				}
 			}
-
-			bulletIndex += 1;
 		}
 
-		index += 1;
+		if (hit) {
+			entities.Destroy(bullets.archetype->entities[bullets.row]);
+		}
 	}
 
-	index = 0;
+	Player* players[NET_PLAYER_COUNT];
+	int playerCount = GatherPlayers(players);
 
-	// Collision between player and enemy projectiles
-	for (Projectile bullet : enemyBullets) {
-		xCol = bullet.pos.x >= player->pos.x - (player->size.x - 10.0f) && bullet.pos.x <= player->pos.x + (player->size.x - 10.0f);
-		yCol = bullet.pos.y >= player->pos.y - player->size.y && bullet.pos.y <= player->pos.y + player->size.y;
+	// Collision between players and enemy projectiles along their moves; a player's box is a little narrower than the ship
+	for (int i = 0; i < playerCount; i++) {
+		Player& target = *players[i];
+		Shape playerBox = { target.pos, glm::vec2(target.size.x - 10.0f, target.size.y), glm::vec2(0.0f, 1.0f) };
+		entities.ForEach(C_TRANSFORM | C_DAMAGE, C_PLAYER_TEAM, [&](Archetype& bullets) {
+			TestMovesInBox(bullets, playerBox, targetDt);
 
-		if (xCol && yCol) {
-			player->TakeDamage(bullet.pos, bullet.damage);
-			enemyBullets.erase(enemyBullets.begin() + index);
-		}
+			for (uint32_t b = 0; b < bullets.Size(); b++) {
+				if (!playerBatch.Hit(b) || entities.IsDying(bullets, b)) {
+					continue;
+				}
 
-		index += 1;
+				target.TakeDamage(bullets.pos[b], bullets.damage[b]);
+				entities.Destroy(bullets.entities[b]);
+				frozenVersion += 1;
+			}
+		});
 	}
 
-	index = 0;
+	entities.FlushDestroyed();
 
-	// Collision between player and powerups
-	for (Powerup* power : powerups) {
-		xCol = power->pos.x >= player->pos.x - (player->size.x - 10.0f) && power->pos.x <= player->pos.x + (player->size.x - 10.0f);
-		yCol = power->pos.y >= player->pos.y - player->size.y && power->pos.y <= player->pos.y + player->size.y;
+	if (enemyKilled) {
+		CheckWaveEnd();
+	}
 
-		if (xCol && yCol) {
-			if (power->pType == BETTER_BULLETS) {
-				pState = P_BETTER_BULLETS;
-				powerUpDisplay = "Better Bullets";
-			}
-			else if (power->pType == MULTI_SHOT) {
-				pState = P_MULTI_SHOT;
-				powerUpDisplay = "Multi Shot";
-			}
-			else if (power->pType == TIME_STOP) {
-				pState = P_TIME_STOP;
-				powerUpDisplay = "Time Stop";
-			}
-			else if (power->pType == HEALING) {
-				pState = P_HEALING;
-				player->AddHealth(20);
+	// Collision between players and powerups; the first player to reach one takes it
+	for (int i = 0; i < playerCount; i++) {
+		Player& target = *players[i];
+		Shape playerBox = { target.pos, glm::vec2(target.size.x - 10.0f, target.size.y), glm::vec2(0.0f, 1.0f) };
+		entities.ForEach(C_TRANSFORM | C_PICKUP, 0, [&](Archetype& powerups) {
+			TestMovesInBox(powerups, playerBox, 0.0f);
+
+			for (uint32_t p = 0; p < powerups.Size(); p++) {
+				if (playerBatch.Hit(p) && !entities.IsDying(powerups, p)) {
+					if (powerups.pickup[p] == BETTER_BULLETS) {
+						pState = P_BETTER_BULLETS;
+					}
+					else if (powerups.pickup[p] == MULTI_SHOT) {
+						pState = P_MULTI_SHOT;
+					}
+					else if (powerups.pickup[p] == TIME_STOP) {
+						pState = P_TIME_STOP;
+					}
+					else if (powerups.pickup[p] == HEALING) {
+						pState = P_HEALING;
+						target.AddHealth(20);
+					}
+					entities.Destroy(powerups.entities[p]);
+				}
 			}
-			powerups.erase(powerups.begin() + index);
-		}
+		});
+	}
+
+	entities.FlushDestroyed();
+}
 
-		index += 1;
+/// <summary>
+/// Tests the path every row of an archetype moves along over dt against one box in a single
+/// narrowphase batch, leaving the result for each row in playerBatch under the row's index;
+/// rows without a velocity are tested where they stand
+/// </summary>
+/// <param name="archetype">Archetype whose moves are tested</param>
+/// <param name="box">Axis aligned box to test them against</param>
+/// <param name="dt">Time the rows move for</param>
+void Game::TestMovesInBox(Archetype& archetype, const Shape& box, float dt) {
+	bool moving = archetype.Has(C_VELOCITY);
+
+	playerBatch.Reset(SHAPE_SEGMENT, SHAPE_AABB);
+	for (uint32_t row = 0; row < archetype.Size(); row++) {
+		glm::vec2 move = moving ? archetype.velocity[row] * dt : glm::vec2(0.0f);
+		playerBatch.Add({ archetype.pos[row], move, glm::vec2(0.0f, 1.0f) }, box);
 	}
+	playerBatch.Test();
 }
 
 /// <summary>
@@ -798,7 +2017,8 @@ void Game::IncreaseScore(int points) {
 /// </summary>
 /// <param name="pos">Position to spawn Powerup at</param>
 void Game::SpawnPowerup(glm::vec2 pos) {
-	powerups.push_back(new Powerup(pos, POWERUP_SIZE, 0.0f, glm::vec3(0.0f, 0.96f, 0.98f)));
+	AllocScope spawnScope(ALLOC_SPAWN, ALLOC_HOT);
+	CreatePowerup(entities, pos, random);
 }
 
 /// <summary>
@@ -843,18 +2063,19 @@ void Game::SpawnWave(float dt, vector<int>& wave) {
 /// </summary>
 /// <param name="enemyType">Value for switch case determining which enemy type to spawn</param>
 void Game::SpawnEnemy(int enemyType) {
+	AllocScope spawnScope(ALLOC_SPAWN, ALLOC_HOT);
 	int randomX, randomY;
 
 	// X-value is randomly generated first
-	randomX = rand() % ((int)player->pos.x + 500) + ((int)player->pos.x - 500);
+	randomX = random.Next() % ((int)player->pos.x + 500) + ((int)player->pos.x - 500);
 
 	// If the x-value is outside of the screen's width, the y-value is randomly generated
 	if (randomX < player->pos.x - 430 || randomX > player->pos.x + 430) {
-		randomY = rand() % ((int)player->pos.y + 450) + ((int)player->pos.y - 450);
+		randomY = random.Next() % ((int)player->pos.y + 450) + ((int)player->pos.y - 450);
 	}
 	// Otherwise, the y-value is set to a fixed value either above or below the screen
 	else {
-		int side = rand() % 2;
+		int side = random.Next() % 2;
 		
 		if (side == 0) {
 			randomY = player->pos.y + 450;
@@ -864,47 +2085,94 @@ void Game::SpawnEnemy(int enemyType) {
 		}
 	}
 	
+	// A new enemy appears in the frozen layer if time is stopped
+	frozenVersion += 1;
+
 	switch (enemyType) {
 		case 1:
-			enemies.push_back(new Enemy(glm::vec2(randomX, randomY), ENEMY_SIZE, 0.0f, N_ENEMY_COLOR, player));
+			CreateEnemy(entities, ENEMY_MELEE, glm::vec2(randomX, randomY));
 			break;
 		case 2:
-			enemies.push_back(new RangedEnemy(glm::vec2(randomX, randomY), ENEMY_SIZE, 0.0f, R_ENEMY_COLOR, player, enemyBullets));
+			CreateEnemy(entities, ENEMY_RANGED, glm::vec2(randomX, randomY));
 			break;
 		case 3:
-			enemies.push_back(new WaveEnemy(glm::vec2(randomX, randomY), WAVE_ENEMY_SIZE, 0.0f, W_ENEMY_COLOR, player, enemyBullets));
+			CreateEnemy(entities, ENEMY_WAVE, glm::vec2(randomX, randomY));
 			break;
 	}
 }
 
 /// <summary>
 /// Checks to see if a wave has been completed, and if so sets a delay for when the next wave starts
-/// spawning changes the background's active textures
+/// spawning and starts fading to the next background
 /// </summary>
 void Game::CheckWaveEnd() {
-	if (enemies.size() == 0) {
+	int endedWave = waveCount;
+
+	if (entities.Count(C_SEEK) == 0) {
 		if (waveCount == 0 && wave1.size() == 0) {
 			waveCount += 1;
 			waveCountDown = WAVE_START_DELAY;
+			StartBackgroundFade(1);
 		}
 		if (waveCount == 1 && wave2.size() == 0) {
 			waveCount += 1;
 			waveCountDown = WAVE_START_DELAY;
-			backgroundShader.Use();
-			backgroundShader.SetInt("texture", 1);
-			backgroundShader.SetInt("texture2", 2);
-			backgroundShift = 0.0f;
+			StartBackgroundFade(2);
 		}
 		if (waveCount == 2 && wave3.size() == 0) {
 			waveCount += 1;
 			waveCountDown = WAVE_START_DELAY;
-			backgroundShader.Use();
-			backgroundShader.SetInt("texture", 2);
-			backgroundShader.SetInt("texture2", 3);
-			backgroundShift = 0.0f;
+			StartBackgroundFade(3);
 		}
 		if (waveCount == 3 && wave4.size() == 0) {
 			waveCount += 1;
 		}
 	}
+
+	if (waveCount != endedWave) {
+		ResetWaveArena();
+	}
+}
+
+/// <summary>
+/// Counts the enemies of each kind in a wave and reserves that many rows in their archetypes, so
+/// the wave's enemy storage is taken from the arena once instead of growing as enemies spawn
+/// </summary>
+/// <param name="wave">Vector of enemy types and pauses, as read by SpawnWave</param>
+void Game::ReserveWave(const vector<int>& wave) {
+	size_t counts[ENEMY_KIND_COUNT] = {};
+	for (int element : wave) {
+		if (element > 0) {
+			counts[element - 1] += 1;
+		}
+	}
+
+	// Kinds with the same components share an archetype, so their counts are added together
+	for (int kind = 0; kind < ENEMY_KIND_COUNT; kind++) {
+		uint32_t components = EnemyComponents((EnemyKind)kind);
+		size_t total = 0;
+
+		for (int other = 0; other < ENEMY_KIND_COUNT; other++) {
+			if (EnemyComponents((EnemyKind)other) == components) {
+				total += counts[other];
+			}
+		}
+
+		entities.Reserve(components, total);
+	}
+}
+
+/// <summary>
+/// Drops the enemy archetypes' storage and rewinds the wave arena, which frees everything the
+/// ended wave allocated no matter how many enemies it spawned, then reserves room for the next
+/// wave; only called once every enemy is dead
+/// </summary>
+void Game::ResetWaveArena() {
+	AllocScope spawnScope(ALLOC_SPAWN, ALLOC_HOT);
+	entities.ReleaseStorage(C_SEEK);
+	waveArena.Reset();
+
+	if (waveCount < 4) {
+		ReserveWave(*waves[waveCount]);
+	}
 }
\ No newline at end of file
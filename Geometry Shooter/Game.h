@@ -7,6 +7,9 @@
 //*****************************************************************************
 #pragma once
 
+#include <atomic>
+#include <functional>
+#include <thread>
 #include <vector>
 
 #include <glad/glad.h>
@@ -16,12 +19,28 @@
 #include "stb_image.h"
 #include "Shader.h"
 #include "Player.h"
-#include "Enemy.h"
-#include "RangedEnemy.h"
-#include "WaveEnemy.h"
-#include "Projectile.h"
-#include "Powerup.h"
+#include "Entities.h"
+#include "Systems.h"
+#include "EntityRenderer.h"
+#include "CollisionDetector.h"
 #include "TextRenderer.h"
+#include "PostProcess.h"
+#include "BackgroundLayers.h"
+#include "AssetLoader.h"
+#include "SimRandom.h"
+#include "RollbackSession.h"
+#include "../Common/JobSystem.h"
+#include "../Common/AssetBundle.h"
+#include "../Common/StreamBuffer.h"
+#include "../Common/GpuResources.h"
+#include "../Common/Arena.h"
+#include "../Common/FrameAllocator.h"
+#include "../Common/AllocTracker.h"
+#include "../Common/SpscQueue.h"
+#include "../Common/FramePacer.h"
+#include "../Common/TripleBuffer.h"
+#include "../Common/SnapshotRing.h"
+#include "../Common/StateStream.h"
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
@@ -35,6 +54,31 @@ enum GameState {
 	GAME_LOSS
 };
 
+// Kinds of input recorded by the GLFW callbacks
+enum InputEventType {
+	INPUT_KEY,
+	INPUT_MOUSE_BUTTON,
+	INPUT_CURSOR
+};
+
+// One input as delivered by GLFW, stamped with glfwGetTime so it can be applied inside the sim tick it belongs to
+struct InputEvent {
+	double time;
+	InputEventType type;
+	// Key or mouse button and its GLFW action; unused for cursor moves
+	int code, action;
+	// Cursor position in screen space; unused for keys and buttons
+	float x, y;
+};
+
+// Snapshot actions asked for by the debug keys, carried out by the sim between ticks
+enum StateRequest {
+	STATE_NONE,
+	STATE_REWIND,
+	STATE_SAVE_SESSION,
+	STATE_RESUME_SESSION
+};
+
 // Powerup states the player can have
 enum PowerupState {
 	P_BETTER_BULLETS,
@@ -47,13 +91,115 @@ enum PowerupState {
 const glm::vec2 PLAYER_SIZE(30.0f, 30.0f);
 const glm::vec2 PROJECTILE_SIZE(5.0f, 5.0f);
 const glm::vec2 BETTER_PROJ_SIZE(7.0f, 7.0f);
-const glm::vec2 ENEMY_SIZE(25.0f, 25.0f);
-const glm::vec2 WAVE_ENEMY_SIZE(50.0f, 25.0f);
-const glm::vec2 POWERUP_SIZE(15.0f, 15.0f);
 
-const glm::vec3 N_ENEMY_COLOR(0.0f, 0.0f, 1.0f);
-const glm::vec3 R_ENEMY_COLOR(0.98f, 0.96f, 0.18f);
-const glm::vec3 W_ENEMY_COLOR(1.0f, 0.43f, 0.0f);
+// Cosine and sine of the turn better bullets are drawn with relative to the aim
+const float COS_45 = 0.707106781187f;
+const float SIN_45 = 0.707106781187f;
+
+// Texture units for the background array and the time stop layer
+const unsigned int BACKGROUND_TEXTURE_UNIT = 0;
+const unsigned int GRAYSCALE_TEXTURE_UNIT = 5;
+
+// Bundle written by Tools/AssetPacker from assets.manifest; loose files are used when it is missing
+const char* const ASSET_BUNDLE_FILE = "assets.bundle";
+
+// Length of one simulation step; the sim always advances by whole ticks no matter the frame rate
+const double SIM_TICK = 1.0 / 120.0;
+
+// Ticks run per frame at most; after a longer stall the sim skips ahead instead of catching up
+const int MAX_SIM_STEPS = 8;
+
+// Player shots per second while the fire button is held
+const float FIRE_RATE = 6.0f;
+
+// Inputs that can wait between ticks; a power of two for SpscQueue
+const size_t INPUT_QUEUE_CAPACITY = 1024;
+
+// Per-frame heap allocation counters written at exit, in the Chrome trace event format
+const char* const ALLOC_TRACE_FILE = "alloc_trace.json";
+
+// Program binaries from earlier runs, so warm starts do not compile shaders
+const char* const SHADER_CACHE_FILE = "shaders.cache";
+
+// Bytes of decoded assets copied to the GPU per frame, so loading never stalls a frame for long
+const size_t ASSET_UPLOAD_BYTES_PER_FRAME = 4 * 1024 * 1024;
+
+// Estimated GPU memory the game may hold before GpuResources prints over-budget warnings
+const size_t GPU_MEMORY_BUDGET = 256 * 1024 * 1024;
+
+// Size of each block of the arena that enemies are allocated from; one block holds any of the waves
+const size_t WAVE_ARENA_BYTES = 64 * 1024;
+
+// Size of each block of the per-frame scratch memory used for UI strings and other short-lived data
+const size_t FRAME_SCRATCH_BYTES = 256 * 1024;
+
+// Bytes of each frame region in the stream buffer used for text and other dynamic vertices
+const size_t STREAM_BYTES_PER_FRAME = 1024 * 1024;
+
+// The time stop layer covers this many screens in each direction, centered on the view when baked
+const unsigned int FROZEN_LAYER_SCALE = 3;
+
+// Largest side of the time stop layer in texels; past it the layer is baked at less than the framebuffer's resolution
+const float FROZEN_LAYER_MAX_SIZE = 4096.0f;
+
+// Ticks between the state snapshots kept for rewinding; four a second at SIM_TICK
+const unsigned long long SNAPSHOT_INTERVAL_TICKS = 30;
+
+// Snapshots from one keyframe to the next, which bounds the deltas a restore has to replay
+const int SNAPSHOT_KEYFRAME_INTERVAL = 8;
+
+// Memory for the encoded snapshots and the most snapshots kept, a little over four minutes of play
+const size_t SNAPSHOT_RING_BYTES = 8 * 1024 * 1024;
+const size_t SNAPSHOT_RING_MAX = 1024;
+
+// How far back F10 rewinds the sim
+const unsigned long long REWIND_TICKS = 120;
+
+// State written by F11 and resumed by F12
+const char* const SESSION_FILE = "session.state";
+
+// Tags the start of a state image, and the layout it was written with; bump the version when SaveState changes
+const uint32_t STATE_MAGIC = 0x54535347;
+const uint32_t STATE_VERSION = 3;
+
+/* Everything the render thread needs from one sim tick, copied out so the sim can move on while
+*  the frame is drawn. Entities are reduced to transforms and colors, one list per render layer;
+*  the lists are reused between snapshots, so publishing does not allocate once they have grown.
+*/
+struct RenderSnapshot {
+	unsigned long long tick;
+	GameState state;
+	PowerupState pState;
+	glm::vec2 playerPos;
+	glm::vec2 playerFacing;
+	glm::vec3 playerColor;
+	// HUD values
+	int playerHealth, score, comboNumber, waveCount;
+	// Background image being faded to, how far the fade has gone, and a count of restored states,
+	// which jump to their background without a fade
+	int backgroundImage;
+	float backgroundShift;
+	unsigned long long restoreCount;
+	// Changes whenever anything baked into the frozen layer changes
+	unsigned long long frozenVersion;
+	RenderList pickups, enemies, playerBullets, enemyBullets;
+	// Debug overlay values
+	int entityCount, archetypeCount;
+	ArenaStats waveArena;
+	// Time the sim spent on the ticks behind this snapshot
+	double simMs;
+	CollisionStats collisions;
+	// Rewind ring, and the time the last capture and restore took including writing and reading the state
+	SnapshotRingStats stateRing;
+	double captureMs, restoreMs;
+	// Co-op: the other player, drawn alongside the one this window controls, whether play is
+	// waiting for them to join, and whether the session ended on a state it could not roll back to
+	bool coop, partnerActive, netWaiting, netFailed;
+	glm::vec2 partnerPos;
+	glm::vec2 partnerFacing;
+	glm::vec3 partnerColor;
+	RollbackStats rollback;
+};
 
 const float POWER_UP_TIME = 10.0f;
 const float SPAWN_PAUSE = 5.0f;
@@ -64,15 +210,56 @@ public:
 	bool Keys[1024];
 	int score, comboNumber, powerupSpawnChance, waveCount;
 	unsigned int Width, Height;
-	unsigned int backgroundVBO, backgroundVAO, healingVBO, healingVAO, timestopVBO, timestopVAO, fbo;
-	unsigned int backgroundTex, background2, background3, background4, grayscaleTex, healingTex;
+	GpuBuffer backgroundVBO, timestopVBO;
+	GpuVertexArray backgroundVAO, timestopVAO;
+	GpuFramebuffer frozenLayerFBO;
+	GpuTexture frozenLayerTex, healingTex;
+	bool frozenLayerValid, debugOverlay;
 	float mouseX, mouseY;
+	// Shots per second while the fire button is held
+	float fireRate;
+	// Time the sim has reached, on the glfwGetTime clock; each Update advances it by one tick
+	double simTime;
 	float scoreMultiplier, powerUpTimer, waveCountDown, spawnPauseTimer, backgroundShift;
-	string powerUpDisplay;
+	// Background the sim is fading to, and a count bumped whenever the frozen layer's contents change
+	int backgroundImage;
+	unsigned long long frozenVersion;
+	glm::vec2 frozenLayerOrigin;
 	glm::mat4 view;
 	GameState State;
 	PowerupState pState;
-	Shader backgroundShader, grayScaleShader, healingShader;
+	Shader backgroundShader, grayScaleShader;
+	// Enemy storage lives only as long as a wave, so it comes from an arena reset when the wave ends;
+	// the arena is declared first so it outlives the archetypes that allocate from it
+	MonotonicArena waveArena;
+	// Charges what the enemy archetypes take from the wave arena to the spawn tag
+	TrackedResource waveResource;
+	// Scratch memory for data built and thrown away within a frame, rewound at the top of each frame
+	FrameAllocator frameMemory;
+	// Filled by the GLFW callbacks and drained by Update on the sim thread; only events before the end of a tick are applied in it
+	SpscQueue<InputEvent, INPUT_QUEUE_CAPACITY> inputQueue;
+	// Published by the sim thread after each batch of ticks and drawn by the render thread
+	TripleBuffer<RenderSnapshot> snapshots;
+	// Enemies, projectiles, and powerups
+	EntityWorld entities;
+	// Every random roll the sim makes, so snapshots can save where the sequence is
+	SimRandom random;
+	EntityRenderer entityRenderer;
+	// Finds player bullet hits on the jobs; CheckCollisions resolves them
+	CollisionDetector collisions;
+	// Enemy bullets, powerups, and enemies tested against the player, one archetype at a time
+	NarrowphaseBatch playerBatch;
+	BackgroundLayers backgrounds;
+	PostProcess postProcess;
+	StreamBuffer frameStream;
+	// Swap interval, frame limiting, and queued frame limit for the main loop
+	FramePacer pacer;
+	// The bundle, loader, and jobs are declared last so they are destroyed first, in reverse: the
+	// workers are joined before the loader they fill or the bundle they read goes away, and before
+	// any other member is destroyed
+	AssetBundle bundle;
+	AssetLoader loader;
+	JobSystem jobs;
 
 	Game(unsigned int width, unsigned int height);
 	~Game();
@@ -80,45 +267,182 @@ public:
 	// Initialzes objects and shaders needed at game start
 	void Init();
 
+	// Makes this a co-op game played as the given player over the loopback port; call before Init
+	bool EnableCoop(int localIndex, const NetConditions& conditions);
+
+	// Deletes every object and GL resource the game owns; called before the context is destroyed
+	void Shutdown();
+
 	// Handles keyboard inputs from the player
 	void ProcessInput();
 
-	// Calls object updates and handles the game loop
+	// Calls object updates and handles the game loop; runs on the sim thread
 	void Update(float dt);
 
-	// Main render loop, handles calls for objects to be drawn
+	// Starts the sim thread, which runs Update on fixed ticks and publishes snapshots
+	void StartSim();
+
+	// Stops and joins the sim thread
+	void StopSim();
+
+	// Main render loop, draws the latest snapshot
 	void Render();
 
+	// Resizes the render targets to match a new framebuffer size
+	void Resize(unsigned int fbWidth, unsigned int fbHeight);
+
+	// Records an input from a GLFW callback to be applied by the tick it falls in
+	void QueueInput(const InputEvent& event);
+
 	// Updates variables that store mouse position
 	void SetMousePos(float xPos, float yPos);
 
-	// Spawns a player projectile
-	void CreateBullet();
+	// Turns the drawn player toward the latest cursor position in the next Render
+	void LateLatchAim(float xPos, float yPos);
+
+	// Spawns a player's projectiles as if fired delay seconds into the current tick
+	void CreateBullet(Player& shooter, float delay = 0.0f);
+
+	// Writes everything the sim changes from tick to tick into a state image
+	void SaveState(StateWriter& writer);
+
+	// Replaces the sim's state with an image written by SaveState; returns false, with the reader
+	// failed, if the image is from another layout or damaged
+	bool LoadState(StateReader& reader);
 
 private:
+	bool fireHeld;
+	// Time the next automatic shot is due while the fire button is held
+	double nextFireTime;
+
+	std::thread simThread;
+	std::atomic<bool> simRunning;
+	// Set by the render thread once every asset is uploaded and every shader built, so the sim can leave loading
+	std::atomic<bool> assetsReady;
+	unsigned long long simTick;
+
+	// Snapshots of the last few minutes of play, the image being written or restored, and the
+	// state kept while restoring in case the image turns out to be damaged
+	SnapshotRing stateRing;
+	StateWriter stateWriter, restoreBackup;
+	std::vector<uint8_t> restoreImage;
+	double captureMs, restoreMs;
+	unsigned long long restoreCount;
+	// Set by the debug keys in ApplyInput and carried out once the tick ends
+	StateRequest stateRequest;
+
+	// Co-op only: exchanges inputs with the other player, whether play has started on both, whether
+	// a rollback failed and stopped the session, and each player's input for the tick being run
+	RollbackSession rollback;
+	bool coopStarted, coopFailed;
+	NetInput tickInputs[NET_PLAYER_COUNT];
+
+	// Render thread state: the background shown, the frozen layer contents baked, and the aim latched for this frame
+	int shownBackground;
+	float shownShift;
+	unsigned long long shownRestoreCount;
+	bool fadeEnded;
+	unsigned long long bakedFrozenVersion;
+	bool aimLatched;
+	glm::vec2 latchedAim;
+
+	// Runs ticks as they come due and publishes a snapshot after each batch until StopSim
+	void SimLoop();
+
+	// Writes the current state into the rewind ring
+	void CaptureState();
+
+	// Puts the sim back to a state image, keeping the input currently held; returns false and
+	// leaves the state as it was if the image cannot be read
+	bool RestoreState(const std::vector<uint8_t>& image);
+
+	// Carries out the snapshot action the debug keys asked for, if any
+	void RunStateRequest();
+
+	// Runs one co-op tick slot: exchanges inputs, rolls back and runs ticks again if a prediction
+	// was wrong, and runs the next tick unless this player has to wait for the other
+	void RunCoopTick();
+
+	// Saves the state, gathers both players' inputs, and runs one co-op tick
+	void AdvanceCoopTick();
+
+	// Takes queued inputs before tickEnd into Keys, the cursor, and the fire button, without touching the sim
+	void DrainCoopInput(double tickEnd);
+
+	// This player's input for the tick, from the keys, fire button, and cursor held now
+	NetInput SampleLocalInput() const;
+
+	// Moves, turns, and fires each player by their input for the tick
+	void ApplyNetInputs(float dt);
+
+	// Copies the state of the current tick into the back snapshot and publishes it
+	void PublishSnapshot(double simMs);
+
+	// Applies the snapshot's background fade to the background layers and shader
+	void SyncBackground(const RenderSnapshot& snapshot);
+
+	// Applies queued inputs that fall before tickEnd in order, moving the player and firing held shots between them
+	void RunInput(double tickStart, double tickEnd);
+
+	// Applies one input at the given time within the tick
+	void ApplyInput(const InputEvent& event, double time, double tickStart);
+
+	// Moves the player from one time to another within the tick, firing any held shots that fall between
+	void AdvancePlayer(double from, double to, double tickStart);
+
+	// Creates one player projectile moved back along its path by delay, so this tick's movement puts it where a shot fired at delay would be
+	void FirePlayerProjectile(const Player& shooter, glm::vec2 spawn, glm::vec2 size, glm::vec2 facing, glm::vec3 color, int damage, float delay);
+
 	// Initializes shader and textures for the background
 	void InitializeBackground();
 
-	// Initializes shader, vertex objects, and texture for the healing vignette
+	// Queues the healing vignette texture and sets up the post-processing chain that applies it
 	void InitializeHealingVignette();
 
-	// Initializes shader, texture, vertex objects, and framebuffer for the time stop filter
+	// Initializes shader, vertex objects, and framebuffer for the time stop filter
 	void InitializeTimeStopFilter();
 
-	// Loads textures from image files into unsigned ints
-	void LoadTexture(string imageFile, unsigned int& texture);
+	// Creates the frozen layer texture at the current framebuffer size and attaches it to its framebuffer
+	void CreateFrozenLayer();
+
+	// Returns the size of the frozen layer texture: FROZEN_LAYER_SCALE framebuffers, capped at FROZEN_LAYER_MAX_SIZE
+	glm::ivec2 FrozenLayerSize() const;
+
+	// Renders the frozen background, enemies, and enemy bullets around the camera into the cached layer
+	void BakeFrozenLayer(glm::vec2 cameraCorner, const RenderSnapshot& snapshot);
+
+	// Returns whether the cached frozen layer contains the whole view at the given camera corner
+	bool FrozenLayerCovers(glm::vec2 cameraCorner);
+
+	// Queues an image file to be loaded into a texture, calling onLoaded once it is on the GPU
+	void LoadTexture(string imageFile, GpuTexture& texture, unsigned int unit, std::function<void()> onLoaded = nullptr);
 
 	// Draws text UI to the screen
-	void DrawUI();
+	void DrawUI(const RenderSnapshot& snapshot);
+
+	// Draws GL state, streaming, GPU memory, and entity counters over the game
+	void DrawDebugOverlay(const RenderSnapshot& snapshot);
 
 	// Draws the background on the screen
 	void DrawBackground();
 
-	// Gradually switches between two background images
+	// Advances the sim's background fade
 	void ChangeBackground(float dt);
 
-	// Checks for and resolves collsions between game objects
-	void CheckCollisions();
+	// Starts the sim's fade to the given background image
+	void StartBackgroundFade(int image);
+
+	// Points the background layers and shader at a new fade; render thread only
+	void FadeToBackground(int image);
+
+	// Points the background layers and shader at one image with no fade; render thread only
+	void ShowBackground(int image);
+
+	// Checks for and resolves collsions between game objects over the tick to come
+	void CheckCollisions(float dt);
+
+	// Tests every move of an archetype over dt against a box, leaving the hits in playerBatch
+	void TestMovesInBox(Archetype& archetype, const Shape& box, float dt);
 
 	// Calculates and returns the direction vector between two points
 	glm::vec2 CalculateDirectionVector(glm::vec2 pos1, glm::vec2 pos2);
@@ -137,5 +461,11 @@ private:
 
 	// Checks to see if a wave has been completed
 	void CheckWaveEnd();
+
+	// Reserves room in the wave arena for every enemy a wave will spawn
+	void ReserveWave(const vector<int>& wave);
+
+	// Frees the storage of the wave that just ended in one step and reserves the next wave's
+	void ResetWaveArena();
 };
 
@@ -8,11 +8,13 @@
 //					  objects
 //*****************************************************************************
 #include "GameObject.h"
+#include "../Common/AffineKernel.h"
+#include "../Common/GLState.h"
 
 /// <summary>
 /// Default constructor for GameObjects
 /// </summary>
-GameObject::GameObject() : pos(0.0f, 0.0f), size(10.0f, 10.0f), rotation(0.0f), color(1.0f, 1.0f, 1.0f), model(glm::mat4(1.0f)), projection(glm::mat4(1.0f)) {
+GameObject::GameObject() : pos(0.0f, 0.0f), size(10.0f, 10.0f), facing(0.0f, 1.0f), color(1.0f, 1.0f, 1.0f), model(glm::mat4(1.0f)), projection(glm::mat4(1.0f)) {
 }
 
 /// <summary>
@@ -20,35 +22,38 @@ GameObject::GameObject() : pos(0.0f, 0.0f), size(10.0f, 10.0f), rotation(0.0f),
 /// </summary>
 /// <param name="pos">Position where the object should be spawned in world space</param>
 /// <param name="size">Scalar values for drawing the object</param>
-/// <param name="rotation">Angle of rotation the object should be drawn at</param>
+/// <param name="facing">Unit vector the object should be drawn facing</param>
 /// <param name="color">Color that the GameObject should be</param>
-GameObject::GameObject(glm::vec2 pos, glm::vec2 size, float rotation, glm::vec3 color) : pos(pos), size(size), rotation(rotation), color(color), model(glm::mat4(1.0f)) {
+GameObject::GameObject(glm::vec2 pos, glm::vec2 size, glm::vec2 facing, glm::vec3 color) : pos(pos), size(size), facing(facing), color(color), model(glm::mat4(1.0f)) {
 }
 
 /// <summary>
 /// Takes a vector of vertices and uses them in intializing the vertex buffer and array
-/// objects, then sets initial values for the object's model and projection matrices
+/// objects, resolves the uniform handles used when drawing, then sets initial values for
+/// the object's model and projection matrices
 /// </summary>
 /// <param name="vertices">Set of vertices to be used </param>
 void GameObject::InitializeVertexObjects(vector<float> vertices) {
-	glGenVertexArrays(1, &this->VAO);
-	glGenBuffers(1, &this->VBO);
+	this->VAO = GpuVertexArray("GameObject VAO");
+	this->VBO = GpuBuffer("GameObject vertices");
 
-	glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
+	GLState::BindArrayBuffer(this->VBO);
 	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), &vertices.front(), GL_STATIC_DRAW);
+	this->VBO.SetBytes(vertices.size() * sizeof(float));
 
-	glBindVertexArray(this->VAO);
+	GLState::BindVertexArray(this->VAO);
 	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
 	glEnableVertexAttribArray(0);
 
-	this->objectShader.Use();
-	this->model = glm::translate(this->model, glm::vec3(this->pos, 0.0f));
-	this->model = glm::rotate(this->model, glm::radians(this->rotation), glm::vec3(0.0f, 0.0f, 1.0f));
-	this->model = glm::scale(this->model, glm::vec3(this->size, 1.0f));
-	this->objectShader.SetMat4("model", this->model);
+	this->modelUniform = this->objectShader.Uniform<glm::mat4>("model");
+	this->viewUniform = this->objectShader.Uniform<glm::mat4>("view");
+	this->colorUniform = this->objectShader.Uniform<glm::vec3>("Color");
+
+	this->model = FacingMatrix(this->pos, this->facing, this->size);
+	this->modelUniform.Set(this->model);
 
 	glm::mat4 projection = glm::ortho(0.0f, 800.0f, 600.0f, 0.0f, -1.0f, 1.0f);
 	this->objectShader.SetMat4("projection", projection);
 
-	this->objectShader.SetVec3("Color", this->color);
+	this->colorUniform.Set(this->color);
 }
\ No newline at end of file
@@ -13,19 +13,24 @@
 #include <glm/glm.hpp>
 
 #include "Shader.h"
+#include "../Common/GpuResources.h"
 
+// Owns its vertex buffer and array, so objects can be moved but not copied
 class GameObject {
 public:
-	unsigned int VBO, VAO;
-	float rotation;
-	glm::vec2 pos, size;
+	GpuBuffer VBO;
+	GpuVertexArray VAO;
+	// Unit vector the object's front points along; (0, 1) is unturned
+	glm::vec2 pos, size, facing;
 	glm::vec3 color;
 	glm::mat4 model, projection;
 	vector<float> vertices;
 	Shader objectShader;
+	UniformHandle<glm::mat4> modelUniform, viewUniform;
+	UniformHandle<glm::vec3> colorUniform;
 
 	GameObject();
-	GameObject(glm::vec2 pos, glm::vec2 size, float rotation, glm::vec3 color);
+	GameObject(glm::vec2 pos, glm::vec2 size, glm::vec2 facing, glm::vec3 color);
 
 protected:
 	// Handles binding vertices to the object's vertex buffer and array objects
@@ -0,0 +1,87 @@
+//*****************************************************************************
+// GlyphAtlas.cpp
+//
+// Author: Kyle Manning
+//
+// Brief Description: Rasterizes a font with FreeType and packs its glyphs
+//					  into one single channel atlas; has no GL calls, so it
+//					  runs on worker threads and in the asset packer
+//*****************************************************************************
+#include "GlyphAtlas.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+/// <summary>
+/// Renders the first 128 characters of a font with FreeType and packs them into rows of a single
+/// channel atlas, one texel apart so linear filtering never bleeds between glyphs
+/// </summary>
+/// <param name="file">Font file to rasterize</param>
+/// <param name="size">Font size in pixels</param>
+/// <returns>Atlas pixels, GLYPH_ATLAS_WIDTH texels wide, with the metrics and atlas coordinates of
+/// each character; no pixels if the font could not be loaded</returns>
+GlyphAtlas RasterizeGlyphAtlas(const std::string& file, int size) {
+	GlyphAtlas atlas = { GLYPH_ATLAS_WIDTH, 0, {}, {} };
+	std::map<char, Character>& glyphs = atlas.glyphs;
+
+	// Each call has its own FreeType library, so fonts can be rasterized on several workers at once
+	FT_Library ft;
+	FT_Face face;
+	if (FT_Init_FreeType(&ft)) {
+		std::cout << "ERROR::FREETYPE::INIT_FAILED" << std::endl;
+		return atlas;
+	}
+	if (FT_New_Face(ft, file.c_str(), 0, &face)) {
+		std::cout << "ERROR::FREETYPE::FAILED_TO_LOAD_FONT " << file << std::endl;
+		FT_Done_FreeType(ft);
+		return atlas;
+	}
+	FT_Set_Pixel_Sizes(face, 0, size);
+
+	// Bitmaps are kept until the atlas height is known
+	std::vector<std::vector<unsigned char>> bitmaps(GLYPH_COUNT);
+	std::vector<glm::ivec2> origins(GLYPH_COUNT);
+	int penX = 1, penY = 1, rowHeight = 0;
+
+	for (unsigned char c = 0; c < GLYPH_COUNT; c++) {
+		FT_Load_Char(face, c, FT_LOAD_RENDER);
+		FT_Bitmap& bitmap = face->glyph->bitmap;
+
+		if (penX + (int)bitmap.width + 1 > GLYPH_ATLAS_WIDTH) {
+			penX = 1;
+			penY += rowHeight + 1;
+			rowHeight = 0;
+		}
+
+		origins[c] = glm::ivec2(penX, penY);
+		bitmaps[c].assign(bitmap.buffer, bitmap.buffer + bitmap.width * bitmap.rows);
+
+		Character character = { glm::vec4(0.0f), glm::ivec2(bitmap.width, bitmap.rows), glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top), (unsigned int)face->glyph->advance.x };
+		glyphs.insert(std::pair<char, Character>(c, character));
+
+		penX += bitmap.width + 1;
+		rowHeight = std::max(rowHeight, (int)bitmap.rows);
+	}
+	FT_Done_Face(face);
+	FT_Done_FreeType(ft);
+
+	atlas.height = penY + rowHeight + 1;
+	atlas.pixels.assign((size_t)atlas.width * atlas.height, 0);
+
+	for (unsigned char c = 0; c < GLYPH_COUNT; c++) {
+		Character& ch = glyphs[c];
+
+		for (int row = 0; row < ch.Size.y; row++) {
+			memcpy(&atlas.pixels[(size_t)(origins[c].y + row) * atlas.width + origins[c].x], &bitmaps[c][(size_t)row * ch.Size.x], ch.Size.x);
+		}
+
+		ch.UV = glm::vec4(origins[c].x, origins[c].y, origins[c].x + ch.Size.x, origins[c].y + ch.Size.y) /
+			glm::vec4(atlas.width, atlas.height, atlas.width, atlas.height);
+	}
+
+	return atlas;
+}
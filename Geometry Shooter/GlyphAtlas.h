@@ -0,0 +1,40 @@
+//*****************************************************************************
+// GlyphAtlas.h
+//
+// Author: Kyle Manning
+//
+// Brief Description: Header for glyph atlas rasterization, shared by the
+//					  TextRenderer and the asset packer
+//*****************************************************************************
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Width of glyph atlases in texels; the height grows to fit the font
+const int GLYPH_ATLAS_WIDTH = 1024;
+
+// Characters rasterized into each atlas, starting from 0
+const int GLYPH_COUNT = 128;
+
+struct Character {
+	// Texture coordinates of the glyph's corners in the atlas: left, top, right, bottom
+	glm::vec4 UV;
+	glm::ivec2 Size;
+	glm::ivec2 Bearing;
+	unsigned int Advance;
+};
+
+// Single channel atlas pixels and the metrics of every glyph in it
+struct GlyphAtlas {
+	int width, height;
+	std::vector<unsigned char> pixels;
+	std::map<char, Character> glyphs;
+};
+
+// Rasterizes the first GLYPH_COUNT characters of a font into one atlas
+GlyphAtlas RasterizeGlyphAtlas(const std::string& file, int size);
+
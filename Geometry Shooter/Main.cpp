@@ -4,25 +4,81 @@
 //	Initializes GLFW and creates a window and OpenGL context; runs input
 //	callbacks and primary game methods
 //*****************************************************************************
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <thread>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
 #include "Game.h"
+#include "../Common/GLState.h"
+#include "../Common/GpuResources.h"
+#include "../Common/AllocTracker.h"
+#include "../Common/AffineKernel.h"
+#include "../Common/FastMath.h"
 
 void FramebufferCallback(GLFWwindow* window, int width, int height);
 void MouseCallback(GLFWwindow* window, double xPos, double yPos);
 void MouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
 void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mode);
+void StartBenchmark(void (*run)());
+void RunCollisionBenchmark();
+void RunSweepCheck();
 
 const unsigned int SCREEN_WIDTH = 800;
 const unsigned int SCREEN_HEIGHT = 600;
 
+// Transforms built per run of the F7 transform benchmark
+const size_t TRANSFORM_BENCHMARK_COUNT = 4096;
+
+// Inputs checked and timed per function by the F7 fast math checks
+const size_t FAST_MATH_CHECK_COUNT = 1 << 16;
+
+// Player bullets in the scene the F8 collision benchmark detects over
+const size_t COLLISION_BENCHMARK_BULLETS = 16384;
+
+// Player bullets fired through the F9 swept collision check
+const size_t SWEEP_CHECK_BULLETS = 4096;
+
 Game Shooter(SCREEN_WIDTH, SCREEN_HEIGHT);
 
-int main() {
-	srand((unsigned int)time(0));
+// The F8 and F9 collision runs take long enough to freeze rendering, so they run here instead, one at a time
+std::thread benchmarkThread;
+std::atomic<bool> benchmarkRunning(false);
+
+/* Co-op on one machine: run one copy with "--coop 0" and another with "--coop 1". Each can
+*  simulate a worse link on what it sends with "--latency ms", "--jitter ms", and "--loss percent",
+*  e.g. "--coop 1 --latency 40 --jitter 10 --loss 2".
+*
+*  "--stats" prints how long assets took to load at startup, and the frame pacing, GL state
+*  cache, shader, wave arena, and heap totals at exit; the F3 overlay shows the same live.
+*/
+int main(int argc, char* argv[]) {
+	// Seeds the sim's generator; snapshots carry its state from here on
+	Shooter.random.Seed((uint64_t)time(0));
+
+	int coopPlayer = -1;
+	NetConditions conditions = {};
+	bool printStats = false;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--stats") == 0)
+			printStats = true;
+		else if (i + 1 < argc && strcmp(argv[i], "--coop") == 0)
+			coopPlayer = atoi(argv[++i]);
+		else if (i + 1 < argc && strcmp(argv[i], "--latency") == 0)
+			conditions.latencyMs = (float)atof(argv[++i]);
+		else if (i + 1 < argc && strcmp(argv[i], "--jitter") == 0)
+			conditions.jitterMs = (float)atof(argv[++i]);
+		else if (i + 1 < argc && strcmp(argv[i], "--loss") == 0)
+			conditions.lossPercent = (float)atof(argv[++i]);
+		else
+			std::cout << "ERROR::MAIN::UNKNOWN_OPTION: " << argv[i] << std::endl;
+	}
+
+	bool coop = coopPlayer >= 0 && Shooter.EnableCoop(coopPlayer, conditions);
 
 	// Initializing GLFW window and context
 	glfwInit();
@@ -31,7 +87,8 @@ int main() {
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 	glfwWindowHint(GLFW_RESIZABLE, false);
 
-	GLFWwindow* window = glfwCreateWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Geometry Shooter", nullptr, nullptr);
+	// Co-op windows are named after their player so the two can be told apart
+	GLFWwindow* window = glfwCreateWindow(SCREEN_WIDTH, SCREEN_HEIGHT, !coop ? "Geometry Shooter" : coopPlayer == 0 ? "Geometry Shooter - Player 1" : "Geometry Shooter - Player 2", nullptr, nullptr);
 	glfwMakeContextCurrent(window);
 
 	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
@@ -49,24 +106,42 @@ int main() {
 	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
 
 	glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
-	glEnable(GL_BLEND);
+	GLState::SetBlend(true);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
 	Shooter.Init();
 
-	float deltaTime = 0.0f;
-	float prevFrame = 0.0f;
+	// The framebuffer can be larger than the window on high DPI displays
+	int fbWidth, fbHeight;
+	glfwGetFramebufferSize(window, &fbWidth, &fbHeight);
+	Shooter.Resize(fbWidth, fbHeight);
+
+	// Vsync with at most one frame queued on the GPU; F5 cycles the pacing mode and F6 toggles low latency
+	Shooter.pacer.SetMode(PACING_VSYNC);
+	Shooter.pacer.SetLowLatency(true);
+
+	bool startupReported = false;
+
+	// From here the sim runs on its own thread; this one polls input and draws its snapshots
+	Shooter.simTime = glfwGetTime();
+	Shooter.StartSim();
 
 	// Loops execution of main gameplay functions
 	while (!glfwWindowShouldClose(window)) {
-		float currentFrame = (float)glfwGetTime();
-		deltaTime = currentFrame - prevFrame;
-		prevFrame = currentFrame;
-	
+		// All waiting for the limiter and the GPU happens before input is polled
+		Shooter.pacer.BeginFrame();
+		AllocTracker::BeginFrame();
+		Shooter.frameMemory.BeginFrame();
+
 		glfwPollEvents();
 
-		Shooter.ProcessInput();
-		Shooter.Update(deltaTime);
+		// Late latch: the aim drawn this frame uses the cursor as of now rather than the snapshot's tick
+		if (Shooter.pacer.LowLatency()) {
+			double cursorX, cursorY;
+			glfwGetCursorPos(window, &cursorX, &cursorY);
+			Shooter.LateLatchAim((float)cursorX, (float)cursorY);
+		}
+		Shooter.pacer.MarkInputSampled();
 
 		glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT);
@@ -74,8 +149,52 @@ int main() {
 		Shooter.Render();
 
 		glfwSwapBuffers(window);
+		Shooter.pacer.EndFrame();
+
+		// Startup benchmark: time from glfwInit until every asset is on the GPU
+		if (printStats && !startupReported && Shooter.loader.Done()) {
+			startupReported = true;
+			std::cout << "Assets resident after " << glfwGetTime() * 1000.0 << " ms, loaded from ";
+			if (Shooter.bundle.IsOpen())
+				std::cout << ASSET_BUNDLE_FILE << " (" << Shooter.bundle.MappedBytes() << " bytes mapped)" << std::endl;
+			else
+				std::cout << "loose files" << std::endl;
+		}
+	}
+
+	Shooter.StopSim();
+
+	if (benchmarkThread.joinable()) {
+		benchmarkThread.join();
 	}
 
+	Shader::SaveProgramCache();
+
+	if (printStats) {
+		FramePacingStats pacingStats = Shooter.pacer.GetStats();
+		std::cout << "Frame pacing: " << pacingStats.frameMs << " ms mean, " << pacingStats.frameStdDevMs << " ms std dev, ~" << pacingStats.inputLatencyMs << " ms input latency" << std::endl;
+
+		GLStateStats glStats = GLState::GetStats();
+		std::cout << "GL state cache: " << glStats.issued << " calls issued, " << glStats.skipped << " skipped" << std::endl;
+
+		ShaderBuildStats shaderStats = Shader::GetBuildStats();
+		std::cout << "Shader programs: " << shaderStats.compiled << " compiled, " << shaderStats.fromSpirv << " from SPIR-V, " << shaderStats.fromBinary << " from cached binaries" << std::endl;
+
+		ArenaStats arenaStats = Shooter.waveArena.GetStats();
+		std::cout << "Wave arena: high water " << arenaStats.highWater << " of " << arenaStats.capacity << " bytes in " << arenaStats.blocks << " blocks, " << arenaStats.resets << " resets" << std::endl;
+
+		AllocFrameStats allocStats = AllocTracker::Totals();
+		std::cout << "Heap: " << allocStats.total.calls << " allocations (" << allocStats.total.bytes << " bytes) over " << allocStats.frame << " frames, " << allocStats.hotAllocations << " in hot scopes" << std::endl;
+		for (int tag = 0; tag < ALLOC_TAG_COUNT; tag++) {
+			std::cout << "  " << AllocTracker::TagName((AllocTag)tag) << ": " << allocStats.tags[tag].calls << " allocations, " << allocStats.tags[tag].bytes << " bytes" << std::endl;
+		}
+	}
+	AllocTracker::WriteTrace(ALLOC_TRACE_FILE);
+
+	// GL objects have to be released while the context still exists
+	Shooter.Shutdown();
+	GpuResources::Shutdown();
+
 	glfwTerminate();
 	return 0;
 }
@@ -85,26 +204,121 @@ void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mode
 	if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) {
 		glfwSetWindowShouldClose(window, true);
 	}
+
+	if (key == GLFW_KEY_F3 && action == GLFW_PRESS) {
+		Shooter.debugOverlay = !Shooter.debugOverlay;
+	}
+
+	if (key == GLFW_KEY_F5 && action == GLFW_PRESS) {
+		Shooter.pacer.SetMode((PacingMode)((Shooter.pacer.Mode() + 1) % PACING_MODE_COUNT));
+		std::cout << "Frame pacing " << FramePacer::ModeName(Shooter.pacer.Mode()) << std::endl;
+	}
+
+	if (key == GLFW_KEY_F6 && action == GLFW_PRESS) {
+		Shooter.pacer.SetLowLatency(!Shooter.pacer.LowLatency());
+		std::cout << "Low latency mode " << (Shooter.pacer.LowLatency() ? "on" : "off") << std::endl;
+	}
+
+	// Steady state mode traps any heap allocation in a hot loop; turn it on once a wave is underway
+	if (key == GLFW_KEY_F4 && action == GLFW_PRESS) {
+		AllocTracker::SetSteadyState(!AllocTracker::SteadyState());
+		std::cout << "Allocation steady state mode " << (AllocTracker::SteadyState() ? "on" : "off") << std::endl;
+	}
 	
-	if (key >= 0 && key < 1024) {
-		if (action == GLFW_PRESS)
-			Shooter.Keys[key] = true;
-		else if (action == GLFW_RELEASE)
-			Shooter.Keys[key] = false;
-	} 
+	// Microbenchmarks of the sprite transform kernel against building each model matrix with glm::mat4,
+	// and of the fast trig functions against libm, with their accuracy checks
+	if (key == GLFW_KEY_F7 && action == GLFW_PRESS) {
+		AffineBenchmark bench = BenchmarkAffineKernel(TRANSFORM_BENCHMARK_COUNT);
+		std::cout << "Transforms: " << bench.mat4Ns << " ns each with glm::mat4, " << bench.kernelNs << " ns with the kernel ("
+			<< bench.mat4Ns / bench.kernelNs << "x)" << std::endl;
+
+		FastMathReport report = RunFastMathChecks(FAST_MATH_CHECK_COUNT);
+		std::cout << "Fast math " << (report.passed ? "passed" : "FAILED") << ": sincos error " << report.sinCosMaxError
+			<< ", atan2 error " << report.atan2MaxError << std::endl;
+		std::cout << "sincos: " << report.libmSinCosNs << " ns each with libm, " << report.fastSinCosNs << " ns fast; atan2: "
+			<< report.libmAtan2Ns << " ns with libm, " << report.fastAtan2Ns << " ns fast" << std::endl;
+	}
+
+	// Collision benchmark and swept collision check; each prints its results when it finishes
+	if (key == GLFW_KEY_F8 && action == GLFW_PRESS) {
+		StartBenchmark(RunCollisionBenchmark);
+	}
+
+	if (key == GLFW_KEY_F9 && action == GLFW_PRESS) {
+		StartBenchmark(RunSweepCheck);
+	}
+
+	// Keys reach the game through the input queue, applied by the tick they fall in
+	if (action != GLFW_REPEAT) {
+		Shooter.QueueInput({ glfwGetTime(), INPUT_KEY, key, action, 0.0f, 0.0f });
+	}
 }
 
 void FramebufferCallback(GLFWwindow* window, int width, int height)
 {
 	glViewport(0, 0, width, height);
+	Shooter.Resize(width, height);
 }
 
 void MouseCallback(GLFWwindow* window, double xPos, double yPos) {
-	Shooter.SetMousePos((float)xPos, (float)yPos);
+	Shooter.QueueInput({ glfwGetTime(), INPUT_CURSOR, 0, 0, (float)xPos, (float)yPos });
 }
 
 void MouseButtonCallback(GLFWwindow* window, int button, int action, int mods) {
-	if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) {
-		Shooter.CreateBullet();
+	Shooter.QueueInput({ glfwGetTime(), INPUT_MOUSE_BUTTON, button, action, 0.0f, 0.0f });
+}
+
+/// <summary>
+/// Runs a collision benchmark on the benchmark thread, so the window keeps drawing and the sim
+/// keeps ticking while it runs; a key pressed while one is still running is ignored
+/// </summary>
+/// <param name="run">Benchmark to run; prints its own results</param>
+void StartBenchmark(void (*run)()) {
+	if (benchmarkRunning.load(std::memory_order_acquire)) {
+		std::cout << "ERROR::MAIN::BENCHMARK_ALREADY_RUNNING" << std::endl;
+		return;
 	}
-}
\ No newline at end of file
+
+	// The last run has finished, so this only reclaims its thread
+	if (benchmarkThread.joinable()) {
+		benchmarkThread.join();
+	}
+
+	benchmarkRunning.store(true, std::memory_order_release);
+	benchmarkThread = std::thread([run]() {
+		run();
+		benchmarkRunning.store(false, std::memory_order_release);
+	});
+}
+
+/// <summary>
+/// Times collision detection on the job system split into 1 to 8 parts, and checks every split
+/// finds the same hits. It runs on a pool of its own, since holding the game's pool would stall
+/// the sim's collision checks until it ends
+/// </summary>
+void RunCollisionBenchmark() {
+	JobSystem benchmarkJobs;
+	benchmarkJobs.Init();
+	CollisionBenchmark bench = BenchmarkCollisions(benchmarkJobs, COLLISION_BENCHMARK_BULLETS);
+	std::cout << "Collisions: " << bench.bullets << " bullets x " << bench.targets << " targets, " << bench.hits << " hits, "
+		<< bench.threads << " threads, narrowphase " << NarrowphaseWidth() << " wide, " << (bench.identical ? "identical" : "DIFFERENT") << " hits in every split" << std::endl;
+	for (int split = 0; split < COLLISION_BENCHMARK_SPLITS; split++) {
+		std::cout << "  " << (1 << split) << " parts: " << bench.ms[split] << " ms (" << bench.ms[0] / bench.ms[split] << "x), tests "
+			<< bench.testMs[split] << " ms (" << bench.testMs[0] / bench.testMs[split] << "x)" << std::endl;
+	}
+}
+
+/// <summary>
+/// Fires the same bullets through the same targets at a slow and a fast tick rate and checks they
+/// hit the same things. Positions are stepped in floats at each rate, so a bullet that only grazes
+/// a target, or reaches two at nearly the same moment, can land on either side of the edge; a few
+/// such bullets differing is expected as the scene grows
+/// </summary>
+void RunSweepCheck() {
+	JobSystem checkJobs;
+	checkJobs.Init();
+	CollisionSweepCheck check = CheckSweptTickRates(checkJobs, SWEEP_CHECK_BULLETS);
+	std::cout << "Swept collisions: " << check.bullets << " bullets x " << check.targets << " targets, " << check.hits[0] << " hits at "
+		<< check.rates[0] << " Hz, " << check.hits[1] << " at " << check.rates[1] << " Hz, " << check.mismatched << " bullets differ"
+		<< " (grazing contacts may differ between rates); " << check.pointHits << " hits at " << check.rates[0] << " Hz without sweeping" << std::endl;
+}
@@ -9,15 +9,18 @@
 //					  taking damage
 //*****************************************************************************
 #include "Player.h"
+#include "../Common/AffineKernel.h"
+#include "../Common/FastMath.h"
+#include "../Common/GLState.h"
 
 /// <summary>
 /// Constructor for Player objects
 /// </summary>
 /// <param name="pos">Postion of Player</param>
 /// <param name="size">Scalar value for drawing the Player</param>
-/// <param name="rotation">Angle of rotation to draw Player at</param>
+/// <param name="facing">Unit vector to draw the Player facing</param>
 /// <param name="color">Color to draw Player as</param>
-Player::Player(glm::vec2 pos, glm::vec2 size, float rotation, glm::vec3 color) : GameObject(pos, size, rotation, color), speed(150.0f), vertDrct(V_NONE), horDrct(H_NONE), knockedBack(false), knockBackVel(glm::vec2(0.0f, 0.0f)), kbTimer(0.1f), health(100), damageColor(glm::vec3(0.41f, 0.39f, 0.23f)) {
+Player::Player(glm::vec2 pos, glm::vec2 size, glm::vec2 facing, glm::vec3 color) : GameObject(pos, size, facing, color), knockedBack(false), health(100), speed(150.0f), kbTimer(0.1f), fireCooldown(0.0f), knockBackVel(glm::vec2(0.0f, 0.0f)), damageColor(glm::vec3(0.41f, 0.39f, 0.23f)), vertDrct(V_NONE), horDrct(H_NONE) {
 	this->objectShader = Shader("player.vs", "player.fs");
 
 	this->vertices = {
@@ -60,70 +63,64 @@ void Player::UpdatePosition(float dt) {
 		else {
 			knockedBack = false;
 			kbTimer = 0.1f;
-			this->objectShader.Use();
-			this->objectShader.SetVec3("Color", this->color);
 		}
 	}
 }
 
 /// <summary>
-/// Sets the Player's model and view matrices and draws it to the screen
+/// Sets the Player's model, view, and color and draws it to the screen. The transform and color
+/// are passed in from the render snapshot, since the sim thread keeps moving the Player itself
 /// </summary>
 /// <param name="view">View matrix used when drawing</param>
-void Player::DrawPlayer(glm::mat4 view) {
-	this->model = glm::mat4(1.0f);
-	this->model = glm::translate(this->model, glm::vec3(this->pos, 0.0f));
-	
-	this->model = glm::rotate(this->model, glm::radians(this->rotation), glm::vec3(0.0f, 0.0f, 1.0f));
-
-	this->model = glm::scale(this->model, glm::vec3(this->size, 1.0f));
+/// <param name="pos">Position to draw the Player at</param>
+/// <param name="facing">Unit vector to draw the Player facing</param>
+/// <param name="color">Color to draw the Player as</param>
+void Player::DrawPlayer(glm::mat4 view, glm::vec2 pos, glm::vec2 facing, glm::vec3 color) {
+	this->model = FacingMatrix(pos, facing, this->size);
 
 	this->objectShader.Use();
-	this->objectShader.SetMat4("model", this->model);
-	this->objectShader.SetMat4("view", view);
+	this->modelUniform.Set(this->model);
+	this->viewUniform.Set(view);
+	this->colorUniform.Set(color);
 
-	glBindVertexArray(this->VAO);
+	GLState::BindVertexArray(this->VAO);
 	glDrawArrays(GL_TRIANGLES, 0, 6);
 }
 
 /// <summary>
-/// Updates the Player's rotation based on the positon of the mouse
+/// Updates the Player's facing based on the positon of the mouse
 /// </summary>
 /// <param name="mouseX">Mouse's x in screen space</param>
 /// <param name="mouseY">Mouse's y in screen space</param>
-void Player::UpdateRotation(float mouseX, float mouseY) {
-	this->rotation = (atan2((double)(mouseY - 300), (double)(mouseX - 400))) * (180 / 3.1415);
+void Player::UpdateFacing(float mouseX, float mouseY) {
+	this->facing = AimFacing(mouseX, mouseY);
+}
 
-	if (this->rotation < 0) {
-		this->rotation = 360 + rotation;
-	}
+glm::vec3 Player::DrawColor() const {
+	return knockedBack ? damageColor : color;
+}
 
-	// Aligns rotation so the front of the Player points towards the mouse
-	this->rotation -= 90;
+/// <summary>
+/// Finds the direction from the center of the screen, where the Player is always drawn, to the
+/// mouse. A mouse right on the center aims along +x, which is where the old angle math landed
+/// </summary>
+/// <param name="mouseX">Mouse's x in screen space</param>
+/// <param name="mouseY">Mouse's y in screen space</param>
+/// <returns>Unit vector with the front of the Player facing the mouse</returns>
+glm::vec2 Player::AimFacing(float mouseX, float mouseY) {
+	return DirectionTo(glm::vec2(mouseX - 400.0f, mouseY - 300.0f), glm::vec2(1.0f, 0.0f));
 }
 
 /// <summary>
-/// Updates the position of the Player's bullet spawn points
+/// Updates the position of the Player's bullet spawn points, 30 units in front of the Player along
+/// its aim and along the aim turned 30 degrees each way for multi-shot
 /// </summary>
 void Player::UpdateBulletSpawnPosition() {
-	glm::mat4 aimMatrix = glm::mat4(1.0f);
-	aimMatrix = glm::translate(aimMatrix, glm::vec3(pos, 0.0f));
-
-	aimMatrix = glm::rotate(aimMatrix, glm::radians(rotation), glm::vec3(0.0f, 0.0f, 1.0f));
-	aimMatrix = glm::translate(aimMatrix, glm::vec3(0.0f, 30.0f, 0.0f));
-	bulletSpawn = glm::vec2(aimMatrix[3][0], aimMatrix[3][1]);
-
-	// shiftedMatrix and otherShift are the left and right spawn positions used for multi-shot
-	glm::mat4 shiftedMatrix = glm::mat4(1.0f);
-	shiftedMatrix = glm::translate(shiftedMatrix, glm::vec3(pos, 0.0f));
-	glm::mat4 otherShift = shiftedMatrix;
-	shiftedMatrix = glm::rotate(shiftedMatrix, glm::radians(rotation - 30), glm::vec3(0.0f, 0.0f, 1.0f));
-	shiftedMatrix = glm::translate(shiftedMatrix, glm::vec3(0.0f, 30.0f, 0.0f));
-	this->shiftedLeftSpawn = glm::vec2(shiftedMatrix[3][0], shiftedMatrix[3][1]);
-
-	otherShift = glm::rotate(otherShift, glm::radians(rotation + 30), glm::vec3(0.0f, 0.0f, 1.0f));
-	otherShift = glm::translate(otherShift, glm::vec3(0.0f, 30.0f, 0.0f));
-	this->shiftedRightSpawn = glm::vec2(otherShift[3][0], otherShift[3][1]);
+	const float muzzle = 30.0f;
+
+	bulletSpawn = pos + facing * muzzle;
+	this->shiftedLeftSpawn = pos + RotateDirection(facing, COS_30, -SIN_30) * muzzle;
+	this->shiftedRightSpawn = pos + RotateDirection(facing, COS_30, SIN_30) * muzzle;
 }
 
 /// <summary>
@@ -139,11 +136,8 @@ void Player::TakeDamage(glm::vec2 damageSource, int damage) {
 	float length = sqrt(pow(direction.x, 2) + pow(direction.y, 2));
 	knockBackVel = glm::vec2(direction.x / length, direction.y / length) * glm::vec2(350.0f, 350.0f);
 
+	// Drawn in the damage color for feedback while the knockback lasts
 	knockedBack = true;
-
-	// Changes Player color for feedback on receiving damage
-	this->objectShader.Use();
-	this->objectShader.SetVec3("Color", damageColor);
 }
 
 /// <summary>
@@ -152,4 +146,45 @@ void Player::TakeDamage(glm::vec2 damageSource, int damage) {
 /// <param name="heal">Amount added to the Player's health</param>
 void Player::AddHealth(int heal) {
 	this->health += heal;
-}
\ No newline at end of file
+}
+
+/// <summary>
+/// Writes the Player's position, facing, color, health, movement, and knockback. The size is left out: it is
+/// fixed when the Player is made, and DrawPlayer reads it on the render thread while the sim thread loads
+/// </summary>
+/// <param name="writer">Stream to write to</param>
+void Player::Save(StateWriter& writer) const {
+	writer.Write(pos);
+	writer.Write(facing);
+	writer.Write(color);
+	writer.Write(knockedBack);
+	writer.Write(health);
+	writer.Write(speed);
+	writer.Write(kbTimer);
+	writer.Write(fireCooldown);
+	writer.Write(knockBackVel);
+	writer.Write(damageColor);
+	writer.Write(vertDrct);
+	writer.Write(horDrct);
+}
+
+/// <summary>
+/// Reads back what Save wrote; the projectile spawn points are worked out again from the transform
+/// </summary>
+/// <param name="reader">Stream to read from</param>
+void Player::Load(StateReader& reader) {
+	reader.Read(pos);
+	reader.Read(facing);
+	reader.Read(color);
+	reader.Read(knockedBack);
+	reader.Read(health);
+	reader.Read(speed);
+	reader.Read(kbTimer);
+	reader.Read(fireCooldown);
+	reader.Read(knockBackVel);
+	reader.Read(damageColor);
+	reader.Read(vertDrct);
+	reader.Read(horDrct);
+
+	UpdateBulletSpawnPosition();
+}
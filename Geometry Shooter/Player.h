@@ -8,9 +8,12 @@
 #pragma once
 
 #include "GameObject.h"
+#include "../Common/StateStream.h"
 #include <GLFW/glfw3.h>
 
-#include "Enemy.h"
+// Cosine and sine of the turn between the Player's aim and the outer multi-shot bullets
+const float COS_30 = 0.866025403784f;
+const float SIN_30 = 0.5f;
 
 // What direction of vertical movement the Player has
 enum VerticalDirection {
@@ -31,19 +34,27 @@ public:
 	bool knockedBack;
 	int health;
 	float speed, kbTimer;
+	// Seconds until the next held shot in co-op, where each player fires on their own tick inputs
+	float fireCooldown;
 	glm::vec2 bulletSpawn, knockBackVel, shiftedLeftSpawn, shiftedRightSpawn;
 	glm::vec3 damageColor;
 	VerticalDirection vertDrct;
 	HorizontalDirection horDrct;
 
-	Player(glm::vec2 pos, glm::vec2 size, float rotation, glm::vec3 color);
+	Player(glm::vec2 pos, glm::vec2 size, glm::vec2 facing, glm::vec3 color);
 
-	// Draws the Player on screen
-	void DrawPlayer(glm::mat4 view);
+	// Draws the Player on screen with a transform and color taken from a render snapshot
+	void DrawPlayer(glm::mat4 view, glm::vec2 pos, glm::vec2 facing, glm::vec3 color);
 
-	// Updates the position and rotation of the Player
+	// Color the Player is drawn with; the damage color while knocked back
+	glm::vec3 DrawColor() const;
+
+	// Facing that points the Player at the mouse
+	static glm::vec2 AimFacing(float mouseX, float mouseY);
+
+	// Updates the position and facing of the Player
 	void UpdatePosition(float dt);
-	void UpdateRotation(float mouseX, float mouseY);
+	void UpdateFacing(float mouseX, float mouseY);
 
 	// Updates the postion of the Player's projectile spawn points
 	void UpdateBulletSpawnPosition();
@@ -53,5 +64,9 @@ public:
 
 	// Adds health to the Player
 	void AddHealth(int heal);
+
+	// Writes and reads back the values the sim changes; GL objects and the drawing state are left alone
+	void Save(StateWriter& writer) const;
+	void Load(StateReader& reader);
 };
 
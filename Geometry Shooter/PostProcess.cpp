@@ -0,0 +1,240 @@
+//*****************************************************************************
+// PostProcess.cpp
+//
+// Author: Kyle Manning
+//
+// Brief Description: Contains methods for PostProcess objects, which own the
+//					  framebuffer-sized scene targets and fuse grayscale, the
+//					  healing vignette, and color grading into one full-screen
+//					  pass chosen from a small set of shader permutations
+//*****************************************************************************
+#include "PostProcess.h"
+#include "../Common/GLState.h"
+
+/// <summary>
+/// Default constructor for PostProcess objects; no GL objects exist until Init is called
+/// </summary>
+PostProcess::PostProcess() : width(0), height(0), vignetteTex(0), current(0), effects(POST_NONE), gradeGain(1.0f), gradeLift(0.0f), compiled() {
+}
+
+/// <summary>
+/// Creates the render targets at the framebuffer size and the empty vertex array the
+/// full-screen pass draws with. The permutations the caller will use are built here, so loading
+/// waits on them with every other shader instead of compiling one in the middle of play
+/// </summary>
+/// <param name="width">Width of the framebuffer in pixels</param>
+/// <param name="height">Height of the framebuffer in pixels</param>
+/// <param name="usedEffects">Each combination of PostEffect flags the caller will enable</param>
+void PostProcess::Init(unsigned int width, unsigned int height, std::initializer_list<int> usedEffects) {
+	this->width = width;
+	this->height = height;
+
+	// The full-screen triangle is generated from gl_VertexID, but core profile still needs a VAO bound
+	passVAO = GpuVertexArray("post pass VAO");
+
+	CreateTargets();
+
+	for (int used : usedEffects) {
+		if (used != POST_NONE) {
+			GetPermutation(used);
+		}
+	}
+}
+
+/// <summary>
+/// Recreates the render targets when the framebuffer size changes; the old textures,
+/// framebuffers, and depth buffer are deleted first so nothing leaks
+/// </summary>
+/// <param name="width">New width of the framebuffer in pixels</param>
+/// <param name="height">New height of the framebuffer in pixels</param>
+void PostProcess::Resize(unsigned int width, unsigned int height) {
+	if (width == this->width && height == this->height) {
+		return;
+	}
+
+	this->width = width;
+	this->height = height;
+
+	DeleteTargets();
+	CreateTargets();
+}
+
+/// <summary>
+/// Sets the vignette texture; it arrives from the asset loader after the chain is created
+/// </summary>
+/// <param name="texture">Texture blended over the scene by POST_HEALING_VIGNETTE</param>
+void PostProcess::SetVignetteTexture(unsigned int texture) {
+	vignetteTex = texture;
+}
+
+/// <summary>
+/// Sets which effects are applied to the next frame
+/// </summary>
+/// <param name="effects">PostEffect flags or'd together</param>
+void PostProcess::SetEffects(int effects) {
+	this->effects = effects;
+}
+
+/// <summary>
+/// Sets the color grade applied as color * gain + lift
+/// </summary>
+/// <param name="gain">Per-channel multiplier</param>
+/// <param name="lift">Per-channel offset</param>
+void PostProcess::SetColorGrade(glm::vec3 gain, glm::vec3 lift) {
+	gradeGain = gain;
+	gradeLift = lift;
+}
+
+/// <summary>
+/// Binds and clears this frame's scene target; with no effects enabled the scene goes
+/// straight to the backbuffer and no extra pass is made
+/// </summary>
+void PostProcess::BeginScene() {
+	glViewport(0, 0, width, height);
+
+	if (effects == POST_NONE) {
+		GLState::BindFramebuffer(0);
+		return;
+	}
+
+	// Alternates targets so this frame never renders into the texture the last frame's pass sampled
+	current = 1 - current;
+
+	GLState::BindFramebuffer(targetFBOs[current]);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+/// <summary>
+/// Draws the scene target to the backbuffer through the permutation for the enabled effects
+/// </summary>
+void PostProcess::EndScene() {
+	if (effects == POST_NONE) {
+		return;
+	}
+
+	GLState::BindFramebuffer(0);
+
+	Shader& pass = GetPermutation(effects);
+	pass.Use();
+
+	if (effects & POST_COLOR_GRADE) {
+		pass.SetVec3("gradeGain", gradeGain);
+		pass.SetVec3("gradeLift", gradeLift);
+	}
+
+	GLState::BindTexture(POST_SCENE_TEXTURE_UNIT, GL_TEXTURE_2D, targetTextures[current]);
+	if (effects & POST_HEALING_VIGNETTE) {
+		GLState::BindTexture(POST_VIGNETTE_TEXTURE_UNIT, GL_TEXTURE_2D, vignetteTex);
+	}
+
+	// The pass replaces every pixel, so blending would only cost bandwidth
+	GLState::SetBlend(false);
+	GLState::BindVertexArray(passVAO);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	GLState::SetBlend(true);
+}
+
+/// <summary>
+/// Returns the framebuffer the scene is drawn into this frame
+/// </summary>
+/// <returns>ID of the scene framebuffer, 0 for the backbuffer</returns>
+unsigned int PostProcess::SceneTarget() const {
+	return effects == POST_NONE ? 0 : targetFBOs[current];
+}
+
+unsigned int PostProcess::Width() const {
+	return width;
+}
+
+unsigned int PostProcess::Height() const {
+	return height;
+}
+
+/// <summary>
+/// Creates two color targets that share one depth buffer, since only one of them is
+/// rendered into at a time
+/// </summary>
+void PostProcess::CreateTargets() {
+	depthRBO = GpuRenderbuffer("post depth");
+	glBindRenderbuffer(GL_RENDERBUFFER, depthRBO);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+	depthRBO.SetBytes(GpuResources::TextureBytes(width, height, 1, 4, 1));
+
+	for (int i = 0; i < 2; i++) {
+		targetFBOs[i] = GpuFramebuffer("post target");
+		targetTextures[i] = GpuTexture("post target color");
+
+		GLState::BindTexture(POST_SCENE_TEXTURE_UNIT, GL_TEXTURE_2D, targetTextures[i]);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		targetTextures[i].SetBytes(GpuResources::TextureBytes(width, height, 1, 4, 1));
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+		GLState::BindFramebuffer(targetFBOs[i]);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, targetTextures[i], 0);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthRBO);
+
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+			cout << "ERROR::POST_PROCESS::FRAMEBUFFER_INCOMPLETE" << endl;
+		}
+	}
+
+	GLState::BindFramebuffer(0);
+}
+
+/// <summary>
+/// Deletes the color targets and depth buffer; GpuResources clears them from the GLState cache
+/// </summary>
+void PostProcess::DeleteTargets() {
+	for (int i = 0; i < 2; i++) {
+		targetFBOs[i].Reset();
+		targetTextures[i].Reset();
+	}
+
+	depthRBO.Reset();
+}
+
+/// <summary>
+/// Deletes every GL object the chain owns; Init must be called again before it is used
+/// </summary>
+void PostProcess::Release() {
+	DeleteTargets();
+	passVAO.Reset();
+
+	for (int i = 0; i < POST_PERMUTATION_COUNT; i++) {
+		permutations[i] = Shader();
+		compiled[i] = false;
+	}
+}
+
+/// <summary>
+/// Returns the pass shader for a combination of effects; each one is compiled the first
+/// time it is used and kept for the rest of the program
+/// </summary>
+/// <param name="effects">PostEffect flags or'd together</param>
+/// <returns>Shader with one #define per enabled effect</returns>
+Shader& PostProcess::GetPermutation(int effects) {
+	if (!compiled[effects]) {
+		string defines;
+		if (effects & POST_GRAYSCALE) {
+			defines += "#define GRAYSCALE\n";
+		}
+		if (effects & POST_HEALING_VIGNETTE) {
+			defines += "#define HEALING_VIGNETTE\n";
+		}
+		if (effects & POST_COLOR_GRADE) {
+			defines += "#define COLOR_GRADE\n";
+		}
+
+		permutations[effects] = Shader("post.vs", "post.fs", defines);
+		permutations[effects].SetInt("scene", POST_SCENE_TEXTURE_UNIT);
+		if (effects & POST_HEALING_VIGNETTE) {
+			permutations[effects].SetInt("vignette", POST_VIGNETTE_TEXTURE_UNIT);
+		}
+		compiled[effects] = true;
+	}
+
+	return permutations[effects];
+}
@@ -0,0 +1,93 @@
+//*****************************************************************************
+// PostProcess.h
+//
+// Author: Kyle Manning
+//
+// Brief Description: Header for PostProcess objects
+//*****************************************************************************
+#pragma once
+
+#include <initializer_list>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+#include "../Common/GpuResources.h"
+
+// Full-screen effects that can be enabled together; each combination is one shader permutation
+enum PostEffect {
+	POST_NONE = 0,
+	POST_GRAYSCALE = 1,
+	POST_HEALING_VIGNETTE = 2,
+	POST_COLOR_GRADE = 4
+};
+
+const int POST_PERMUTATION_COUNT = 8;
+
+// Texture units sampled by the post pass, kept apart from the background, effect, and text units
+const unsigned int POST_SCENE_TEXTURE_UNIT = 7;
+const unsigned int POST_VIGNETTE_TEXTURE_UNIT = 8;
+
+/* Renders the scene into an offscreen target the size of the framebuffer and applies every enabled
+*  effect in a single full-screen pass. The pass shader is built from post.fs with one #define per
+*  effect, so only the permutations that are actually used get compiled. The ones named to Init
+*  are built with the other shaders during loading; any other is built the first time it is used.
+*/
+class PostProcess {
+public:
+	PostProcess();
+
+	// Creates the render targets and the vertex array for the full-screen pass, and starts building
+	// the permutation for each combination of PostEffect flags in usedEffects
+	void Init(unsigned int width, unsigned int height, std::initializer_list<int> usedEffects);
+
+	// Sets the texture blended over the scene by POST_HEALING_VIGNETTE
+	void SetVignetteTexture(unsigned int texture);
+
+	// Recreates the render targets at a new framebuffer size, deleting the old ones
+	void Resize(unsigned int width, unsigned int height);
+
+	// Sets the PostEffect flags applied to the next frame
+	void SetEffects(int effects);
+
+	// Sets the per-channel multiplier and offset used by POST_COLOR_GRADE
+	void SetColorGrade(glm::vec3 gain, glm::vec3 lift);
+
+	// Binds the framebuffer the scene should be drawn into this frame
+	void BeginScene();
+
+	// Applies the enabled effects to the backbuffer; UI drawn afterwards is left untouched
+	void EndScene();
+
+	// Returns the framebuffer the scene is being drawn into, 0 when no effects are enabled
+	unsigned int SceneTarget() const;
+
+	unsigned int Width() const;
+	unsigned int Height() const;
+
+	// Deletes the render targets, vertex array, and compiled permutations
+	void Release();
+
+private:
+	unsigned int width, height;
+	GpuFramebuffer targetFBOs[2];
+	GpuTexture targetTextures[2];
+	GpuRenderbuffer depthRBO;
+	GpuVertexArray passVAO;
+	unsigned int vignetteTex;
+	int current, effects;
+	glm::vec3 gradeGain, gradeLift;
+	Shader permutations[POST_PERMUTATION_COUNT];
+	bool compiled[POST_PERMUTATION_COUNT];
+
+	// Creates both color targets and the shared depth buffer at the current size
+	void CreateTargets();
+
+	// Deletes the color targets and depth buffer, if they exist
+	void DeleteTargets();
+
+	// Returns the shader for a set of effects, compiling it the first time it is needed
+	Shader& GetPermutation(int effects);
+};
+
@@ -0,0 +1,433 @@
+//*****************************************************************************
+// RollbackSession.cpp
+//
+// Author: Kyle Manning
+//
+// Brief Description: Contains methods for RollbackSession objects, which
+//					  send each tick's local input to the other player, keep
+//					  both players' recent inputs, and find the first tick
+//					  that ran on a wrong prediction
+//*****************************************************************************
+#include "RollbackSession.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+// First bytes of every packet, so stray traffic on the port is ignored
+const uint32_t NET_PACKET_MAGIC = 0x544E5347;
+
+enum NetPacketType : uint8_t {
+	NET_PACKET_HELLO = 1,
+	NET_PACKET_INPUT = 2
+};
+
+// Largest aim component, which a facing of 1 scales to
+const float NET_AIM_SCALE = 32767.0f;
+
+/// <summary>
+/// Seconds on a steady clock
+/// </summary>
+static double NowSeconds() {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/// <summary>
+/// Stores a unit facing as the aim of an input
+/// </summary>
+/// <param name="input">Input to set the aim of</param>
+/// <param name="facing">Unit vector the player faces</param>
+void SetNetAim(NetInput& input, glm::vec2 facing) {
+	input.aimX = (int16_t)std::lround(glm::clamp(facing.x, -1.0f, 1.0f) * NET_AIM_SCALE);
+	input.aimY = (int16_t)std::lround(glm::clamp(facing.y, -1.0f, 1.0f) * NET_AIM_SCALE);
+}
+
+/// <summary>
+/// Turns the aim of an input back into a unit facing. Both peers do this from the same integers,
+/// so they get the same vector; an input with no aim faces straight up
+/// </summary>
+/// <param name="input">Input to read the aim of</param>
+/// <returns>Unit vector to face</returns>
+glm::vec2 NetAimFacing(const NetInput& input) {
+	if (input.aimX == 0 && input.aimY == 0) {
+		return glm::vec2(0.0f, 1.0f);
+	}
+
+	glm::vec2 aim((float)input.aimX, (float)input.aimY);
+	return aim / glm::length(aim);
+}
+
+RollbackSession::RollbackSession() : localIndex(0), localSeed(0), remoteSeed(0), helloReceived(false), peerPlaying(false), connected(false),
+	lastHello(0.0), localLatest(0), remoteConfirmed(0), remoteAcked(0), remoteTick(0), remoteAdvantage(0), lastSyncTick(0), advantageSum(0), advantageSamples(0), rollbackTick(-1),
+	localTick(0), stats() { }
+
+/// <summary>
+/// Opens the loopback port for a player and starts with no inputs, except the first
+/// NET_INPUT_DELAY ticks, which nobody can have input for and so run with none
+/// </summary>
+/// <param name="localIndex">0 for the host, 1 for the other player</param>
+/// <param name="conditions">Link the simulator applies to everything sent</param>
+/// <returns>False if the index is not a player's or the port could not be opened</returns>
+bool RollbackSession::Open(int localIndex, const NetConditions& conditions) {
+	Close();
+
+	if (localIndex < 0 || localIndex >= NET_PLAYER_COUNT) {
+		std::cout << "ERROR::ROLLBACK_SESSION::NO_SUCH_PLAYER " << localIndex << std::endl;
+		return false;
+	}
+
+	unsigned short localPort = (unsigned short)(NET_BASE_PORT + localIndex);
+	unsigned short remotePort = (unsigned short)(NET_BASE_PORT + 1 - localIndex);
+	if (!transport.Open(localPort, remotePort)) {
+		return false;
+	}
+
+	transport.SetConditions(conditions);
+	this->localIndex = localIndex;
+	localSeed = (uint64_t)std::chrono::high_resolution_clock::now().time_since_epoch().count();
+	remoteSeed = 0;
+	helloReceived = false;
+	peerPlaying = false;
+	connected = false;
+	lastHello = 0.0;
+
+	NetInput none = {};
+	for (int player = 0; player < NET_PLAYER_COUNT; player++) {
+		for (int i = 0; i < NET_INPUT_HISTORY; i++) {
+			history[player][i] = { -1, none, false, none, false };
+		}
+
+		for (int tick = 0; tick < NET_INPUT_DELAY; tick++) {
+			Slot(player, tick) = { tick, none, true, none, false };
+		}
+	}
+
+	localLatest = NET_INPUT_DELAY - 1;
+	remoteConfirmed = NET_INPUT_DELAY - 1;
+	remoteAcked = NET_INPUT_DELAY - 1;
+	remoteTick = 0;
+	remoteAdvantage = 0;
+	lastSyncTick = 0;
+	advantageSum = 0;
+	advantageSamples = 0;
+	rollbackTick = -1;
+	localTick = 0;
+
+	stats = RollbackStats();
+	stats.localIndex = localIndex;
+	stats.conditions = conditions;
+	return true;
+}
+
+void RollbackSession::Close() {
+	transport.Close();
+	connected = false;
+}
+
+bool RollbackSession::IsOpen() const {
+	return transport.IsOpen();
+}
+
+int RollbackSession::LocalIndex() const {
+	return localIndex;
+}
+
+/// <summary>
+/// Reads every waiting packet. Once this peer is ready it says hello until the other peer's
+/// inputs show it is playing, since the hello it needed may have been lost
+/// </summary>
+/// <param name="localReady">Whether this peer can start playing</param>
+/// <param name="tick">Tick this peer is on</param>
+void RollbackSession::Poll(bool localReady, unsigned long long tick) {
+	if (!IsOpen()) {
+		return;
+	}
+
+	localTick = (long long)tick;
+	while (transport.Receive(received)) {
+		ReadPacket();
+	}
+
+	if (localReady && helloReceived) {
+		connected = true;
+	}
+
+	if (peerPlaying) {
+		advantageSum += (localTick - remoteTick) - remoteAdvantage;
+		advantageSamples += 1;
+	}
+
+	double now = NowSeconds();
+	if (localReady && !peerPlaying && now - lastHello >= NET_HELLO_INTERVAL) {
+		SendHello();
+		lastHello = now;
+	}
+}
+
+bool RollbackSession::Connected() const {
+	return connected;
+}
+
+/// <summary>
+/// Seed both peers start the sim with, which is the host's
+/// </summary>
+uint64_t RollbackSession::Seed() const {
+	return localIndex == 0 ? localSeed : remoteSeed;
+}
+
+/// <summary>
+/// Records the local input sampled on a tick as the input for NET_INPUT_DELAY ticks later, and
+/// sends it along with every earlier one the other peer has not acknowledged
+/// </summary>
+/// <param name="tick">Tick the input was sampled on</param>
+/// <param name="input">Input sampled</param>
+void RollbackSession::AddLocalInput(unsigned long long tick, NetInput input) {
+	long long applyTick = (long long)tick + NET_INPUT_DELAY;
+	if (applyTick > localLatest) {
+		Slot(localIndex, applyTick) = { applyTick, input, true, input, false };
+		localLatest = applyTick;
+	}
+
+	SendInputs(tick);
+}
+
+/// <summary>
+/// Whether a tick can run without going more than ROLLBACK_MAX_TICKS past the last input known
+/// from the other player. A peer that cannot sends its inputs again, since if both are waiting
+/// on a lost packet neither would otherwise send one
+/// </summary>
+/// <param name="tick">Tick about to run</param>
+/// <returns>False to stall this tick</returns>
+bool RollbackSession::CanRun(unsigned long long tick) {
+	if ((long long)tick - remoteConfirmed <= ROLLBACK_MAX_TICKS) {
+		return true;
+	}
+
+	stats.stalls += 1;
+	SendInputs(tick);
+	return false;
+}
+
+/// <summary>
+/// Whether to hold back a tick because this peer is ahead of the other. Each peer sees the other
+/// as behind by the latency, so only half of the difference between what each sees is its lead.
+/// The difference is averaged over the last NET_SYNC_INTERVAL ticks, since jitter moves a single
+/// reading by a tick or two, and a tick is held back at most that often so the correction is not felt
+/// </summary>
+/// <param name="tick">Tick about to run</param>
+/// <returns>True to skip running a tick this time</returns>
+bool RollbackSession::ShouldWait(unsigned long long tick) {
+	if ((long long)tick - lastSyncTick < NET_SYNC_INTERVAL) {
+		return false;
+	}
+
+	lastSyncTick = (long long)tick;
+	long long sum = advantageSum;
+	int samples = advantageSamples;
+	advantageSum = 0;
+	advantageSamples = 0;
+
+	if (samples == 0 || sum / samples / 2 < 1) {
+		return false;
+	}
+
+	stats.syncWaits += 1;
+	return true;
+}
+
+/// <summary>
+/// Both players' inputs for a tick. The other player's is predicted as their last known input
+/// held, and the prediction is kept so the real input can be checked against it
+/// </summary>
+/// <param name="tick">Tick about to run</param>
+/// <param name="inputs">Each player's input; replaced</param>
+void RollbackSession::Inputs(unsigned long long tick, NetInput inputs[NET_PLAYER_COUNT]) {
+	long long t = (long long)tick;
+	stats.predictedTicks = (int)std::max(0LL, t - remoteConfirmed);
+
+	for (int player = 0; player < NET_PLAYER_COUNT; player++) {
+		InputSlot& slot = Slot(player, t);
+		if (slot.tick == t && slot.confirmed) {
+			inputs[player] = slot.input;
+			continue;
+		}
+
+		if (player == localIndex) {
+			// Local input is always added before its tick runs, so this is only the first ticks
+			inputs[player] = NetInput();
+			continue;
+		}
+
+		NetInput guess = Slot(player, remoteConfirmed).input;
+		slot = { t, guess, false, guess, true };
+		inputs[player] = guess;
+	}
+}
+
+/// <summary>
+/// Takes the first tick that ran on a prediction the real input has since contradicted
+/// </summary>
+/// <param name="tick">Tick to load the state of and run again from</param>
+/// <returns>False if every tick run so far still holds</returns>
+bool RollbackSession::TakeRollback(unsigned long long& tick) {
+	if (rollbackTick < 0) {
+		return false;
+	}
+
+	tick = (unsigned long long)rollbackTick;
+	rollbackTick = -1;
+	return true;
+}
+
+StateWriter& RollbackSession::StateAt(unsigned long long tick) {
+	return states[tick % (ROLLBACK_MAX_TICKS + 1)];
+}
+
+void RollbackSession::RecordSave(double ms) {
+	stats.saveMs = ms;
+}
+
+void RollbackSession::RecordRollback(int ticks, double ms) {
+	stats.rollbacks += 1;
+	stats.resimulatedTicks += (unsigned long long)ticks;
+	stats.lastResimTicks = ticks;
+	stats.maxResimTicks = std::max(stats.maxResimTicks, ticks);
+	stats.lastRollbackMs = ms;
+	stats.maxRollbackMs = std::max(stats.maxRollbackMs, ms);
+}
+
+RollbackStats RollbackSession::GetStats() const {
+	RollbackStats result = stats;
+	result.connected = connected;
+	result.localAdvantage = (int)(localTick - remoteTick);
+	result.remoteAdvantage = remoteAdvantage;
+	result.net = transport.GetStats();
+	result.conditions = transport.Conditions();
+	return result;
+}
+
+RollbackSession::InputSlot& RollbackSession::Slot(int player, long long tick) {
+	return history[player][tick % NET_INPUT_HISTORY];
+}
+
+/// <summary>
+/// Stores the other player's real input for a tick. If the tick already ran on a prediction
+/// that differs, it and every tick after it are wrong, so the earliest such tick is kept
+/// </summary>
+/// <param name="tick">Tick the input is for; the one after remoteConfirmed</param>
+/// <param name="input">Input that arrived</param>
+void RollbackSession::ConfirmRemote(long long tick, const NetInput& input) {
+	InputSlot& slot = Slot(1 - localIndex, tick);
+	if (slot.tick == tick && slot.predictionUsed && !(slot.predicted == input) && (rollbackTick < 0 || tick < rollbackTick)) {
+		rollbackTick = tick;
+	}
+
+	slot = { tick, input, true, input, false };
+}
+
+void RollbackSession::SendHello() {
+	packet.Clear();
+	packet.Write(NET_PACKET_MAGIC);
+	packet.Write((uint8_t)NET_PACKET_HELLO);
+	packet.Write((uint8_t)localIndex);
+	packet.Write(localSeed);
+	transport.Send(packet.Bytes().data(), packet.Bytes().size());
+}
+
+/// <summary>
+/// Sends every local input the other peer has not acknowledged, up to NET_MAX_PACKET_INPUTS of
+/// the newest, along with the newest remote input this peer has, which acknowledges it
+/// </summary>
+/// <param name="tick">Tick this peer is on</param>
+void RollbackSession::SendInputs(unsigned long long tick) {
+	long long first = std::max(remoteAcked + 1, localLatest - NET_MAX_PACKET_INPUTS + 1);
+	long long count = std::max(0LL, localLatest - first + 1);
+
+	packet.Clear();
+	packet.Write(NET_PACKET_MAGIC);
+	packet.Write((uint8_t)NET_PACKET_INPUT);
+	packet.Write((uint8_t)localIndex);
+	packet.Write((int64_t)tick);
+	packet.Write((int32_t)((long long)tick - remoteTick));
+	packet.Write((int64_t)remoteConfirmed);
+	packet.Write((int64_t)first);
+	packet.Write((uint8_t)count);
+	for (long long t = first; t < first + count; t++) {
+		packet.Write(Slot(localIndex, t).input);
+	}
+
+	transport.Send(packet.Bytes().data(), packet.Bytes().size());
+}
+
+/// <summary>
+/// Reads the packet in received. Inputs are only taken in order: one after a gap waits for a
+/// later packet, which repeats everything not yet acknowledged
+/// </summary>
+void RollbackSession::ReadPacket() {
+	StateReader reader(received.data(), received.size());
+	uint32_t magic = 0;
+	uint8_t type = 0, sender = 0;
+	reader.Read(magic);
+	reader.Read(type);
+	reader.Read(sender);
+	if (reader.Failed() || magic != NET_PACKET_MAGIC || sender != 1 - localIndex) {
+		return;
+	}
+
+	if (type == NET_PACKET_HELLO) {
+		uint64_t seed = 0;
+		reader.Read(seed);
+		if (!reader.Failed()) {
+			remoteSeed = seed;
+			helloReceived = true;
+		}
+
+		return;
+	}
+
+	// Inputs sent before this peer was ready are sent again until acknowledged
+	if (type != NET_PACKET_INPUT || !connected) {
+		return;
+	}
+
+	int64_t tick = 0, ack = 0, first = 0;
+	int32_t advantage = 0;
+	uint8_t count = 0;
+	reader.Read(tick);
+	reader.Read(advantage);
+	reader.Read(ack);
+	reader.Read(first);
+	reader.Read(count);
+	if (reader.Failed()) {
+		return;
+	}
+
+	peerPlaying = true;
+	if (tick >= remoteTick) {
+		remoteTick = tick;
+		remoteAdvantage = advantage;
+	}
+
+	remoteAcked = std::max(remoteAcked, std::min((long long)ack, localLatest));
+
+	for (int i = 0; i < count; i++) {
+		NetInput input = {};
+		reader.Read(input);
+		if (reader.Failed()) {
+			return;
+		}
+
+		long long t = first + i;
+		if (t <= remoteConfirmed) {
+			continue;
+		}
+
+		if (t > remoteConfirmed + 1) {
+			return;
+		}
+
+		ConfirmRemote(t, input);
+		remoteConfirmed = t;
+	}
+}
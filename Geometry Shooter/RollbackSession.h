@@ -0,0 +1,194 @@
+//*****************************************************************************
+// RollbackSession.h
+//
+// Author: Kyle Manning
+//
+// Brief Description: Header for RollbackSession objects, which exchange
+//					  per-tick inputs between the two players of a co-op game,
+//					  predict the other player's input until it arrives, and
+//					  say when a prediction was wrong and ticks must be run again
+//*****************************************************************************
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "../Common/LoopbackTransport.h"
+#include "../Common/StateStream.h"
+
+// Ticks a peer may run past the last input it has from the other, and so the most one rollback runs again
+const int ROLLBACK_MAX_TICKS = 8;
+
+// Ticks from sampling local input to the tick it is applied on; hides that much latency with no rollback at all
+const int NET_INPUT_DELAY = 2;
+
+// Inputs kept per player, well past the rollback window so a late resend still finds its tick
+const int NET_INPUT_HISTORY = 64;
+
+// Most inputs one packet carries; a packet repeats every input the other peer has not acknowledged
+const int NET_MAX_PACKET_INPUTS = 32;
+
+// Seconds between hellos while waiting for the other peer
+const double NET_HELLO_INTERVAL = 0.1;
+
+// Ticks between holding back a tick when this peer runs ahead of the other
+const int NET_SYNC_INTERVAL = 30;
+
+// Player 0 receives on this loopback port and player 1 on the next
+const unsigned short NET_BASE_PORT = 47810;
+
+// Co-op has two players; player 0 hosts and picks the random seed
+const int NET_PLAYER_COUNT = 2;
+
+// Buttons a player holds during a tick, one bit each
+enum NetButton : uint16_t {
+	NET_UP = 1 << 0,
+	NET_DOWN = 1 << 1,
+	NET_LEFT = 1 << 2,
+	NET_RIGHT = 1 << 3,
+	NET_FIRE = 1 << 4
+};
+
+// One player's input for one tick. The aim is the facing scaled to int16, so both peers turn it
+// back into exactly the same vector
+struct NetInput {
+	uint16_t buttons;
+	int16_t aimX, aimY;
+
+	bool operator==(const NetInput& other) const {
+		return buttons == other.buttons && aimX == other.aimX && aimY == other.aimY;
+	}
+};
+
+// Stores a unit facing as the aim of an input
+void SetNetAim(NetInput& input, glm::vec2 facing);
+
+// Facing an input aims along; (0, 1) for an input with no aim
+glm::vec2 NetAimFacing(const NetInput& input);
+
+// Counters for the debug overlay
+struct RollbackStats {
+	bool connected;
+	int localIndex;
+	// Ticks run so far on a predicted input of the other player's
+	int predictedTicks;
+	unsigned long long rollbacks, resimulatedTicks, stalls, syncWaits;
+	int lastResimTicks, maxResimTicks;
+	// Loading the rolled back state and running the ticks again, last and worst, and saving the state each tick
+	double lastRollbackMs, maxRollbackMs, saveMs;
+	// Ticks this peer runs ahead of the other, as this peer and the other see it
+	int localAdvantage, remoteAdvantage;
+	NetStats net;
+	NetConditions conditions;
+};
+
+/* Both peers run the same deterministic sim from the same seed, one tick at a time, and only
+*  inputs cross the network. Input sampled on a tick is applied NET_INPUT_DELAY ticks later, and
+*  every packet repeats all of a peer's inputs the other has not acknowledged, so a lost packet
+*  only delays inputs until the next one arrives.
+*
+*  When a tick comes up before the other player's input for it has arrived, the sim runs it with
+*  a prediction: the other player's last known input, held. Once the real input arrives, any tick
+*  that ran on a prediction it contradicts is a rollback: the caller loads the state saved at the
+*  start of the first wrong tick and runs every tick since again with the inputs now known. A
+*  peer never runs more than ROLLBACK_MAX_TICKS ticks ahead of the other's input, stalling
+*  instead, so a rollback never runs more ticks again than that and only that many states are
+*  kept. A peer that keeps finding itself ahead also holds back a tick now and then, so the two
+*  settle at running the same tick at about the same time rather than one stalling.
+*
+*  The session only tracks inputs and the saved states; the caller owns the sim and does the
+*  loading and running, reporting how long it took for the overlay.
+*/
+class RollbackSession {
+public:
+	RollbackSession();
+
+	// Opens the loopback port for a player; the simulator applies conditions to everything sent
+	bool Open(int localIndex, const NetConditions& conditions);
+
+	void Close();
+
+	bool IsOpen() const;
+
+	int LocalIndex() const;
+
+	// Reads every waiting packet, and says hello until the other peer is playing once this one is ready
+	void Poll(bool localReady, unsigned long long tick);
+
+	// Whether both peers are ready; play then starts on tick 0 with Seed
+	bool Connected() const;
+
+	uint64_t Seed() const;
+
+	// Records the local input sampled on a tick, which applies NET_INPUT_DELAY ticks later, and sends it
+	void AddLocalInput(unsigned long long tick, NetInput input);
+
+	// Whether a tick can run without going more than ROLLBACK_MAX_TICKS past the other player's
+	// input; while it cannot, unacknowledged inputs are sent again so neither peer waits on a lost packet
+	bool CanRun(unsigned long long tick);
+
+	// Whether to hold back this tick because this peer is running ahead of the other
+	bool ShouldWait(unsigned long long tick);
+
+	// Both players' inputs for a tick, predicting the other player's if it has not arrived
+	void Inputs(unsigned long long tick, NetInput inputs[NET_PLAYER_COUNT]);
+
+	// Takes the first tick that ran on a prediction the real input has since contradicted
+	bool TakeRollback(unsigned long long& tick);
+
+	// Buffer for the state at the start of a tick; holds the last ROLLBACK_MAX_TICKS + 1 ticks
+	StateWriter& StateAt(unsigned long long tick);
+
+	void RecordSave(double ms);
+	void RecordRollback(int ticks, double ms);
+
+	RollbackStats GetStats() const;
+
+private:
+	struct InputSlot {
+		long long tick;
+		NetInput input;
+		bool confirmed;
+		// The input a tick ran with before the real one arrived
+		NetInput predicted;
+		bool predictionUsed;
+	};
+
+	LoopbackTransport transport;
+	int localIndex;
+	uint64_t localSeed, remoteSeed;
+	bool helloReceived, peerPlaying, connected;
+	double lastHello;
+
+	InputSlot history[NET_PLAYER_COUNT][NET_INPUT_HISTORY];
+	// Newest local input, newest tick every remote input up to is known, and newest local input the other peer has
+	long long localLatest, remoteConfirmed, remoteAcked;
+	// Tick the other peer was on when it last sent, and how far ahead of this one it saw itself
+	long long remoteTick;
+	int remoteAdvantage;
+	long long lastSyncTick;
+	// Difference between the two peers' advantages, summed over the polls since the last sync check, so jitter averages out
+	long long advantageSum;
+	int advantageSamples;
+	long long rollbackTick;
+	// Tick this peer was on at the last Poll
+	long long localTick;
+
+	StateWriter states[ROLLBACK_MAX_TICKS + 1];
+	StateWriter packet;
+	std::vector<uint8_t> received;
+	RollbackStats stats;
+
+	InputSlot& Slot(int player, long long tick);
+
+	// Stores a remote input that arrived, noting a rollback if a tick ran on a different prediction
+	void ConfirmRemote(long long tick, const NetInput& input);
+
+	void SendHello();
+	void SendInputs(unsigned long long tick);
+
+	// Reads one packet; anything malformed or from the wrong player is ignored
+	void ReadPacket();
+};
@@ -2,8 +2,9 @@
 // Shader.cpp
 // 
 // Brief Description: Contains methods for building shader programs using
-//					  file paths for vertex and fragment shaders, and methods
-//					  for setting various types of uniforms
+//					  file paths for vertex and fragment shaders, reflecting
+//					  their active uniforms, and methods for setting various
+//					  types of uniforms
 // 
 // This code is a slightly modified version of:
 // 
@@ -11,6 +12,133 @@
 // Created by Joey de Vries, licensed under CC BY 4.0
 //*****************************************************************************
 #include "Shader.h"
+#include "../Common/GLState.h"
+#include "../Common/GpuResources.h"
+
+// Consulted before the file system when a shader is built; empty unless an app sets it
+static ShaderSourceLookup sourceLookup;
+
+const char PROGRAM_CACHE_MAGIC[4] = { 'G', 'S', 'P', 'C' };
+const uint32_t PROGRAM_CACHE_VERSION = 1;
+
+// Start of the program cache file; binaries are only valid for the driver that produced them
+struct ProgramCacheHeader {
+	char magic[4];
+	uint32_t version;
+	uint64_t driverHash;
+	uint32_t entryCount;
+	uint32_t reserved;
+};
+
+// Precedes each binary in the cache file
+struct ProgramCacheEntry {
+	uint64_t key;
+	uint32_t format;
+	uint32_t length;
+};
+
+struct ProgramBinary {
+	GLenum format;
+	vector<unsigned char> data;
+};
+
+// Program whose compile and link were issued but whose results have not been checked yet
+struct PendingProgram {
+	uint64_t key;
+	unsigned int vertex, fragment;
+};
+
+// Binaries of every program built so far this run or loaded from the cache file, by source hash
+static unordered_map<uint64_t, ProgramBinary> programBinaries;
+static unordered_map<unsigned int, PendingProgram> pendingPrograms;
+static string programCachePath;
+static bool programCacheDirty = false;
+
+static bool buildStateReady = false;
+static bool binariesSupported = false;
+static bool parallelCompile = false;
+static uint64_t driverHash = 0;
+static ShaderBuildStats buildStats = { 0, 0, 0 };
+
+/// <summary>
+/// FNV-1a hash, used to key program binaries by their source
+/// </summary>
+/// <param name="data">Bytes to hash</param>
+/// <param name="size">Number of bytes</param>
+/// <param name="hash">Hash to continue from, for hashing several pieces as one</param>
+/// <returns>64 bit hash</returns>
+static uint64_t HashBytes(const void* data, size_t size, uint64_t hash = 14695981039346656037ull) {
+	const unsigned char* bytes = (const unsigned char*)data;
+	for (size_t i = 0; i < size; i++) {
+		hash = (hash ^ bytes[i]) * 1099511628211ull;
+	}
+	return hash;
+}
+
+/// <summary>
+/// Hashes both stages together; the separator keeps "ab" + "c" from matching "a" + "bc"
+/// </summary>
+static uint64_t ProgramKey(const string& vertexCode, const string& fragmentCode) {
+	const char separator = 0;
+	uint64_t hash = HashBytes(vertexCode.data(), vertexCode.size());
+	hash = HashBytes(&separator, 1, hash);
+	return HashBytes(fragmentCode.data(), fragmentCode.size(), hash);
+}
+
+/// <summary>
+/// Queries the driver once for what program building can use: binary formats, parallel compile,
+/// and the strings that identify the driver for the binary cache
+/// </summary>
+static void InitBuildState() {
+	if (buildStateReady) {
+		return;
+	}
+	buildStateReady = true;
+
+	int formatCount = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+	binariesSupported = formatCount > 0;
+
+	const GLenum driverStrings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+	driverHash = HashBytes(nullptr, 0);
+	for (GLenum name : driverStrings) {
+		const char* value = (const char*)glGetString(name);
+		if (value != nullptr) {
+			driverHash = HashBytes(value, strlen(value) + 1, driverHash);
+		}
+	}
+
+	// Lets the driver compile on its own threads; programs are only waited on when they are first used
+#ifdef GL_KHR_parallel_shader_compile
+	if (GLAD_GL_KHR_parallel_shader_compile) {
+		glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+		parallelCompile = true;
+	}
+#endif
+#ifdef GL_ARB_parallel_shader_compile
+	if (!parallelCompile && GLAD_GL_ARB_parallel_shader_compile) {
+		glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+		parallelCompile = true;
+	}
+#endif
+}
+
+/// <summary>
+/// Deletes the program once no Shader or UniformHandle refers to it, along with its shader objects
+/// if it never finished building
+/// </summary>
+UniformTable::~UniformTable() {
+	if (GpuResources::ContextAlive()) {
+		auto pending = pendingPrograms.find(program);
+		if (pending != pendingPrograms.end()) {
+			glDeleteShader(pending->second.vertex);
+			glDeleteShader(pending->second.fragment);
+			pendingPrograms.erase(pending);
+		}
+	}
+
+	GpuResources::Destroy(GPU_PROGRAM, program);
+}
 
 Shader::Shader() { }
 
@@ -20,70 +148,471 @@ Shader::Shader() { }
 /// </summary>
 /// <param name="vertexPath">filepath of vertex shader</param>
 /// <param name="fragmentPath">filepath of fragment shader</param>
-Shader::Shader(const char* vertexPath, const char* fragmentPath) {
-	string vertexCode;
-	string fragmentCode;
-	ifstream vShaderFile;
-	ifstream fShaderFile;
+Shader::Shader(const char* vertexPath, const char* fragmentPath) : Shader(vertexPath, fragmentPath, "") {
+}
 
-	vShaderFile.exceptions(ifstream::failbit | ifstream::badbit);
-	fShaderFile.exceptions(ifstream::failbit | ifstream::badbit);
+/// <summary>
+/// Opens files using the paths provided as arguments and builds them into shader programs,
+/// with extra #define lines inserted after the #version line of each stage; used to build
+/// several permutations of one shader source. Offline compiled SPIR-V is preferred when there
+/// are no defines, and a cached binary of the same source is used instead of compiling when
+/// there is one
+/// </summary>
+/// <param name="vertexPath">filepath of vertex shader</param>
+/// <param name="fragmentPath">filepath of fragment shader</param>
+/// <param name="defines">Lines inserted into both stages, e.g. "#define GRAYSCALE\n"</param>
+Shader::Shader(const char* vertexPath, const char* fragmentPath, const string& defines) {
+	InitBuildState();
 
-	try {
-		vShaderFile.open(vertexPath);
-		fShaderFile.open(fragmentPath);
-		stringstream vShaderStream, fShaderStream;
+	if (!defines.empty() || !BuildFromSpirv(vertexPath, fragmentPath)) {
+		BuildFromSource(vertexPath, fragmentPath, defines);
+	}
 
-		vShaderStream << vShaderFile.rdbuf();
-		fShaderStream << fShaderFile.rdbuf();
+	uniforms = make_shared<UniformTable>();
+	uniforms->program = ID;
+	uniforms->reflected = false;
+}
 
-		vShaderFile.close();
-		fShaderFile.close();
+/// <summary>
+/// Sets a lookup that can supply shader sources without reading their files
+/// </summary>
+/// <param name="lookup">Function that fills in the source for a path and returns true if it has it</param>
+void Shader::SetSourceLookup(ShaderSourceLookup lookup) {
+	sourceLookup = lookup;
+}
 
-		vertexCode = vShaderStream.str();
-		fragmentCode = fShaderStream.str();
+/// <summary>
+/// Reads a file, asking the source lookup first
+/// </summary>
+/// <param name="path">filepath of the file</param>
+/// <param name="contents">Filled with the file's bytes</param>
+/// <returns>False if neither the lookup nor the file system has it</returns>
+bool Shader::ReadFile(const string& path, string& contents) {
+	if (sourceLookup && sourceLookup(path.c_str(), contents)) {
+		return true;
 	}
-	catch (ifstream::failure e) {
+
+	ifstream file(path, ios::binary);
+	if (!file) {
+		return false;
+	}
+
+	stringstream stream;
+	stream << file.rdbuf();
+	contents = stream.str();
+	return true;
+}
+
+/// <summary>
+/// Reads the source of one shader stage
+/// </summary>
+/// <param name="path">filepath of the shader stage</param>
+/// <returns>GLSL source text, empty if it could not be read</returns>
+string Shader::ReadSource(const char* path) {
+	string code;
+	if (!ReadFile(path, code)) {
 		cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ" << endl;
 	}
+
+	return code;
+}
+
+/// <summary>
+/// Builds the program from SPIR-V modules made by Tools/CompileSpirv.sh. The program is linked
+/// right away so that a module the driver rejects, or one stripped of the names that uniforms are
+/// looked up by, falls back to the GLSL source
+/// </summary>
+/// <param name="vertexPath">filepath of vertex shader; its module is this path plus .spv</param>
+/// <param name="fragmentPath">filepath of fragment shader; its module is this path plus .spv</param>
+/// <returns>True if the program was built from SPIR-V or from a cached binary of it</returns>
+bool Shader::BuildFromSpirv(const char* vertexPath, const char* fragmentPath) {
+	if (!GLAD_GL_VERSION_4_6) {
+		return false;
+	}
+
+	string vertexModule, fragmentModule;
+	if (!ReadFile(string(vertexPath) + ".spv", vertexModule) || !ReadFile(string(fragmentPath) + ".spv", fragmentModule)) {
+		return false;
+	}
+
+	uint64_t key = ProgramKey(vertexModule, fragmentModule);
+	if (LoadProgramBinary(key, vertexPath)) {
+		return true;
+	}
+
+	unsigned int vertex = glCreateShader(GL_VERTEX_SHADER);
+	glShaderBinary(1, &vertex, GL_SHADER_BINARY_FORMAT_SPIR_V, vertexModule.data(), (GLsizei)vertexModule.size());
+	glSpecializeShader(vertex, "main", 0, nullptr, nullptr);
+
+	unsigned int fragment = glCreateShader(GL_FRAGMENT_SHADER);
+	glShaderBinary(1, &fragment, GL_SHADER_BINARY_FORMAT_SPIR_V, fragmentModule.data(), (GLsizei)fragmentModule.size());
+	glSpecializeShader(fragment, "main", 0, nullptr, nullptr);
+
+	int vertexSuccess, fragmentSuccess;
+	glGetShaderiv(vertex, GL_COMPILE_STATUS, &vertexSuccess);
+	glGetShaderiv(fragment, GL_COMPILE_STATUS, &fragmentSuccess);
+
+	int linked = 0;
+	ID = GpuResources::Create(GPU_PROGRAM, vertexPath);
+
+	if (vertexSuccess && fragmentSuccess) {
+		glProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		glAttachShader(ID, vertex);
+		glAttachShader(ID, fragment);
+		glLinkProgram(ID);
+		glGetProgramiv(ID, GL_LINK_STATUS, &linked);
+		glDetachShader(ID, vertex);
+		glDetachShader(ID, fragment);
+	}
+
+	glDeleteShader(vertex);
+	glDeleteShader(fragment);
+
+	// Uniforms are set by name, which needs the module's debug names
+	int uniformCount = 0;
+	if (linked) {
+		glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &uniformCount);
+	}
+	for (GLuint i = 0; i < (GLuint)uniformCount && linked; i++) {
+		int length = 0;
+		glGetActiveUniformsiv(ID, 1, &i, GL_UNIFORM_NAME_LENGTH, &length);
+		linked = length > 1;
+	}
+
+	if (!linked) {
+		cout << "ERROR::SHADER::SPIRV::UNUSABLE " << vertexPath << ", " << fragmentPath << " (using GLSL)" << endl;
+		GpuResources::Destroy(GPU_PROGRAM, ID);
+		return false;
+	}
+
+	buildStats.fromSpirv += 1;
+
+	pendingPrograms[ID] = { key, 0, 0 };
+	FinishProgram(ID, true);
+	return true;
+}
+
+/// <summary>
+/// Reads both GLSL stages and compiles them unless a binary of the same source is cached. The
+/// compile and link are only issued here; with parallel compile the driver works on them in the
+/// background until the program is first used or PollPending sees that they are done
+/// </summary>
+/// <param name="vertexPath">filepath of vertex shader</param>
+/// <param name="fragmentPath">filepath of fragment shader</param>
+/// <param name="defines">Lines inserted after the #version line of both stages</param>
+void Shader::BuildFromSource(const char* vertexPath, const char* fragmentPath, const string& defines) {
+	string vertexCode = ReadSource(vertexPath);
+	string fragmentCode = ReadSource(fragmentPath);
+
+	if (!defines.empty()) {
+		vertexCode.insert(vertexCode.find('\n') + 1, defines);
+		fragmentCode.insert(fragmentCode.find('\n') + 1, defines);
+	}
+
+	uint64_t key = ProgramKey(vertexCode, fragmentCode);
+
+	// A copy of the same program still compiling is finished first so its binary can be reused
+	for (auto& pending : pendingPrograms) {
+		if (pending.second.key == key) {
+			FinishProgram(pending.first, true);
+			break;
+		}
+	}
+
+	if (LoadProgramBinary(key, vertexPath)) {
+		return;
+	}
+
 	const char* vShaderCode = vertexCode.c_str();
 	const char* fShaderCode = fragmentCode.c_str();
 
 	unsigned int vertex, fragment;
-	int success;
-	char infoLog[512];
 
 	vertex = glCreateShader(GL_VERTEX_SHADER);
 	glShaderSource(vertex, 1, &vShaderCode, NULL);
 	glCompileShader(vertex);
 
-	glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
-	if (!success) {
-		glGetShaderInfoLog(vertex, 512, NULL, infoLog);
-		cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << endl;
-	};
-
 	fragment = glCreateShader(GL_FRAGMENT_SHADER);
 	glShaderSource(fragment, 1, &fShaderCode, NULL);
 	glCompileShader(fragment);
 
-	glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
-	if (!success) {
-		glGetShaderInfoLog(fragment, 512, NULL, infoLog);
-		cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << endl;
-	};
-
-	ID = glCreateProgram();
+	ID = GpuResources::Create(GPU_PROGRAM, vertexPath);
+	glProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 	glAttachShader(ID, vertex);
 	glAttachShader(ID, fragment);
 	glLinkProgram(ID);
 
-	glDeleteShader(vertex);
-	glDeleteShader(fragment);
+	buildStats.compiled += 1;
+	pendingPrograms[ID] = { key, vertex, fragment };
+}
+
+/// <summary>
+/// Creates the program from a binary cached this run or loaded from the cache file
+/// </summary>
+/// <param name="key">Hash of the program's sources</param>
+/// <param name="label">Name the program is registered under, usually its vertex shader path</param>
+/// <returns>False if there is no binary for the key or the driver no longer accepts it</returns>
+bool Shader::LoadProgramBinary(uint64_t key, const char* label) {
+	auto found = programBinaries.find(key);
+	if (found == programBinaries.end()) {
+		return false;
+	}
+
+	ID = GpuResources::Create(GPU_PROGRAM, label);
+	glProgramBinary(ID, found->second.format, found->second.data.data(), (GLsizei)found->second.data.size());
+
+	int linked = 0;
+	glGetProgramiv(ID, GL_LINK_STATUS, &linked);
+	if (!linked) {
+		GpuResources::Destroy(GPU_PROGRAM, ID);
+		programBinaries.erase(found);
+		programCacheDirty = true;
+		return false;
+	}
+
+	GpuResources::SetBytes(GPU_PROGRAM, ID, found->second.data.size());
+	buildStats.fromBinary += 1;
+	return true;
+}
+
+/// <summary>
+/// Reports compile and link errors of a program built by BuildFromSource, releases its shader
+/// objects, and keeps its binary so later builds of the same source can skip compiling
+/// </summary>
+/// <param name="program">Program ID</param>
+/// <param name="wait">Whether to block until the driver is done with it</param>
+/// <returns>True if the program is finished, or was never pending</returns>
+bool Shader::FinishProgram(unsigned int program, bool wait) {
+	auto found = pendingPrograms.find(program);
+	if (found == pendingPrograms.end()) {
+		return true;
+	}
+
+	if (!wait && parallelCompile) {
+		int complete = 0;
+		glGetProgramiv(program, GL_COMPLETION_STATUS_KHR, &complete);
+		if (!complete) {
+			return false;
+		}
+	}
+
+	PendingProgram pending = found->second;
+	pendingPrograms.erase(found);
+
+	int success;
+	char infoLog[512];
+
+	if (pending.vertex != 0) {
+		glGetShaderiv(pending.vertex, GL_COMPILE_STATUS, &success);
+		if (!success) {
+			glGetShaderInfoLog(pending.vertex, 512, NULL, infoLog);
+			cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << endl;
+		}
+
+		glDetachShader(program, pending.vertex);
+		glDeleteShader(pending.vertex);
+	}
+
+	if (pending.fragment != 0) {
+		glGetShaderiv(pending.fragment, GL_COMPILE_STATUS, &success);
+		if (!success) {
+			glGetShaderInfoLog(pending.fragment, 512, NULL, infoLog);
+			cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << endl;
+		}
+
+		glDetachShader(program, pending.fragment);
+		glDeleteShader(pending.fragment);
+	}
+
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	if (!success) {
+		glGetProgramInfoLog(program, 512, NULL, infoLog);
+		cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << endl;
+		return true;
+	}
+
+	int length = 0;
+	if (binariesSupported) {
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	}
+
+	if (length > 0) {
+		ProgramBinary& binary = programBinaries[pending.key];
+		binary.data.resize(length);
+		glGetProgramBinary(program, length, NULL, &binary.format, binary.data.data());
+		programCacheDirty = true;
+
+		GpuResources::SetBytes(GPU_PROGRAM, program, length);
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Finishes every program whose compile the driver has completed, without blocking on the others
+/// </summary>
+/// <returns>True when no programs are left compiling</returns>
+bool Shader::PollPending() {
+	vector<unsigned int> programs;
+	for (auto& pending : pendingPrograms) {
+		programs.push_back(pending.first);
+	}
+
+	for (unsigned int program : programs) {
+		FinishProgram(program, false);
+	}
+
+	return pendingPrograms.empty();
+}
+
+/// <summary>
+/// Reads the program cache file; it is ignored if it was written by a different driver, since
+/// program binaries are not portable between drivers or even driver versions
+/// </summary>
+/// <param name="path">File name/path of the cache</param>
+void Shader::LoadProgramCache(const string& path) {
+	InitBuildState();
+	programCachePath = path;
+
+	if (!binariesSupported) {
+		return;
+	}
+
+	ifstream file(path, ios::binary);
+	ProgramCacheHeader header;
+	if (!file.read((char*)&header, sizeof(header))) {
+		return;
+	}
+
+	if (memcmp(header.magic, PROGRAM_CACHE_MAGIC, sizeof(PROGRAM_CACHE_MAGIC)) != 0 ||
+		header.version != PROGRAM_CACHE_VERSION || header.driverHash != driverHash) {
+		// Rewritten for the current driver once programs have been compiled
+		programCacheDirty = true;
+		return;
+	}
+
+	for (uint32_t i = 0; i < header.entryCount; i++) {
+		ProgramCacheEntry entry;
+		if (!file.read((char*)&entry, sizeof(entry))) {
+			break;
+		}
+
+		ProgramBinary binary;
+		binary.format = entry.format;
+		binary.data.resize(entry.length);
+		if (!file.read((char*)binary.data.data(), entry.length)) {
+			break;
+		}
+
+		programBinaries[entry.key] = std::move(binary);
+	}
+}
+
+/// <summary>
+/// Writes every program binary to the cache file set by LoadProgramCache if any were added or
+/// dropped since it was read
+/// </summary>
+void Shader::SaveProgramCache() {
+	if (programCachePath.empty() || !programCacheDirty) {
+		return;
+	}
+
+	ofstream file(programCachePath, ios::binary | ios::trunc);
+	if (!file) {
+		cout << "ERROR::SHADER::PROGRAM_CACHE_NOT_WRITTEN " << programCachePath << endl;
+		return;
+	}
+
+	ProgramCacheHeader header = {};
+	memcpy(header.magic, PROGRAM_CACHE_MAGIC, sizeof(PROGRAM_CACHE_MAGIC));
+	header.version = PROGRAM_CACHE_VERSION;
+	header.driverHash = driverHash;
+	header.entryCount = (uint32_t)programBinaries.size();
+	file.write((const char*)&header, sizeof(header));
+
+	for (auto& binary : programBinaries) {
+		ProgramCacheEntry entry = { binary.first, binary.second.format, (uint32_t)binary.second.data.size() };
+		file.write((const char*)&entry, sizeof(entry));
+		file.write((const char*)binary.second.data.data(), binary.second.data.size());
+	}
+
+	programCacheDirty = false;
+}
+
+ShaderBuildStats Shader::GetBuildStats() {
+	return buildStats;
 }
 
 void Shader::Use() {
-	glUseProgram(ID);
+	if (uniforms && !uniforms->reflected) {
+		ReflectUniforms();
+	}
+
+	GLState::UseProgram(ID);
+}
+
+/// <summary>
+/// Queries every active uniform of the linked program once and stores its location, so
+/// setting uniforms never has to ask the driver for a location by name; waits for the program
+/// to finish compiling first
+/// </summary>
+void Shader::ReflectUniforms() const {
+	FinishProgram(ID, true);
+	uniforms->reflected = true;
+
+	int count = 0;
+	int maxLength = 0;
+	glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+	vector<char> nameBuffer(maxLength + 1);
+	uniforms->slots.reserve(count);
+
+	for (int i = 0; i < count; i++) {
+		int length = 0;
+		int size = 0;
+		GLenum type;
+		glGetActiveUniform(ID, i, (GLsizei)nameBuffer.size(), &length, &size, &type, nameBuffer.data());
+
+		string name(nameBuffer.data(), length);
+
+		// Arrays are reported as "name[0]"; they are looked up by their plain name
+		if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0) {
+			name.erase(name.size() - 3);
+		}
+
+		UniformSlot slot;
+		slot.location = glGetUniformLocation(ID, name.c_str());
+		slot.hasValue = false;
+
+		// Uniforms in blocks have no location and cannot be set through this class
+		if (slot.location < 0) {
+			continue;
+		}
+
+		uniforms->slotIndex[name] = (int)uniforms->slots.size();
+		uniforms->slots.push_back(slot);
+	}
+}
+
+/// <summary>
+/// Returns the cached slot of a uniform
+/// </summary>
+/// <param name="name">Name of the uniform</param>
+/// <returns>Pointer to the slot, or nullptr if the program has no such active uniform</returns>
+UniformSlot* Shader::FindSlot(const string& name) const {
+	if (!uniforms) {
+		return nullptr;
+	}
+	if (!uniforms->reflected) {
+		ReflectUniforms();
+	}
+
+	auto found = uniforms->slotIndex.find(name);
+	if (found == uniforms->slotIndex.end()) {
+		return nullptr;
+	}
+	return &uniforms->slots[found->second];
 }
 
 /// <summary>
@@ -92,7 +621,7 @@ void Shader::Use() {
 /// <param name="name">Name of the uniform</param>
 /// <param name="value">Value to set uniform as</param>
 void Shader::SetBool(const string& name, bool value) const {
-	glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+	SetUniformSlot(ID, FindSlot(name), (int)value);
 }
 
 /// <summary>
@@ -101,7 +630,7 @@ void Shader::SetBool(const string& name, bool value) const {
 /// <param name="name">Name of the uniform</param>
 /// <param name="value">Value to set uniform as</param>
 void Shader::SetInt(const string& name, int value) const {
-	glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+	SetUniformSlot(ID, FindSlot(name), value);
 }
 
 /// <summary>
@@ -110,7 +639,7 @@ void Shader::SetInt(const string& name, int value) const {
 /// <param name="name">Name of the uniform</param>
 /// <param name="value">Value to set uniform as</param>
 void Shader::SetFloat(const string& name, float value) const {
-	glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+	SetUniformSlot(ID, FindSlot(name), value);
 }
 
 /// <summary>
@@ -119,7 +648,7 @@ void Shader::SetFloat(const string& name, float value) const {
 /// <param name="name">Name of the uniform</param>
 /// <param name="value">Value to set uniform as</param>
 void Shader::SetVec2(const std::string& name, const glm::vec2& value) const {
-	glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+	SetUniformSlot(ID, FindSlot(name), value);
 }
 
 /// <summary>
@@ -129,7 +658,7 @@ void Shader::SetVec2(const std::string& name, const glm::vec2& value) const {
 /// <param name="x">Value to set the uniform's x as</param>
 /// <param name="y">Value to set the uniform's y as</param>
 void Shader::SetVec2(const std::string& name, float x, float y) const {
-	glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+	SetUniformSlot(ID, FindSlot(name), glm::vec2(x, y));
 }
 
 /// <summary>
@@ -138,7 +667,7 @@ void Shader::SetVec2(const std::string& name, float x, float y) const {
 /// <param name="name">Name of the uniform</param>
 /// <param name="value">Value to set uniform as</param>
 void Shader::SetVec3(const std::string& name, const glm::vec3& value) const {
-	glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+	SetUniformSlot(ID, FindSlot(name), value);
 }
 
 /// <summary>
@@ -149,7 +678,7 @@ void Shader::SetVec3(const std::string& name, const glm::vec3& value) const {
 /// <param name="y">Value to set the uniform's y as</param>
 /// <param name="z">Value to set the uniform's z as</param>
 void Shader::SetVec3(const std::string& name, float x, float y, float z) const {
-	glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+	SetUniformSlot(ID, FindSlot(name), glm::vec3(x, y, z));
 }
 
 /// <summary>
@@ -158,7 +687,7 @@ void Shader::SetVec3(const std::string& name, float x, float y, float z) const {
 /// <param name="name">Name of the uniform</param>
 /// <param name="value">Value to set uniform as</param>
 void Shader::SetVec4(const std::string& name, const glm::vec4& value) const {
-	glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+	SetUniformSlot(ID, FindSlot(name), value);
 }
 
 /// <summary>
@@ -170,7 +699,7 @@ void Shader::SetVec4(const std::string& name, const glm::vec4& value) const {
 /// <param name="z">Value to set the uniform's z to</param>
 /// <param name="w">Value to set the unifrom's w to</param>
 void Shader::SetVec4(const std::string& name, float x, float y, float z, float w) const {
-	glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+	SetUniformSlot(ID, FindSlot(name), glm::vec4(x, y, z, w));
 }
 
 /// <summary>
@@ -179,7 +708,7 @@ void Shader::SetVec4(const std::string& name, float x, float y, float z, float w
 /// <param name="name">Name of the uniform</param>
 /// <param name="mat">Matrix that uniform is set to</param>
 void Shader::SetMat2(const std::string& name, const glm::mat2& mat) const {
-	glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+	SetUniformSlot(ID, FindSlot(name), mat);
 }
 
 /// <summary>
@@ -188,7 +717,7 @@ void Shader::SetMat2(const std::string& name, const glm::mat2& mat) const {
 /// <param name="name">Name of the uniform</param>
 /// <param name="mat">Matrix that uniform is set to</param>
 void Shader::SetMat3(const std::string& name, const glm::mat3& mat) const {
-	glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+	SetUniformSlot(ID, FindSlot(name), mat);
 }
 
 /// <summary>
@@ -197,5 +726,39 @@ void Shader::SetMat3(const std::string& name, const glm::mat3& mat) const {
 /// <param name="name">Name of the uniform</param>
 /// <param name="mat">Matrix that uniform is set to</param>
 void Shader::SetMat4(const std::string& name, const glm::mat4& mat) const {
-	glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+	SetUniformSlot(ID, FindSlot(name), mat);
+}
+
+// Overloads below upload each supported uniform type with the program-targeted entry points
+
+void UploadUniform(unsigned int program, int location, const int& value) {
+	glProgramUniform1i(program, location, value);
+}
+
+void UploadUniform(unsigned int program, int location, const float& value) {
+	glProgramUniform1f(program, location, value);
+}
+
+void UploadUniform(unsigned int program, int location, const glm::vec2& value) {
+	glProgramUniform2fv(program, location, 1, &value[0]);
+}
+
+void UploadUniform(unsigned int program, int location, const glm::vec3& value) {
+	glProgramUniform3fv(program, location, 1, &value[0]);
+}
+
+void UploadUniform(unsigned int program, int location, const glm::vec4& value) {
+	glProgramUniform4fv(program, location, 1, &value[0]);
+}
+
+void UploadUniform(unsigned int program, int location, const glm::mat2& value) {
+	glProgramUniformMatrix2fv(program, location, 1, GL_FALSE, &value[0][0]);
+}
+
+void UploadUniform(unsigned int program, int location, const glm::mat3& value) {
+	glProgramUniformMatrix3fv(program, location, 1, GL_FALSE, &value[0][0]);
+}
+
+void UploadUniform(unsigned int program, int location, const glm::mat4& value) {
+	glProgramUniformMatrix4fv(program, location, 1, GL_FALSE, &value[0][0]);
 }
\ No newline at end of file
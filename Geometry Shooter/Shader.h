@@ -14,6 +14,12 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <cstring>
+#include <functional>
+#include <cstdint>
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
@@ -21,6 +27,91 @@
 
 using namespace std;
 
+// Fills source with the shader at path and returns true, or returns false to read the file instead
+typedef std::function<bool(const char* path, string& source)> ShaderSourceLookup;
+
+// Location and last uploaded value of one active uniform; value is large enough for a mat4
+struct UniformSlot {
+	int location;
+	bool hasValue;
+	float value[16];
+};
+
+// Counts of how programs were built; on a warm start everything should come from binaries
+struct ShaderBuildStats {
+	int compiled;
+	int fromSpirv;
+	int fromBinary;
+};
+
+// Uniforms reflected from a linked program; shared by every copy of the Shader that owns it, and
+// deletes the program when the last copy is gone
+struct UniformTable {
+	~UniformTable();
+
+	unsigned int program;
+	// Reflection waits until the program is first used so that its link can finish in the background
+	bool reflected;
+	std::unordered_map<string, int> slotIndex;
+	std::vector<UniformSlot> slots;
+};
+
+// Uploads a value to a uniform location of a program without needing it to be bound
+void UploadUniform(unsigned int program, int location, const int& value);
+void UploadUniform(unsigned int program, int location, const float& value);
+void UploadUniform(unsigned int program, int location, const glm::vec2& value);
+void UploadUniform(unsigned int program, int location, const glm::vec3& value);
+void UploadUniform(unsigned int program, int location, const glm::vec4& value);
+void UploadUniform(unsigned int program, int location, const glm::mat2& value);
+void UploadUniform(unsigned int program, int location, const glm::mat3& value);
+void UploadUniform(unsigned int program, int location, const glm::mat4& value);
+
+// Uploads a value to a reflected uniform unless it matches the last value uploaded to it
+template <typename T>
+void SetUniformSlot(unsigned int program, UniformSlot* slot, const T& value) {
+	static_assert(sizeof(T) <= sizeof(UniformSlot::value), "Uniform type is too large to cache");
+
+	if (slot == nullptr) {
+		return;
+	}
+	if (slot->hasValue && memcmp(slot->value, &value, sizeof(T)) == 0) {
+		return;
+	}
+
+	memcpy(slot->value, &value, sizeof(T));
+	slot->hasValue = true;
+	UploadUniform(program, slot->location, value);
+}
+
+/* Typed handle to a uniform that is resolved once and remembers the last value
+*  uploaded to it; setting the same value again is skipped. The cached value lives
+*  in the program's UniformTable, so every handle and Set* call on the same program
+*  sees the same cache.
+*/
+template <typename T>
+class UniformHandle {
+public:
+	UniformHandle() : slot(nullptr) { }
+
+	UniformHandle(shared_ptr<UniformTable> table, UniformSlot* slot) : table(table), slot(slot) { }
+
+	// Uploads the value unless it matches the last one uploaded
+	void Set(const T& value) {
+		if (slot != nullptr) {
+			SetUniformSlot(table->program, slot, value);
+		}
+	}
+
+	// Whether the uniform exists in the program
+	bool IsValid() const {
+		return slot != nullptr;
+	}
+
+private:
+	shared_ptr<UniformTable> table;
+	UniformSlot* slot;
+};
+
 class Shader {
 public:
 	unsigned int ID;
@@ -29,8 +120,20 @@ public:
 
 	Shader(const char* vertexPath, const char* fragmentPath);
 
+	Shader(const char* vertexPath, const char* fragmentPath, const string& defines);
+
 	void Use();
 
+	// Returns a handle to the named uniform; the handle is invalid if the uniform is not active
+	template <typename T>
+	UniformHandle<T> Uniform(const string& name) const {
+		UniformSlot* slot = FindSlot(name);
+		if (slot == nullptr) {
+			return UniformHandle<T>();
+		}
+		return UniformHandle<T>(uniforms, slot);
+	}
+
 	// Functions below are for setting uniforms various types
 	void SetBool(const string& name, bool value) const;
 
@@ -55,5 +158,45 @@ public:
 	void SetMat3(const std::string& name, const glm::mat3& mat) const;
 
 	void SetMat4(const std::string& name, const glm::mat4& mat) const;
-};
 
+	// Sets where shader sources are looked up before the file system, e.g. an asset bundle
+	static void SetSourceLookup(ShaderSourceLookup lookup);
+
+	// Loads program binaries saved by an earlier run on the same driver; call after the context is created
+	static void LoadProgramCache(const string& path);
+
+	// Writes the program binaries back to the cache file if any were added
+	static void SaveProgramCache();
+
+	// Finishes programs whose background compile is done; returns true once none are left
+	static bool PollPending();
+
+	static ShaderBuildStats GetBuildStats();
+
+private:
+	shared_ptr<UniformTable> uniforms;
+
+	// Builds the program from offline compiled vertexPath.spv and fragmentPath.spv if both exist
+	bool BuildFromSpirv(const char* vertexPath, const char* fragmentPath);
+
+	// Builds the program from GLSL, loading a cached binary of the same source when there is one
+	void BuildFromSource(const char* vertexPath, const char* fragmentPath, const string& defines);
+
+	// Creates the program from the cached binary for key; returns false if there is none or the driver rejects it
+	bool LoadProgramBinary(uint64_t key, const char* label);
+
+	// Checks a program's compile and link results and caches its binary; returns false if wait is false and it is not done
+	static bool FinishProgram(unsigned int program, bool wait);
+
+	// Returns the contents of a file from the lookup if it has it, otherwise from disk
+	static bool ReadFile(const string& path, string& contents);
+
+	// Returns the source of a shader stage from the lookup if it has it, otherwise from the file
+	static string ReadSource(const char* path);
+
+	// Fills the uniform table from the program's active uniforms once linking has finished
+	void ReflectUniforms() const;
+
+	// Returns the slot for a uniform name, or nullptr if it is not active
+	UniformSlot* FindSlot(const string& name) const;
+};
@@ -0,0 +1,41 @@
+//*****************************************************************************
+// SimRandom.cpp
+//
+// Author: Kyle Manning
+//
+// Brief Description: Contains methods for SimRandom objects, which step a
+//					  64 bit linear congruential generator
+//*****************************************************************************
+#include "SimRandom.h"
+
+// Knuth's MMIX multiplier and increment
+const uint64_t SIM_RANDOM_MULTIPLIER = 6364136223846793005ull;
+const uint64_t SIM_RANDOM_INCREMENT = 1442695040888963407ull;
+
+SimRandom::SimRandom() : state(0) { }
+
+/// <summary>
+/// Starts a new sequence; the seed is stepped once so nearby seeds do not start with nearby values
+/// </summary>
+/// <param name="seed">Any value, such as the time</param>
+void SimRandom::Seed(uint64_t seed) {
+	state = seed;
+	Next();
+}
+
+/// <summary>
+/// Steps the generator; the low bits of an LCG repeat quickly, so only the top 31 are returned
+/// </summary>
+/// <returns>Value from 0 to SIM_RANDOM_MAX</returns>
+int SimRandom::Next() {
+	state = state * SIM_RANDOM_MULTIPLIER + SIM_RANDOM_INCREMENT;
+	return (int)(state >> 33);
+}
+
+uint64_t SimRandom::GetState() const {
+	return state;
+}
+
+void SimRandom::SetState(uint64_t state) {
+	this->state = state;
+}
@@ -0,0 +1,37 @@
+//*****************************************************************************
+// SimRandom.h
+//
+// Author: Kyle Manning
+//
+// Brief Description: Header for SimRandom objects, the random number
+//					  generator the sim draws from, whose whole state is one
+//					  value that snapshots can save and put back
+//*****************************************************************************
+#pragma once
+
+#include <cstdint>
+
+// Largest value Next returns
+const int SIM_RANDOM_MAX = 0x7FFFFFFF;
+
+/* A 64 bit linear congruential generator that returns the high bits of its state. The C rand()
+*  keeps its state where nothing can read it, so a restored snapshot would go on to roll
+*  different spawns and powerups than the run it was taken from; with the state saved alongside
+*  everything else, a restored sim plays out exactly as it did the first time for the same
+*  inputs.
+*/
+class SimRandom {
+public:
+	SimRandom();
+
+	void Seed(uint64_t seed);
+
+	// Returns a value from 0 to SIM_RANDOM_MAX, used like rand()
+	int Next();
+
+	uint64_t GetState() const;
+	void SetState(uint64_t state);
+
+private:
+	uint64_t state;
+};
@@ -0,0 +1,402 @@
+//*****************************************************************************
+// Systems.cpp
+//
+// Author: Kyle Manning
+//
+// Brief Description: Contains the enemy and weapon tables, functions for
+//					  spawning enemies and projectiles as entities, and the
+//					  systems that walk the entity world's component arrays to
+//					  move, aim, fire, flash, expire, and draw them
+//*****************************************************************************
+#include "Systems.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Player.h"
+
+// Index 0 is the ranged enemy's gun, index 1 the wave enemy's
+const WeaponDef WEAPONS[] = {
+	{ 1.5f, 225.0f, glm::vec2(10.0f, 10.0f), glm::vec3(0.55f, 0.075f, 0.075f), false },
+	{ 2.5f, 100.0f, glm::vec2(10.0f, 10.0f), glm::vec3(0.62f, 0.005f, 0.59f), true }
+};
+
+const EnemyDef ENEMY_DEFS[ENEMY_KIND_COUNT] = {
+	{ 50, 10, 10, 165.0f, 0.0f, ENEMY_SIZE, N_ENEMY_COLOR, MESH_ENEMY, -1 },
+	{ 40, 15, 10, 100.0f, 250.0f, ENEMY_SIZE, R_ENEMY_COLOR, MESH_RANGED_ENEMY, 0 },
+	{ 80, 25, 10, 75.0f, 300.0f, WAVE_ENEMY_SIZE, W_ENEMY_COLOR, MESH_WAVE_ENEMY, 1 }
+};
+
+// Projectiles turn about a point slightly below their center
+const float MESH_PIVOT[ENTITY_MESH_COUNT] = { 0.0f, 0.0f, 0.0f, -0.1f, 0.0f };
+
+// Distance in front of a shooter that its bullets appear
+const float BULLET_SPAWN_OFFSET = 30.0f;
+
+/// <summary>
+/// Returns the components of an enemy kind; enemies that fire also get a shooter, so the three
+/// kinds differ only in which components they have and what is in them
+/// </summary>
+/// <param name="kind">Kind of enemy</param>
+/// <returns>ComponentFlags of the kind</returns>
+uint32_t EnemyComponents(EnemyKind kind) {
+	uint32_t components = C_TRANSFORM | C_VELOCITY | C_HEALTH | C_SEEK | C_CONTACT | C_DAMAGE_FLASH | C_RENDER | C_SCORE;
+	if (ENEMY_DEFS[kind].weapon >= 0) {
+		components |= C_SHOOTER;
+	}
+	return components;
+}
+
+/// <summary>
+/// Creates an enemy from its kind's starting values
+/// </summary>
+/// <param name="world">World to create the enemy in</param>
+/// <param name="kind">Kind of enemy</param>
+/// <param name="pos">Position to spawn at</param>
+/// <returns>Handle of the new enemy</returns>
+Entity CreateEnemy(EntityWorld& world, EnemyKind kind, glm::vec2 pos) {
+	const EnemyDef& def = ENEMY_DEFS[kind];
+	Entity entity = world.Create(EnemyComponents(kind));
+
+	Archetype* archetype;
+	uint32_t row;
+	world.Locate(entity, archetype, row);
+
+	archetype->pos[row] = pos;
+	archetype->size[row] = def.size;
+	archetype->health[row] = def.health;
+	archetype->seekSpeed[row] = def.speed;
+	archetype->followDistance[row] = def.followDistance;
+	archetype->contactDamage[row] = def.contactDamage;
+	archetype->mesh[row] = def.mesh;
+	archetype->color[row] = def.color;
+	archetype->pointValue[row] = def.pointValue;
+
+	if (def.weapon >= 0) {
+		archetype->weapon[row] = def.weapon;
+		archetype->reloadTime[row] = WEAPONS[def.weapon].reloadTime;
+	}
+
+	return entity;
+}
+
+/// <summary>
+/// Creates a projectile that travels in a straight line until its lifetime runs out
+/// </summary>
+/// <param name="world">World to create the projectile in</param>
+/// <param name="pos">Starting position</param>
+/// <param name="size">Scalar value for drawing</param>
+/// <param name="facing">Unit vector to draw the projectile facing</param>
+/// <param name="velocity">Velocity the projectile travels at</param>
+/// <param name="color">Color to draw the projectile as</param>
+/// <param name="damage">Damage dealt on hit</param>
+/// <param name="wave">Whether the projectile widens and takes several hits to destroy</param>
+/// <param name="playerTeam">Whether the player fired it</param>
+/// <returns>Handle of the new projectile</returns>
+Entity CreateProjectile(EntityWorld& world, glm::vec2 pos, glm::vec2 size, glm::vec2 facing, glm::vec2 velocity, glm::vec3 color, int damage, bool wave, bool playerTeam) {
+	uint32_t components = C_TRANSFORM | C_VELOCITY | C_LIFETIME | C_DAMAGE | C_RENDER;
+	if (wave) {
+		components |= C_HEALTH | C_GROWTH;
+	}
+	if (playerTeam) {
+		components |= C_PLAYER_TEAM;
+	}
+
+	Entity entity = world.Create(components);
+
+	Archetype* archetype;
+	uint32_t row;
+	world.Locate(entity, archetype, row);
+
+	archetype->pos[row] = pos;
+	archetype->size[row] = size;
+	archetype->facing[row] = facing;
+	archetype->velocity[row] = velocity;
+	archetype->lifeTime[row] = PROJECTILE_LIFETIME;
+	archetype->damage[row] = damage;
+	archetype->mesh[row] = MESH_PROJECTILE;
+	archetype->color[row] = color;
+
+	if (wave) {
+		archetype->health[row] = WAVE_BULLET_HEALTH;
+		archetype->growth[row] = WAVE_BULLET_GROWTH;
+	}
+
+	return entity;
+}
+
+/// <summary>
+/// Creates a pickup with a randomly chosen powerup: better bullets and multi shot are the most
+/// likely, healing and time stop the least
+/// </summary>
+/// <param name="world">World to create the pickup in</param>
+/// <param name="pos">Position of the pickup</param>
+/// <param name="random">Sim generator the powerup is rolled from</param>
+/// <returns>Handle of the new pickup</returns>
+Entity CreatePowerup(EntityWorld& world, glm::vec2 pos, SimRandom& random) {
+	Entity entity = world.Create(C_TRANSFORM | C_RENDER | C_PICKUP);
+
+	Archetype* archetype;
+	uint32_t row;
+	world.Locate(entity, archetype, row);
+
+	archetype->pos[row] = pos;
+	archetype->size[row] = POWERUP_SIZE;
+	archetype->mesh[row] = MESH_POWERUP;
+	archetype->color[row] = POWERUP_COLOR;
+
+	// Sets the powerup type by randomly choosing a number between 1 and 10
+	int option = random.Next() % 10 + 1;
+
+	if (option <= 3) {
+		archetype->pickup[row] = BETTER_BULLETS;
+	}
+	else if (option <= 6) {
+		archetype->pickup[row] = MULTI_SHOT;
+	}
+	else if (option <= 8) {
+		archetype->pickup[row] = HEALING;
+	}
+	else {
+		archetype->pickup[row] = TIME_STOP;
+	}
+
+	return entity;
+}
+
+/// <summary>
+/// Picks the target closest to a point; ties go to the earlier target, so every peer in a co-op
+/// game picks the same one
+/// </summary>
+/// <param name="pos">Point to measure from</param>
+/// <param name="targets">Positions of the players</param>
+/// <param name="targetCount">Number of players; at least 1</param>
+/// <returns>Position of the nearest target</returns>
+static glm::vec2 NearestTarget(glm::vec2 pos, const glm::vec2* targets, int targetCount) {
+	glm::vec2 nearest = targets[0];
+	glm::vec2 offset = nearest - pos;
+	float nearestDistance = offset.x * offset.x + offset.y * offset.y;
+
+	for (int i = 1; i < targetCount; i++) {
+		offset = targets[i] - pos;
+		float distance = offset.x * offset.x + offset.y * offset.y;
+		if (distance < nearestDistance) {
+			nearest = targets[i];
+			nearestDistance = distance;
+		}
+	}
+
+	return nearest;
+}
+
+/// <summary>
+/// Sets each seeker's velocity toward the nearest target, zeroing it once the seeker is within its
+/// follow distance, and turns the seeker so its front faces the target
+/// </summary>
+/// <param name="world">World to update</param>
+/// <param name="targets">Positions of the players</param>
+/// <param name="targetCount">Number of players</param>
+void SeekSystem(EntityWorld& world, const glm::vec2* targets, int targetCount) {
+	world.ForEach(C_TRANSFORM | C_VELOCITY | C_SEEK, 0, [targets, targetCount](Archetype& archetype) {
+		for (uint32_t row = 0; row < archetype.Size(); row++) {
+			glm::vec2 target = NearestTarget(archetype.pos[row], targets, targetCount);
+			glm::vec2 direction = target - archetype.pos[row];
+			float length = sqrt(direction.x * direction.x + direction.y * direction.y);
+
+			// A seeker sitting exactly on the target keeps facing the way it was
+			if (length <= 0.0f) {
+				archetype.velocity[row] = glm::vec2(0.0f, 0.0f);
+				continue;
+			}
+
+			glm::vec2 facing = direction / length;
+			if (length > archetype.followDistance[row]) {
+				archetype.velocity[row] = facing * archetype.seekSpeed[row];
+			}
+			else {
+				archetype.velocity[row] = glm::vec2(0.0f, 0.0f);
+			}
+
+			archetype.facing[row] = facing;
+		}
+	});
+}
+
+/// <summary>
+/// Adds each entity's velocity to its position
+/// </summary>
+/// <param name="world">World to update</param>
+/// <param name="dt">Time elapsed between frames</param>
+/// <param name="required">Components an entity must have, on top of a transform and velocity</param>
+/// <param name="excluded">Components an entity must not have</param>
+void MovementSystem(EntityWorld& world, float dt, uint32_t required, uint32_t excluded) {
+	world.ForEach(C_TRANSFORM | C_VELOCITY | required, excluded, [dt](Archetype& archetype) {
+		for (uint32_t row = 0; row < archetype.Size(); row++) {
+			archetype.pos[row] += archetype.velocity[row] * dt;
+		}
+	});
+}
+
+/// <summary>
+/// Delivers damage and knockback to the player from every entity touching them, testing the
+/// player against each archetype's contact circles in one narrowphase batch
+/// </summary>
+/// <param name="world">World to check</param>
+/// <param name="player">Player to hurt</param>
+/// <param name="batch">Scratch batch the tests are run in</param>
+void ContactDamageSystem(EntityWorld& world, Player& player, NarrowphaseBatch& batch) {
+	Shape point = { player.pos, glm::vec2(0.0f), glm::vec2(0.0f, 1.0f) };
+
+	world.ForEach(C_TRANSFORM | C_CONTACT, 0, [&player, &batch, &point](Archetype& archetype) {
+		batch.Reset(SHAPE_POINT, SHAPE_CIRCLE);
+		for (uint32_t row = 0; row < archetype.Size(); row++) {
+			batch.Add(point, { archetype.pos[row], glm::vec2(CONTACT_RANGE, 0.0f), glm::vec2(0.0f, 1.0f) });
+		}
+		batch.Test();
+
+		for (uint32_t row = 0; row < archetype.Size(); row++) {
+			if (batch.Hit(row)) {
+				player.TakeDamage(archetype.pos[row], archetype.contactDamage[row]);
+			}
+		}
+	});
+}
+
+/// <summary>
+/// Counts down each shooter's reload and, when it runs out, fires a bullet from just in front of
+/// the shooter toward the nearest target and starts the reload again; bullets are created in another
+/// archetype, so the shooter's own arrays do not move while they are walked
+/// </summary>
+/// <param name="world">World to update</param>
+/// <param name="targets">Positions of the players</param>
+/// <param name="targetCount">Number of players</param>
+/// <param name="dt">Time elapsed between frames</param>
+void ShooterSystem(EntityWorld& world, const glm::vec2* targets, int targetCount, float dt) {
+	world.ForEach(C_TRANSFORM | C_SHOOTER, 0, [&world, targets, targetCount, dt](Archetype& archetype) {
+		for (uint32_t row = 0; row < archetype.Size(); row++) {
+			archetype.reloadTime[row] -= dt;
+
+			if (archetype.reloadTime[row] > 0) {
+				continue;
+			}
+
+			const WeaponDef& weapon = WEAPONS[archetype.weapon[row]];
+			glm::vec2 spawn = archetype.pos[row] + archetype.facing[row] * BULLET_SPAWN_OFFSET;
+
+			glm::vec2 direction = NearestTarget(archetype.pos[row], targets, targetCount) - spawn;
+			direction /= sqrt(direction.x * direction.x + direction.y * direction.y);
+
+			CreateProjectile(world, spawn, weapon.bulletSize, archetype.facing[row], direction * weapon.bulletSpeed, weapon.bulletColor, 10, weapon.wave, false);
+			archetype.reloadTime[row] = weapon.reloadTime;
+		}
+	});
+}
+
+/// <summary>
+/// Counts down damage flashes; an entity is drawn in DAMAGE_COLOR until its flash reaches zero
+/// </summary>
+/// <param name="world">World to update</param>
+/// <param name="dt">Time elapsed between frames</param>
+void DamageFlashSystem(EntityWorld& world, float dt) {
+	world.ForEach(C_DAMAGE_FLASH, 0, [dt](Archetype& archetype) {
+		for (uint32_t row = 0; row < archetype.Size(); row++) {
+			if (archetype.flashTime[row] > 0) {
+				archetype.flashTime[row] = std::max(0.0f, archetype.flashTime[row] - dt);
+			}
+		}
+	});
+}
+
+/// <summary>
+/// Counts down lifetimes and destroys entities whose lifetime has run out
+/// </summary>
+/// <param name="world">World to update</param>
+/// <param name="dt">Time elapsed between frames</param>
+/// <param name="required">Components an entity must have, on top of a lifetime</param>
+/// <param name="excluded">Components an entity must not have</param>
+void LifetimeSystem(EntityWorld& world, float dt, uint32_t required, uint32_t excluded) {
+	world.ForEach(C_LIFETIME | required, excluded, [&world, dt](Archetype& archetype) {
+		for (uint32_t row = 0; row < archetype.Size(); row++) {
+			archetype.lifeTime[row] -= dt;
+
+			if (archetype.lifeTime[row] <= 0) {
+				world.Destroy(archetype.entities[row]);
+			}
+		}
+	});
+}
+
+/// <summary>
+/// Widens entities over time
+/// </summary>
+/// <param name="world">World to update</param>
+/// <param name="dt">Time elapsed between frames</param>
+/// <param name="required">Components an entity must have, on top of a transform and growth</param>
+/// <param name="excluded">Components an entity must not have</param>
+void GrowthSystem(EntityWorld& world, float dt, uint32_t required, uint32_t excluded) {
+	world.ForEach(C_TRANSFORM | C_GROWTH | required, excluded, [dt](Archetype& archetype) {
+		for (uint32_t row = 0; row < archetype.Size(); row++) {
+			archetype.size[row].x += archetype.growth[row] * dt;
+		}
+	});
+}
+
+/// <summary>
+/// Subtracts health from an entity and starts its damage flash; hits during a flash do not extend it
+/// </summary>
+/// <param name="archetype">Archetype of the entity, which must have health</param>
+/// <param name="row">Row of the entity</param>
+/// <param name="damage">Amount of health to be lost</param>
+void ApplyDamage(Archetype& archetype, uint32_t row, int damage) {
+	archetype.health[row] -= damage;
+
+	if (archetype.Has(C_DAMAGE_FLASH) && archetype.flashTime[row] <= 0) {
+		archetype.flashTime[row] = COLOR_RESET_TIME;
+	}
+}
+
+void RenderList::Clear() {
+	pos.clear();
+	size.clear();
+	facing.clear();
+	pivot.clear();
+	mesh.clear();
+	color.clear();
+}
+
+/// <summary>
+/// Copies the transform of every drawable entity, and picks the damage color for entities that are
+/// flashing
+/// </summary>
+/// <param name="world">World to draw</param>
+/// <param name="required">Components an entity must have, on top of a transform and render</param>
+/// <param name="excluded">Components an entity must not have</param>
+/// <param name="list">Receives one entry per entity</param>
+void ExtractRenderList(EntityWorld& world, uint32_t required, uint32_t excluded, RenderList& list) {
+	world.ForEach(C_TRANSFORM | C_RENDER | required, excluded, [&list](Archetype& archetype) {
+		bool flashes = archetype.Has(C_DAMAGE_FLASH);
+
+		list.pos.insert(list.pos.end(), archetype.pos.begin(), archetype.pos.end());
+		list.size.insert(list.size.end(), archetype.size.begin(), archetype.size.end());
+		list.facing.insert(list.facing.end(), archetype.facing.begin(), archetype.facing.end());
+		list.mesh.insert(list.mesh.end(), archetype.mesh.begin(), archetype.mesh.end());
+
+		for (uint32_t row = 0; row < archetype.Size(); row++) {
+			list.pivot.push_back(MESH_PIVOT[archetype.mesh[row]]);
+			list.color.push_back(flashes && archetype.flashTime[row] > 0 ? DAMAGE_COLOR : archetype.color[row]);
+		}
+	});
+}
+
+/// <summary>
+/// Bounds an extracted entity by a circle that holds its mesh at any rotation, for culling
+/// </summary>
+/// <param name="size">Half extents of the entity</param>
+/// <param name="pivot">Height of the point the entity turns about</param>
+/// <returns>Radius around the entity's position</returns>
+float RenderRadius(glm::vec2 size, float pivot) {
+	return glm::length(size) + 2.0f * std::abs(pivot);
+}
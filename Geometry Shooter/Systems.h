@@ -0,0 +1,144 @@
+//*****************************************************************************
+// Systems.h
+//
+// Author: Kyle Manning
+//
+// Brief Description: Header for the enemy and projectile definitions and the
+//					  systems that update them in the entity world
+//*****************************************************************************
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Entities.h"
+#include "SimRandom.h"
+#include "../Common/Narrowphase.h"
+
+class Player;
+
+// Kinds of enemy that waves spawn; each is a set of components and starting values
+enum EnemyKind {
+	ENEMY_MELEE,
+	ENEMY_RANGED,
+	ENEMY_WAVE,
+	ENEMY_KIND_COUNT
+};
+
+// What type of powerup each pickup gives
+enum PType {
+	BETTER_BULLETS,
+	MULTI_SHOT,
+	TIME_STOP,
+	HEALING
+};
+
+// Shapes entities are drawn with
+enum EntityMesh {
+	MESH_ENEMY,
+	MESH_RANGED_ENEMY,
+	MESH_WAVE_ENEMY,
+	MESH_PROJECTILE,
+	MESH_POWERUP,
+	ENTITY_MESH_COUNT
+};
+
+const glm::vec2 ENEMY_SIZE(25.0f, 25.0f);
+const glm::vec2 WAVE_ENEMY_SIZE(50.0f, 25.0f);
+const glm::vec2 POWERUP_SIZE(15.0f, 15.0f);
+
+const glm::vec3 N_ENEMY_COLOR(0.0f, 0.0f, 1.0f);
+const glm::vec3 R_ENEMY_COLOR(0.98f, 0.96f, 0.18f);
+const glm::vec3 W_ENEMY_COLOR(1.0f, 0.43f, 0.0f);
+const glm::vec3 DAMAGE_COLOR(0.5f, 0.18f, 0.35f);
+const glm::vec3 POWERUP_COLOR(0.0f, 0.96f, 0.98f);
+
+const float COLOR_RESET_TIME = 0.1f;
+const float PROJECTILE_LIFETIME = 5.0f;
+
+// Distance at which enemies hurt the player by touching them
+const float CONTACT_RANGE = 35.0f;
+
+// Wave bullets take three hits to destroy and widen as they travel
+const int WAVE_BULLET_HEALTH = 30;
+const float WAVE_BULLET_GROWTH = 20.0f;
+
+// What a shooter fires and how often
+struct WeaponDef {
+	float reloadTime, bulletSpeed;
+	glm::vec2 bulletSize;
+	glm::vec3 bulletColor;
+	bool wave;
+};
+
+// Starting values of an enemy kind; weapon is an index into WEAPONS, or -1 for none
+struct EnemyDef {
+	int health, pointValue, contactDamage;
+	float speed, followDistance;
+	glm::vec2 size;
+	glm::vec3 color;
+	EntityMesh mesh;
+	int weapon;
+};
+
+// Transforms and colors of a group of entities, extracted for the renderer as parallel arrays so the
+// transform kernel can read them directly; pivot is the mesh's pivot, copied so the kernel needs no lookup
+struct RenderList {
+	std::vector<glm::vec2> pos, size;
+	std::vector<glm::vec2> facing;
+	std::vector<float> pivot;
+	std::vector<int> mesh;
+	std::vector<glm::vec3> color;
+
+	void Clear();
+
+	size_t Size() const {
+		return pos.size();
+	}
+};
+
+extern const WeaponDef WEAPONS[];
+extern const EnemyDef ENEMY_DEFS[ENEMY_KIND_COUNT];
+
+// Components an enemy of the given kind is created with
+uint32_t EnemyComponents(EnemyKind kind);
+
+// Creates an enemy of the given kind; enemies that have a weapon also get a shooter component
+Entity CreateEnemy(EntityWorld& world, EnemyKind kind, glm::vec2 pos);
+
+// Creates a projectile; wave projectiles also get health and growth, player ones the player team tag
+Entity CreateProjectile(EntityWorld& world, glm::vec2 pos, glm::vec2 size, glm::vec2 facing, glm::vec2 velocity, glm::vec3 color, int damage, bool wave, bool playerTeam);
+
+// Creates a pickup that gives a powerup rolled from random
+Entity CreatePowerup(EntityWorld& world, glm::vec2 pos, SimRandom& random);
+
+// Points seekers at the nearest target, stopping them once they are within their follow distance
+void SeekSystem(EntityWorld& world, const glm::vec2* targets, int targetCount);
+
+// Moves every entity matching the query by its velocity
+void MovementSystem(EntityWorld& world, float dt, uint32_t required, uint32_t excluded);
+
+// Hurts the player for every entity with a contact component touching them
+void ContactDamageSystem(EntityWorld& world, Player& player, NarrowphaseBatch& batch);
+
+// Counts down reloads and fires at the nearest target when they run out
+void ShooterSystem(EntityWorld& world, const glm::vec2* targets, int targetCount, float dt);
+
+// Counts down damage flashes
+void DamageFlashSystem(EntityWorld& world, float dt);
+
+// Counts down lifetimes of entities matching the query, destroying those that run out
+void LifetimeSystem(EntityWorld& world, float dt, uint32_t required, uint32_t excluded);
+
+// Widens entities with a growth component matching the query
+void GrowthSystem(EntityWorld& world, float dt, uint32_t required, uint32_t excluded);
+
+// Subtracts health and starts a damage flash if the entity has one
+void ApplyDamage(Archetype& archetype, uint32_t row, int damage);
+
+// Appends the transform and color of every drawable entity matching the query to list
+void ExtractRenderList(EntityWorld& world, uint32_t required, uint32_t excluded, RenderList& list);
+
+// Distance from an extracted entity's position to the furthest point it can cover
+float RenderRadius(glm::vec2 size, float pivot);
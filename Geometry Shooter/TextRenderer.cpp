@@ -3,61 +3,97 @@
 // 
 // Author: Kyle Manning
 // 
-// Brief Description: Creates a useable set of textures for each character in
-//					  a font file, and can draw strings on the screen using
-//					  these textures
+// Brief Description: Rasterizes the characters of a font file into a glyph
+//					  atlas off the main thread, and can draw strings on the
+//					  screen using the atlas and vertices streamed through a
+//					  StreamBuffer
 //*****************************************************************************
 #include "TextRenderer.h"
 
+#include <algorithm>
+#include <cstring>
+#include <memory>
+
+#include "../Common/GLState.h"
+
 /// <summary>
-/// Creates a sets of Character structs with textures set to each character in the
-/// given font file at the specified font size
+/// Compiles the text Shader and queues the font's glyph atlas; a prebuilt atlas from the bundle
+/// is uploaded straight from the mapping, otherwise the font is rasterized on a worker thread.
+/// Text is drawn once the atlas arrives
 /// </summary>
 /// <param name="file">Font file to generate character textures of</param>
 /// <param name="size">Font size</param>
-TextRenderer::TextRenderer(string file, int size) : fontFile(file), fontSize(size) {
+/// <param name="stream">Stream buffer that glyph vertices are written into each frame</param>
+/// <param name="loader">Loader that rasterizes and uploads the atlas</param>
+/// <param name="bundle">Asset bundle that may hold a prebuilt atlas for this font and size</param>
+TextRenderer::TextRenderer(string file, int size, StreamBuffer* stream, AssetLoader* loader, const AssetBundle* bundle) : fontSize(size), fontFile(file), stream(stream) {
 	textShader = Shader("text.vs", "text.fs");
 
-	FT_Library ft;
-	FT_Init_FreeType(&ft);
-	FT_Face face;
-	FT_New_Face(ft, fontFile.c_str(), 0, &face);
-	FT_Set_Pixel_Sizes(face, 0, size);
-	
-	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-	for (unsigned char c = 0; c < 128; c++) {
-		FT_Load_Char(face, c, FT_LOAD_RENDER);
-
-		unsigned int texture;
-		glGenTextures(1, &texture);
-		glBindTexture(GL_TEXTURE_2D, texture);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, face->glyph->bitmap.width, face->glyph->bitmap.rows, 0, GL_RED, GL_UNSIGNED_BYTE, face->glyph->bitmap.buffer);
-
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		Character character = { texture, glm::ivec2(face->glyph->bitmap.width, face->glyph->bitmap.rows), glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top), (unsigned int)face->glyph->advance.x };
-		Characters.insert(std::pair<char, Character>(c, character));
+	const BundleEntry* entry = bundle->Find(file + "@" + std::to_string(size), BUNDLE_GLYPH_ATLAS);
+	if (entry != nullptr) {
+		const BundleGlyph* packed = (const BundleGlyph*)bundle->Data(*entry);
+		for (unsigned int c = 0; c < entry->levels; c++) {
+			const BundleGlyph& glyph = packed[c];
+			Character character = { glm::vec4(glyph.uv[0], glyph.uv[1], glyph.uv[2], glyph.uv[3]), glm::ivec2(glyph.size[0], glyph.size[1]), glm::ivec2(glyph.bearing[0], glyph.bearing[1]), glyph.advance };
+			Characters.insert(std::pair<char, Character>((char)c, character));
+		}
+
+		const unsigned char* pixels = (const unsigned char*)(packed + entry->levels);
+		loader->QueueMapped(pixels, (size_t)entry->width * entry->height, entry->width, entry->height,
+			[this](const DecodedAsset& atlas, const void* pixels) { UploadAtlas(atlas.width, atlas.height, pixels); });
+	}
+	else {
+		// The worker fills this while the main thread keeps drawing, so it is only copied once uploaded
+		std::shared_ptr<std::map<char, Character>> glyphs = std::make_shared<std::map<char, Character>>();
+		loader->Queue(
+			[file, size, glyphs]() {
+				GlyphAtlas atlas = RasterizeGlyphAtlas(file, size);
+				*glyphs = atlas.glyphs;
+				return DecodedAsset{ atlas.width, atlas.height, std::move(atlas.pixels) };
+			},
+			[this, glyphs](const DecodedAsset& atlas, const void* pixels) {
+				UploadAtlas(atlas.width, atlas.height, pixels);
+				Characters.insert(glyphs->begin(), glyphs->end());
+			});
 	}
-	glBindTexture(GL_TEXTURE_2D, 0);
-	FT_Done_Face(face);
-	FT_Done_FreeType(ft);
-
-	glGenVertexArrays(1, &textVAO);
-	glGenBuffers(1, &textVBO);
-	glBindVertexArray(textVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, textVBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
+
+	// Vertices are sourced from the shared stream buffer; draws select them with their first vertex
+	textVAO = GpuVertexArray("text VAO");
+	GLState::BindVertexArray(textVAO);
+	GLState::BindArrayBuffer(stream->ID);
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
 
 	textShader.Use();
 	glm::mat4 projection = glm::ortho(0.0f, 800.0f, 0.0f, 600.0f);
 	textShader.SetMat4("projection", projection);
+	textShader.SetInt("text", TEXT_TEXTURE_UNIT);
+}
+
+/// <summary>
+/// Creates the single channel atlas texture on the text unit
+/// </summary>
+/// <param name="width">Width of the atlas in texels</param>
+/// <param name="height">Height of the atlas in texels</param>
+/// <param name="pixels">Offset into the bound unpack buffer, or a pointer to the pixels</param>
+void TextRenderer::UploadAtlas(int width, int height, const void* pixels) {
+	atlasTexture = GpuTexture("glyph atlas");
+	GLState::BindTexture(TEXT_TEXTURE_UNIT, GL_TEXTURE_2D, atlasTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, pixels);
+	atlasTexture.SetBytes(GpuResources::TextureBytes(width, height, 1, 1, 1));
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+}
+
+/// <summary>
+/// Returns whether the glyph atlas is on the GPU
+/// </summary>
+/// <returns>True once text can be drawn</returns>
+bool TextRenderer::Ready() const {
+	return atlasTexture != 0;
 }
 
 /// <summary>
@@ -68,44 +104,12 @@ TextRenderer::TextRenderer(string file, int size) : fontFile(file), fontSize(siz
 /// <param name="pos">Position of the text in screen space</param>
 /// <param name="scale">Scalar value used when drawing</param>
 /// <param name="color">Color of the text</param>
-void TextRenderer::DrawText(std::string text, glm::vec2 pos, float scale, glm::vec3 color) {
+void TextRenderer::DrawText(std::string_view text, glm::vec2 pos, float scale, glm::vec3 color) {
 	textShader.Use();
 	textShader.SetVec3("textColor", color);
-	glActiveTexture(GL_TEXTURE0);
-	glBindVertexArray(textVAO);
-
-	std::string::const_iterator c;
-	for (c = text.begin(); c != text.end(); c++) {
-		Character ch = Characters[*c];
-
-		float xpos = pos.x + ch.Bearing.x * scale;
-		float ypos = pos.y - (ch.Size.y - ch.Bearing.y) * scale;
-
-		float w = ch.Size.x * scale;
-		float h = ch.Size.y * scale;
-
-		float vertices[6][4] = {
-			{ xpos, ypos + h, 0.0f, 0.0f },
-			{ xpos, ypos, 0.0f, 1.0f },
-			{ xpos + w, ypos, 1.0f, 1.0f },
-
-			{ xpos, ypos + h, 0.0f, 0.0f },
-			{ xpos + w, ypos, 1.0f, 1.0f },
-			{ xpos + w, ypos + h, 1.0f, 0.0f }
-		};
+	GLState::BindVertexArray(textVAO);
 
-		glBindTexture(GL_TEXTURE_2D, ch.TextureId);
-		glBindBuffer(GL_ARRAY_BUFFER, textVBO);
-		glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-		glDrawArrays(GL_TRIANGLES, 0, 6);
-
-		pos.x += (ch.Advance >> 6) * scale;
-	}
-
-	glBindVertexArray(0);
-	glBindTexture(GL_TEXTURE_2D, 0);
+	DrawGlyphs(text, pos, scale);
 }
 
 // NOTE: Number of elemetns in strings and colors must match to work
@@ -117,44 +121,64 @@ void TextRenderer::DrawText(std::string text, glm::vec2 pos, float scale, glm::v
 /// <param name="colors">Set of colors that each string should be</param>
 /// <param name="pos">Position of the text in screen space</param>
 /// <param name="scale">Scalar value for drawing the text</param>
-void TextRenderer::DrawTextMultColor(vector<string> strings, vector<glm::vec3> colors, glm::vec2 pos, float scale) {
+void TextRenderer::DrawTextMultColor(const vector<string>& strings, const vector<glm::vec3>& colors, glm::vec2 pos, float scale) {
 	textShader.Use();
-	glActiveTexture(GL_TEXTURE0);
-	glBindVertexArray(textVAO);
+	GLState::BindVertexArray(textVAO);
 	
 	for (int i = 0; i < strings.size(); i++) {
-		std::string::const_iterator c;
 		textShader.SetVec3("textColor", colors[i]);
-		for (c = strings[i].begin(); c != strings[i].end(); c++) {
-			Character ch = Characters[*c];
+		DrawGlyphs(strings[i], pos, scale);
+	}
+}
+
+/// <summary>
+/// Writes the quads for every character of a string into the stream buffer in one pass,
+/// then draws them all from the glyph atlas with one call
+/// </summary>
+/// <param name="text">String of text to draw</param>
+/// <param name="pos">Position of the text in screen space; advanced past the drawn text</param>
+/// <param name="scale">Scalar value used when drawing</param>
+void TextRenderer::DrawGlyphs(std::string_view text, glm::vec2& pos, float scale) {
+	const size_t vertexSize = 4 * sizeof(float);
 
-			float xpos = pos.x + ch.Bearing.x * scale;
-			float ypos = pos.y - (ch.Size.y - ch.Bearing.y) * scale;
+	if (atlasTexture == 0 || text.empty()) {
+		return;
+	}
+
+	StreamAllocation alloc = stream->Allocate(text.size() * 6 * vertexSize, vertexSize);
+	if (alloc.data == nullptr) {
+		return;
+	}
 
-			float w = ch.Size.x * scale;
-			float h = ch.Size.y * scale;
+	float(*vertices)[6][4] = (float(*)[6][4])alloc.data;
+	GLint first = (GLint)(alloc.offset / vertexSize);
 
-			float vertices[6][4] = {
-				{ xpos, ypos + h, 0.0f, 0.0f },
-				{ xpos, ypos, 0.0f, 1.0f },
-				{ xpos + w, ypos, 1.0f, 1.0f },
+	std::string_view::const_iterator c;
+	int index = 0;
+	for (c = text.begin(); c != text.end(); c++, index++) {
+		Character& ch = Characters[*c];
+
+		float xpos = pos.x + ch.Bearing.x * scale;
+		float ypos = pos.y - (ch.Size.y - ch.Bearing.y) * scale;
 
-				{ xpos, ypos + h, 0.0f, 0.0f },
-				{ xpos + w, ypos, 1.0f, 1.0f },
-				{ xpos + w, ypos + h, 1.0f, 0.0f }
-			};
+		float w = ch.Size.x * scale;
+		float h = ch.Size.y * scale;
 
-			glBindTexture(GL_TEXTURE_2D, ch.TextureId);
-			glBindBuffer(GL_ARRAY_BUFFER, textVBO);
-			glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
-			glBindBuffer(GL_ARRAY_BUFFER, 0);
+		float quad[6][4] = {
+			{ xpos, ypos + h, ch.UV.x, ch.UV.y },
+			{ xpos, ypos, ch.UV.x, ch.UV.w },
+			{ xpos + w, ypos, ch.UV.z, ch.UV.w },
 
-			glDrawArrays(GL_TRIANGLES, 0, 6);
+			{ xpos, ypos + h, ch.UV.x, ch.UV.y },
+			{ xpos + w, ypos, ch.UV.z, ch.UV.w },
+			{ xpos + w, ypos + h, ch.UV.z, ch.UV.y }
+		};
+		memcpy(vertices[index], quad, sizeof(quad));
 
-			pos.x += (ch.Advance >> 6) * scale;
-		}
+		pos.x += (ch.Advance >> 6) * scale;
 	}
 
-	glBindVertexArray(0);
-	glBindTexture(GL_TEXTURE_2D, 0);
-}
\ No newline at end of file
+	// Every glyph comes from the same atlas, so the whole string is one draw
+	GLState::BindTexture(TEXT_TEXTURE_UNIT, GL_TEXTURE_2D, atlasTexture);
+	glDrawArrays(GL_TRIANGLES, first, (GLsizei)text.size() * 6);
+}
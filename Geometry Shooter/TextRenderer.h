@@ -9,6 +9,7 @@
 
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <map>
 #include <vector>
 
@@ -18,28 +19,42 @@
 #include FT_FREETYPE_H
 
 #include "Shader.h"
+#include "AssetLoader.h"
+#include "GlyphAtlas.h"
+#include "../Common/AssetBundle.h"
+#include "../Common/StreamBuffer.h"
+#include "../Common/GpuResources.h"
 
-struct Character {
-	unsigned int TextureId;
-	glm::ivec2 Size;
-	glm::ivec2 Bearing;
-	unsigned int Advance;
-};
+// Texture unit that glyph atlases are bound to, kept apart from the background units
+const unsigned int TEXT_TEXTURE_UNIT = 6;
 
 class TextRenderer {
 public:
 	int fontSize;
-	unsigned int textVAO, textVBO;
+	GpuVertexArray textVAO;
+	GpuTexture atlasTexture;
 	string fontFile;
 	std::map<GLchar, Character> Characters;
 	Shader textShader;
+	StreamBuffer* stream;
+
+	TextRenderer(string file, int size, StreamBuffer* stream, AssetLoader* loader, const AssetBundle* bundle);
 
-	TextRenderer(string file, int size);
+	// Returns whether the glyph atlas has been uploaded; text is skipped until then
+	bool Ready() const;
 
-	// Draws a string of text to the screen at a specified position, scale, and color
-	void DrawText(std::string text, glm::vec2 pos, float scale, glm::vec3 color);
+	// Draws a string of text to the screen at a specified position, scale, and color; the text is
+	// only read, so literals and frame allocated strings are drawn without a copy
+	void DrawText(std::string_view text, glm::vec2 pos, float scale, glm::vec3 color);
 
 	// Draws text to the screen with different sections being different colors
-	void DrawTextMultColor(vector<string> strings, vector<glm::vec3> colors, glm::vec2 pos, float scale);
+	void DrawTextMultColor(const vector<string>& strings, const vector<glm::vec3>& colors, glm::vec2 pos, float scale);
+
+private:
+	// Streams the vertices of a string and draws it, advancing pos past the text
+	void DrawGlyphs(std::string_view text, glm::vec2& pos, float scale);
+
+	// Creates the atlas texture from pixels in the bound unpack buffer or in memory
+	void UploadAtlas(int width, int height, const void* pixels);
 };
 
@@ -3,10 +3,17 @@ in vec2 TexCoords;
 
 out vec4 color;
 
-uniform sampler2D texture;
-uniform sampler2D texture2;
+// Array holding the resident backgrounds; the crossfade mixes two of its layers
+uniform sampler2DArray backgrounds;
+uniform int fromLayer;
+uniform int toLayer;
 uniform float shift;
+// Set while baking the time stop layer, which keeps only the average of the color
+uniform bool luminance;
 
 void main() {
-    color = mix(texture(texture, TexCoords), texture(texture2, TexCoords), shift);
+    color = mix(texture(backgrounds, vec3(TexCoords, fromLayer)), texture(backgrounds, vec3(TexCoords, toLayer)), shift);
+    if (luminance) {
+        color = vec4(vec3((color.r + color.g + color.b) / 3.0f), color.a);
+    }
 }
\ No newline at end of file
@@ -1,10 +0,0 @@
-#version 460 core
-layout (location = 0) in vec2 aVertex;
-layout (location = 1) in vec2 aTexCoords;
-
-out vec2 TexCoords;
-
-void main() {
-	gl_Position = vec4(aVertex, 0.0, 1.0);
-	TexCoords = aTexCoords;
-}
\ No newline at end of file
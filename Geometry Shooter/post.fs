@@ -0,0 +1,34 @@
+#version 460 core
+in vec2 TexCoords;
+
+out vec4 color;
+
+uniform sampler2D scene;
+
+#ifdef HEALING_VIGNETTE
+uniform sampler2D vignette;
+#endif
+
+#ifdef COLOR_GRADE
+uniform vec3 gradeGain;
+uniform vec3 gradeLift;
+#endif
+
+// Each effect is compiled in with a #define, so the pass only does the work that is enabled
+void main() {
+    color = vec4(texture(scene, TexCoords).rgb, 1.0);
+
+#ifdef HEALING_VIGNETTE
+    vec4 tint = texture(vignette, TexCoords);
+    color.rgb = mix(color.rgb, tint.rgb, tint.a);
+#endif
+
+#ifdef GRAYSCALE
+    float average = (color.r + color.g + color.b) / 3.0f;
+    color.rgb = vec3(average);
+#endif
+
+#ifdef COLOR_GRADE
+    color.rgb = color.rgb * gradeGain + gradeLift;
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,9 @@
+#version 460 core
+out vec2 TexCoords;
+
+// Covers the screen with one oversized triangle generated from the vertex index
+void main() {
+	vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+	gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+	TexCoords = corner;
+}
\ No newline at end of file
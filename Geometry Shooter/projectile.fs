@@ -1,8 +1,21 @@
 #version 460 core
 out vec4 color;
 
+#ifdef INSTANCED
+in vec3 instanceColor;
+#else
 uniform vec3 Color;
+#endif
+// Set while baking the time stop layer, which keeps only the average of the color
+uniform bool luminance;
 
 void main() {
+#ifdef INSTANCED
+    color = vec4(instanceColor, 1.0f);
+#else
     color = vec4(Color, 1.0f);
+#endif
+    if (luminance) {
+        color = vec4(vec3((color.r + color.g + color.b) / 3.0f), color.a);
+    }
 }
\ No newline at end of file
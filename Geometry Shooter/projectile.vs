@@ -1,10 +1,26 @@
 #version 460 core
 layout (location = 0) in vec2 aVertex;
 
+#ifdef INSTANCED
+// Rows of the packed 2x3 model transform and the color of each instance
+layout (location = 1) in vec3 aModelRow0;
+layout (location = 2) in vec3 aModelRow1;
+layout (location = 3) in vec3 aColor;
+
+out vec3 instanceColor;
+#else
 uniform mat4 model;
+#endif
 uniform mat4 projection;
 uniform mat4 view;
 
 void main() {
+#ifdef INSTANCED
+	vec3 vertex = vec3(aVertex, 1.0);
+	vec2 worldPos = vec2(dot(aModelRow0, vertex), dot(aModelRow1, vertex));
+	gl_Position = projection * view * vec4(worldPos, 0.0, 1.0);
+	instanceColor = aColor;
+#else
 	gl_Position = projection * view * model * vec4(aVertex, 0.0, 1.0);
+#endif
 }
\ No newline at end of file
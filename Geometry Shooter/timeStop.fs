@@ -7,7 +7,7 @@ uniform sampler2D texture;
 
 void main()
 { 
-    color = texture(texture, TexCoords);
-    float average = (color.r + color.g + color.b) / 3.0f;
+    // The layer was baked as one channel holding the average of each color
+    float average = texture(texture, TexCoords).r;
     color = vec4(average, average, average, 1.0);
 }
\ No newline at end of file
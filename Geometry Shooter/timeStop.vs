@@ -4,7 +4,11 @@ layout (location = 1) in vec2 aTexCoords;
 
 out vec2 TexCoords;
 
+// Selects the part of the frozen layer that is under the view
+uniform vec2 uvOffset;
+uniform vec2 uvScale;
+
 void main() {
 	gl_Position = vec4(aVertex.x, aVertex.y, 0.0f, 1.0f);
-	TexCoords = aTexCoords;
+	TexCoords = aTexCoords * uvScale + uvOffset;
 }
\ No newline at end of file
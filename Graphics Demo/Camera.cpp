@@ -1,4 +1,5 @@
 #include "Camera.h"
+#include "../Common/FastMath.h"
 
 Camera::Camera(glm::vec3 pos, glm::vec3 up) : pos(pos), up(up), yaw(YAW), pitch(PITCH), front(glm::vec3(0.0f, 0.0f, -1.0f)), worldUp(up), movementSpeed(SPEED), mouseSensitivity(SENSITIVITY) {
 
@@ -39,10 +40,15 @@ void Camera::ProcessMouseMovement(float xoffset, float yoffset, GLboolean constr
 }
 
 void Camera::updateCameraVectors() {
+    // One sine and cosine per angle instead of a separate call for each use
+    float sinYaw, cosYaw, sinPitch, cosPitch;
+    FastSinCos(glm::radians(yaw), sinYaw, cosYaw);
+    FastSinCos(glm::radians(pitch), sinPitch, cosPitch);
+
     glm::vec3 newFront;
-    newFront.x = cos(glm::radians(yaw)) * cos(glm::radians(pitch));
-    newFront.y = -sin(glm::radians(pitch));
-    newFront.z = sin(glm::radians(yaw)) * cos(glm::radians(pitch));
+    newFront.x = cosYaw * cosPitch;
+    newFront.y = -sinPitch;
+    newFront.z = sinYaw * cosPitch;
     front = glm::normalize(newFront);
     
     right = glm::normalize(glm::cross(front, worldUp));
@@ -5,6 +5,9 @@
 
 #include "Shader.h"
 #include "Camera.h"
+#include "../Common/GLState.h"
+#include "../Common/GpuResources.h"
+#include "../Common/FramePacer.h"
 
 void FramebufferCallback(GLFWwindow* window, int width, int height);
 void MouseCallback(GLFWwindow* window, double xPos, double yPos);
@@ -23,6 +26,10 @@ bool firstMouse = true;
 float dt = 0.0f;
 float prevFrame = 0.0f;
 
+// Key 2 cycles the pacing mode and key 3 toggles low latency; the window title shows the results
+FramePacer pacer;
+float titleTimer = 0.0f;
+
 glm::mat4 view = glm::mat4(1.0f);
 glm::mat4 projection = glm::perspective(glm::radians(45.0f), SCREEN_WIDTH / SCREEN_HEIGHT, 0.1f, 100.0f);
 
@@ -59,11 +66,15 @@ int main() {
 	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
 	glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
-	glEnable(GL_DEPTH_TEST);
+	GLState::SetDepthTest(true);
 	//glEnable(GL_CULL_FACE);
-	glEnable(GL_BLEND);
+	GLState::SetBlend(true);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
+	// The car and object programs are each built more than once; after the first of each, and on
+	// every warm start, they are loaded from program binaries instead of compiled
+	Shader::LoadProgramCache("shaders.cache");
+
 	Shader carShader = Shader("car.vs", "car.fs");
 	Shader interiorShader = Shader("car.vs", "car.fs");
 	Shader tireShader = Shader("object.vs", "object.fs");
@@ -1616,12 +1627,12 @@ int main() {
 	glGenBuffers(1, &carVBO);
 	glGenBuffers(1, &carEBO);
 
-	glBindBuffer(GL_ARRAY_BUFFER, carVBO);
+	GLState::BindArrayBuffer(carVBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(carVerts), carVerts, GL_STATIC_DRAW);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, carEBO);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(carIndices), carIndices, GL_STATIC_DRAW);
 
-	glBindVertexArray(carVAO);
+	GLState::BindVertexArray(carVAO);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
@@ -1633,12 +1644,12 @@ int main() {
 	glGenBuffers(1, &tireVBO);
 	glGenBuffers(1, &tireEBO);
 
-	glBindBuffer(GL_ARRAY_BUFFER, tireVBO);
+	GLState::BindArrayBuffer(tireVBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(tireVerts), tireVerts, GL_STATIC_DRAW);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, tireEBO);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(tireIndices), tireIndices, GL_STATIC_DRAW);
 
-	glBindVertexArray(tireVAO);
+	GLState::BindVertexArray(tireVAO);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
 	glEnableVertexAttribArray(0);
 
@@ -1647,10 +1658,10 @@ int main() {
 	glGenVertexArrays(1, &roadVAO);
 	glGenBuffers(1, &roadVBO);
 
-	glBindBuffer(GL_ARRAY_BUFFER, roadVBO);
+	GLState::BindArrayBuffer(roadVBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(roadVerts), roadVerts, GL_STATIC_DRAW);
 
-	glBindVertexArray(roadVAO);
+	GLState::BindVertexArray(roadVAO);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
 	glEnableVertexAttribArray(0);
 
@@ -1673,16 +1684,38 @@ int main() {
 	grassShader.Use();
 	grassShader.SetVec3("Color", glm::vec3(0.045f, 0.25f, 0.065f));
 
+	// Handles for the uniforms set per tile, resolved once instead of looked up by name every draw
+	UniformHandle<glm::mat4> tireModel = tireShader.Uniform<glm::mat4>("model");
+	UniformHandle<glm::mat4> roadModel = roadShader.Uniform<glm::mat4>("model");
+	UniformHandle<glm::mat4> grassModel = grassShader.Uniform<glm::mat4>("model");
+
 	int faces = 0;
 	float timer = 1.0f;
 
 	// Loops execution of main gameplay functions
+	pacer.SetMode(PACING_VSYNC);
+
 	while (!glfwWindowShouldClose(window)) {
+		// Waiting for the limiter and the GPU comes before polling, so the camera uses the freshest input
+		pacer.BeginFrame();
+		glfwPollEvents();
+
 		float currentFrame = (float)glfwGetTime();
 		dt = currentFrame - prevFrame;
 		prevFrame = currentFrame;
 
 		ProcessInput(window);
+		pacer.MarkInputSampled();
+
+		titleTimer -= dt;
+		if (titleTimer <= 0.0f) {
+			FramePacingStats pacingStats = pacer.GetStats();
+			char title[128];
+			snprintf(title, sizeof(title), "Graphics Demo - %.2f ms, std dev %.2f ms, ~%.1f ms latency, %s%s", pacingStats.frameMs, pacingStats.frameStdDevMs,
+				pacingStats.inputLatencyMs, FramePacer::ModeName(pacer.Mode()), pacer.LowLatency() ? ", low latency" : "");
+			glfwSetWindowTitle(window, title);
+			titleTimer = 1.0f;
+		}
 
 		glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -1723,10 +1756,9 @@ int main() {
 		}
 		*/
 		
-		glBindVertexArray(carVAO);
+		GLState::BindVertexArray(carVAO);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, carEBO);
 		glDrawElements(GL_TRIANGLES, sizeof(carIndices), GL_UNSIGNED_INT, 0);
-		glBindVertexArray(0);
 		
 
 		tireShader.Use();
@@ -1740,12 +1772,11 @@ int main() {
 			model = glm::translate(model, tirePos[i]);
 			model = glm::rotate(model, glm::radians(rotation), glm::vec3(0.0f, 0.0f, 1.0f));
 			model = glm::scale(model, glm::vec3(0.3f, 0.3f, 0.18f));
-			tireShader.SetMat4("model", model);
+			tireModel.Set(model);
 
-			glBindVertexArray(tireVAO);
+			GLState::BindVertexArray(tireVAO);
 			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, tireEBO);
 			glDrawElements(GL_TRIANGLES, sizeof(tireIndices), GL_UNSIGNED_INT, 0);
-			glBindVertexArray(0);
 		}
 		
 
@@ -1763,11 +1794,10 @@ int main() {
 
 			model = glm::mat4(1.0f);
 			model = glm::translate(model, roadTilePos[i]);
-			roadShader.SetMat4("model", model);
+			roadModel.Set(model);
 
-			glBindVertexArray(roadVAO);
+			GLState::BindVertexArray(roadVAO);
 			glDrawArrays(GL_TRIANGLES, 0, 6);
-			glBindVertexArray(0);
 		}
 
 		grassShader.Use();
@@ -1784,18 +1814,40 @@ int main() {
 			model = glm::mat4(1.0f);
 			model = glm::translate(model, grassTilePos[i]);
 			model = glm::scale(model, glm::vec3(1.0f, 1.0f, 2.0f));
-			roadShader.SetMat4("model", model);
+			grassModel.Set(model);
 
-			glBindVertexArray(roadVAO);
+			GLState::BindVertexArray(roadVAO);
 			glDrawArrays(GL_TRIANGLES, 0, 6);
-			glBindVertexArray(0);
 		}
 		
 
 		glfwSwapBuffers(window);
-		glfwPollEvents();
+		pacer.EndFrame();
 	}
 
+	FramePacingStats pacingStats = pacer.GetStats();
+	std::cout << "Frame pacing: " << pacingStats.frameMs << " ms mean, " << pacingStats.frameStdDevMs << " ms std dev, ~" << pacingStats.inputLatencyMs << " ms input latency" << std::endl;
+
+	GLStateStats glStats = GLState::GetStats();
+	std::cout << "GL state cache: " << glStats.issued << " calls issued, " << glStats.skipped << " skipped" << std::endl;
+
+	Shader::SaveProgramCache();
+
+	ShaderBuildStats shaderStats = Shader::GetBuildStats();
+	std::cout << "Shader programs: " << shaderStats.compiled << " compiled, " << shaderStats.fromSpirv << " from SPIR-V, " << shaderStats.fromBinary << " from cached binaries" << std::endl;
+
+	// Programs are released while the context still exists; the scene's vertex objects live until exit
+	tireModel = UniformHandle<glm::mat4>();
+	roadModel = UniformHandle<glm::mat4>();
+	grassModel = UniformHandle<glm::mat4>();
+	carShader = Shader();
+	interiorShader = Shader();
+	tireShader = Shader();
+	roadShader = Shader();
+	grassShader = Shader();
+	pacer.Release();
+	GpuResources::Shutdown();
+
 	glfwTerminate();
 	return 0;
 }
@@ -1836,6 +1888,14 @@ void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
 	else if (key == GLFW_KEY_1 && action == GLFW_RELEASE) {
 		pressed1 = false;
 	}
+
+	if (key == GLFW_KEY_2 && action == GLFW_PRESS) {
+		pacer.SetMode((PacingMode)((pacer.Mode() + 1) % PACING_MODE_COUNT));
+	}
+
+	if (key == GLFW_KEY_3 && action == GLFW_PRESS) {
+		pacer.SetLowLatency(!pacer.LowLatency());
+	}
 }
 
 void FramebufferCallback(GLFWwindow* window, int width, int height)
@@ -0,0 +1,260 @@
+//*****************************************************************************
+// AssetPacker.cpp
+//
+// Author: Kyle Manning
+//
+// Brief Description: Offline tool that reads an asset manifest and writes one
+//					  versioned bundle holding RGBA8 textures with their full
+//					  mip chains, prebuilt glyph atlases with metrics, and
+//					  shader sources, in the layout read by AssetBundle
+//
+// Build by compiling this file with Geometry Shooter/GlyphAtlas.cpp and linking
+// FreeType; no GL context is needed.
+//
+// Usage: AssetPacker <manifest> <output bundle>
+//*****************************************************************************
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../../Common/AssetBundle.h"
+#include "../../Geometry Shooter/GlyphAtlas.h"
+
+// One entry and its data, before offsets are assigned
+struct PackedAsset {
+	BundleEntry entry;
+	std::vector<unsigned char> data;
+};
+
+/// <summary>
+/// Halves an RGBA8 image with a 2x2 box filter; odd edges reuse the last row or column
+/// </summary>
+/// <param name="source">Pixels of the larger level</param>
+/// <param name="width">Width of the larger level</param>
+/// <param name="height">Height of the larger level</param>
+/// <returns>Pixels of the next level</returns>
+std::vector<unsigned char> Downsample(const unsigned char* source, int width, int height) {
+	int nextWidth = AssetBundle::LevelSize(width, 1);
+	int nextHeight = AssetBundle::LevelSize(height, 1);
+	std::vector<unsigned char> next((size_t)nextWidth * nextHeight * 4);
+
+	for (int y = 0; y < nextHeight; y++) {
+		int y0 = std::min(y * 2, height - 1);
+		int y1 = std::min(y * 2 + 1, height - 1);
+
+		for (int x = 0; x < nextWidth; x++) {
+			int x0 = std::min(x * 2, width - 1);
+			int x1 = std::min(x * 2 + 1, width - 1);
+
+			for (int c = 0; c < 4; c++) {
+				int sum = source[(y0 * width + x0) * 4 + c] + source[(y0 * width + x1) * 4 + c] +
+					source[(y1 * width + x0) * 4 + c] + source[(y1 * width + x1) * 4 + c];
+				next[((size_t)y * nextWidth + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+			}
+		}
+	}
+
+	return next;
+}
+
+/// <summary>
+/// Decodes an image the same way the game does (RGBA, flipped vertically) and appends every mip
+/// level down to 1x1, so the game never has to call glGenerateMipmap for it
+/// </summary>
+/// <param name="path">Path of the image file</param>
+/// <param name="asset">Entry and data to fill in</param>
+/// <returns>False if the image could not be decoded</returns>
+bool PackTexture(const std::string& path, PackedAsset& asset) {
+	int width, height, channels;
+	unsigned char* pixels = stbi_load(path.c_str(), &width, &height, &channels, 4);
+	if (!pixels) {
+		return false;
+	}
+
+	int levels = 1 + (int)std::log2(std::max(width, height));
+
+	asset.entry.type = BUNDLE_TEXTURE_RGBA8;
+	asset.entry.width = width;
+	asset.entry.height = height;
+	asset.entry.levels = levels;
+	asset.data.assign(pixels, pixels + (size_t)width * height * 4);
+	stbi_image_free(pixels);
+
+	std::vector<unsigned char> level(asset.data);
+	for (int i = 1; i < levels; i++) {
+		level = Downsample(level.data(), AssetBundle::LevelSize(width, i - 1), AssetBundle::LevelSize(height, i - 1));
+		asset.data.insert(asset.data.end(), level.begin(), level.end());
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Rasterizes a font into an atlas and stores the glyph records followed by the atlas pixels
+/// </summary>
+/// <param name="path">Path of the font file</param>
+/// <param name="size">Font size in pixels</param>
+/// <param name="asset">Entry and data to fill in</param>
+/// <returns>False if the font could not be loaded</returns>
+bool PackFont(const std::string& path, int size, PackedAsset& asset) {
+	GlyphAtlas atlas = RasterizeGlyphAtlas(path, size);
+	if (atlas.pixels.empty()) {
+		return false;
+	}
+
+	asset.entry.type = BUNDLE_GLYPH_ATLAS;
+	asset.entry.width = atlas.width;
+	asset.entry.height = atlas.height;
+	asset.entry.levels = GLYPH_COUNT;
+
+	std::vector<BundleGlyph> glyphs(GLYPH_COUNT);
+	for (int c = 0; c < GLYPH_COUNT; c++) {
+		const Character& ch = atlas.glyphs[(char)c];
+		BundleGlyph& glyph = glyphs[c];
+		glyph.uv[0] = ch.UV.x;
+		glyph.uv[1] = ch.UV.y;
+		glyph.uv[2] = ch.UV.z;
+		glyph.uv[3] = ch.UV.w;
+		glyph.size[0] = ch.Size.x;
+		glyph.size[1] = ch.Size.y;
+		glyph.bearing[0] = ch.Bearing.x;
+		glyph.bearing[1] = ch.Bearing.y;
+		glyph.advance = ch.Advance;
+	}
+
+	const unsigned char* records = (const unsigned char*)glyphs.data();
+	asset.data.assign(records, records + glyphs.size() * sizeof(BundleGlyph));
+	asset.data.insert(asset.data.end(), atlas.pixels.begin(), atlas.pixels.end());
+	return true;
+}
+
+/// <summary>
+/// Stores a shader's source text as it is
+/// </summary>
+/// <param name="path">Path of the shader file</param>
+/// <param name="asset">Entry and data to fill in</param>
+/// <returns>False if the file could not be read</returns>
+bool PackShader(const std::string& path, PackedAsset& asset) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		return false;
+	}
+
+	asset.entry.type = BUNDLE_SHADER_SOURCE;
+	asset.data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	return true;
+}
+
+int main(int argc, char** argv) {
+	if (argc != 3) {
+		std::cout << "Usage: AssetPacker <manifest> <output bundle>" << std::endl;
+		return 1;
+	}
+
+	std::string manifestPath = argv[1];
+	size_t slash = manifestPath.find_last_of("/\\");
+	std::string baseDir = slash == std::string::npos ? "" : manifestPath.substr(0, slash + 1);
+
+	std::ifstream manifest(manifestPath);
+	if (!manifest) {
+		std::cout << "ERROR::ASSET_PACKER::MANIFEST_NOT_FOUND " << manifestPath << std::endl;
+		return 1;
+	}
+
+	// Matches the game's loader, which flips images so row 0 is the bottom of the texture
+	stbi_set_flip_vertically_on_load(true);
+
+	std::vector<PackedAsset> assets;
+	std::string line;
+	int lineNumber = 0;
+
+	while (std::getline(manifest, line)) {
+		lineNumber += 1;
+
+		std::istringstream words(line);
+		std::string kind, name;
+		if (!(words >> kind) || kind[0] == '#') {
+			continue;
+		}
+		words >> name;
+
+		PackedAsset asset = {};
+		std::string path = baseDir + name;
+		std::string entryName = name;
+		bool packed = false;
+
+		if (kind == "texture") {
+			packed = PackTexture(path, asset);
+		}
+		else if (kind == "font") {
+			int size = 0;
+			words >> size;
+			entryName = name + "@" + std::to_string(size);
+			packed = size > 0 && PackFont(path, size, asset);
+		}
+		else if (kind == "shader") {
+			packed = PackShader(path, asset);
+		}
+		else {
+			std::cout << "ERROR::ASSET_PACKER::UNKNOWN_KIND line " << lineNumber << ": " << kind << std::endl;
+			return 1;
+		}
+
+		if (!packed || entryName.size() >= BUNDLE_NAME_LENGTH) {
+			std::cout << "ERROR::ASSET_PACKER::FAILED line " << lineNumber << ": " << path << std::endl;
+			return 1;
+		}
+
+		strncpy(asset.entry.name, entryName.c_str(), BUNDLE_NAME_LENGTH - 1);
+		asset.entry.size = asset.data.size();
+		assets.push_back(std::move(asset));
+	}
+
+	// Data follows the entry table, each block starting on an aligned offset
+	uint64_t offset = sizeof(BundleHeader) + assets.size() * sizeof(BundleEntry);
+	for (PackedAsset& asset : assets) {
+		offset = (offset + BUNDLE_ALIGNMENT - 1) / BUNDLE_ALIGNMENT * BUNDLE_ALIGNMENT;
+		asset.entry.offset = offset;
+		offset += asset.entry.size;
+	}
+
+	FILE* output = fopen(argv[2], "wb");
+	if (output == nullptr) {
+		std::cout << "ERROR::ASSET_PACKER::CANNOT_WRITE " << argv[2] << std::endl;
+		return 1;
+	}
+
+	BundleHeader header = {};
+	memcpy(header.magic, BUNDLE_MAGIC, sizeof(BUNDLE_MAGIC));
+	header.version = BUNDLE_VERSION;
+	header.entryCount = (uint32_t)assets.size();
+	fwrite(&header, sizeof(header), 1, output);
+
+	for (const PackedAsset& asset : assets) {
+		fwrite(&asset.entry, sizeof(BundleEntry), 1, output);
+	}
+
+	const unsigned char padding[BUNDLE_ALIGNMENT] = {};
+	uint64_t written = sizeof(BundleHeader) + assets.size() * sizeof(BundleEntry);
+	for (const PackedAsset& asset : assets) {
+		fwrite(padding, 1, (size_t)(asset.entry.offset - written), output);
+		fwrite(asset.data.data(), 1, asset.data.size(), output);
+		written = asset.entry.offset + asset.entry.size;
+
+		std::cout << asset.entry.name << ": " << asset.entry.size << " bytes" << std::endl;
+	}
+
+	fclose(output);
+
+	std::cout << "Wrote " << assets.size() << " entries, " << written << " bytes, to " << argv[2] << std::endl;
+	return 0;
+}
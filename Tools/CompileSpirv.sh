@@ -0,0 +1,37 @@
+#!/bin/sh
+#******************************************************************************
+# CompileSpirv.sh
+#
+# Author: Kyle Manning
+#
+# Brief Description: Compiles every .vs/.fs shader in the given directories to
+#					 OpenGL SPIR-V modules next to them (player.vs ->
+#					 player.vs.spv), which Shader loads in place of the GLSL
+#					 source. Needs glslangValidator from the Vulkan SDK.
+#
+# Usage: Tools/CompileSpirv.sh "Geometry Shooter" "Graphics Demo"
+#
+# Uniform locations and sampler bindings are assigned automatically, and debug
+# names are kept because uniforms are still set by name. Shaders built with
+# #define permutations (post.fs) always use their GLSL source.
+#******************************************************************************
+status=0
+
+for dir in "$@"; do
+	for shader in "$dir"/*.vs "$dir"/*.fs; do
+		[ -f "$shader" ] || continue
+
+		case "$shader" in
+			*.vs) stage=vert ;;
+			*.fs) stage=frag ;;
+		esac
+
+		if ! glslangValidator -G -S "$stage" --auto-map-locations --auto-map-bindings -o "$shader.spv" "$shader"; then
+			echo "ERROR: failed to compile $shader"
+			rm -f "$shader.spv"
+			status=1
+		fi
+	done
+done
+
+exit $status